@@ -72,4 +72,20 @@ struct cuddl_resource_id {
 	int instance;
 };
 
+/**
+ * enum cuddl_resource_type - Types of device resources.
+ *
+ * @CUDDL_RESOURCE_MEMREGION: The associated resource is a memory region.
+ *
+ * @CUDDL_RESOURCE_EVENTSRC: The associated resource is an event source.
+ *
+ * This type enumerates the kinds of device resources that may be claimed by
+ * user-space applications.  The values are equivalent to the corresponding
+ * ``cuddlk_resource`` enumeration values used in kernel space.
+ */
+enum cuddl_resource_type {
+	CUDDL_RESOURCE_MEMREGION = 1,
+	CUDDL_RESOURCE_EVENTSRC  = 2,
+};
+
 #endif /* !_CUDDL_COMMON_GENERAL_H */
@@ -17,9 +17,10 @@
 #define _CUDDL_COMMON_IMPL_LINUX_H
 
 #ifdef __KERNEL__
-  #include <linux/types.h> /* size_t */
+  #include <linux/types.h> /* size_t, uint64_t */
 #else
   #include <sys/types.h> /* size_t */
+  #include <stdint.h> /* uint64_t */
 #endif
 
 /**
@@ -75,6 +76,21 @@ typedef size_t cuddlci_size_t;
  * @token: Opaque token used (internally) when releasing ownership of the
  *         associated memory region.
  *
+ * @mode_mmap_offset: Page-aligned mmap offset used to map the memory region
+ *                    with an explicit caching mode.  The offset for a given
+ *                    ``cuddlci_mem_map_mode`` is ``mode_mmap_offset + mode *
+ *                    CUDDLK_PAGE_SIZE``.  Such mappings are made via the
+ *                    ``mmap()`` system call on the ``/dev/cuddl`` manager
+ *                    device rather than on ``device_name``.
+ *
+ * @huge_page_size: Largest page size that may be used to map the memory
+ *                  region via the ``mode_mmap_offset`` (with
+ *                  ``CUDDLCI_MEM_MAP_HUGE`` set), or ``0`` if the memory
+ *                  region cannot be mapped with huge pages.
+ *
+ * @dma_addr: Bus address of the memory region if ``CUDDL_MEMF_DMA`` is set.
+ *            DMA buffers are always mapped via ``mode_mmap_offset``.
+ *
  * @device_name:
  *
  *     Name of the device node that will be used to map the memory region via
@@ -105,15 +121,61 @@ struct cuddlci_memregion_info_priv {
 	cuddlci_size_t pa_len;
 	cuddlci_size_t start_offset;
 	struct cuddlci_token token;
+	unsigned long mode_mmap_offset;
+	unsigned long huge_page_size;
+	uint64_t dma_addr;
 	char device_name[CUDDLCI_MAX_STR_LEN];
 };
 
+/**
+ * enum cuddlci_mem_map_mode - Memory region caching modes.
+ *
+ * @CUDDLCI_MEM_MAP_DEFAULT: Mapping made via ``device_name``, with the
+ *                           caching mode chosen by Linux UIO or Xenomai UDD
+ *                           for the memory region type.
+ *
+ * @CUDDLCI_MEM_MAP_UNCACHED: Uncached mapping.
+ *
+ * @CUDDLCI_MEM_MAP_WRITE_COMBINE: Write-combining mapping.
+ *
+ * @CUDDLCI_MEM_MAP_CACHED: Cached (write-back) mapping.
+ *
+ * @CUDDLCI_MEM_MAP_HUGE: May be ORed with any of the above modes to map the
+ *                        memory region with huge pages where the alignment
+ *                        of the mapping permits.  When ORed with
+ *                        ``CUDDLCI_MEM_MAP_DEFAULT``, the mapping is made
+ *                        via the manager device with the same caching mode
+ *                        that Linux UIO would use.
+ *
+ * @CUDDLCI_MEM_MAP_MODES: Number of distinct mode values.
+ */
+enum cuddlci_mem_map_mode {
+	CUDDLCI_MEM_MAP_DEFAULT       = 0,
+	CUDDLCI_MEM_MAP_UNCACHED      = 1,
+	CUDDLCI_MEM_MAP_WRITE_COMBINE = 2,
+	CUDDLCI_MEM_MAP_CACHED        = 3,
+	CUDDLCI_MEM_MAP_HUGE          = 4,
+	CUDDLCI_MEM_MAP_MODES         = 8,
+};
+
+/*
+ * First page offset used for memory region mappings made via the manager
+ * device.  Event source status pages are mapped at lower page offsets.
+ */
+#define CUDDLCI_MEM_MMAP_PGOFF 0x10000UL
+
 /**
  * struct cuddlci_eventsrc_info_priv - Private event source information.
  *
  * @token: Opaque token used (internally) when releasing ownership of the
  *         associated memory region.
  *
+ * @status_mmap_offset: Page-aligned mmap offset of the event source status
+ *                      page (see ``cuddlci_eventsrc_status``).  This value
+ *                      is used as the ``offset`` argument when mapping the
+ *                      status page via the ``mmap()`` system call on the
+ *                      ``/dev/cuddl`` manager device.
+ *
  * @device_name:
  *
  *     Name of the device that will be used to receive interrupt events.
@@ -137,7 +199,49 @@ struct cuddlci_memregion_info_priv {
  */
 struct cuddlci_eventsrc_info_priv {
 	struct cuddlci_token token;
+	unsigned long status_mmap_offset;
 	char device_name[CUDDLCI_MAX_STR_LEN];
 };
 
+/**
+ * enum cuddlci_eventsrc_status_enabled_value - Special ``enabled`` values.
+ *
+ * @CUDDLCI_EVENTSRC_STATUS_ENABLED_UNKNOWN: The enabled/disabled state of the
+ *     event source has not been established yet.
+ */
+enum cuddlci_eventsrc_status_enabled_value {
+	CUDDLCI_EVENTSRC_STATUS_ENABLED_UNKNOWN = -1,
+};
+
+/**
+ * struct cuddlci_eventsrc_status - Event source status page layout.
+ *
+ * @sequence: Sequence lock counter.  This value is odd while the kernel is
+ *            updating the other fields.  Readers must retry if the value is
+ *            odd or if it changes while the other fields are being read.
+ *
+ * @enabled: ``1`` if the event source is enabled, ``0`` if it is disabled,
+ *           or ``CUDDLCI_EVENTSRC_STATUS_ENABLED_UNKNOWN``.  This reflects
+ *           the most recent enable/disable request or ``is_enabled()``
+ *           query made through Cuddl, or the most recent state reported by
+ *           the driver via ``cuddlk_eventsrc_report_enabled()``.
+ *
+ * @event_seq: Number of events that have occurred since the event source
+ *             was registered.  The low 32 bits of this value track the
+ *             event count returned by ``read()`` on the event source device.
+ *
+ * @timestamp_ns: ``CLOCK_MONOTONIC`` time (in nanoseconds) at which the
+ *                most recent event occurred.
+ *
+ * The kernel maintains one read-only page with this layout per event
+ * source, so that user space can query the event source status with plain
+ * memory loads instead of system calls.
+ */
+struct cuddlci_eventsrc_status {
+	uint32_t sequence;
+	int32_t enabled;
+	uint64_t event_seq;
+	uint64_t timestamp_ns;
+};
+
 #endif /* !_CUDDL_COMMON_IMPL_LINUX_H */
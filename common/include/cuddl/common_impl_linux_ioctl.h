@@ -132,8 +132,28 @@
  * .. c:macro:: CUDDLCI_EVENTSRC_IS_ENABLED_IOCTL
  *
  *    IOCTL associated with ``cuddl_eventsrc_is_enabled()``.
+ *
+ * .. c:macro:: CUDDLCI_CLAIM_BATCH_UIO_IOCTL
+ *
+ *    IOCTL associated with ``cuddl_resource_claim_batch()`` for Linux UIO.
+ *
+ * .. c:macro:: CUDDLCI_CLAIM_BATCH_UDD_IOCTL
+ *
+ *    IOCTL associated with ``cuddl_resource_claim_batch()`` for Xenomai
+ *    UDD.
+ *
+ * .. c:macro:: CUDDLCI_EVENTSRC_GET_RECORD_IOCTL
+ *
+ *    IOCTL associated with ``cuddl_eventsrc_get_record()``.
+ *
+ * .. c:macro:: CUDDLCI_MAX_CLAIM_BATCH
+ *
+ *    Maximum number of resources that may be claimed with a single batch
+ *    claim IOCTL.
  */
 
+#define CUDDLCI_MAX_CLAIM_BATCH 1024
+
 /**
  * struct cuddlci_void_ioctl_data - IOCTL struct for calls without data.
  *
@@ -283,6 +303,62 @@ struct cuddlci_eventsrc_is_enabled_ioctl_data {
 	struct cuddlci_token token;
 };
 
+/**
+ * struct cuddlci_eventsrc_get_record_ioctl_data - IOCTL data for get_record.
+ *
+ * @version_code: Cuddl version code passed in from user space.
+ * @token: Token for event source to be queried (passed in from user space).
+ * @seq: Event sequence number returned from kernel space.
+ * @timestamp_ns: ``CLOCK_MONOTONIC`` time of the most recent event (in
+ *                nanoseconds) returned from kernel space.
+ */
+struct cuddlci_eventsrc_get_record_ioctl_data {
+	int version_code;
+	struct cuddlci_token token;
+	uint64_t seq;
+	uint64_t timestamp_ns;
+};
+
+/**
+ * struct cuddlci_claim_batch_entry - Batch claim IOCTL entry.
+ *
+ * @id: Resource identifier passed in from user space.
+ * @type: Resource type (``cuddl_resource_type``) passed in from user space.
+ * @options: Memregion or eventsrc claim options passed in from user space.
+ * @result: Claim result for this entry returned from kernel space.
+ * @info: Memory region or event source information returned from kernel
+ *        space, depending on ``type``.
+ */
+struct cuddlci_claim_batch_entry {
+	struct cuddl_resource_id id;
+	int type;
+	int options;
+	int result;
+	union {
+		struct cuddl_memregion_info mem;
+		struct cuddl_eventsrc_info event;
+	} info;
+};
+
+/**
+ * struct cuddlci_claim_batch_ioctl_data - Batch claim IOCTL data.
+ *
+ * @version_code: Cuddl version code passed in from user space.
+ * @pid: Process id passed in from user space.
+ * @count: Number of entries in the ``entries`` array (input).
+ * @failed_index: Index of the entry that caused the batch claim to fail, or
+ *                ``-1`` (output).
+ * @entries: User-space address of an array of ``count``
+ *           ``cuddlci_claim_batch_entry`` structures (input/output).
+ */
+struct cuddlci_claim_batch_ioctl_data {
+	int version_code;
+	pid_t pid;
+	int count;
+	int failed_index;
+	uint64_t entries;
+};
+
 #define CUDDLCI_IOCTL_TYPE 'A'
 
 #define CUDDLCI_MEMREGION_CLAIM_UIO_IOCTL \
@@ -353,4 +429,12 @@ struct cuddlci_eventsrc_is_enabled_ioctl_data {
 #define CUDDLCI_EVENTSRC_IS_ENABLED_IOCTL \
   _IOW(CUDDLCI_IOCTL_TYPE, 27, struct cuddlci_eventsrc_is_enabled_ioctl_data)
 
+#define CUDDLCI_CLAIM_BATCH_UIO_IOCTL \
+  _IOWR(CUDDLCI_IOCTL_TYPE, 28, struct cuddlci_claim_batch_ioctl_data)
+#define CUDDLCI_CLAIM_BATCH_UDD_IOCTL \
+  _IOWR(CUDDLCI_IOCTL_TYPE, 29, struct cuddlci_claim_batch_ioctl_data)
+
+#define CUDDLCI_EVENTSRC_GET_RECORD_IOCTL \
+  _IOWR(CUDDLCI_IOCTL_TYPE, 30, struct cuddlci_eventsrc_get_record_ioctl_data)
+
 #endif /* !_CUDDL_COMMON_IMPL_LINUX_IOCTL_H */
@@ -36,10 +36,33 @@
  *                     claimed by more than one user-space application
  *                     simultaneously.
  *
+ * @CUDDL_MEMF_MAP_UNCACHED: The memory region may be mapped with the
+ *                           ``CUDDL_MEM_MAPF_UNCACHED`` map flag.
+ *
+ * @CUDDL_MEMF_MAP_WRITE_COMBINE: The memory region may be mapped with the
+ *                                ``CUDDL_MEM_MAPF_WRITE_COMBINE`` map flag.
+ *
+ * @CUDDL_MEMF_MAP_CACHED: The memory region may be mapped with the
+ *                         ``CUDDL_MEM_MAPF_CACHED`` map flag.
+ *
+ * @CUDDL_MEMF_MAP_HUGE_PAGES: The memory region is large and aligned enough
+ *                             to be mapped with huge pages, and the platform
+ *                             supports doing so (see
+ *                             ``CUDDL_MEM_MAPF_HUGE_PAGES``).
+ *
+ * @CUDDL_MEMF_DMA: The memory region is a coherent DMA buffer allocated by
+ *                  the kernel.  Its bus address may be obtained via
+ *                  ``cuddl_memregion_get_dma_addr()``.
+ *
  * Flags that describe the properties of a memory region to user-space code.
  */
 enum cuddl_memregion_flags {
-	CUDDL_MEMF_SHARED = (1 << 0),
+	CUDDL_MEMF_SHARED            = (1 << 0),
+	CUDDL_MEMF_MAP_UNCACHED      = (1 << 1),
+	CUDDL_MEMF_MAP_WRITE_COMBINE = (1 << 2),
+	CUDDL_MEMF_MAP_CACHED        = (1 << 3),
+	CUDDL_MEMF_MAP_HUGE_PAGES    = (1 << 4),
+	CUDDL_MEMF_DMA               = (1 << 5),
 };
 
 /**
@@ -58,6 +81,45 @@ enum cuddl_memregion_claim_flags {
 	CUDDL_MEM_CLAIMF_HOSTILE = (1 << 0),
 };
 
+/**
+ * enum cuddl_memregion_map_flags - Flags used when mapping mem regions.
+ *
+ * @CUDDL_MEM_MAPF_UNCACHED: Map the memory region uncached.  Every access
+ *                           reaches the device, in program order.  This is
+ *                           appropriate for device registers.
+ *
+ * @CUDDL_MEM_MAPF_WRITE_COMBINE: Map the memory region with write-combining.
+ *                                Writes may be buffered and merged into
+ *                                bursts, and reads are uncached.  This is
+ *                                appropriate for frame buffers and other
+ *                                device RAM that is mostly written.
+ *
+ * @CUDDL_MEM_MAPF_CACHED: Map the memory region cached (write-back).  This
+ *                         is appropriate for memory regions backed by
+ *                         system RAM.
+ *
+ * @CUDDL_MEM_MAPF_HUGE_PAGES: Map the memory region with huge pages (e.g. 2
+ *                             MiB or 1 GiB pages on x86-64) where alignment
+ *                             permits, to reduce TLB misses when accessing
+ *                             large memory regions.  This flag may be
+ *                             combined with a caching mode.  If the memory
+ *                             region cannot be mapped with huge pages, it is
+ *                             silently mapped with normal pages instead.
+ *
+ * Flags that are applicable to the memory region map operation.  At most
+ * one caching mode may be specified.  If none is specified, the caching
+ * mode is chosen by the platform based on the type of the memory region
+ * (uncached for device memory, and cached for system RAM under Linux).
+ * The kernel driver determines which caching modes each memory region
+ * permits, as indicated by the ``CUDDL_MEMF_MAP_*`` memory region flags.
+ */
+enum cuddl_memregion_map_flags {
+	CUDDL_MEM_MAPF_UNCACHED      = (1 << 0),
+	CUDDL_MEM_MAPF_WRITE_COMBINE = (1 << 1),
+	CUDDL_MEM_MAPF_CACHED        = (1 << 2),
+	CUDDL_MEM_MAPF_HUGE_PAGES    = (1 << 3),
+};
+
 /**
  * struct cuddl_memregion_info - Memory region information for user space.
  *
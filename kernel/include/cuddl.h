@@ -32,8 +32,11 @@
 #define cuddl_ioread8 cuddlk_ioread8
 #define cuddl_ioread16 cuddlk_ioread16
 #define cuddl_ioread32 cuddlk_ioread32
+#define cuddl_ioread64 cuddlk_ioread64
+#define cuddl_ioread64_split cuddlk_ioread64_split
 #define cuddl_iowrite8 cuddlk_iowrite8
 #define cuddl_iowrite16 cuddlk_iowrite16
 #define cuddl_iowrite32 cuddlk_iowrite32
+#define cuddl_iowrite64 cuddlk_iowrite64
 
 #endif /* !_CUDDL_H */
@@ -53,14 +53,15 @@
  *
  *    Maximum number of event sources allowed for a single Cuddl device.
  *
- *    Currently only one event source per Cuddl device is supported.
- *    Removing this limitation should be possible, but it would require
- *    substantial changes in the implementation because this feature is not
- *    supported natively under Linux UIO and Xenomai UDD.
+ *    Each event source may be waited on, enabled, disabled, and claimed
+ *    independently of the others.  Linux UIO and Xenomai UDD only support
+ *    one interrupt per device, so the first event source shares the device
+ *    nodes of the memory regions, and each additional event source that
+ *    has a name gets device nodes of its own.
  */
 
 #define CUDDLK_MAX_DEV_MEM_REGIONS 5
-#define CUDDLK_MAX_DEV_EVENTS 1
+#define CUDDLK_MAX_DEV_EVENTS 4
 
 /**
  * typedef cuddlk_parent_device_t - Parent device type.
@@ -150,6 +151,10 @@ struct cuddlk_device_kernel {
  *             On Linux, this field should be a pointer to the ``struct
  *             module`` that registers the device (e.g. ``THIS_MODULE``).  If
  *             this field is not set, the ``cuddl`` module will be the owner.
+ *             Memory regions of the device that are mapped via the
+ *             ``/dev/cuddl`` manager device hold a reference on the owner
+ *             until they are unmapped, so the owner module cannot be
+ *             unloaded while such mappings exist.
  *
  *             This field is not used on RTEMS.
  *
@@ -172,14 +177,18 @@ struct cuddlk_device_kernel {
  *
  *   Interrupt event device name: /dev/rtdm/<UNIQUE_NAME>
  *   Memory region 0 device name: /dev/rtdm/<UNIQUE_NAME>,mapper0
+ *   Event source 1  device name: /dev/rtdm/<UNIQUE_NAME>.event1
  *
  * where ``<UNIQUE_NAME>`` is equivalent to ``<GROUP>.<NAME>.<INSTANCE>``.
+ * The interrupt event device serves event source 0, and each additional
+ * event source is served by a device named after its slot.
  *
  * Under Linux UIO, the value of ``<UNIQUE_NAME>`` can be read from a file::
  *
  *   e.g. /sys/class/uio/uio0/name
  *
- * The UIO device name itself, however, is simply generated from the
+ * (with ``<UNIQUE_NAME>.event<N>`` for each additional event source).  The
+ * UIO device name itself, however, is simply generated from the
  * registration order::
  *
  *   /dev/uio0
@@ -249,6 +258,10 @@ int cuddlk_device_find_eventsrc_slot(
  * This routine is automatically called from ``cuddlk_device_manage()``, so
  * Cuddl drivers do not typically need to call this routine directly.
  *
+ * The buffers of any ``CUDDLK_MEMT_DMA`` memory regions are allocated here,
+ * and are released by ``cuddlk_device_unregister()``.  A buffer that is
+ * still mapped into a process is only freed once it has been unmapped.
+ *
  * Linux UIO equivalent in *linux/uio_driver.h*::
  *
  *   int uio_register_device(struct device *parent, struct uio_info *info);
@@ -260,7 +273,8 @@ int cuddlk_device_find_eventsrc_slot(
  * Return: ``0`` on success, or a negative error code.
  *
  *   Error codes:
- *     - ``-EINVAL``: Invalid ``group`` or ``name`` argument.
+ *     - ``-EINVAL``: Invalid ``group`` or ``name`` argument, or a
+ *       ``CUDDLK_MEMT_DMA`` memory region has ``pa_addr`` set or no size.
  *     - ``-ENOMEM``: Memory allocation error.
  *     - Error code returned by ``uio_device_register()`` (Linux).
  *     - Error code returned by ``udd_register_device()`` (Xenomai UDD).
@@ -321,4 +335,43 @@ int cuddlk_device_manage(struct cuddlk_device *dev);
  */
 int cuddlk_device_release(struct cuddlk_device *dev);
 
+/**
+ * cuddlk_devices_manage() - Register and manage several Cuddl devices.
+ *
+ * @devs: Array of Cuddl devices to manage.
+ *
+ * @n_devs: Number of elements in the ``devs`` array.
+ *
+ * Equivalent to calling ``cuddlk_device_manage()`` for each device in
+ * order, except that the global device manager is only locked once.  This is
+ * intended for drivers that expose many logical devices (e.g. one per channel
+ * of a multi-channel card).  If any device cannot be managed, the devices
+ * that were already managed by this call are released again.
+ *
+ * Return: ``0`` on success, or a negative error code.
+ *
+ *   Error codes:
+ *     - Error codes returned by ``cuddlk_device_manage()``.
+ */
+int cuddlk_devices_manage(struct cuddlk_device **devs, int n_devs);
+
+/**
+ * cuddlk_devices_release() - Release and unregister several managed Cuddl
+ *                            devices.
+ *
+ * @devs: Array of managed Cuddl devices to release.
+ *
+ * @n_devs: Number of elements in the ``devs`` array.
+ *
+ * Equivalent to calling ``cuddlk_device_release()`` for each device in
+ * reverse order, except that the global device manager is only locked once.
+ * All devices are released, even if an error occurs.
+ *
+ * Return: ``0`` on success, or the first negative error code encountered.
+ *
+ *   Error codes:
+ *     - Error codes returned by ``cuddlk_device_release()``.
+ */
+int cuddlk_devices_release(struct cuddlk_device **devs, int n_devs);
+
 #endif /* !_CUDDLK_DEVICE_H */
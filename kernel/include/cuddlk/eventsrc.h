@@ -62,7 +62,9 @@ struct cuddlk_eventsrc_kernel {
 /**
  * struct cuddlk_eventsrc - Event source information (kernel-space).
  *
- * @name: Name used to identify the event source.
+ * @name: Name used to identify the event source.  Event sources other than
+ *        the first one in a device's ``events`` array are only registered
+ *        if they are named.
  *
  * @flags: Flags that describe the properties of the event source.  This
  *         field may be a set of ``cuddlk_eventsrc_flags`` ORed together.
@@ -113,4 +115,22 @@ struct cuddlk_eventsrc {
  */
 void cuddlk_eventsrc_notify(struct cuddlk_eventsrc *eventsrc);
 
+/**
+ * cuddlk_eventsrc_report_enabled() - Publish the event source enable state.
+ *
+ * Update the enabled/disabled state shown in the event source status page
+ * that user-space applications may map in order to query the state without
+ * a system call.  Cuddl updates this state automatically when the event
+ * source is enabled, disabled, or queried through Cuddl, so this routine
+ * only needs to be called by drivers that change the state on their own
+ * (e.g. an interrupt handler that masks the interrupt source).
+ *
+ * This routine may be called from interrupt context.
+ *
+ * @eventsrc: Event source to update.
+ * @enabled: ``1`` if the event source is enabled, ``0`` if it is disabled.
+ */
+void cuddlk_eventsrc_report_enabled(
+	struct cuddlk_eventsrc *eventsrc, int enabled);
+
 #endif /* !_CUDDLK_EVENTSRC_H */
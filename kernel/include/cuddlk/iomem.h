@@ -112,6 +112,65 @@ inline void cuddlk_iowrite32(uint32_t value, cuddlk_iomem_t *addr)
 	(*(volatile uint32_t *) (addr)) = value;
 }
 
+/**
+ * cuddlk_ioread64() - Read a 64-bit value from device I/O memory.
+ *
+ * @addr: I/O memory address for reading.
+ *
+ * On 32-bit platforms, the access may be split into two 32-bit accesses
+ * (low word first).  Use ``cuddlk_ioread64_split()`` for registers that may
+ * change between the two halves being read.
+ *
+ * Return: Value that results from reading the specified memory address.
+ */
+inline uint64_t cuddlk_ioread64(cuddlk_iomem_t *addr)
+{
+	return *(volatile uint64_t *) (addr);
+}
+
+/**
+ * cuddlk_iowrite64() - Write a 64-bit value to device I/O memory.
+ *
+ * @value: Value to be written.
+ * @addr: I/O memory address for writing.
+ *
+ * On 32-bit platforms, the access may be split into two 32-bit accesses
+ * (low word first).
+ */
+inline void cuddlk_iowrite64(uint64_t value, cuddlk_iomem_t *addr)
+{
+	(*(volatile uint64_t *) (addr)) = value;
+}
+
 #endif /* CUDDLK_LINUX */
 
+/**
+ * cuddlk_ioread64_split() - Read a 64-bit counter split over two registers.
+ *
+ * @lo: I/O memory address of the register holding the low 32 bits.
+ * @hi: I/O memory address of the register holding the high 32 bits.
+ *
+ * Read a free-running 64-bit value (such as a timestamp counter) that is
+ * exposed as two 32-bit registers, without tearing.  The high register is
+ * read before and after the low register, and the sequence is retried if
+ * the low register wrapped in between.
+ *
+ * Return: Value that results from reading the specified registers.
+ */
+static inline uint64_t cuddlk_ioread64_split(
+	cuddlk_iomem_t *lo, cuddlk_iomem_t *hi)
+{
+	uint32_t h, l, h2;
+
+	h = cuddlk_ioread32(hi);
+	for (;;) {
+		l = cuddlk_ioread32(lo);
+		h2 = cuddlk_ioread32(hi);
+		if (h2 == h)
+			break;
+		h = h2;
+	}
+	return ((uint64_t) h << 32) | l;
+}
+
 #endif /* !_CUDDLK_IOMEM_H */
@@ -33,9 +33,14 @@
  * .. c:macro:: CUDDLK_MAX_MANAGED_DEVICES
  *
  *    Maximum number of Cuddl devices that can be managed.
+ *
+ * .. c:macro:: CUDDLK_MANAGER_HASH_BUCKETS
+ *
+ *    Number of buckets in the device manager's (group, name) hash index.
  */
 
-#define CUDDLK_MAX_MANAGED_DEVICES 256
+#define CUDDLK_MAX_MANAGED_DEVICES 4096
+#define CUDDLK_MANAGER_HASH_BUCKETS 1024
 
 /**
  * enum cuddlk_resource - Types of device resources.
@@ -60,6 +65,26 @@ enum cuddlk_resource {
  *
  * @devices: Array of pointers to the devices currently being managed.
  *
+ * @hash_heads: Heads of the hash chains used to look up devices by group and
+ *              device name.  Each element holds the ``devices`` array index
+ *              of the first device in the chain plus one, or ``0`` if the
+ *              chain is empty.  Each chain is sorted by instance number.
+ *
+ * @hash_next: Links of the hash chains, indexed like ``devices``.  Each
+ *             element holds the index of the next device in the chain plus
+ *             one, or ``0`` at the end of the chain.
+ *
+ * @free_next: Links of the list of emptied slots, indexed like ``devices``.
+ *             Each element holds the index of the next emptied slot plus one,
+ *             or ``0`` at the end of the list.
+ *
+ * @free_slots: Index of the most recently emptied slot of the ``devices``
+ *              array plus one, or ``0`` if no slots have been emptied.
+ *
+ * @n_slots_used: Number of slots at the start of the ``devices`` array that
+ *                have ever been used.  Slots at or beyond this index are
+ *                empty.
+ *
  * @priv: Private memory region data reserved for internal use by the Cuddl
  *        implementation.
  *
@@ -77,6 +102,11 @@ enum cuddlk_resource {
  */
 struct cuddlk_manager {
 	struct cuddlk_device *devices[CUDDLK_MAX_MANAGED_DEVICES];
+	int hash_heads[CUDDLK_MANAGER_HASH_BUCKETS];
+	int hash_next[CUDDLK_MAX_MANAGED_DEVICES];
+	int free_next[CUDDLK_MAX_MANAGED_DEVICES];
+	int free_slots;
+	int n_slots_used;
 	struct cuddlki_manager_priv priv;
 };
 
@@ -113,14 +143,15 @@ void cuddlk_manager_unlock(void);
  * @manager: Cuddl manager instance.
  * @dev: Cuddl device to manage.
  *
- * Add the specified device to the device manager's ``devices`` array.  This
- * routine is automatically called from ``cuddlk_device_manage()``, so Cuddl
- * drivers do not typically need to call this routine directly.
- *
+ * Add the specified device to the device manager's ``devices`` array and
+ * hash index.  This routine is automatically called from
+ * ``cuddlk_device_manage()``, so Cuddl drivers do not typically need to call
+ * this routine directly.
  *
  * Return: ``0`` on success, or a negative error code.
  *
  *   Error codes:
+ *     - ``-EINVAL``: The device group or name is ``NULL``.
  *     - ``-ENOMEM``: No empty device slots available.
  */
 int cuddlk_manager_add_device(
@@ -132,8 +163,10 @@ int cuddlk_manager_add_device(
  * @manager: Cuddl manager instance.
  * @dev: Cuddl device to stop managing.
  *
- * Remove the specified device from the device manager's ``devices`` array.
- * This routine is automatically called from ``cuddlk_device_release()``, so
+ * Remove the specified device from the device manager's ``devices`` array
+ * and hash index, and wait until no read-only manager queries (which do not
+ * take the manager lock on Linux) can still be using the device.  This
+ * routine is automatically called from ``cuddlk_device_release()``, so
  * Cuddl drivers do not typically need to call this routine directly.
  *
  * Return: ``0`` on success, or a negative error code.
@@ -162,7 +195,10 @@ int cuddlk_manager_remove_device(
  * @start_index: Index in device array to start the search.
  *
  * Search the device manager's ``devices`` array for an entry matching the
- * specified (non-``NULL``) parameters.
+ * specified (non-``NULL``) parameters.  The lowest matching index at or
+ * after ``start_index`` is returned.  If both ``group`` and ``name`` are
+ * specified, only the devices on the corresponding hash chain are examined;
+ * otherwise, the whole array is searched.
  *
  * Return: Index of a matching device in the ``devices`` array on success, or
  * a negative error code.
@@ -181,7 +217,9 @@ int cuddlk_manager_find_device_slot_matching(
  * @manager: Cuddl manager instance.
  * @dev: Cuddl device to search for.
  *
- * Search the device manager's ``devices`` array for the specified device.
+ * Search the device manager's hash index for the specified device.  If
+ * ``dev`` is ``NULL``, this is equivalent to calling
+ * ``cuddlk_manager_find_empty_slot()``.
  *
  * Return: Index of matching device in the ``devices`` array on success, or a
  * negative error code.
@@ -197,25 +235,26 @@ int cuddlk_manager_find_device_slot(
  *
  * @manager: Cuddl manager instance.
  *
- * Search the device manager's ``devices`` array for an empty device slot.
- * This routine is not typically called directly by Cuddl kernel drivers.
+ * Return the ``devices`` array slot that the next call to
+ * ``cuddlk_manager_add_device()`` will use.  The most recently emptied slot
+ * is reused first, so this routine does not need to search the array.  This
+ * routine is not typically called directly by Cuddl kernel drivers.
  *
- * Return: Index of first empty slot in the ``devices`` array on success, or
- * a negative error code.
+ * Return: Index of an empty slot in the ``devices`` array on success, or a
+ * negative error code.
  *
  *   Error codes:
- *     - Error code returned by ``cuddlk_manager_find_device_slot()``.
+ *     - ``-ENXIO``: No empty slots are available.
  */
 int cuddlk_manager_find_empty_slot(struct cuddlk_manager *manager);
 
 /**
  * cuddlk_manager_next_available_instance_id() - Find next unique instance id.
  *
- * Search the device manager's ``devices`` array for devices with a ``group``
- * and ``name`` combination matching the specified device.  The next
- * available instance identifier that is not used by one of the found devices
- * will be returned.  This routine is not typically called directly by Cuddl
- * kernel drivers.
+ * Search the device manager's hash index for devices with a ``group`` and
+ * ``name`` combination matching the specified device.  The lowest instance
+ * identifier that is not used by one of the found devices will be returned.
+ * This routine is not typically called directly by Cuddl kernel drivers.
  *
  * @manager: Cuddl manager instance.
  * @dev: Cuddl device supplying the ``group`` and ``name`` fields to search
@@ -225,6 +264,7 @@ int cuddlk_manager_find_empty_slot(struct cuddlk_manager *manager);
  * negative error code.
  *
  *   Error codes:
+ *     - ``-EINVAL``: The device group or name is ``NULL``.
  *     - ``-ENOMEM``: No empty managed device slots are available.
  */
 int  cuddlk_manager_next_available_instance_id(
@@ -44,6 +44,18 @@
  *
  * @CUDDLK_MEMT_VIRTUAL: Virtual memory region (e.g. from ``vmalloc()``).
  *
+ * @CUDDLK_MEMT_DMA: Coherent DMA buffer allocated by the Cuddl
+ *                   implementation when the parent device is registered.
+ *                   The driver specifies the size of the buffer via ``len``
+ *                   (and optionally ``pa_len``), and must leave ``pa_addr``
+ *                   unset.  On registration, ``pa_addr`` is set to the
+ *                   kernel virtual address of the buffer, and
+ *                   ``kernel.dma_addr`` is set to its bus address.  If the
+ *                   ``parent_device_ptr`` of the device is not set, the
+ *                   buffer is allocated from system RAM and its physical
+ *                   address is used as the bus address, which allows DMA
+ *                   designs to be tested without a DMA-capable device.
+ *
  * This type enumerates the types of memory regions that may be exposed to
  * user-space code.  These are the possible values for the ``type`` member of
  * the ``cuddlk_memregion`` struct.
@@ -59,15 +71,21 @@
  * values.  Our implementation currently relies on this condition, so we
  * confirm this via compile-time assertions in *cuddlk_linux.c*.  We also
  * assume ``CUDDLK_MEMT_NONE`` is ``0`` for proper default initialization, so
- * that condition is checked as well.
+ * that condition is checked as well.  ``CUDDLK_MEMT_DMA`` has no Linux UIO
+ * or Xenomai UDD equivalent, so DMA buffers may only be mapped via the
+ * Cuddl manager device.
  */
 enum cuddlk_memregion_type {
 	CUDDLK_MEMT_NONE    = CUDDLKI_MEMT_NONE,
 	CUDDLK_MEMT_PHYS    = CUDDLKI_MEMT_PHYS,
 	CUDDLK_MEMT_LOGICAL = CUDDLKI_MEMT_LOGICAL,
 	CUDDLK_MEMT_VIRTUAL = CUDDLKI_MEMT_VIRTUAL,
+	CUDDLK_MEMT_DMA     = CUDDLKI_MEMT_DMA,
 };
 
+/* OS-specific type used to represent a DMA bus address. */
+typedef cuddlki_dma_addr_t cuddlk_dma_addr_t;
+
 /** 
  * enum cuddlk_memregion_flags - Memory region flags for kernel space.
  *
@@ -75,11 +93,29 @@ enum cuddlk_memregion_type {
  *                      claimed by more than one user-space application
  *                      simultaneously.
  *
+ * @CUDDLK_MEMF_ALLOW_WRITE_COMBINE: Allow user-space applications to map
+ *                                   this ``CUDDLK_MEMT_PHYS`` memory region
+ *                                   with write-combining (e.g. for frame
+ *                                   buffers in prefetchable device memory).
+ *
+ * @CUDDLK_MEMF_ALLOW_CACHED: Allow user-space applications to map this
+ *                            ``CUDDLK_MEMT_PHYS`` memory region cached
+ *                            (e.g. for reserved system RAM).
+ *
  * Flags that describe the properties of a memory region.  These may be used
  * in the ``flags`` member of the ``cuddlk_memregion`` struct.
+ *
+ * ``CUDDLK_MEMT_PHYS`` memory regions may always be mapped uncached, and
+ * may only be mapped with write-combining or cached if the driver sets the
+ * corresponding flag.  ``CUDDLK_MEMT_LOGICAL`` and ``CUDDLK_MEMT_VIRTUAL``
+ * memory regions (which are backed by system RAM) may only be mapped
+ * cached, because mapping RAM with conflicting cache attributes is not
+ * permitted on many architectures.
  */
 enum cuddlk_memregion_flags {
-	CUDDLK_MEMF_SHARED = (1 << 0),
+	CUDDLK_MEMF_SHARED              = (1 << 0),
+	CUDDLK_MEMF_ALLOW_WRITE_COMBINE = (1 << 1),
+	CUDDLK_MEMF_ALLOW_CACHED        = (1 << 2),
 };
 
 /**
@@ -89,11 +125,16 @@ enum cuddlk_memregion_flags {
  *             memory region.  This should be either ``0`` or ``1`` unless
  *             the memory region has the ``CUDDLK_MEMF_SHARED`` flag set.
  *
+ * @dma_addr: Bus address of a ``CUDDLK_MEMT_DMA`` buffer, to be programmed
+ *            into the device.  This is set when the parent device is
+ *            registered.
+ *
  * Kernel-managed ``cuddlk_memregion`` data members that are available for
  * use by Cuddl drivers.
  */
 struct cuddlk_memregion_kernel {
 	int ref_count;
+	cuddlk_dma_addr_t dma_addr;
 };
 
 /**
@@ -39,7 +39,16 @@
 
 #include <linux/version.h>
 #include <linux/uio_driver.h>
+#include <linux/mm.h>
+#include <linux/slab.h>
+#include <linux/kref.h>
+#include <linux/dma-mapping.h>
+#include <linux/percpu.h>
+#include <linux/spinlock.h>
+#include <linux/srcu.h>
+#include <linux/timekeeping.h>
 #include <asm/io.h>
+#include <linux/io-64-nonatomic-lo-hi.h>
 
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(6,4,0)
   #define class_create_compat(a, b) class_create(b)
@@ -47,6 +56,21 @@
   #define class_create_compat(a, b) class_create(a, b)
 #endif
 
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6,3,0)
+  #define vm_flags_clear_compat(vma, flags) vm_flags_clear(vma, flags)
+  #define vm_flags_set_compat(vma, flags) vm_flags_set(vma, flags)
+#else
+  #define vm_flags_clear_compat(vma, flags) ((vma)->vm_flags &= ~(flags))
+  #define vm_flags_set_compat(vma, flags) ((vma)->vm_flags |= (flags))
+#endif
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6,17,0)
+  #define pfn_dev_compat(pfn) (pfn)
+#else
+  #include <linux/pfn_t.h>
+  #define pfn_dev_compat(pfn) __pfn_to_pfn_t(pfn, PFN_DEV)
+#endif
+
 #define CUDDLK_PAGE_SIZE PAGE_SIZE
 
 #define cuddlk_ioread8  ioread8
@@ -57,10 +81,16 @@
 #define cuddlk_iowrite16 iowrite16
 #define cuddlk_iowrite32 iowrite32
 
+/* Split into two 32-bit accesses (low first) on 32-bit kernels */
+#define cuddlk_ioread64  ioread64
+#define cuddlk_iowrite64 iowrite64
+
 #define CUDDLKI_MEMT_NONE    UIO_MEM_NONE
 #define CUDDLKI_MEMT_PHYS    UIO_MEM_PHYS
 #define CUDDLKI_MEMT_LOGICAL UIO_MEM_LOGICAL
 #define CUDDLKI_MEMT_VIRTUAL UIO_MEM_VIRTUAL
+/* Cuddl-specific (never passed to Linux UIO or Xenomai UDD) */
+#define CUDDLKI_MEMT_DMA     0x100
 
 #if defined(CUDDLK_USE_UDD)
   #include <rtdm/udd.h>
@@ -99,15 +129,178 @@ typedef void __iomem cuddlki_iomem_t;
 
 typedef struct device cuddlki_parent_device_t;
 
+typedef dma_addr_t cuddlki_dma_addr_t;
+
 typedef struct module cuddlki_owner_t;
 
 extern struct device *cuddlk_manager_device;
 
+/* Number of log2 buckets in each latency histogram */
+#define CUDDLKI_STATS_HIST_BUCKETS 32
+
+/**
+ * struct cuddlki_eventsrc_stats - Per-CPU event source statistics.
+ *
+ * @irqs_seen: Number of times the interrupt handler was invoked.
+ * @irqs_handled: Number of interrupts claimed by the handler.
+ * @irqs_not_handled: Number of interrupts rejected by the handler (e.g.
+ *                    interrupts raised by another device on a shared line).
+ * @notifications: Number of calls to ``cuddlk_eventsrc_notify()``.
+ * @claims: Number of successful claims.
+ * @claims_busy: Number of claims rejected because the event source was
+ *               already claimed.
+ * @releases: Number of releases.
+ * @handler_ns_hist: Histogram of interrupt handler (top-half) execution
+ *                   times.  Bucket ``0`` counts durations of ``0`` ns and
+ *                   bucket ``N`` counts durations in the range
+ *                   [2^(N-1), 2^N) ns.  The last bucket also counts all
+ *                   longer durations.
+ */
+struct cuddlki_eventsrc_stats {
+	u64 irqs_seen;
+	u64 irqs_handled;
+	u64 irqs_not_handled;
+	u64 notifications;
+	u64 claims;
+	u64 claims_busy;
+	u64 releases;
+	u64 handler_ns_hist[CUDDLKI_STATS_HIST_BUCKETS];
+};
+
+/**
+ * struct cuddlki_memregion_stats - Per-CPU memory region statistics.
+ *
+ * @claims: Number of successful claims.
+ * @claims_busy: Number of claims rejected because the memory region was
+ *               already claimed.
+ * @releases: Number of releases.
+ */
+struct cuddlki_memregion_stats {
+	u64 claims;
+	u64 claims_busy;
+	u64 releases;
+};
+
+/*
+ * Statistics are updated with per-CPU operations, so the hot paths never
+ * share a cache line between CPUs.  A NULL stats pointer (allocation
+ * failure or an unregistered device) simply disables accounting.
+ */
+#if defined(CUDDLK_DISABLE_STATS)
+  #define cuddlki_stats_inc(stats, field) do { } while (0)
+  #define cuddlki_stats_clock_ns() 0
+#else
+  #define cuddlki_stats_inc(stats, field) \
+	do { if (stats) this_cpu_inc((stats)->field); } while (0)
+  #define cuddlki_stats_clock_ns() cuddlki_event_clock_ns()
+#endif
+
+static inline int cuddlki_stats_hist_bucket(u64 ns)
+{
+	int bucket = fls64(ns);
+
+	if (bucket >= CUDDLKI_STATS_HIST_BUCKETS)
+		bucket = CUDDLKI_STATS_HIST_BUCKETS - 1;
+	return bucket;
+}
+
+/**
+ * struct cuddlki_dma_buffer - Reference-counted coherent DMA buffer.
+ *
+ * @kref: References held by the memory region and by its mappings.
+ * @dev: Device the buffer was allocated for (a reference is held on it).
+ * @size: Size of the buffer in bytes.
+ * @cpu_addr: Kernel virtual address of the buffer.
+ * @dma_addr: Bus address of the buffer.
+ *
+ * Buffers from ``dma_alloc_coherent()`` are mapped via
+ * ``dma_mmap_coherent()``, which does not reference the underlying pages, so
+ * the buffer is only freed once the memory region and all of its mappings
+ * have dropped their references.
+ */
+struct cuddlki_dma_buffer {
+	struct kref kref;
+	struct device *dev;
+	size_t size;
+	void *cpu_addr;
+	dma_addr_t dma_addr;
+};
+
+/**
+ * cuddlki_dma_buffer_alloc() - Allocate a reference-counted DMA buffer.
+ *
+ * @dev: Device to allocate the buffer for.
+ * @size: Size of the buffer in bytes.
+ *
+ * Return: Pointer to the new buffer (holding one reference), or ``NULL`` if
+ * it could not be allocated.
+ */
+static inline struct cuddlki_dma_buffer *cuddlki_dma_buffer_alloc(
+	struct device *dev, size_t size)
+{
+	struct cuddlki_dma_buffer *buf;
+
+	buf = kzalloc(sizeof(*buf), GFP_KERNEL);
+	if (!buf)
+		return NULL;
+	buf->cpu_addr = dma_alloc_coherent(dev, size, &buf->dma_addr,
+					   GFP_KERNEL);
+	if (!buf->cpu_addr) {
+		kfree(buf);
+		return NULL;
+	}
+	kref_init(&buf->kref);
+	buf->dev = get_device(dev);
+	buf->size = size;
+	return buf;
+}
+
+static inline void cuddlki_dma_buffer_release(struct kref *kref)
+{
+	struct cuddlki_dma_buffer *buf =
+		container_of(kref, struct cuddlki_dma_buffer, kref);
+
+	dma_free_coherent(buf->dev, buf->size, buf->cpu_addr, buf->dma_addr);
+	put_device(buf->dev);
+	kfree(buf);
+}
+
+/**
+ * cuddlki_dma_buffer_get() - Take a reference on a DMA buffer.
+ *
+ * @buf: DMA buffer.
+ *
+ * Return: ``buf``
+ */
+static inline struct cuddlki_dma_buffer *cuddlki_dma_buffer_get(
+	struct cuddlki_dma_buffer *buf)
+{
+	kref_get(&buf->kref);
+	return buf;
+}
+
+/**
+ * cuddlki_dma_buffer_put() - Drop a reference on a DMA buffer.
+ *
+ * @buf: DMA buffer (may be ``NULL``).
+ *
+ * The buffer is freed when the last reference is dropped.
+ */
+static inline void cuddlki_dma_buffer_put(struct cuddlki_dma_buffer *buf)
+{
+	if (buf)
+		kref_put(&buf->kref, cuddlki_dma_buffer_release);
+}
+
 /**
  * struct cuddlki_memregion_priv - Private kernel memory region data.
  *
  * @uio_ptr: Pointer to the associated Linux UIO device.
  * @ref_mutex: Mutex protecting ref_count.
+ * @stats: Per-CPU statistics (``NULL`` if unavailable).
+ * @dma_buf: Buffer of a ``CUDDLK_MEMT_DMA`` memory region allocated via
+ *           ``dma_alloc_coherent()``, or ``NULL`` if the buffer was
+ *           allocated from system RAM.
  *
  * This data structure contains private, platform-specific data members
  * reserved for internal use by the Cuddl implementation.
@@ -115,6 +308,8 @@ extern struct device *cuddlk_manager_device;
 struct cuddlki_memregion_priv {
 	struct uio_info *uio_ptr;
 	struct mutex ref_mutex;
+	struct cuddlki_memregion_stats __percpu *stats;
+	struct cuddlki_dma_buffer *dma_buf;
 };
 
 /**
@@ -122,6 +317,9 @@ struct cuddlki_memregion_priv {
  *
  * @irqh: Xenomai RTDM interrupt data structure.
  *
+ * @name: Name passed to ``cuddlk_interrupt_register()`` for stand-alone
+ *        interrupt handlers, reported by the interrupt trace events.
+ *
  * This data structure contains private, platform-specific data members
  * reserved for internal use by the Cuddl implementation.
  */
@@ -129,11 +327,34 @@ struct cuddlki_interrupt_priv {
 #if defined(CUDDLK_USE_UDD)
 	rtdm_irq_t irqh;
 #endif
+	const char *name;
+};
+
+#if defined(CUDDLK_USE_UDD)
+struct cuddlk_eventsrc;
+
+/**
+ * struct cuddlki_udd_device - Xenomai UDD device serving an event source.
+ *
+ * @udd: The Xenomai UDD device.
+ * @eventsrc: Event source served by the UDD device.
+ *
+ * Xenomai UDD devices carry no private data pointer, so this wrapper lets
+ * the UDD callbacks find the event source that a UDD device serves.
+ */
+struct cuddlki_udd_device {
+	struct udd_device udd;
+	struct cuddlk_eventsrc *eventsrc;
 };
+#endif
 
 /**
  * struct cuddlki_eventsrc_priv - Private kernel event source data.
  *
+ * @unique_name: Unique name of the UIO/UDD device nodes of an additional
+ *               event source (``NULL`` if not registered).
+ * @uio: Linux UIO device of an additional event source.
+ * @udd: Xenomai UDD device of an additional event source.
  * @uio_open_count: Count of open Linux UIO file descriptors.
  * @uio_ptr: Pointer to the associated Linux UIO device.
  * @udd_open_count: Count of open Xenomai UDD file descriptors.
@@ -141,28 +362,216 @@ struct cuddlki_interrupt_priv {
  * @nrt_sig: Xenomai real-time/non-real-time signaling mechanism.
  * @ref_mutex: Mutex protecting ref_count.
  * @open_mutex: Mutex protecting the open counts.
+ * @event_lock: Lock serializing updates of the status page.
+ * @status_page: Page holding the event source status.  The page is
+ *               reference counted, so it remains valid for as long as
+ *               user space keeps it mapped, even after the event source is
+ *               unregistered.
+ * @status: Kernel virtual address of ``status_page``.
+ * @stats: Per-CPU statistics (``NULL`` if unavailable).
+ *
+ * Linux UIO and Xenomai UDD devices only support one interrupt each.  The
+ * first event source of a device is served by the device's own UIO/UDD
+ * device (which also maps the memory regions), and each additional event
+ * source is served by a UIO/UDD device of its own (with no memory maps),
+ * so ``uio_ptr`` and ``udd_ptr`` point to one or the other.
  *
  * This data structure contains private, platform-specific data members
  * reserved for internal use by the Cuddl implementation.
  */
 struct cuddlki_eventsrc_priv {
+	char *unique_name;
+	struct uio_info uio;
+#if defined(CUDDLK_USE_UDD)
+	struct cuddlki_udd_device udd;
+#endif
 	int uio_open_count;
 	struct uio_info *uio_ptr;
 #if defined(CUDDLK_USE_UDD)
 	int udd_open_count;
 	struct udd_device *udd_ptr;
 	rtdm_nrtsig_t nrt_sig;
+	rtdm_lock_t event_lock;
+#else
+	raw_spinlock_t event_lock;
 #endif
 	struct mutex ref_mutex;
 	struct mutex open_mutex;
+	struct page *status_page;
+	struct cuddlci_eventsrc_status *status;
+	struct cuddlki_eventsrc_stats __percpu *stats;
 };
 
+#if defined(CUDDLK_USE_UDD)
+  #define cuddlki_event_lock_flags_t rtdm_lockctx_t
+  #define cuddlki_event_lock(priv, flags) \
+	rtdm_lock_get_irqsave(&(priv)->event_lock, flags)
+  #define cuddlki_event_unlock(priv, flags) \
+	rtdm_lock_put_irqrestore(&(priv)->event_lock, flags)
+  #define cuddlki_event_clock_ns() rtdm_clock_read_monotonic()
+#else
+  #define cuddlki_event_lock_flags_t unsigned long
+  #define cuddlki_event_lock(priv, flags) \
+	raw_spin_lock_irqsave(&(priv)->event_lock, flags)
+  #define cuddlki_event_unlock(priv, flags) \
+	raw_spin_unlock_irqrestore(&(priv)->event_lock, flags)
+  #define cuddlki_event_clock_ns() ktime_get_ns()
+#endif
+
+/**
+ * cuddlki_eventsrc_init_status() - Allocate an event source's status page.
+ *
+ * @priv: Private event source data.
+ *
+ * Return: ``0`` on success, or ``-ENOMEM`` if the page could not be
+ * allocated.
+ */
+static inline int cuddlki_eventsrc_init_status(
+	struct cuddlki_eventsrc_priv *priv)
+{
+#if defined(CUDDLK_USE_UDD)
+	rtdm_lock_init(&priv->event_lock);
+#else
+	raw_spin_lock_init(&priv->event_lock);
+#endif
+	priv->status_page = alloc_page(GFP_KERNEL | __GFP_ZERO);
+	if (!priv->status_page)
+		return -ENOMEM;
+	priv->status = page_address(priv->status_page);
+	priv->status->enabled = CUDDLCI_EVENTSRC_STATUS_ENABLED_UNKNOWN;
+	return 0;
+}
+
+/**
+ * cuddlki_eventsrc_free_status() - Drop the kernel's status page reference.
+ *
+ * @priv: Private event source data.
+ */
+static inline void cuddlki_eventsrc_free_status(
+	struct cuddlki_eventsrc_priv *priv)
+{
+	if (priv->status_page)
+		put_page(priv->status_page);
+	priv->status_page = NULL;
+	priv->status = NULL;
+}
+
+/*
+ * Status page writers bracket their updates with these routines, which must
+ * be called with event_lock held.  The sequence counter lives in the shared
+ * page (rather than in a seqcount_t) so that user space can use it too.
+ */
+static inline void cuddlki_eventsrc_status_write_begin(
+	struct cuddlci_eventsrc_status *status)
+{
+	WRITE_ONCE(status->sequence, status->sequence + 1);
+	smp_wmb();
+}
+
+static inline void cuddlki_eventsrc_status_write_end(
+	struct cuddlci_eventsrc_status *status)
+{
+	smp_wmb();
+	WRITE_ONCE(status->sequence, status->sequence + 1);
+}
+
+/**
+ * cuddlki_eventsrc_record_event() - Record the occurrence of an event.
+ *
+ * @priv: Private event source data.
+ *
+ * Increment the event sequence number and capture the current
+ * ``CLOCK_MONOTONIC`` time.  This is called from the top-half interrupt
+ * handler (or ``cuddlk_eventsrc_notify()``), so it is safe to call from
+ * hard interrupt context (and from the Xenomai primary domain for UDD).
+ */
+static inline void cuddlki_eventsrc_record_event(
+	struct cuddlki_eventsrc_priv *priv)
+{
+	cuddlki_event_lock_flags_t flags;
+	u64 now = cuddlki_event_clock_ns();
+
+	cuddlki_event_lock(priv, flags);
+	cuddlki_eventsrc_status_write_begin(priv->status);
+	WRITE_ONCE(priv->status->event_seq, priv->status->event_seq + 1);
+	WRITE_ONCE(priv->status->timestamp_ns, now);
+	cuddlki_eventsrc_status_write_end(priv->status);
+	cuddlki_event_unlock(priv, flags);
+}
+
+/**
+ * cuddlki_eventsrc_set_enabled() - Publish the enabled/disabled state.
+ *
+ * @priv: Private event source data.
+ * @enabled: ``1`` if enabled, ``0`` if disabled.
+ */
+static inline void cuddlki_eventsrc_set_enabled(
+	struct cuddlki_eventsrc_priv *priv, int enabled)
+{
+	cuddlki_event_lock_flags_t flags;
+
+	cuddlki_event_lock(priv, flags);
+	cuddlki_eventsrc_status_write_begin(priv->status);
+	WRITE_ONCE(priv->status->enabled, enabled ? 1 : 0);
+	cuddlki_eventsrc_status_write_end(priv->status);
+	cuddlki_event_unlock(priv, flags);
+}
+
+/**
+ * cuddlki_eventsrc_read_record() - Read an event source's event record.
+ *
+ * @priv: Private event source data.
+ * @seq: Receives the event sequence number.
+ * @timestamp_ns: Receives the time of the most recent event.
+ */
+static inline void cuddlki_eventsrc_read_record(
+	struct cuddlki_eventsrc_priv *priv, u64 *seq, u64 *timestamp_ns)
+{
+	u32 start;
+
+	do {
+		start = READ_ONCE(priv->status->sequence);
+		smp_rmb();
+		*seq = READ_ONCE(priv->status->event_seq);
+		*timestamp_ns = READ_ONCE(priv->status->timestamp_ns);
+		smp_rmb();
+	} while ((start & 1) || (READ_ONCE(priv->status->sequence) != start));
+}
+
+/**
+ * cuddlki_eventsrc_account_irq() - Account for an interrupt handler call.
+ *
+ * @priv: Private event source data.
+ * @start_ns: Value of ``cuddlki_stats_clock_ns()`` sampled before the
+ *            handler was called.
+ * @handled: Non-zero if the handler claimed the interrupt.
+ */
+static inline void cuddlki_eventsrc_account_irq(
+	struct cuddlki_eventsrc_priv *priv, u64 start_ns, int handled)
+{
+#if !defined(CUDDLK_DISABLE_STATS)
+	u64 elapsed;
+
+	if (!priv->stats)
+		return;
+	elapsed = cuddlki_stats_clock_ns() - start_ns;
+	this_cpu_inc(priv->stats->irqs_seen);
+	if (handled)
+		this_cpu_inc(priv->stats->irqs_handled);
+	else
+		this_cpu_inc(priv->stats->irqs_not_handled);
+	this_cpu_inc(priv->stats->handler_ns_hist[
+			     cuddlki_stats_hist_bucket(elapsed)]);
+#endif
+}
+
 /**
  * struct cuddlki_device_priv - Private kernel device data.
  *
  * @unique_name: Unique base name for use when creating UDD/UIO device nodes.
  * @uio: The associate Linux UIO device.
  * @udd: The associate Xenomai UDD device.
+ * @debugfs_dir: Debugfs directory holding the device statistics.
  *
  * This data structure contains private, platform-specific data members
  * reserved for internal use by the Cuddl implementation.
@@ -171,8 +580,9 @@ struct cuddlki_device_priv {
 	char *unique_name;
 	struct uio_info uio;
 #if defined(CUDDLK_USE_UDD)
-	struct udd_device udd;
+	struct cuddlki_udd_device udd;
 #endif
+	struct dentry *debugfs_dir;
 };
 
 /**
@@ -180,11 +590,25 @@ struct cuddlki_device_priv {
  *
  * @global_mutex: Mutex protecting the managed device list.
  *
+ * @srcu: SRCU domain protecting lockless (read-only) lookups in the managed
+ *        device list.
+ *
  * This data structure contains private, platform-specific data members
  * reserved for internal use by the Cuddl implementation.
  */
 struct cuddlki_manager_priv {
 	struct mutex global_mutex;
+	struct srcu_struct srcu;
 };
 
+/*
+ * Read-only manager queries look up devices under SRCU instead of holding
+ * the global mutex, so updates to the device list and hash index are
+ * published with release semantics.  Removed devices (and their slots) may
+ * only be freed or reused after cuddlki_manager_sync() returns.
+ */
+#define cuddlki_manager_read(x) READ_ONCE(x)
+#define cuddlki_manager_publish(x, v) smp_store_release(&(x), (v))
+#define cuddlki_manager_sync(manager) synchronize_srcu(&(manager)->priv.srcu)
+
 #endif /* !_CUDDLK_IMPL_LINUX_H */
@@ -0,0 +1,235 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Cross-platform user-space device driver layer Linux kernel tracepoints.
+ *
+ * Copyright (C) 2022 Jeff Webb <jeff.webb@codecraftsmen.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * Tracepoints for the Linux kernel modules.
+ *
+ * The events are grouped under the ``cuddl`` trace system, so they may be
+ * enabled via (e.g.)::
+ *
+ *   echo 1 > /sys/kernel/tracing/events/cuddl/enable
+ *
+ * or recorded alongside scheduler events with ``perf record -e 'cuddl:*'``.
+ * Disabled tracepoints cost a single patched-out branch.
+ *
+ * This header is reserved for internal use by the Cuddl implementation.
+ * The tracepoints are instantiated in *cuddlk_linux.c*.
+ */
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM cuddl
+
+#if !defined(_CUDDLK_TRACE_LINUX_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _CUDDLK_TRACE_LINUX_H
+
+#include <linux/tracepoint.h>
+#include <linux/version.h>
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6,10,0)
+  #define cuddlki_trace_assign_str(field, src) __assign_str(field)
+#else
+  #define cuddlki_trace_assign_str(field, src) __assign_str(field, src)
+#endif
+
+#define cuddlki_trace_safe_str(s) ((s) ? (s) : "")
+
+/* Manager IOCTL command numbers (see common_impl_linux_ioctl.h) */
+#define cuddlki_trace_show_ioctl(nr)				\
+	__print_symbolic(nr,					\
+		{  2, "MEMREGION_CLAIM_UIO" },			\
+		{  3, "MEMREGION_CLAIM_UDD" },			\
+		{  4, "EVENTSRC_CLAIM_UIO" },			\
+		{  5, "EVENTSRC_CLAIM_UDD" },			\
+		{  6, "MEMREGION_RELEASE_UIO" },		\
+		{  7, "MEMREGION_RELEASE_UDD" },		\
+		{  8, "EVENTSRC_RELEASE_UIO" },			\
+		{  9, "EVENTSRC_RELEASE_UDD" },			\
+		{ 10, "GET_MAX_MANAGED_DEVICES" },		\
+		{ 11, "GET_MAX_DEV_MEM_REGIONS" },		\
+		{ 12, "GET_MAX_DEV_EVENTS" },			\
+		{ 13, "GET_MEMREGION_ID" },			\
+		{ 14, "GET_EVENTSRC_ID" },			\
+		{ 15, "GET_MEMREGION_INFO" },			\
+		{ 16, "GET_EVENTSRC_INFO" },			\
+		{ 17, "GET_MEMREGION_REF_COUNT" },		\
+		{ 18, "GET_EVENTSRC_REF_COUNT" },		\
+		{ 19, "DECREMENT_MEMREGION_REF_COUNT" },	\
+		{ 20, "DECREMENT_EVENTSRC_REF_COUNT" },		\
+		{ 21, "JANITOR_REGISTER_PID" },			\
+		{ 22, "GET_KERNEL_COMMIT_ID" },			\
+		{ 23, "GET_DRIVER_INFO" },			\
+		{ 24, "GET_HW_INFO" },				\
+		{ 25, "GET_KERNEL_VERSION_CODE" },		\
+		{ 26, "GET_KERNEL_VARIANT" },			\
+		{ 27, "EVENTSRC_IS_ENABLED" },			\
+		{ 28, "CLAIM_BATCH_UIO" },			\
+		{ 29, "CLAIM_BATCH_UDD" },			\
+		{ 30, "EVENTSRC_GET_RECORD" })
+
+#define cuddlki_trace_show_resource(type)			\
+	__print_symbolic(type,					\
+		{ 1, "memregion" },				\
+		{ 2, "eventsrc" })
+
+/*
+ * Interrupt handler entry.  ``name`` is the unique device name for event
+ * source interrupts, or the name passed to ``cuddlk_interrupt_register()``
+ * for stand-alone interrupt handlers.
+ */
+TRACE_EVENT(cuddl_irq_entry,
+	TP_PROTO(int irq, const char *name),
+	TP_ARGS(irq, name),
+	TP_STRUCT__entry(
+		__field(int, irq)
+		__string(name, cuddlki_trace_safe_str(name))
+	),
+	TP_fast_assign(
+		__entry->irq = irq;
+		cuddlki_trace_assign_str(name, cuddlki_trace_safe_str(name));
+	),
+	TP_printk("irq=%d name=%s", __entry->irq, __get_str(name))
+);
+
+/* Interrupt handler exit */
+TRACE_EVENT(cuddl_irq_exit,
+	TP_PROTO(int irq, const char *name, int handled),
+	TP_ARGS(irq, name, handled),
+	TP_STRUCT__entry(
+		__field(int, irq)
+		__field(int, handled)
+		__string(name, cuddlki_trace_safe_str(name))
+	),
+	TP_fast_assign(
+		__entry->irq = irq;
+		__entry->handled = handled;
+		cuddlki_trace_assign_str(name, cuddlki_trace_safe_str(name));
+	),
+	TP_printk("irq=%d name=%s ret=%s", __entry->irq, __get_str(name),
+		  __entry->handled ? "handled" : "unhandled")
+);
+
+/* Programmatic event notification via cuddlk_eventsrc_notify() */
+TRACE_EVENT(cuddl_eventsrc_notify,
+	TP_PROTO(const char *name),
+	TP_ARGS(name),
+	TP_STRUCT__entry(
+		__string(name, cuddlki_trace_safe_str(name))
+	),
+	TP_fast_assign(
+		cuddlki_trace_assign_str(name, cuddlki_trace_safe_str(name));
+	),
+	TP_printk("name=%s", __get_str(name))
+);
+
+/* Event source enable/disable request from user space */
+TRACE_EVENT(cuddl_irqcontrol,
+	TP_PROTO(const char *name, int enable, int ret),
+	TP_ARGS(name, enable, ret),
+	TP_STRUCT__entry(
+		__field(int, enable)
+		__field(int, ret)
+		__string(name, cuddlki_trace_safe_str(name))
+	),
+	TP_fast_assign(
+		__entry->enable = enable;
+		__entry->ret = ret;
+		cuddlki_trace_assign_str(name, cuddlki_trace_safe_str(name));
+	),
+	TP_printk("name=%s %s ret=%d", __get_str(name),
+		  __entry->enable ? "enable" : "disable", __entry->ret)
+);
+
+/* Manager IOCTL entry */
+TRACE_EVENT(cuddl_manager_ioctl_entry,
+	TP_PROTO(unsigned int cmd),
+	TP_ARGS(cmd),
+	TP_STRUCT__entry(
+		__field(unsigned int, nr)
+	),
+	TP_fast_assign(
+		__entry->nr = _IOC_NR(cmd);
+	),
+	TP_printk("cmd=%s", cuddlki_trace_show_ioctl(__entry->nr))
+);
+
+/* Manager IOCTL exit */
+TRACE_EVENT(cuddl_manager_ioctl_exit,
+	TP_PROTO(unsigned int cmd, long ret),
+	TP_ARGS(cmd, ret),
+	TP_STRUCT__entry(
+		__field(unsigned int, nr)
+		__field(long, ret)
+	),
+	TP_fast_assign(
+		__entry->nr = _IOC_NR(cmd);
+		__entry->ret = ret;
+	),
+	TP_printk("cmd=%s ret=%ld", cuddlki_trace_show_ioctl(__entry->nr),
+		  __entry->ret)
+);
+
+/* Resource reference count changes */
+DECLARE_EVENT_CLASS(cuddl_resource_ref,
+	TP_PROTO(int type, const char *device, const char *resource,
+		 int ref_count, int ret),
+	TP_ARGS(type, device, resource, ref_count, ret),
+	TP_STRUCT__entry(
+		__field(int, type)
+		__field(int, ref_count)
+		__field(int, ret)
+		__string(device, cuddlki_trace_safe_str(device))
+		__string(resource, cuddlki_trace_safe_str(resource))
+	),
+	TP_fast_assign(
+		__entry->type = type;
+		__entry->ref_count = ref_count;
+		__entry->ret = ret;
+		cuddlki_trace_assign_str(device,
+					 cuddlki_trace_safe_str(device));
+		cuddlki_trace_assign_str(resource,
+					 cuddlki_trace_safe_str(resource));
+	),
+	TP_printk("%s device=%s resource=%s ref_count=%d ret=%d",
+		  cuddlki_trace_show_resource(__entry->type),
+		  __get_str(device), __get_str(resource),
+		  __entry->ref_count, __entry->ret)
+);
+
+DEFINE_EVENT(cuddl_resource_ref, cuddl_claim,
+	TP_PROTO(int type, const char *device, const char *resource,
+		 int ref_count, int ret),
+	TP_ARGS(type, device, resource, ref_count, ret)
+);
+
+DEFINE_EVENT(cuddl_resource_ref, cuddl_release,
+	TP_PROTO(int type, const char *device, const char *resource,
+		 int ref_count, int ret),
+	TP_ARGS(type, device, resource, ref_count, ret)
+);
+
+#endif /* !_CUDDLK_TRACE_LINUX_H || TRACE_HEADER_MULTI_READ */
+
+/* This part must be outside the multi-read protection */
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH cuddlk
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE trace_linux
+#include <trace/define_trace.h>
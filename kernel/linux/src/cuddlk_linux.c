@@ -28,8 +28,31 @@
 
 #include <linux/module.h>
 #include <linux/slab.h>
+#include <linux/gfp.h>
+#include <linux/dma-mapping.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 #include <cuddlk.h>
 
+#define CREATE_TRACE_POINTS
+#include <cuddlk/trace_linux.h>
+
+/* Tracepoints used by the manager module */
+EXPORT_TRACEPOINT_SYMBOL_GPL(cuddl_manager_ioctl_entry);
+EXPORT_TRACEPOINT_SYMBOL_GPL(cuddl_manager_ioctl_exit);
+EXPORT_TRACEPOINT_SYMBOL_GPL(cuddl_claim);
+EXPORT_TRACEPOINT_SYMBOL_GPL(cuddl_release);
+
+/*
+ * Tracepoints must not be hit from the Xenomai primary domain, so code that
+ * may run there only traces in Linux UIO builds.
+ */
+#if defined(CUDDLK_USE_UDD)
+  #define cuddlk_trace_rt(event, ...) do { } while (0)
+#else
+  #define cuddlk_trace_rt(event, ...) trace_##event(__VA_ARGS__)
+#endif
+
 /* Export symbols from cuddlk_common.c */
 EXPORT_SYMBOL_GPL(cuddlk_get_commit_id);
 EXPORT_SYMBOL_GPL(cuddlk_device_find_eventsrc_slot);
@@ -39,6 +62,9 @@ struct device *cuddlk_manager_device = NULL;
 
 EXPORT_SYMBOL_GPL(cuddlk_manager_device);
 
+/* Root debugfs directory (NULL if debugfs is unavailable) */
+static struct dentry *cuddlk_debugfs_root;
+
 static cuddlk_size_t page_size_aligned(cuddlk_size_t i)
 {
 	int lower;
@@ -67,18 +93,38 @@ static void check_assertions(void)
 }
 
 #if defined(CUDDLK_USE_UDD)
+/* Return the event source served by a UDD device */
+static struct cuddlk_eventsrc *cuddlk_udd_eventsrc(struct udd_device *udd_dev)
+{
+	return container_of(udd_dev, struct cuddlki_udd_device, udd)->eventsrc;
+}
+
+/* Return the event source served by the UDD device of an open file */
+static struct cuddlk_eventsrc *cuddlk_udd_fd_eventsrc(struct rtdm_fd *fd)
+{
+	return cuddlk_udd_eventsrc(
+		container_of(rtdm_fd_device(fd),
+			     struct udd_device, __reserved.device));
+}
+
 static int cuddlk_udd_interrupt_handler(struct udd_device *udd_dev)
 {
-	struct cuddlk_device *dev;
 	struct cuddlk_eventsrc *eventsrc;
 	struct cuddlk_interrupt *intr;
 	int ret;
 	
-	dev = container_of(udd_dev, struct cuddlk_device, priv.udd);
-	eventsrc = &dev->events[0];
+	u64 start_ns;
+	
+	eventsrc = cuddlk_udd_eventsrc(udd_dev);
 	intr = &eventsrc->intr;
 
+	start_ns = cuddlki_stats_clock_ns();
 	ret = intr->handler(intr);
+	cuddlki_eventsrc_account_irq(&eventsrc->priv, start_ns,
+				     ret == CUDDLK_RET_INTR_HANDLED);
+
+	if (ret == CUDDLK_RET_INTR_HANDLED)
+		cuddlki_eventsrc_record_event(&eventsrc->priv);
 
 	if ((eventsrc->priv.uio_open_count > 0) &&
 	    (ret == CUDDLK_RET_INTR_HANDLED)) {
@@ -93,14 +139,26 @@ static int cuddlk_udd_interrupt_handler(struct udd_device *udd_dev)
 static irqreturn_t cuddlk_uio_interrupt_handler(
 	int irq, struct uio_info *uinfo)
 {
-	struct cuddlk_device *dev;
+	struct cuddlk_eventsrc *eventsrc;
 	struct cuddlk_interrupt *intr;
+	irqreturn_t ret;
 	
-	dev = container_of(uinfo, struct cuddlk_device, priv.uio);
-	intr = &dev->events[0].intr;
+	u64 start_ns;
 	
+	eventsrc = uinfo->priv;
+	intr = &eventsrc->intr;
+	
+	trace_cuddl_irq_entry(irq, uinfo->name);
+	start_ns = cuddlki_stats_clock_ns();
+	ret = intr->handler(intr);
+	cuddlki_eventsrc_account_irq(&eventsrc->priv, start_ns,
+				     ret == IRQ_HANDLED);
+	trace_cuddl_irq_exit(irq, uinfo->name, ret == IRQ_HANDLED);
+	if (ret == IRQ_HANDLED)
+		cuddlki_eventsrc_record_event(&eventsrc->priv);
+
 	/* uio_event_notify() is triggered by caller */
-	return intr->handler(intr);
+	return ret;
 }
 #endif
 
@@ -118,10 +176,15 @@ static int cuddlk_xenomai_interrupt_handler(rtdm_irq_t *irqh)
 static irqreturn_t cuddlk_linux_interrupt_handler(int irq, void *arg)
 {
 	struct cuddlk_interrupt *intr;
+	irqreturn_t ret;
 
 	intr = (struct cuddlk_interrupt *) arg;
 
-	return intr->handler(intr);
+	trace_cuddl_irq_entry(irq, intr->priv.name);
+	ret = intr->handler(intr);
+	trace_cuddl_irq_exit(irq, intr->priv.name, ret == IRQ_HANDLED);
+
+	return ret;
 }
 #endif
 
@@ -136,14 +199,9 @@ void event_nrtsig_handler(rtdm_nrtsig_t *nrt_sig, void *data)
 #if defined(CUDDLK_USE_UDD)
 static int cuddlk_udd_eventsrc_open(struct rtdm_fd *fd, int oflags)
 {
-	struct udd_device *udd_dev;
-	struct cuddlk_device *dev;
 	struct cuddlk_eventsrc *eventsrc;
 	
-	udd_dev = container_of(
-		rtdm_fd_device(fd), struct udd_device, __reserved.device);
-	dev = container_of(udd_dev, struct cuddlk_device, priv.udd);
-	eventsrc = &dev->events[0];
+	eventsrc = cuddlk_udd_fd_eventsrc(fd);
 
 	mutex_lock(&eventsrc->priv.open_mutex);
 	eventsrc->priv.udd_open_count += 1;
@@ -156,11 +214,9 @@ static int cuddlk_udd_eventsrc_open(struct rtdm_fd *fd, int oflags)
 static int cuddlk_uio_eventsrc_or_mem_open(
 	struct uio_info *uinfo, struct inode *inode)
 {
-	struct cuddlk_device *dev;
 	struct cuddlk_eventsrc *eventsrc;
 
-	dev = container_of(uinfo, struct cuddlk_device, priv.uio);
-	eventsrc = &dev->events[0];
+	eventsrc = uinfo->priv;
 
 	mutex_lock(&eventsrc->priv.open_mutex);
 	eventsrc->priv.uio_open_count += 1;
@@ -172,14 +228,9 @@ static int cuddlk_uio_eventsrc_or_mem_open(
 #if defined(CUDDLK_USE_UDD)
 static void cuddlk_udd_eventsrc_close(struct rtdm_fd *fd)
 {
-	struct udd_device *udd_dev;
-	struct cuddlk_device *dev;
 	struct cuddlk_eventsrc *eventsrc;
 
-	udd_dev = container_of(
-		rtdm_fd_device(fd), struct udd_device, __reserved.device);
-	dev = container_of(udd_dev, struct cuddlk_device, priv.udd);
-	eventsrc = &dev->events[0];
+	eventsrc = cuddlk_udd_fd_eventsrc(fd);
 
 	mutex_lock(&eventsrc->priv.open_mutex);
 	eventsrc->priv.udd_open_count -= 1;
@@ -190,11 +241,9 @@ static void cuddlk_udd_eventsrc_close(struct rtdm_fd *fd)
 static int cuddlk_uio_eventsrc_or_mem_close(
 	struct uio_info *uinfo, struct inode *inode)
 {
-	struct cuddlk_device *dev;
 	struct cuddlk_eventsrc *eventsrc;
 
-	dev = container_of(uinfo, struct cuddlk_device, priv.uio);
-	eventsrc = &dev->events[0];
+	eventsrc = uinfo->priv;
 
 	mutex_lock(&eventsrc->priv.open_mutex);
 	eventsrc->priv.uio_open_count -= 1;
@@ -203,32 +252,50 @@ static int cuddlk_uio_eventsrc_or_mem_close(
 	return 0;
 }
 
+/* Enable/disable the event source and publish the new state if successful */
+static int cuddlk_eventsrc_enable_and_report(
+	struct cuddlk_eventsrc *eventsrc)
+{
+	int ret;
+
+	ret = eventsrc->intr.enable(&eventsrc->intr);
+	if (ret == 0)
+		cuddlki_eventsrc_set_enabled(&eventsrc->priv, 1);
+	return ret;
+}
+
+static int cuddlk_eventsrc_disable_and_report(
+	struct cuddlk_eventsrc *eventsrc)
+{
+	int ret;
+
+	ret = eventsrc->intr.disable(&eventsrc->intr);
+	if (ret == 0)
+		cuddlki_eventsrc_set_enabled(&eventsrc->priv, 0);
+	return ret;
+}
+
 #if defined(CUDDLK_USE_UDD)
 static int cuddlk_udd_eventsrc_ioctl(
 	struct rtdm_fd *fd, unsigned int request, void *arg)
 {
-	struct udd_device *udd_dev;
-	struct cuddlk_device *dev;
 	struct cuddlk_eventsrc *eventsrc;
 	struct cuddlk_interrupt *intr;
 
-	udd_dev = container_of(
-		rtdm_fd_device(fd), struct udd_device, __reserved.device);
-	dev = container_of(udd_dev, struct cuddlk_device, priv.udd);
-	eventsrc = &dev->events[0];
+	eventsrc = cuddlk_udd_fd_eventsrc(fd);
 	intr = &eventsrc->intr;
 
 	switch (request) {
 	case UDD_RTIOC_IRQEN:
 		if (intr->enable)
-			return intr->enable(intr);
+			return cuddlk_eventsrc_enable_and_report(eventsrc);
 		else
 			cuddlk_idebug("%s: intr->enable is NULL in %s\n",
 				      THIS_MODULE->name, __func__);
 		break;
 	case UDD_RTIOC_IRQDIS:
 		if (intr->disable)
-			return intr->disable(intr);
+			return cuddlk_eventsrc_disable_and_report(eventsrc);
 		else
 			cuddlk_idebug("%s: intr->disable is NULL in %s\n",
 				      THIS_MODULE->name, __func__);
@@ -243,49 +310,415 @@ static int cuddlk_udd_eventsrc_ioctl(
 static int cuddlk_uio_eventsrc_or_mem_irqcontrol(
 	struct uio_info *uinfo, int32_t irq_on)
 {
-	struct cuddlk_device *dev;
 	struct cuddlk_eventsrc *eventsrc;
 	struct cuddlk_interrupt *intr;
+	int ret = -EINVAL;
 
-	dev = container_of(uinfo, struct cuddlk_device, priv.uio);
-	eventsrc = &dev->events[0];
+	eventsrc = uinfo->priv;
 	intr = &eventsrc->intr;
 
 	if (irq_on) {
 		if (intr->enable)
-			return intr->enable(intr);
+			ret = cuddlk_eventsrc_enable_and_report(eventsrc);
 		else
 			cuddlk_idebug("%s: intr->enable is NULL in %s\n",
 				      THIS_MODULE->name, __func__);
 	} else {
 		if (intr->disable)
-			return intr->disable(intr);
+			ret = cuddlk_eventsrc_disable_and_report(eventsrc);
 		else
 			cuddlk_idebug("%s: intr->disable is NULL in %s\n",
 				      THIS_MODULE->name, __func__);
 	}
-	return -EINVAL;
+
+	trace_cuddl_irqcontrol(uinfo->name, irq_on, ret);
+	return ret;
 }
 
+#if !defined(CUDDLK_DISABLE_STATS)
+static void cuddlk_stats_show_eventsrc(
+	struct seq_file *m, int eslot, struct cuddlk_eventsrc *eventsrc)
+{
+	struct cuddlki_eventsrc_stats sum;
+	struct cuddlki_eventsrc_stats *cpu_stats;
+	int cpu;
+	int i;
+
+	memset(&sum, 0, sizeof(sum));
+	for_each_possible_cpu(cpu) {
+		cpu_stats = per_cpu_ptr(eventsrc->priv.stats, cpu);
+		sum.irqs_seen += cpu_stats->irqs_seen;
+		sum.irqs_handled += cpu_stats->irqs_handled;
+		sum.irqs_not_handled += cpu_stats->irqs_not_handled;
+		sum.notifications += cpu_stats->notifications;
+		sum.claims += cpu_stats->claims;
+		sum.claims_busy += cpu_stats->claims_busy;
+		sum.releases += cpu_stats->releases;
+		for (i=0; i<CUDDLKI_STATS_HIST_BUCKETS; i++)
+			sum.handler_ns_hist[i] += cpu_stats->handler_ns_hist[i];
+	}
+
+	seq_printf(m, "eventsrc %d name %s\n", eslot,
+		   eventsrc->name ? eventsrc->name : "");
+	seq_printf(m, "eventsrc %d irqs_seen %llu\n", eslot, sum.irqs_seen);
+	seq_printf(m, "eventsrc %d irqs_handled %llu\n",
+		   eslot, sum.irqs_handled);
+	seq_printf(m, "eventsrc %d irqs_not_handled %llu\n",
+		   eslot, sum.irqs_not_handled);
+	seq_printf(m, "eventsrc %d notifications %llu\n",
+		   eslot, sum.notifications);
+	seq_printf(m, "eventsrc %d claims %llu\n", eslot, sum.claims);
+	seq_printf(m, "eventsrc %d claims_busy %llu\n", eslot, sum.claims_busy);
+	seq_printf(m, "eventsrc %d releases %llu\n", eslot, sum.releases);
+	seq_printf(m, "eventsrc %d handler_ns_log2", eslot);
+	for (i=0; i<CUDDLKI_STATS_HIST_BUCKETS; i++)
+		seq_printf(m, " %llu", sum.handler_ns_hist[i]);
+	seq_putc(m, '\n');
+}
+
+static void cuddlk_stats_show_memregion(
+	struct seq_file *m, int mslot, struct cuddlk_memregion *memregion)
+{
+	struct cuddlki_memregion_stats sum;
+	struct cuddlki_memregion_stats *cpu_stats;
+	int cpu;
+
+	memset(&sum, 0, sizeof(sum));
+	for_each_possible_cpu(cpu) {
+		cpu_stats = per_cpu_ptr(memregion->priv.stats, cpu);
+		sum.claims += cpu_stats->claims;
+		sum.claims_busy += cpu_stats->claims_busy;
+		sum.releases += cpu_stats->releases;
+	}
+
+	seq_printf(m, "memregion %d name %s\n", mslot,
+		   memregion->name ? memregion->name : "");
+	seq_printf(m, "memregion %d claims %llu\n", mslot, sum.claims);
+	seq_printf(m, "memregion %d claims_busy %llu\n",
+		   mslot, sum.claims_busy);
+	seq_printf(m, "memregion %d releases %llu\n", mslot, sum.releases);
+}
+
+/*
+ * Show the statistics for a device as "<resource> <slot> <counter> <value>"
+ * lines (histograms list one value per bucket), summed over all CPUs.
+ */
+static int cuddlk_stats_show(struct seq_file *m, void *unused)
+{
+	struct cuddlk_device *dev = m->private;
+	int i;
+
+	for (i=0; i<CUDDLK_MAX_DEV_EVENTS; i++) {
+		if (dev->events[i].priv.stats)
+			cuddlk_stats_show_eventsrc(m, i, &dev->events[i]);
+	}
+	for (i=0; i<CUDDLK_MAX_DEV_MEM_REGIONS; i++) {
+		if (dev->mem[i].priv.stats)
+			cuddlk_stats_show_memregion(m, i, &dev->mem[i]);
+	}
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(cuddlk_stats);
+#endif /* !CUDDLK_DISABLE_STATS */
+
+/*
+ * Event source 0 is always set up, because it shares the device's UIO/UDD
+ * device with the memory regions.  Additional event sources are only set
+ * up if they have a name (and are therefore visible to the manager).
+ */
+static int cuddlk_eventsrc_is_used(struct cuddlk_device *dev, int eslot)
+{
+	return (eslot == 0) || dev->events[eslot].name;
+}
+
+/*
+ * Allocate the device statistics and publish them via debugfs.  Statistics
+ * are optional, so failures here are not treated as registration failures.
+ */
+static void cuddlk_stats_init(struct cuddlk_device *dev)
+{
+	int i;
+
+	dev->priv.debugfs_dir = NULL;
+	for (i=0; i<CUDDLK_MAX_DEV_EVENTS; i++)
+		dev->events[i].priv.stats = NULL;
+	for (i=0; i<CUDDLK_MAX_DEV_MEM_REGIONS; i++)
+		dev->mem[i].priv.stats = NULL;
+
+#if !defined(CUDDLK_DISABLE_STATS)
+	for (i=0; i<CUDDLK_MAX_DEV_EVENTS; i++) {
+		if (!cuddlk_eventsrc_is_used(dev, i))
+			continue;
+		dev->events[i].priv.stats =
+			alloc_percpu(struct cuddlki_eventsrc_stats);
+	}
+	for (i=0; i<CUDDLK_MAX_DEV_MEM_REGIONS; i++) {
+		if (dev->mem[i].type == CUDDLK_MEMT_NONE)
+			continue;
+		dev->mem[i].priv.stats =
+			alloc_percpu(struct cuddlki_memregion_stats);
+	}
+
+	if (cuddlk_debugfs_root) {
+		dev->priv.debugfs_dir = debugfs_create_dir(
+			dev->priv.unique_name, cuddlk_debugfs_root);
+		debugfs_create_file("stats", 0444, dev->priv.debugfs_dir,
+				    dev, &cuddlk_stats_fops);
+	}
+#endif
+}
+
+static void cuddlk_stats_cleanup(struct cuddlk_device *dev)
+{
+	int i;
+
+	debugfs_remove_recursive(dev->priv.debugfs_dir);
+	dev->priv.debugfs_dir = NULL;
+
+	for (i=0; i<CUDDLK_MAX_DEV_EVENTS; i++) {
+		free_percpu(dev->events[i].priv.stats);
+		dev->events[i].priv.stats = NULL;
+	}
+	for (i=0; i<CUDDLK_MAX_DEV_MEM_REGIONS; i++) {
+		free_percpu(dev->mem[i].priv.stats);
+		dev->mem[i].priv.stats = NULL;
+	}
+}
+
+static void cuddlk_dma_free(struct cuddlk_device *dev)
+{
+	struct cuddlk_memregion *mem;
+	int i;
+
+	for (i=0; i<CUDDLK_MAX_DEV_MEM_REGIONS; i++) {
+		mem = &dev->mem[i];
+		if ((mem->type != CUDDLK_MEMT_DMA) || !mem->pa_addr)
+			continue;
+		/* Mappings made via the manager may still hold references */
+		if (mem->priv.dma_buf)
+			cuddlki_dma_buffer_put(mem->priv.dma_buf);
+		else
+			free_pages_exact((void *) mem->pa_addr, mem->pa_len);
+		mem->pa_addr = 0;
+		mem->kernel.dma_addr = 0;
+		mem->priv.dma_buf = NULL;
+	}
+}
+
+/*
+ * Allocate the buffers of all ``CUDDLK_MEMT_DMA`` memory regions.  Buffers
+ * are allocated via ``dma_alloc_coherent()`` for the parent device, or from
+ * system RAM if no parent device was specified.
+ */
+static int cuddlk_dma_alloc(struct cuddlk_device *dev)
+{
+	struct cuddlk_memregion *mem;
+	struct cuddlki_dma_buffer *buf;
+	void *cpu_addr;
+	dma_addr_t dma_addr;
+	int i;
+
+	for (i=0; i<CUDDLK_MAX_DEV_MEM_REGIONS; i++) {
+		mem = &dev->mem[i];
+		if ((mem->type == CUDDLK_MEMT_DMA) &&
+		    (mem->pa_addr || ((mem->len == 0) && (mem->pa_len == 0))))
+			return -EINVAL;
+	}
+
+	for (i=0; i<CUDDLK_MAX_DEV_MEM_REGIONS; i++) {
+		mem = &dev->mem[i];
+		if (mem->type != CUDDLK_MEMT_DMA)
+			continue;
+		if (mem->pa_len == 0)
+			mem->pa_len = page_size_aligned(
+				mem->len + mem->start_offset);
+
+		buf = NULL;
+		if (dev->parent_device_ptr) {
+			buf = cuddlki_dma_buffer_alloc(
+				dev->parent_device_ptr, mem->pa_len);
+			cpu_addr = buf ? buf->cpu_addr : NULL;
+			dma_addr = buf ? buf->dma_addr : 0;
+		} else {
+			cpu_addr = alloc_pages_exact(
+				mem->pa_len, GFP_KERNEL | __GFP_ZERO);
+			if (cpu_addr)
+				dma_addr = virt_to_phys(cpu_addr);
+		}
+		if (!cpu_addr) {
+			cuddlk_dma_free(dev);
+			return -ENOMEM;
+		}
+		mem->pa_addr = (unsigned long) cpu_addr;
+		mem->kernel.dma_addr = dma_addr;
+		mem->priv.dma_buf = buf;
+	}
+	return 0;
+}
+
+/*
+ * Hook an event source up to the UIO (and UDD) device that serves it, which
+ * must already be set in the event source's private data.
+ */
+static void cuddlk_eventsrc_setup(struct cuddlk_eventsrc *eventsrc)
+{
+	struct uio_info *uio;
+	struct cuddlk_interrupt *intr;
+
+#if defined(CUDDLK_USE_UDD)
+	struct udd_device *udd;
+#endif
+
+	intr = &eventsrc->intr;
+	uio = eventsrc->priv.uio_ptr;
+	uio->priv = eventsrc;
+
+#if defined(CUDDLK_USE_UDD)
+	udd = eventsrc->priv.udd_ptr;
+	container_of(udd, struct cuddlki_udd_device, udd)->eventsrc = eventsrc;
+#endif
+
+	if ((intr->irq > 0) && (intr->handler)) {
+#if defined(CUDDLK_USE_UDD)
+		udd->irq = intr->irq;
+		udd->ops.interrupt = cuddlk_udd_interrupt_handler;
+		uio->irq = UIO_IRQ_CUSTOM;
+
+#else /* UIO */
+		uio->irq = intr->irq;
+		if (intr->flags & CUDDLK_IRQF_SHARED) {
+			uio->irq_flags |= IRQF_SHARED;
+		}
+		uio->handler = cuddlk_uio_interrupt_handler;
+#endif
+	}
+
+	if (intr->irq == CUDDLK_IRQ_CUSTOM) {
+		uio->irq = UIO_IRQ_CUSTOM;
+#if defined(CUDDLK_USE_UDD)
+		udd->irq = UDD_IRQ_CUSTOM;
+#endif
+	}
+
+	if ((intr->irq > 0) || (intr->irq == CUDDLK_IRQ_CUSTOM)) {
+		uio->open = cuddlk_uio_eventsrc_or_mem_open;
+		uio->release = cuddlk_uio_eventsrc_or_mem_close;
+		uio->irqcontrol = cuddlk_uio_eventsrc_or_mem_irqcontrol;
+#if defined(CUDDLK_USE_UDD)
+		udd->ops.open = cuddlk_udd_eventsrc_open;
+		udd->ops.close = cuddlk_udd_eventsrc_close;
+		udd->ops.ioctl = cuddlk_udd_eventsrc_ioctl;
+#endif
+	}
+}
+
+/*
+ * Register the UIO (and UDD) device of an additional event source.  These
+ * devices have no memory maps, since the memory regions are mapped via the
+ * device of event source 0.
+ */
+static int cuddlk_eventsrc_register(struct cuddlk_device *dev, int eslot)
+{
+	int ret;
+	struct cuddlk_eventsrc *eventsrc;
+	struct uio_info *uio;
+
+#if defined(CUDDLK_USE_UDD)
+	struct udd_device *udd;
+#endif
+
+	eventsrc = &dev->events[eslot];
+	eventsrc->priv.unique_name = kasprintf(
+		GFP_KERNEL, "%s.event%d", dev->priv.unique_name, eslot);
+	if (!eventsrc->priv.unique_name)
+		return -ENOMEM;
+
+	uio = &eventsrc->priv.uio;
+	uio->name = eventsrc->priv.unique_name;
+	uio->version = "0.0.1";
+	eventsrc->priv.uio_ptr = uio;
+
+#if defined(CUDDLK_USE_UDD)
+	udd = &eventsrc->priv.udd.udd;
+	udd->device_name = eventsrc->priv.unique_name;
+	udd->device_flags = RTDM_NAMED_DEVICE;
+	eventsrc->priv.udd_ptr = udd;
+#endif
+
+	cuddlk_eventsrc_setup(eventsrc);
+
+	ret = __uio_register_device(
+		dev->owner_ptr, dev->parent_device_ptr, uio);
+	if (ret)
+		goto free_name;
+
+#if defined(CUDDLK_USE_UDD)
+	rtdm_nrtsig_init(&eventsrc->priv.nrt_sig,
+			 event_nrtsig_handler, uio);
+
+	ret = udd_register_device(udd);
+	if (ret) {
+		rtdm_nrtsig_destroy(&eventsrc->priv.nrt_sig);
+		uio_unregister_device(uio);
+		goto free_name;
+	}
+#endif
+
+	return 0;
+
+free_name:
+	kfree(eventsrc->priv.unique_name);
+	eventsrc->priv.unique_name = NULL;
+	return ret;
+}
+
+/* Unregister the devices of the additional event sources below max_eslot */
+static void cuddlk_eventsrcs_unregister(
+	struct cuddlk_device *dev, int max_eslot)
+{
+	struct cuddlk_eventsrc *eventsrc;
+	int i;
+
+	for (i=1; i<max_eslot; i++) {
+		eventsrc = &dev->events[i];
+		if (!eventsrc->priv.unique_name)
+			continue;
+#if defined(CUDDLK_USE_UDD)
+		udd_unregister_device(eventsrc->priv.udd_ptr);
+		rtdm_nrtsig_destroy(&eventsrc->priv.nrt_sig);
+#endif
+		uio_unregister_device(eventsrc->priv.uio_ptr);
+		kfree(eventsrc->priv.unique_name);
+		eventsrc->priv.unique_name = NULL;
+	}
+}
 
 enum cuddlk_registration_failure {
 	CUDDLK_FAIL_NULL_GROUP,
 	CUDDLK_FAIL_NULL_NAME,
 	CUDDLK_FAIL_UNIQUE_NAME,
+	CUDDLK_FAIL_STATUS_PAGE,
+	CUDDLK_FAIL_DMA_ALLOC,
 	CUDDLK_FAIL_UIO_REGISTER,
 	CUDDLK_FAIL_UDD_REGISTER,
+	CUDDLK_FAIL_EVENTSRC_REGISTER,
 	CUDDLK_NO_FAILURE,
 };
 
 static int cuddlk_cleanup(struct cuddlk_device *dev,
 			  enum cuddlk_registration_failure  failure)
 {
+	int i;
 	int ret = 0;
 
 	switch(failure) {
 	case CUDDLK_NO_FAILURE:
+		cuddlk_eventsrcs_unregister(dev, CUDDLK_MAX_DEV_EVENTS);
+		fallthrough;
+	case CUDDLK_FAIL_EVENTSRC_REGISTER:
 #if defined(CUDDLK_USE_UDD)
-		ret = udd_unregister_device(&dev->priv.udd);
+		ret = udd_unregister_device(&dev->priv.udd.udd);
 #endif
 		fallthrough;
 	case CUDDLK_FAIL_UDD_REGISTER:
@@ -295,6 +728,14 @@ static int cuddlk_cleanup(struct cuddlk_device *dev,
 		uio_unregister_device(&dev->priv.uio);
 		fallthrough;
 	case CUDDLK_FAIL_UIO_REGISTER:
+		cuddlk_stats_cleanup(dev);
+		cuddlk_dma_free(dev);
+		fallthrough;
+	case CUDDLK_FAIL_DMA_ALLOC:
+		fallthrough;
+	case CUDDLK_FAIL_STATUS_PAGE:
+		for (i=0; i<CUDDLK_MAX_DEV_EVENTS; i++)
+			cuddlki_eventsrc_free_status(&dev->events[i].priv);
 		kfree(dev->priv.unique_name);
 		fallthrough;
 	case CUDDLK_FAIL_UNIQUE_NAME:
@@ -318,15 +759,11 @@ int cuddlk_device_register(struct cuddlk_device *dev)
 	struct uio_info *uio;
 	struct cuddlk_memregion *mem_i;
 	struct cuddlk_eventsrc *eventsrc;
-	struct cuddlk_interrupt *intr;
 
 #if defined(CUDDLK_USE_UDD)
 	struct udd_device *udd;
 #endif
 
-	eventsrc = &dev->events[0];
-	intr = &eventsrc->intr;
-
 	if (!dev->group) {
 		ret = -EINVAL;
 		failure = CUDDLK_FAIL_NULL_GROUP;
@@ -346,19 +783,43 @@ int cuddlk_device_register(struct cuddlk_device *dev)
 		goto handle_failure;
 	}
 	
-	eventsrc->priv.uio_ptr = &dev->priv.uio;
-	mutex_init(&eventsrc->priv.ref_mutex);
-	mutex_init(&eventsrc->priv.open_mutex);
+	for (i=0; i<CUDDLK_MAX_DEV_EVENTS; i++) {
+		eventsrc = &dev->events[i];
+		mutex_init(&eventsrc->priv.ref_mutex);
+		mutex_init(&eventsrc->priv.open_mutex);
+		eventsrc->priv.status_page = NULL;
+		eventsrc->priv.status = NULL;
+	}
+	for (i=0; i<CUDDLK_MAX_DEV_EVENTS; i++) {
+		if (!cuddlk_eventsrc_is_used(dev, i))
+			continue;
+		ret = cuddlki_eventsrc_init_status(&dev->events[i].priv);
+		if (ret) {
+			failure = CUDDLK_FAIL_STATUS_PAGE;
+			goto handle_failure;
+		}
+	}
+
+	ret = cuddlk_dma_alloc(dev);
+	if (ret) {
+		failure = CUDDLK_FAIL_DMA_ALLOC;
+		goto handle_failure;
+	}
 
 	uio = &dev->priv.uio;
 	uio->name = dev->priv.unique_name;
 	uio->version = "0.0.1";
 
+	cuddlk_stats_init(dev);
+
+	eventsrc = &dev->events[0];
+	eventsrc->priv.uio_ptr = uio;
+
 #if defined(CUDDLK_USE_UDD)
-	eventsrc->priv.udd_ptr = &dev->priv.udd;
-	udd = &dev->priv.udd;
+	udd = &dev->priv.udd.udd;
 	udd->device_name = dev->priv.unique_name;
 	udd->device_flags = RTDM_NAMED_DEVICE;
+	eventsrc->priv.udd_ptr = udd;
 #endif
 
 	for (i=0; i<CUDDLK_MAX_DEV_MEM_REGIONS; i++) {
@@ -379,6 +840,11 @@ int cuddlk_device_register(struct cuddlk_device *dev)
 			uio->mem[i].offs    = mem_i->start_offset;
 			uio->mem[i].size    = mem_i->pa_len;
 			uio->mem[i].memtype = mem_i->type;
+			/* DMA buffers are only mapped via the manager */
+			if (mem_i->type == CUDDLK_MEMT_DMA) {
+				uio->mem[i].addr    = mem_i->kernel.dma_addr;
+				uio->mem[i].memtype = UIO_MEM_NONE;
+			}
 		}
 
 #if defined(CUDDLK_USE_UDD)
@@ -387,42 +853,13 @@ int cuddlk_device_register(struct cuddlk_device *dev)
 			udd->mem_regions[i].addr = mem_i->pa_addr;
 			udd->mem_regions[i].len  = mem_i->pa_len;
 			udd->mem_regions[i].type = mem_i->type;
+			if (mem_i->type == CUDDLK_MEMT_DMA)
+				udd->mem_regions[i].type = UDD_MEM_NONE;
 		}
 #endif
 	}
 
-	if ((intr->irq > 0) && (intr->handler)) {
-#if defined(CUDDLK_USE_UDD)
-		udd->irq = intr->irq;
-		udd->ops.interrupt = cuddlk_udd_interrupt_handler;
-		uio->irq = UIO_IRQ_CUSTOM;
-
-#else /* UIO */
-		uio->irq = intr->irq;
-		if (intr->flags & CUDDLK_IRQF_SHARED) {
-			uio->irq_flags |= IRQF_SHARED;
-		}
-		uio->handler = cuddlk_uio_interrupt_handler;
-#endif
-	}
-
-	if (intr->irq == CUDDLK_IRQ_CUSTOM) {
-		uio->irq = UIO_IRQ_CUSTOM;
-#if defined(CUDDLK_USE_UDD)
-		udd->irq = UDD_IRQ_CUSTOM;
-#endif
-	}
-
-	if ((intr->irq > 0) || (intr->irq == CUDDLK_IRQ_CUSTOM)) {
-		uio->open = cuddlk_uio_eventsrc_or_mem_open;
-		uio->release = cuddlk_uio_eventsrc_or_mem_close;
-		uio->irqcontrol = cuddlk_uio_eventsrc_or_mem_irqcontrol;
-#if defined(CUDDLK_USE_UDD)
-		udd->ops.open = cuddlk_udd_eventsrc_open;
-		udd->ops.close = cuddlk_udd_eventsrc_close;
-		udd->ops.ioctl = cuddlk_udd_eventsrc_ioctl;
-#endif
-	}
+	cuddlk_eventsrc_setup(eventsrc);
 
 	if (!dev->parent_device_ptr)
 		dev->parent_device_ptr = cuddlk_manager_device;
@@ -448,6 +885,17 @@ int cuddlk_device_register(struct cuddlk_device *dev)
 	}
 #endif
 
+	for (i=1; i<CUDDLK_MAX_DEV_EVENTS; i++) {
+		if (!cuddlk_eventsrc_is_used(dev, i))
+			continue;
+		ret = cuddlk_eventsrc_register(dev, i);
+		if (ret) {
+			cuddlk_eventsrcs_unregister(dev, i);
+			failure = CUDDLK_FAIL_EVENTSRC_REGISTER;
+			goto handle_failure;
+		}
+	}
+
 	return 0;
 
 handle_failure:
@@ -464,6 +912,10 @@ EXPORT_SYMBOL_GPL(cuddlk_device_unregister);
 
 void cuddlk_eventsrc_notify(struct cuddlk_eventsrc *eventsrc)
 {
+	cuddlk_trace_rt(cuddl_eventsrc_notify, eventsrc->priv.uio_ptr->name);
+	cuddlki_stats_inc(eventsrc->priv.stats, notifications);
+	cuddlki_eventsrc_record_event(&eventsrc->priv);
+
 #if defined(CUDDLK_USE_UDD)
 	udd_notify_event(eventsrc->priv.udd_ptr);
 	if (eventsrc->priv.uio_open_count > 0) {
@@ -475,11 +927,20 @@ void cuddlk_eventsrc_notify(struct cuddlk_eventsrc *eventsrc)
 }
 EXPORT_SYMBOL_GPL(cuddlk_eventsrc_notify);
 
+void cuddlk_eventsrc_report_enabled(
+	struct cuddlk_eventsrc *eventsrc, int enabled)
+{
+	cuddlki_eventsrc_set_enabled(&eventsrc->priv, enabled);
+}
+EXPORT_SYMBOL_GPL(cuddlk_eventsrc_report_enabled);
+
 int cuddlk_interrupt_register(struct cuddlk_interrupt *intr, const char *name)
 {
 	int ret;
 	unsigned long flags = 0;
 
+	intr->priv.name = name;
+
 #if defined(CUDDLK_USE_UDD)
 	ret = rtdm_irq_request(&intr->priv.irqh, intr->irq,
 			       cuddlk_xenomai_interrupt_handler,
@@ -514,13 +975,22 @@ EXPORT_SYMBOL_GPL(cuddlk_interrupt_unregister);
 
 static int __init cuddlk_init(void)
 {
+	struct dentry *root;
+
 	/* This must be called somewhere for assertions to trigger. */
 	check_assertions();
+
+	/* Statistics are optional, so a missing debugfs is not an error */
+	root = debugfs_create_dir("cuddl", NULL);
+	if (!IS_ERR_OR_NULL(root))
+		cuddlk_debugfs_root = root;
+
 	return 0;
 }
 
 static void __exit cuddlk_exit(void)
 {
+	debugfs_remove_recursive(cuddlk_debugfs_root);
 }
 
 module_init(cuddlk_init)
@@ -30,25 +30,55 @@
 #include <linux/slab.h>
 #include <linux/cdev.h>
 #include <linux/uaccess.h>
+#include <linux/mm.h>
+#include <linux/dma-mapping.h>
+#include <linux/hashtable.h>
+#include <linux/refcount.h>
 #include <cuddlk.h>
 #include <cuddl/common_impl_linux_ioctl.h>
+#include <cuddlk/trace_linux.h>
 
 /*
- * struct cuddlk_resource_ref_list - List of references to resources.
+ * struct cuddlk_resource_ref - Reference to a resource held by a process.
  *
- * @list: Linux kernel list implementation.
+ * @node: Entry in the reference hash table, keyed by ``pid``.
  * @token: Identifies the resource being referenced.
  * @pid: Process id holding the reference (for clean up).
  * 
  * This data structure is reserved for internal use by the Cuddl
  * implementation.
  */
-struct cuddlk_resource_ref_list {
-	struct list_head list;
+struct cuddlk_resource_ref {
+	struct hlist_node node;
 	struct cuddlci_token token;
 	pid_t pid;
 };
 
+/* Number of hash buckets (log2) in each resource reference table */
+#define CUDDLK_REF_HASH_BITS 8
+
+/*
+ * Payloads of the manager IOCTLs that are too large for the kernel stack.
+ * These are allocated from a dedicated slab cache, and only for the
+ * commands that use them.
+ */
+union cuddlk_ioctl_large_data {
+	struct cuddlci_memregion_claim_ioctl_data mem;
+	struct cuddlci_eventsrc_claim_ioctl_data event;
+	struct cuddlci_get_resource_id_ioctl_data get_id;
+	struct cuddlci_ref_count_ioctl_data ref_count;
+};
+
+/* Payloads of the remaining manager IOCTLs, which live on the stack */
+union cuddlk_ioctl_small_data {
+	struct cuddlci_memregion_release_ioctl_data mem_release;
+	struct cuddlci_eventsrc_release_ioctl_data event_release;
+	struct cuddlci_get_kernel_commit_id_ioctl_data commit;
+	struct cuddlci_get_driver_info_ioctl_data driver_info;
+	struct cuddlci_void_ioctl_data void_data;
+	struct cuddlci_eventsrc_is_enabled_ioctl_data is_enabled;
+};
+
 /* Export symbols from cuddlk_manager_common.c */
 EXPORT_SYMBOL_GPL(cuddlk_manager_find_device_slot_matching);
 EXPORT_SYMBOL_GPL(cuddlk_manager_find_device_slot);
@@ -58,15 +88,22 @@ EXPORT_SYMBOL_GPL(cuddlk_manager_add_device);
 EXPORT_SYMBOL_GPL(cuddlk_manager_remove_device);
 EXPORT_SYMBOL_GPL(cuddlk_device_manage);
 EXPORT_SYMBOL_GPL(cuddlk_device_release);
+EXPORT_SYMBOL_GPL(cuddlk_devices_manage);
+EXPORT_SYMBOL_GPL(cuddlk_devices_release);
 
 static dev_t cuddlk_manager_dev;
 static struct cdev cuddlk_manager_cdev;
 static struct class *cuddlk_manager_class;
 static struct cuddlk_manager *cuddlk_global_manager_ptr;
+static struct kmem_cache *cuddlk_ref_cache;
+static struct kmem_cache *cuddlk_ioctl_data_cache;
 
-/* These are just for emergency clean-up */
-struct cuddlk_resource_ref_list cuddlk_mem_refs;
-struct cuddlk_resource_ref_list cuddlk_event_refs;
+/*
+ * References held by processes, hashed by process id so that releases and
+ * emergency clean-up only visit the references of the process concerned
+ */
+static DEFINE_HASHTABLE(cuddlk_mem_refs, CUDDLK_REF_HASH_BITS);
+static DEFINE_HASHTABLE(cuddlk_event_refs, CUDDLK_REF_HASH_BITS);
 
 struct cuddlk_manager *cuddlk_manager_lock(void)
 {
@@ -81,6 +118,18 @@ void cuddlk_manager_unlock(void)
 }
 EXPORT_SYMBOL_GPL(cuddlk_manager_unlock);
 
+/*
+ * Look up the device in a manager slot.  The caller must either hold the
+ * manager lock or be in an SRCU read-side critical section (see
+ * _ioctl_is_read_only()).  In the latter case, the slot may be emptied at
+ * any time, but the device will not be unregistered until the critical
+ * section ends.
+ */
+static struct cuddlk_device *_get_device(int slot)
+{
+	return cuddlki_manager_read(cuddlk_global_manager_ptr->devices[slot]);
+}
+
 static int _eventsrc_claim(struct cuddlk_eventsrc *eventsrc, int hostile)
 {
 	int failed = 0;
@@ -91,8 +140,10 @@ static int _eventsrc_claim(struct cuddlk_eventsrc *eventsrc, int hostile)
 	    !(eventsrc->flags & CUDDLK_EVENTSRCF_SHARED) &&
 	    !hostile) {
 		cuddlk_print("eventsrc claim failed (busy)\n");
+		cuddlki_stats_inc(eventsrc->priv.stats, claims_busy);
 		failed = -EBUSY;
 	} else {
+		cuddlki_stats_inc(eventsrc->priv.stats, claims);
 		eventsrc->kernel.ref_count += 1;
 		if (eventsrc->priv.uio_ptr->uio_dev->owner) {
 			try_module_get(
@@ -100,6 +151,10 @@ static int _eventsrc_claim(struct cuddlk_eventsrc *eventsrc, int hostile)
 		}
 	}
 
+	trace_cuddl_claim(CUDDL_RESOURCE_EVENTSRC,
+			  eventsrc->priv.uio_ptr->name, eventsrc->name,
+			  eventsrc->kernel.ref_count, failed);
+
 	mutex_unlock(&eventsrc->priv.ref_mutex);
 
 	return failed;
@@ -115,6 +170,7 @@ static int _eventsrc_decr_ref_count(struct cuddlk_eventsrc *eventsrc)
 		cuddlk_print("eventsrc refcount already zero\n");
 		failed = -ENOSPC;
 	} else {
+		cuddlki_stats_inc(eventsrc->priv.stats, releases);
 		eventsrc->kernel.ref_count -= 1;
 		if (eventsrc->priv.uio_ptr->uio_dev->owner) {
 			module_put(
@@ -122,6 +178,10 @@ static int _eventsrc_decr_ref_count(struct cuddlk_eventsrc *eventsrc)
 		}
 	}
 
+	trace_cuddl_release(CUDDL_RESOURCE_EVENTSRC,
+			    eventsrc->priv.uio_ptr->name, eventsrc->name,
+			    eventsrc->kernel.ref_count, failed);
+
 	mutex_unlock(&eventsrc->priv.ref_mutex);
 
 	return failed;
@@ -137,8 +197,10 @@ static int _memregion_claim(struct cuddlk_memregion *memregion, int hostile)
 	    !(memregion->flags & CUDDLK_MEMF_SHARED) &&
 	    !hostile) {
 		cuddlk_print("memregion claim failed (busy)\n");
+		cuddlki_stats_inc(memregion->priv.stats, claims_busy);
 		failed = -EBUSY;
 	} else {
+		cuddlki_stats_inc(memregion->priv.stats, claims);
 		memregion->kernel.ref_count += 1;
 		if (memregion->priv.uio_ptr->uio_dev->owner) {
 			try_module_get(
@@ -146,6 +208,10 @@ static int _memregion_claim(struct cuddlk_memregion *memregion, int hostile)
 		}
 	}
 
+	trace_cuddl_claim(CUDDL_RESOURCE_MEMREGION,
+			  memregion->priv.uio_ptr->name, memregion->name,
+			  memregion->kernel.ref_count, failed);
+
 	mutex_unlock(&memregion->priv.ref_mutex);
 
 	return failed;
@@ -161,6 +227,7 @@ static int _memregion_decr_ref_count(struct cuddlk_memregion *memregion)
 		cuddlk_print("memregion refcount already zero\n");
 		failed = -ENOSPC;
 	} else {
+		cuddlki_stats_inc(memregion->priv.stats, releases);
 		memregion->kernel.ref_count -= 1;
 		if (memregion->priv.uio_ptr->uio_dev->owner) {
 			module_put(
@@ -168,6 +235,10 @@ static int _memregion_decr_ref_count(struct cuddlk_memregion *memregion)
 		}
 	}
 
+	trace_cuddl_release(CUDDL_RESOURCE_MEMREGION,
+			    memregion->priv.uio_ptr->name, memregion->name,
+			    memregion->kernel.ref_count, failed);
+
 	mutex_unlock(&memregion->priv.ref_mutex);
 
 	return failed;
@@ -177,41 +248,36 @@ void cuddlk_manager_free_refs_for_pid(pid_t pid); // Get rid of warning on 6.12
 
 void cuddlk_manager_free_refs_for_pid(pid_t pid)
 {
-	struct cuddlk_resource_ref_list *pos;
-	struct cuddlk_resource_ref_list *tmp;
-	struct cuddlk_resource_ref_list *ref_to_free;
+	struct cuddlk_resource_ref *pos;
+	struct hlist_node *tmp;
 	struct cuddlk_device *dev;
 	int slot, mslot, eslot;
 
 	cuddlk_manager_lock();
 
-	list_for_each_entry_safe(
-		pos, tmp, &cuddlk_mem_refs.list, list) {
+	hash_for_each_possible_safe(cuddlk_mem_refs, pos, tmp, node, pid) {
 		if (pos->pid == pid) {
 			slot = pos->token.device_index;
 			mslot = pos->token.resource_index;
 			cuddlk_print("emergency clean up for pid %d, "
 				     "mem slot: %d %d\n", pid, slot, mslot);
-			dev = cuddlk_global_manager_ptr->devices[slot];
+			dev = _get_device(slot);
 			_memregion_decr_ref_count(&dev->mem[mslot]);
-			ref_to_free = pos;
-			list_del(&pos->list);
-			kfree(ref_to_free);
+			hash_del(&pos->node);
+			kmem_cache_free(cuddlk_ref_cache, pos);
 		}
 	}
 
-	list_for_each_entry_safe(
-		pos, tmp, &cuddlk_event_refs.list, list) {
+	hash_for_each_possible_safe(cuddlk_event_refs, pos, tmp, node, pid) {
 		if (pos->pid == pid) {
 			slot = pos->token.device_index;
 			eslot = pos->token.resource_index;
 			cuddlk_print("emergency clean up for pid %d, "
 				     "event slot: %d %d\n", pid, slot, eslot);
-			dev = cuddlk_global_manager_ptr->devices[slot];
+			dev = _get_device(slot);
 			_eventsrc_decr_ref_count(&dev->events[eslot]);
-			ref_to_free = pos;
-			list_del(&pos->list);
-			kfree(ref_to_free);
+			hash_del(&pos->node);
+			kmem_cache_free(cuddlk_ref_cache, pos);
 		}
 	}
 
@@ -233,167 +299,487 @@ static int _version_code_is_compat(int user_version_code) {
 		return 0;
 }
 
-static long cuddlk_manager_ioctl(
-	struct file *file, unsigned int cmd, unsigned long arg)
+/*
+ * Return the largest huge page size that may be used to map a memory
+ * region, or 0 if huge pages cannot be used.  Huge page mappings are made
+ * from the page fault handler (as for VFIO PCI BARs), which requires huge
+ * PFN map support (Linux 6.12 or later).  The start of the memory region
+ * must be aligned to the huge page size.
+ */
+static unsigned long _memregion_huge_page_size(struct cuddlk_memregion *mem)
+{
+	phys_addr_t pa;
+
+	switch (mem->type) {
+	case CUDDLK_MEMT_PHYS:
+		pa = mem->pa_addr;
+		break;
+	case CUDDLK_MEMT_LOGICAL:
+		pa = virt_to_phys((void *) mem->pa_addr);
+		break;
+	default:
+		return 0;
+	}
+
+#ifdef CONFIG_ARCH_SUPPORTS_PUD_PFNMAP
+	if (IS_ALIGNED(pa, PUD_SIZE) && (mem->pa_len >= PUD_SIZE))
+		return PUD_SIZE;
+#endif
+#ifdef CONFIG_ARCH_SUPPORTS_PMD_PFNMAP
+	if (IS_ALIGNED(pa, PMD_SIZE) && (mem->pa_len >= PMD_SIZE))
+		return PMD_SIZE;
+#endif
+	return 0;
+}
+
+/*
+ * Return the set of ``CUDDL_MEMF_MAP_*`` flags describing the caching modes
+ * permitted for a memory region (see ``enum cuddlk_memregion_flags``).
+ */
+static int _memregion_map_flags(struct cuddlk_memregion *mem)
+{
+	int flags = 0;
+
+	if (_memregion_huge_page_size(mem))
+		flags |= CUDDL_MEMF_MAP_HUGE_PAGES;
+
+	switch (mem->type) {
+	case CUDDLK_MEMT_PHYS:
+		flags |= CUDDL_MEMF_MAP_UNCACHED;
+		if (mem->flags & CUDDLK_MEMF_ALLOW_WRITE_COMBINE)
+			flags |= CUDDL_MEMF_MAP_WRITE_COMBINE;
+		if (mem->flags & CUDDLK_MEMF_ALLOW_CACHED)
+			flags |= CUDDL_MEMF_MAP_CACHED;
+		break;
+	case CUDDLK_MEMT_LOGICAL:
+	case CUDDLK_MEMT_VIRTUAL:
+		flags |= CUDDL_MEMF_MAP_CACHED;
+		break;
+	}
+	return flags;
+}
+
+static void _fill_memregion_info(
+	struct cuddl_memregion_info *info,
+	struct cuddlk_device *dev, int slot, int mslot, int rt)
+{
+	info->priv.token.device_index = slot;
+	info->priv.token.resource_index = mslot;
+	info->priv.pa_len = dev->mem[mslot].pa_len;
+	info->priv.start_offset = dev->mem[mslot].start_offset;
+	info->priv.mode_mmap_offset =
+		(CUDDLCI_MEM_MMAP_PGOFF +
+		 (slot * CUDDLK_MAX_DEV_MEM_REGIONS + mslot) *
+		 CUDDLCI_MEM_MAP_MODES) * CUDDLK_PAGE_SIZE;
+	info->priv.huge_page_size = _memregion_huge_page_size(&dev->mem[mslot]);
+	info->len = dev->mem[mslot].len;
+	info->flags = 0;
+	if (dev->mem[mslot].flags & CUDDLK_MEMF_SHARED)
+		info->flags |= CUDDL_MEMF_SHARED;
+	info->flags |= _memregion_map_flags(&dev->mem[mslot]);
+	info->priv.dma_addr = 0;
+	if (dev->mem[mslot].type == CUDDLK_MEMT_DMA) {
+		info->flags |= CUDDL_MEMF_DMA;
+		info->priv.dma_addr = dev->mem[mslot].kernel.dma_addr;
+	}
+	if (rt) {
+		info->priv.pa_mmap_offset = 0;
+		snprintf(info->priv.device_name,
+			 CUDDLCI_MAX_STR_LEN,
+			 "/dev/rtdm/%s,mapper%d",
+			 dev->priv.unique_name,
+			 mslot);
+	} else {
+		info->priv.pa_mmap_offset = mslot * CUDDLK_PAGE_SIZE;
+		snprintf(info->priv.device_name,
+			 CUDDLCI_MAX_STR_LEN,
+			 "/dev/uio%d",
+			 dev->priv.uio.uio_dev->minor);
+	}
+}
+
+static void _fill_eventsrc_info(
+	struct cuddl_eventsrc_info *info,
+	struct cuddlk_device *dev, int slot, int eslot, int rt)
+{
+	info->priv.token.device_index = slot;
+	info->priv.token.resource_index = eslot;
+	info->priv.status_mmap_offset =
+		(slot * CUDDLK_MAX_DEV_EVENTS + eslot) * CUDDLK_PAGE_SIZE;
+	info->flags = 0;
+	info->flags |= CUDDL_EVENTSRCF_WAITABLE;
+	if (dev->events[eslot].flags & CUDDLK_EVENTSRCF_SHARED)
+		info->flags |= CUDDL_EVENTSRCF_SHARED;
+	if (dev->events[eslot].intr.enable)
+		info->flags |= CUDDL_EVENTSRCF_HAS_ENABLE;
+	if (dev->events[eslot].intr.disable)
+		info->flags |= CUDDL_EVENTSRCF_HAS_DISABLE;
+	if (dev->events[eslot].intr.is_enabled)
+		info->flags |= CUDDL_EVENTSRCF_HAS_IS_ENABLED;
+
+	/* The UDD device of an event source is named after its UIO device */
+	if (rt) {
+		snprintf(info->priv.device_name,
+			 CUDDLCI_MAX_STR_LEN,
+			 "/dev/rtdm/%s",
+			 dev->events[eslot].priv.uio_ptr->name);
+	} else {
+		snprintf(info->priv.device_name,
+			 CUDDLCI_MAX_STR_LEN,
+			 "/dev/uio%d",
+			 dev->events[eslot].priv.uio_ptr->uio_dev->minor);
+	}
+}
+
+/*
+ * Claim the resource described by a batch entry.  Unlike the single-resource
+ * claim IOCTLs, a wildcard pattern that matches a busy resource moves on to
+ * the next matching device, so that a batch containing several identical
+ * patterns claims several distinct resources.  Must be called with the
+ * manager locked.
+ */
+static int _claim_batch_entry(struct cuddlci_claim_batch_entry *entry, int rt)
 {
 	int slot;
-	int mslot;
-	int eslot;
-	int rt = 0;
-	int claim = 0;
-	int decrement = 0;
-	int ret = 0;
-	int freed_ref = 0;
+	int rslot;
+	int ret = -ENXIO;
+	int start = 0;
+	enum cuddlk_resource type;
 	struct cuddlk_device *dev;
-	struct cuddlci_memregion_claim_ioctl_data *mdata;
-	struct cuddlci_eventsrc_claim_ioctl_data *edata;
-	struct cuddlci_memregion_release_ioctl_data *mrdata;
-	struct cuddlci_eventsrc_release_ioctl_data *erdata;
-	struct cuddlci_get_resource_id_ioctl_data *get_id_data;
-	struct cuddlci_get_kernel_commit_id_ioctl_data *commit_data;
-	struct cuddlci_get_driver_info_ioctl_data *driver_info_data;
-	struct cuddlci_void_ioctl_data *void_data;
-	struct cuddlci_ref_count_ioctl_data *id_data;
-	struct cuddlci_eventsrc_is_enabled_ioctl_data *is_enabled_data;
-	struct cuddlk_resource_ref_list *tmp_ref;
-	struct cuddlk_resource_ref_list *pos;
-	struct cuddlk_resource_ref_list *tmp;
-	struct cuddlk_resource_ref_list *ref_to_free;
-
-	cuddlk_debug("cuddlk_manager_ioctl\n");
-	cuddlk_debug("  cmd:  %u\n", cmd);
-	cuddlk_debug("  dir:  %u\n", _IOC_DIR(cmd));
-	cuddlk_debug("  type: %u\n", _IOC_TYPE(cmd));
-	cuddlk_debug("  nr:   %u\n", _IOC_NR(cmd));
-	cuddlk_debug("  size: %u\n", _IOC_SIZE(cmd));
-	cuddlk_debug("  arg:  %lu\n", arg);
-
-	mdata = kzalloc(
-		sizeof(struct cuddlci_memregion_claim_ioctl_data),
-		GFP_KERNEL);
-	if (!mdata) {
-		cuddlk_print("kzalloc failed\n");
-		return -ENOMEM;
+
+	if (entry->type == CUDDL_RESOURCE_MEMREGION)
+		type = CUDDLK_RESOURCE_MEMREGION;
+	else if (entry->type == CUDDL_RESOURCE_EVENTSRC)
+		type = CUDDLK_RESOURCE_EVENTSRC;
+	else
+		return -EINVAL;
+
+	while (start < CUDDLK_MAX_MANAGED_DEVICES) {
+		slot = cuddlk_manager_find_device_slot_matching(
+			cuddlk_global_manager_ptr,
+			entry->id.group, entry->id.device, entry->id.resource,
+			entry->id.instance, type, start);
+		if (slot < 0)
+			return (ret == -EBUSY) ? ret : slot;
+		dev = _get_device(slot);
+		start = slot + 1;
+
+		if (type == CUDDLK_RESOURCE_MEMREGION) {
+			rslot = cuddlk_device_find_memregion_slot(
+				dev, entry->id.resource);
+			if (rslot < 0)
+				return rslot;
+			ret = _memregion_claim(
+				&dev->mem[rslot],
+				entry->options & CUDDL_MEM_CLAIMF_HOSTILE);
+			if (ret == -EBUSY)
+				continue;
+			if (ret)
+				return ret;
+			_fill_memregion_info(
+				&entry->info.mem, dev, slot, rslot, rt);
+		} else {
+			rslot = cuddlk_device_find_eventsrc_slot(
+				dev, entry->id.resource);
+			if (rslot < 0)
+				return rslot;
+			ret = _eventsrc_claim(
+				&dev->events[rslot],
+				entry->options & CUDDL_EVENTSRC_CLAIMF_HOSTILE);
+			if (ret == -EBUSY)
+				continue;
+			if (ret)
+				return ret;
+			_fill_eventsrc_info(
+				&entry->info.event, dev, slot, rslot, rt);
+		}
+		return 0;
 	}
 
-	edata = kzalloc(
-		sizeof(struct cuddlci_eventsrc_claim_ioctl_data),
-		GFP_KERNEL);
-	if (!edata) {
-		kfree(mdata);
-		cuddlk_print("kzalloc failed\n");
-		return -ENOMEM;
+	return ret;
+}
+
+/* Must be called with the manager locked */
+static void _unclaim_batch_entry(struct cuddlci_claim_batch_entry *entry)
+{
+	struct cuddlci_token *token;
+	struct cuddlk_device *dev;
+
+	if (entry->type == CUDDL_RESOURCE_MEMREGION) {
+		token = &entry->info.mem.priv.token;
+		dev = _get_device(token->device_index);
+		_memregion_decr_ref_count(&dev->mem[token->resource_index]);
+	} else {
+		token = &entry->info.event.priv.token;
+		dev = _get_device(token->device_index);
+		_eventsrc_decr_ref_count(&dev->events[token->resource_index]);
 	}
+}
 
-	mrdata = kzalloc(
-		sizeof(struct cuddlci_memregion_release_ioctl_data),
-		GFP_KERNEL);
-	if (!mrdata) {
-		kfree(edata);
-		kfree(mdata);
-		cuddlk_print("kzalloc failed\n");
-		return -ENOMEM;
+/*
+ * Claim a batch of memory regions and/or event sources on behalf of a single
+ * process.  Either all of the requested resources are claimed, or none of
+ * them are.  All entries are copied in and out of user space in one shot.
+ * Must be called with the manager locked.
+ */
+static int _claim_batch(void __user *arg, int rt)
+{
+	int i;
+	int ret = 0;
+	int n_claimed = 0;
+	size_t entries_size;
+	void __user *user_entries;
+	struct cuddlci_claim_batch_ioctl_data bdata;
+	struct cuddlci_claim_batch_entry *entries = NULL;
+	struct cuddlk_resource_ref **refs = NULL;
+
+	if (copy_from_user(&bdata, arg, sizeof(bdata))) {
+		cuddlk_print("copy_from_user failed\n");
+		return -EOVERFLOW;
 	}
 
-	erdata = kzalloc(
-		sizeof(struct cuddlci_eventsrc_release_ioctl_data),
-		GFP_KERNEL);
-	if (!erdata) {
-		kfree(mrdata);
-		kfree(edata);
-		kfree(mdata);
-		cuddlk_print("kzalloc failed\n");
-		return -ENOMEM;
+	if (!_version_code_is_compat(bdata.version_code)) {
+		cuddlk_print("cuddl user/kernel version mismatch in IOCTL\n");
+		return -ENOEXEC;
 	}
 
-	get_id_data = kzalloc(
-		sizeof(struct cuddlci_get_resource_id_ioctl_data),
-		GFP_KERNEL);
-	if (!get_id_data) {
-		kfree(erdata);
-		kfree(mrdata);
-		kfree(edata);
-		kfree(mdata);
-		cuddlk_print("kzalloc failed\n");
-		return -ENOMEM;
+	if ((bdata.count <= 0) || (bdata.count > CUDDLCI_MAX_CLAIM_BATCH))
+		return -EINVAL;
+
+	entries_size = bdata.count * sizeof(*entries);
+	user_entries = (void __user *) (uintptr_t) bdata.entries;
+
+	entries = kmalloc_array(bdata.count, sizeof(*entries), GFP_KERNEL);
+	refs = kcalloc(bdata.count, sizeof(*refs), GFP_KERNEL);
+	if (!entries || !refs) {
+		cuddlk_print("kmalloc failed\n");
+		ret = -ENOMEM;
+		goto free_all;
 	}
 
-	commit_data = kzalloc(
-		sizeof(struct cuddlci_get_kernel_commit_id_ioctl_data),
-		GFP_KERNEL);
-	if (!commit_data) {
-		kfree(get_id_data);
-		kfree(erdata);
-		kfree(mrdata);
-		kfree(edata);
-		kfree(mdata);
-		cuddlk_print("kzalloc failed\n");
-		return -ENOMEM;
+	if (copy_from_user(entries, user_entries, entries_size)) {
+		cuddlk_print("copy_from_user failed\n");
+		ret = -EOVERFLOW;
+		goto free_all;
 	}
 
-	driver_info_data = kzalloc(
-		sizeof(struct cuddlci_get_driver_info_ioctl_data),
-		GFP_KERNEL);
-	if (!driver_info_data) {
-		kfree(commit_data);
-		kfree(get_id_data);
-		kfree(erdata);
-		kfree(mrdata);
-		kfree(edata);
-		kfree(mdata);
-		cuddlk_print("kzalloc failed\n");
-		return -ENOMEM;
+	/* Allocate the references up front so that nothing can fail after
+	 * the resources have been claimed */
+	for (i = 0; i < bdata.count; i++) {
+		refs[i] = kmem_cache_zalloc(cuddlk_ref_cache, GFP_KERNEL);
+		if (!refs[i]) {
+			cuddlk_print("ref allocation failed\n");
+			ret = -ENOMEM;
+			goto free_all;
+		}
 	}
 
-	void_data = kzalloc(
-		sizeof(struct cuddlci_void_ioctl_data),
-		GFP_KERNEL);
-	if (!void_data) {
-		kfree(driver_info_data);
-		kfree(commit_data);
-		kfree(get_id_data);
-		kfree(erdata);
-		kfree(mrdata);
-		kfree(edata);
-		kfree(mdata);
-		cuddlk_print("kzalloc failed\n");
-		return -ENOMEM;
+	bdata.failed_index = -1;
+	for (n_claimed = 0; n_claimed < bdata.count; n_claimed++) {
+		ret = _claim_batch_entry(&entries[n_claimed], rt);
+		entries[n_claimed].result = ret;
+		if (ret) {
+			bdata.failed_index = n_claimed;
+			goto roll_back;
+		}
 	}
 
-	id_data = kzalloc(
-		sizeof(struct cuddlci_ref_count_ioctl_data),
-		GFP_KERNEL);
-	if (!id_data) {
-		kfree(void_data);
-		kfree(driver_info_data);
-		kfree(commit_data);
-		kfree(get_id_data);
-		kfree(erdata);
-		kfree(mrdata);
-		kfree(edata);
-		kfree(mdata);
-		cuddlk_print("kzalloc failed\n");
-		return -ENOMEM;
+	if (copy_to_user(user_entries, entries, entries_size)) {
+		cuddlk_print("copy_to_user failed\n");
+		ret = -EOVERFLOW;
+		goto roll_back;
 	}
 
-	is_enabled_data = kzalloc(
-		sizeof(struct cuddlci_eventsrc_is_enabled_ioctl_data),
-		GFP_KERNEL);
-	if (!is_enabled_data) {
-		kfree(id_data);
-		kfree(void_data);
-		kfree(driver_info_data);
-		kfree(commit_data);
-		kfree(get_id_data);
-		kfree(erdata);
-		kfree(mrdata);
-		kfree(edata);
-		kfree(mdata);
-		cuddlk_print("kzalloc failed\n");
-		return -ENOMEM;
+	for (i = 0; i < bdata.count; i++) {
+		refs[i]->pid = bdata.pid;
+		if (entries[i].type == CUDDL_RESOURCE_MEMREGION) {
+			refs[i]->token = entries[i].info.mem.priv.token;
+			hash_add(cuddlk_mem_refs, &refs[i]->node, bdata.pid);
+		} else {
+			refs[i]->token = entries[i].info.event.priv.token;
+			hash_add(cuddlk_event_refs, &refs[i]->node,
+				 bdata.pid);
+		}
+		refs[i] = NULL;
 	}
+	goto free_all;
+
+roll_back:
+	for (i = n_claimed - 1; i >= 0; i--)
+		_unclaim_batch_entry(&entries[i]);
+
+	/* Report which entry failed (best effort) */
+	for (i = 0; i < bdata.count; i++)
+		if (i != bdata.failed_index)
+			entries[i].result = -ECANCELED;
+	if (copy_to_user(user_entries, entries, entries_size) ||
+	    copy_to_user(arg, &bdata, sizeof(bdata)))
+		cuddlk_print("copy_to_user failed\n");
+
+free_all:
+	if (refs)
+		for (i = 0; i < bdata.count; i++)
+			if (refs[i])
+				kmem_cache_free(cuddlk_ref_cache, refs[i]);
+	kfree(refs);
+	kfree(entries);
+	return ret;
+}
 
-	cuddlk_manager_lock();
+/* Must be called with the manager locked or under SRCU */
+static int _eventsrc_get_record(void __user *arg)
+{
+	int slot;
+	int eslot;
+	u64 seq;
+	u64 timestamp_ns;
+	struct cuddlk_device *dev;
+	struct cuddlci_eventsrc_get_record_ioctl_data rdata;
+
+	if (copy_from_user(&rdata, arg, sizeof(rdata))) {
+		cuddlk_print("copy_from_user failed\n");
+		return -EOVERFLOW;
+	}
+
+	if (!_version_code_is_compat(rdata.version_code)) {
+		cuddlk_print("cuddl user/kernel version mismatch in IOCTL\n");
+		return -ENOEXEC;
+	}
+
+	slot = rdata.token.device_index;
+	eslot = rdata.token.resource_index;
+	if ((slot >= CUDDLK_MAX_MANAGED_DEVICES) || (slot < 0))
+		return -EBADSLT;
+	dev = _get_device(slot);
+	if (!dev)
+		return -ENODEV;
+	if ((eslot >= CUDDLK_MAX_DEV_EVENTS) || (eslot < 0))
+		return -EBADSLT;
+	if (!dev->events[eslot].priv.status)
+		return -ENODEV;
+
+	cuddlki_eventsrc_read_record(
+		&dev->events[eslot].priv, &seq, &timestamp_ns);
+	rdata.seq = seq;
+	rdata.timestamp_ns = timestamp_ns;
+
+	if (copy_to_user(arg, &rdata, sizeof(rdata))) {
+		cuddlk_print("copy_to_user failed\n");
+		return -EOVERFLOW;
+	}
+
+	return 0;
+}
+
+/*
+ * Queries that only read the device table (and do not modify reference
+ * counts) are served under SRCU instead of the manager mutex, so that
+ * concurrent monitoring and lookup requests do not serialize.  Queries that
+ * call into a driver (e.g. CUDDLCI_EVENTSRC_IS_ENABLED_IOCTL) still take the
+ * mutex, since drivers do not expect their callbacks to run concurrently
+ * with claims, releases, and device removal.
+ */
+static int _ioctl_is_read_only(unsigned int cmd)
+{
+	switch(cmd) {
+	case CUDDLCI_GET_MEMREGION_INFO_IOCTL:
+	case CUDDLCI_GET_EVENTSRC_INFO_IOCTL:
+	case CUDDLCI_GET_MAX_MANAGED_DEVICES_IOCTL:
+	case CUDDLCI_GET_MAX_DEV_MEM_REGIONS_IOCTL:
+	case CUDDLCI_GET_MAX_DEV_EVENTS_IOCTL:
+	case CUDDLCI_GET_MEMREGION_ID_IOCTL:
+	case CUDDLCI_GET_EVENTSRC_ID_IOCTL:
+	case CUDDLCI_GET_MEMREGION_REF_COUNT_IOCTL:
+	case CUDDLCI_GET_EVENTSRC_REF_COUNT_IOCTL:
+	case CUDDLCI_GET_KERNEL_COMMIT_ID_IOCTL:
+	case CUDDLCI_GET_DRIVER_INFO_IOCTL:
+	case CUDDLCI_GET_HW_INFO_IOCTL:
+	case CUDDLCI_GET_KERNEL_VERSION_CODE_IOCTL:
+	case CUDDLCI_GET_KERNEL_VARIANT_IOCTL:
+	case CUDDLCI_EVENTSRC_GET_RECORD_IOCTL:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+/* Commands whose payload is in union cuddlk_ioctl_large_data */
+static int _ioctl_has_large_data(unsigned int cmd)
+{
+	switch(cmd) {
+	case CUDDLCI_MEMREGION_CLAIM_UIO_IOCTL:
+	case CUDDLCI_MEMREGION_CLAIM_UDD_IOCTL:
+	case CUDDLCI_GET_MEMREGION_INFO_IOCTL:
+	case CUDDLCI_EVENTSRC_CLAIM_UIO_IOCTL:
+	case CUDDLCI_EVENTSRC_CLAIM_UDD_IOCTL:
+	case CUDDLCI_GET_EVENTSRC_INFO_IOCTL:
+	case CUDDLCI_GET_MEMREGION_ID_IOCTL:
+	case CUDDLCI_GET_EVENTSRC_ID_IOCTL:
+	case CUDDLCI_GET_MEMREGION_REF_COUNT_IOCTL:
+	case CUDDLCI_GET_EVENTSRC_REF_COUNT_IOCTL:
+	case CUDDLCI_DECREMENT_MEMREGION_REF_COUNT_IOCTL:
+	case CUDDLCI_DECREMENT_EVENTSRC_REF_COUNT_IOCTL:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+static long _manager_ioctl(
+	struct file *file, unsigned int cmd, unsigned long arg)
+{
+	int read_only = _ioctl_is_read_only(cmd);
+	int srcu_idx = 0;
+	int slot;
+	int mslot;
+	int eslot;
+	int rt = 0;
+	int claim = 0;
+	int decrement = 0;
+	int ret = 0;
+	int freed_ref = 0;
+	struct cuddlk_device *dev;
+	union cuddlk_ioctl_small_data small;
+	union cuddlk_ioctl_large_data *large = NULL;
+	struct cuddlci_memregion_claim_ioctl_data *mdata = NULL;
+	struct cuddlci_eventsrc_claim_ioctl_data *edata = NULL;
+	struct cuddlci_get_resource_id_ioctl_data *get_id_data = NULL;
+	struct cuddlci_ref_count_ioctl_data *id_data = NULL;
+	struct cuddlci_memregion_release_ioctl_data *mrdata =
+		&small.mem_release;
+	struct cuddlci_eventsrc_release_ioctl_data *erdata =
+		&small.event_release;
+	struct cuddlci_get_kernel_commit_id_ioctl_data *commit_data =
+		&small.commit;
+	struct cuddlci_get_driver_info_ioctl_data *driver_info_data =
+		&small.driver_info;
+	struct cuddlci_void_ioctl_data *void_data = &small.void_data;
+	struct cuddlci_eventsrc_is_enabled_ioctl_data *is_enabled_data =
+		&small.is_enabled;
+	struct cuddlk_resource_ref *tmp_ref;
+	struct cuddlk_resource_ref *pos;
+
+	/*
+	 * Each payload is copied in full from user space by the command that
+	 * uses it, so neither buffer needs to be zeroed.
+	 */
+	if (_ioctl_has_large_data(cmd)) {
+		large = kmem_cache_alloc(cuddlk_ioctl_data_cache, GFP_KERNEL);
+		if (!large) {
+			cuddlk_print("kmem_cache_alloc failed\n");
+			return -ENOMEM;
+		}
+		mdata = &large->mem;
+		edata = &large->event;
+		get_id_data = &large->get_id;
+		id_data = &large->ref_count;
+	}
+
+	if (read_only)
+		srcu_idx = srcu_read_lock(
+			&cuddlk_global_manager_ptr->priv.srcu);
+	else
+		cuddlk_manager_lock();
 
 	switch(cmd) {
 	case CUDDLCI_MEMREGION_CLAIM_UDD_IOCTL:
@@ -403,7 +789,6 @@ static long cuddlk_manager_ioctl(
 		claim = 1;
 		fallthrough;
 	case CUDDLCI_GET_MEMREGION_INFO_IOCTL:
-		cuddlk_debug("CUDDLCI_MEMREGION_CLAIM_*/INFO_IOCTL called\n");
 		if (copy_from_user(mdata, (void*)arg, sizeof(*mdata))) {
 			cuddlk_print("copy_from_user failed\n");
 			ret = -EOVERFLOW;
@@ -417,10 +802,6 @@ static long cuddlk_manager_ioctl(
 			break;
 		}
 
-		cuddlk_debug("  %s %s %s %d (pid: %d)\n",
-			     mdata->id.group, mdata->id.device,
-			     mdata->id.resource, mdata->id.instance,
-			     mdata->pid);
 		slot = cuddlk_manager_find_device_slot_matching(
 			cuddlk_global_manager_ptr,
 			mdata->id.group, mdata->id.device, mdata->id.resource,
@@ -429,8 +810,12 @@ static long cuddlk_manager_ioctl(
 			ret = slot;
 			break;
 		}
-		dev = cuddlk_global_manager_ptr->devices[slot];
-		cuddlk_debug("  found slot: %d (dev_ptr: %p)\n", slot, dev);
+		dev = _get_device(slot);
+		if (!dev) {
+			/* Released since the lockless lookup */
+			ret = -ENXIO;
+			break;
+		}
 
 		mslot = cuddlk_device_find_memregion_slot(
 			dev, mdata->id.resource);
@@ -438,7 +823,6 @@ static long cuddlk_manager_ioctl(
 			ret = mslot;
 			break;
 		}
-		cuddlk_debug("  found mslot: %d\n", mslot);
 
 		if (claim) {
 			ret = _memregion_claim(
@@ -448,41 +832,19 @@ static long cuddlk_manager_ioctl(
 				break;
 		}
 
-		mdata->info.priv.token.device_index = slot;
-		mdata->info.priv.token.resource_index = mslot;
-		mdata->info.priv.pa_len = dev->mem[mslot].pa_len;
-		mdata->info.priv.start_offset = dev->mem[mslot].start_offset;
-		mdata->info.len = dev->mem[mslot].len;
-		mdata->info.flags = 0;
-		if (dev->mem[mslot].flags & CUDDLK_MEMF_SHARED)
-			mdata->info.flags |= CUDDL_MEMF_SHARED;
-		if (rt) {
-			mdata->info.priv.pa_mmap_offset = 0;
-			snprintf(mdata->info.priv.device_name,
-				 CUDDLCI_MAX_STR_LEN,
-				 "/dev/rtdm/%s,mapper%d",
-				 dev->priv.unique_name,
-				 mslot);
-		} else {
-			mdata->info.priv.pa_mmap_offset = \
-				mslot * CUDDLK_PAGE_SIZE;
-			snprintf(mdata->info.priv.device_name,
-				 CUDDLCI_MAX_STR_LEN,
-				 "/dev/uio%d",
-				 dev->priv.uio.uio_dev->minor);
-		}
+		_fill_memregion_info(&mdata->info, dev, slot, mslot, rt);
 		if (copy_to_user((void*)arg, mdata, sizeof(*mdata))) {
 			cuddlk_print("copy_to_user failed\n");
 			ret = -EOVERFLOW;
-			_memregion_decr_ref_count(&dev->mem[mslot]);
+			if (claim)
+				_memregion_decr_ref_count(&dev->mem[mslot]);
 			break;
 		}
 		if (claim) {
-			tmp_ref = kzalloc(
-				sizeof(struct cuddlk_resource_ref_list),
-				GFP_KERNEL);
+			tmp_ref = kmem_cache_zalloc(
+				cuddlk_ref_cache, GFP_KERNEL);
 			if (!tmp_ref) {
-				cuddlk_print("kzalloc failed for ref\n");
+				cuddlk_print("ref allocation failed\n");
 				ret = -ENOMEM;
 				_memregion_decr_ref_count(&dev->mem[mslot]);
 				break;
@@ -492,10 +854,8 @@ static long cuddlk_manager_ioctl(
 			tmp_ref->token.resource_index =
 				mdata->info.priv.token.resource_index;
 			tmp_ref->pid = mdata->pid;
-			list_add(&tmp_ref->list, &cuddlk_mem_refs.list);
+			hash_add(cuddlk_mem_refs, &tmp_ref->node, tmp_ref->pid);
 		}
-		cuddlk_debug("  success: ref_count: %d\n",
-		       dev->mem[mslot].kernel.ref_count);
 		break;
 
 	case CUDDLCI_EVENTSRC_CLAIM_UDD_IOCTL:
@@ -505,7 +865,6 @@ static long cuddlk_manager_ioctl(
 		claim = 1;
 		fallthrough;
 	case CUDDLCI_GET_EVENTSRC_INFO_IOCTL:
-		cuddlk_debug("CUDDLCI_EVENTSRC_CLAIM_*/INFO_IOCTL called\n");
 		if (copy_from_user(edata, (void*)arg, sizeof(*edata))) {
 			cuddlk_print("copy_from_user failed\n");
 			ret = -EOVERFLOW;
@@ -519,10 +878,6 @@ static long cuddlk_manager_ioctl(
 			break;
 		}
 
-		cuddlk_debug("  %s %s %s %d (pid: %d)\n",
-			     edata->id.group, edata->id.device,
-			     edata->id.resource, edata->id.instance,
-			     edata->pid);
 		slot = cuddlk_manager_find_device_slot_matching(
 			cuddlk_global_manager_ptr,
 			edata->id.group, edata->id.device, edata->id.resource,
@@ -531,8 +886,12 @@ static long cuddlk_manager_ioctl(
 			ret = slot;
 			break;
 		}
-		dev = cuddlk_global_manager_ptr->devices[slot];
-		cuddlk_debug("  found slot: %d (dev_ptr: %p)\n", slot, dev);
+		dev = _get_device(slot);
+		if (!dev) {
+			/* Released since the lockless lookup */
+			ret = -ENXIO;
+			break;
+		}
 
 		eslot = cuddlk_device_find_eventsrc_slot(
 			dev, edata->id.resource);
@@ -540,7 +899,6 @@ static long cuddlk_manager_ioctl(
 			ret = eslot;
 			break;
 		}
-		cuddlk_debug("  found eslot: %d\n", eslot);
 
 		if (claim) {
 			ret = _eventsrc_claim(
@@ -550,42 +908,19 @@ static long cuddlk_manager_ioctl(
 				break;
 		}
 
-		edata->info.priv.token.device_index = slot;
-		edata->info.priv.token.resource_index = eslot;
-		edata->info.flags = 0;
-		edata->info.flags |= CUDDL_EVENTSRCF_WAITABLE;
-		if (dev->events[eslot].flags & CUDDLK_EVENTSRCF_SHARED)
-			edata->info.flags |= CUDDL_EVENTSRCF_SHARED;
-		if (dev->events[eslot].intr.enable)
-			edata->info.flags |= CUDDL_EVENTSRCF_HAS_ENABLE;
-		if (dev->events[eslot].intr.disable)
-			edata->info.flags |= CUDDL_EVENTSRCF_HAS_DISABLE;
-		if (dev->events[eslot].intr.is_enabled)
-			edata->info.flags |= CUDDL_EVENTSRCF_HAS_IS_ENABLED;
-
-		if (rt) {
-			snprintf(edata->info.priv.device_name,
-				 CUDDLCI_MAX_STR_LEN,
-				 "/dev/rtdm/%s",
-				 dev->priv.unique_name);
-		} else {
-			snprintf(edata->info.priv.device_name,
-				 CUDDLCI_MAX_STR_LEN,
-				 "/dev/uio%d",
-				 dev->priv.uio.uio_dev->minor);
-		}
+		_fill_eventsrc_info(&edata->info, dev, slot, eslot, rt);
 		if (copy_to_user((void*)arg, edata, sizeof(*edata))) {
 			cuddlk_print("copy_to_user failed\n");
 			ret = -EOVERFLOW;
-			_eventsrc_decr_ref_count(&dev->events[eslot]);
+			if (claim)
+				_eventsrc_decr_ref_count(&dev->events[eslot]);
 			break;
 		}
 		if (claim) {
-			tmp_ref = kzalloc(
-				sizeof(struct cuddlk_resource_ref_list),
-				GFP_KERNEL);
+			tmp_ref = kmem_cache_zalloc(
+				cuddlk_ref_cache, GFP_KERNEL);
 			if (!tmp_ref) {
-				cuddlk_print("kzalloc failed for ref\n");
+				cuddlk_print("ref allocation failed\n");
 				ret = -ENOMEM;
 				_eventsrc_decr_ref_count(&dev->events[eslot]);
 				break;
@@ -595,17 +930,15 @@ static long cuddlk_manager_ioctl(
 			tmp_ref->token.resource_index =
 				edata->info.priv.token.resource_index;
 			tmp_ref->pid = edata->pid;
-			list_add(&tmp_ref->list, &cuddlk_event_refs.list);
+			hash_add(cuddlk_event_refs, &tmp_ref->node,
+				 tmp_ref->pid);
 		}
-		cuddlk_debug("  success: ref_count: %d\n",
-		       dev->events[eslot].kernel.ref_count);
 		break;
 
 	case CUDDLCI_MEMREGION_RELEASE_UDD_IOCTL:
 		rt = 1;
 		fallthrough;
 	case CUDDLCI_MEMREGION_RELEASE_UIO_IOCTL:
-		cuddlk_debug("CUDDLCI_MEMREGION_RELEASE_*_IOCTL called\n");
 		if (copy_from_user(mrdata, (void*)arg, sizeof(*mrdata))) {
 			cuddlk_print("copy_from_user failed\n");
 			ret = -EOVERFLOW;
@@ -621,54 +954,43 @@ static long cuddlk_manager_ioctl(
 
 		slot = mrdata->token.device_index;
 		mslot = mrdata->token.resource_index;
-		cuddlk_debug("  token: %d %d (pid: %d)\n", slot, mslot,
-			     mrdata->pid);
 
 		if ((slot >= CUDDLK_MAX_MANAGED_DEVICES) || (slot < 0)) {
 			ret = -EBADSLT;
 			break;
 		}
-		dev = cuddlk_global_manager_ptr->devices[slot];
+		dev = _get_device(slot);
 		if (!dev) {
 			ret = -ENODEV;
 			break;
 		}
-		cuddlk_debug("  found slot: %d (dev_ptr: %p)\n", slot, dev);
 
 		if ((mslot >= CUDDLK_MAX_DEV_MEM_REGIONS) || (mslot < 0)) {
 			ret = -EBADSLT;
 			break;
 		}
-		cuddlk_debug("  found mslot: %d\n", mslot);
 
 		_memregion_decr_ref_count(&dev->mem[mslot]);
 		freed_ref = 0;
-		list_for_each_entry_safe(
-			pos, tmp, &cuddlk_mem_refs.list, list) {
+		hash_for_each_possible(
+			cuddlk_mem_refs, pos, node, mrdata->pid) {
 			if ((slot        == pos->token.device_index) &&
 			    (mslot       == pos->token.resource_index) &&
 			    (mrdata->pid == pos->pid)) {
-				cuddlk_debug("clean up ref for pid %d, "
-					     "mem slot: %d %d\n",
-					     pos->pid, slot, mslot);
-				ref_to_free = pos;
-				list_del(&pos->list);
-				kfree(ref_to_free);
+				hash_del(&pos->node);
+				kmem_cache_free(cuddlk_ref_cache, pos);
 				freed_ref = 1;
 				break;
 			}
 		}
 		if (!freed_ref)
 			cuddlk_print("could not clean up mem ref\n");
-		cuddlk_debug("  success: ref_count: %d\n",
-		       dev->mem[mslot].kernel.ref_count);
 		break;
 
 	case CUDDLCI_EVENTSRC_RELEASE_UDD_IOCTL:
 		rt = 1;
 		fallthrough;
 	case CUDDLCI_EVENTSRC_RELEASE_UIO_IOCTL:
-		cuddlk_debug("CUDDLCI_EVENTSRC_RELEASE_*_IOCTL called\n");
 		if (copy_from_user(erdata, (void*)arg, sizeof(*erdata))) {
 			cuddlk_print("copy_from_user failed\n");
 			ret = -EOVERFLOW;
@@ -684,51 +1006,40 @@ static long cuddlk_manager_ioctl(
 
 		slot = erdata->token.device_index;
 		eslot = erdata->token.resource_index;
-		cuddlk_debug("  token: %d %d (pid: %d)\n", slot, eslot,
-			     erdata->pid);
 
 		if ((slot >= CUDDLK_MAX_MANAGED_DEVICES) || (slot < 0)) {
 			ret = -EBADSLT;
 			break;
 		}
-		dev = cuddlk_global_manager_ptr->devices[slot];
+		dev = _get_device(slot);
 		if (!dev) {
 			ret = -ENODEV;
 			break;
 		}
-		cuddlk_debug("  found slot: %d (dev_ptr: %p)\n", slot, dev);
 
 		if ((eslot >= CUDDLK_MAX_DEV_EVENTS) || (eslot < 0)) {
 			ret = -EBADSLT;
 			break;
 		}
-		cuddlk_debug("  found eslot: %d\n", eslot);
 
 		_eventsrc_decr_ref_count(&dev->events[eslot]);
 		freed_ref = 0;
-		list_for_each_entry_safe(
-			pos, tmp, &cuddlk_event_refs.list, list) {
+		hash_for_each_possible(
+			cuddlk_event_refs, pos, node, erdata->pid) {
 			if ((slot        == pos->token.device_index) &&
 			    (eslot       == pos->token.resource_index) &&
 			    (erdata->pid == pos->pid)) {
-				cuddlk_debug("clean up ref for pid %d, "
-					     "event slot: %d %d\n",
-					     pos->pid, slot, eslot);
-				ref_to_free = pos;
-				list_del(&pos->list);
-				kfree(ref_to_free);
+				hash_del(&pos->node);
+				kmem_cache_free(cuddlk_ref_cache, pos);
 				freed_ref = 1;
 				break;
 			}
 		}
 		if (!freed_ref)
 			cuddlk_print("could not clean up event ref\n");
-		cuddlk_debug("  success: ref_count: %d\n",
-		       dev->events[eslot].kernel.ref_count);
 		break;
 
 	case CUDDLCI_GET_MAX_MANAGED_DEVICES_IOCTL:
-		cuddlk_debug("CUDDLCI_GET_MAX_MANAGED_DEVICES_IOCTL called\n");
 		if (copy_from_user(
 			    void_data, (void*)arg, sizeof(*void_data))) {
 			cuddlk_print("copy_from_user failed\n");
@@ -742,12 +1053,9 @@ static long cuddlk_manager_ioctl(
 			break;
 		}
 		ret = CUDDLK_MAX_MANAGED_DEVICES;
-		cuddlk_debug("  success\n");
 		break;
 
 	case CUDDLCI_GET_MAX_DEV_MEM_REGIONS_IOCTL:
-		cuddlk_debug(
-			"CUDDLCI_GET_MAX_DEV_MEM_REGIONS_IOCTL called\n");
 		if (copy_from_user(
 			    void_data, (void*)arg, sizeof(*void_data))) {
 			cuddlk_print("copy_from_user failed\n");
@@ -761,11 +1069,9 @@ static long cuddlk_manager_ioctl(
 			break;
 		}
 		ret = CUDDLK_MAX_DEV_MEM_REGIONS;
-		cuddlk_debug("  success\n");
 		break;
 
 	case CUDDLCI_GET_MAX_DEV_EVENTS_IOCTL:
-		cuddlk_debug("CUDDLCI_GET_MAX_DEV_EVENTS_IOCTL called\n");
 		if (copy_from_user(
 			    void_data, (void*)arg, sizeof(*void_data))) {
 			cuddlk_print("copy_from_user failed\n");
@@ -779,11 +1085,9 @@ static long cuddlk_manager_ioctl(
 			break;
 		}
 		ret = CUDDLK_MAX_DEV_EVENTS;
-		cuddlk_debug("  success\n");
 		break;
 
 	case CUDDLCI_GET_MEMREGION_ID_IOCTL:
-		cuddlk_debug("CUDDLCI_GET_MEMREGION_ID_IOCTL called\n");
 		if (copy_from_user(
 			    get_id_data, (void*)arg, sizeof(*get_id_data))) {
 			cuddlk_print("copy_from_user failed\n");
@@ -800,28 +1104,22 @@ static long cuddlk_manager_ioctl(
 
 		slot = get_id_data->device_slot;
 		mslot = get_id_data->resource_slot;
-		cuddlk_debug("  device_slot: %d, resource_slot: %d\n",
-			     slot, mslot);
 
 		if ((slot < 0) || (slot >= CUDDLK_MAX_MANAGED_DEVICES)) {
-			cuddlk_debug("device slot out of range\n");
 			ret = -EBADSLT;
 			break;
 		}
 		if ((mslot < 0) || (mslot >= CUDDLK_MAX_DEV_MEM_REGIONS)) {
-			cuddlk_debug("mem region slot out of range\n");
 			ret = -EBADSLT;
 			break;
 		}
 
-		dev = cuddlk_global_manager_ptr->devices[slot];
+		dev = _get_device(slot);
 		if (!dev) {
-			cuddlk_debug("empty device slot\n");
 			ret = -ENODEV;
 			break;
 		}
 		if(dev->mem[mslot].type == CUDDLK_MEMT_NONE) {
-			cuddlk_debug("empty mem region slot\n");
 			ret = -EINVAL;
 			break;
 		}
@@ -837,11 +1135,9 @@ static long cuddlk_manager_ioctl(
 			ret = -EOVERFLOW;
 			break;
 		}
-		cuddlk_debug("  success\n");
 		break;
 
 	case CUDDLCI_GET_EVENTSRC_ID_IOCTL:
-		cuddlk_debug("CUDDLCI_GET_EVENTSRC_ID_IOCTL called\n");
 		if (copy_from_user(
 			    get_id_data, (void*)arg, sizeof(*get_id_data))) {
 			cuddlk_print("copy_from_user failed\n");
@@ -858,28 +1154,23 @@ static long cuddlk_manager_ioctl(
 
 		slot = get_id_data->device_slot;
 		eslot = get_id_data->resource_slot;
-		cuddlk_debug("  device_slot: %d, resource_slot: %d\n",
-			     slot, eslot);
 
 		if ((slot < 0) || (slot >= CUDDLK_MAX_MANAGED_DEVICES)) {
-			cuddlk_debug("device slot out of range\n");
 			ret = -EBADSLT;
 			break;
 		}
 		if ((eslot < 0) || (eslot >= CUDDLK_MAX_DEV_EVENTS)) {
-			cuddlk_debug("event slot out of range\n");
 			ret = -EBADSLT;
 			break;
 		}
 
-		dev = cuddlk_global_manager_ptr->devices[slot];
+		dev = _get_device(slot);
 		if (!dev) {
-			cuddlk_debug("empty device slot\n");
 			ret = -ENODEV;
 			break;
 		}
-		if(dev->events[eslot].intr.irq == CUDDLK_IRQ_NONE) {
-			cuddlk_debug("empty event slot\n");
+		if ((dev->events[eslot].intr.irq == CUDDLK_IRQ_NONE) ||
+		    !dev->events[eslot].name) {
 			ret = -EINVAL;
 			break;
 		}
@@ -895,15 +1186,12 @@ static long cuddlk_manager_ioctl(
 			ret = -EOVERFLOW;
 			break;
 		}
-		cuddlk_debug("  success\n");
 		break;
 
 	case CUDDLCI_DECREMENT_MEMREGION_REF_COUNT_IOCTL:
 		decrement = 1;
 		fallthrough;
 	case CUDDLCI_GET_MEMREGION_REF_COUNT_IOCTL:
-		cuddlk_debug(
-			"CUDDLCI_GET_MEMREGION_REF_COUNT_IOCTL called\n");
 		if (copy_from_user(
 			    id_data, (void*)arg, sizeof(*id_data))) {
 			cuddlk_print("copy_from_user failed\n");
@@ -918,9 +1206,6 @@ static long cuddlk_manager_ioctl(
 			break;
 		}
 
-		cuddlk_debug("  %s %s %s %d\n",
-			     id_data->id.group, id_data->id.device,
-			     id_data->id.resource, id_data->id.instance);
 		slot = cuddlk_manager_find_device_slot_matching(
 			cuddlk_global_manager_ptr,
 			id_data->id.group, id_data->id.device,
@@ -930,8 +1215,12 @@ static long cuddlk_manager_ioctl(
 			ret = slot;
 			break;
 		}
-		dev = cuddlk_global_manager_ptr->devices[slot];
-		cuddlk_debug("  found slot: %d (dev_ptr: %p)\n", slot, dev);
+		dev = _get_device(slot);
+		if (!dev) {
+			/* Released since the lockless lookup */
+			ret = -ENXIO;
+			break;
+		}
 
 		mslot = cuddlk_device_find_memregion_slot(
 			dev, id_data->id.resource);
@@ -939,7 +1228,6 @@ static long cuddlk_manager_ioctl(
 			ret = mslot;
 			break;
 		}
-		cuddlk_debug("  found mslot: %d\n", mslot);
 
 		if (decrement) {
 			ret = _memregion_decr_ref_count(&dev->mem[mslot]);
@@ -948,14 +1236,12 @@ static long cuddlk_manager_ioctl(
 		} else {
 			ret = dev->mem[mslot].kernel.ref_count;
 		}
-		cuddlk_debug("  success\n");
 		break;
 
 	case CUDDLCI_DECREMENT_EVENTSRC_REF_COUNT_IOCTL:
 		decrement = 1;
 		fallthrough;
 	case CUDDLCI_GET_EVENTSRC_REF_COUNT_IOCTL:
-		cuddlk_debug("CUDDLCI_GET_EVENTSRC_REF_COUNT_IOCTL called\n");
 		if (copy_from_user(
 			    id_data, (void*)arg, sizeof(*id_data))) {
 			cuddlk_print("copy_from_user failed\n");
@@ -970,9 +1256,6 @@ static long cuddlk_manager_ioctl(
 			break;
 		}
 
-		cuddlk_debug("  %s %s %s %d\n",
-			     id_data->id.group, id_data->id.device,
-			     id_data->id.resource, id_data->id.instance);
 		slot = cuddlk_manager_find_device_slot_matching(
 			cuddlk_global_manager_ptr,
 			id_data->id.group, id_data->id.device,
@@ -982,8 +1265,12 @@ static long cuddlk_manager_ioctl(
 			ret = slot;
 			break;
 		}
-		dev = cuddlk_global_manager_ptr->devices[slot];
-		cuddlk_debug("  found slot: %d (dev_ptr: %p)\n", slot, dev);
+		dev = _get_device(slot);
+		if (!dev) {
+			/* Released since the lockless lookup */
+			ret = -ENXIO;
+			break;
+		}
 
 		eslot = cuddlk_device_find_eventsrc_slot(
 			dev, id_data->id.resource);
@@ -991,7 +1278,6 @@ static long cuddlk_manager_ioctl(
 			ret = eslot;
 			break;
 		}
-		cuddlk_debug("  found eslot: %d\n", eslot);
 
 		if (decrement) {
 			ret = _eventsrc_decr_ref_count(&dev->events[eslot]);
@@ -1000,7 +1286,6 @@ static long cuddlk_manager_ioctl(
 		} else {
 			ret = dev->events[eslot].kernel.ref_count;
 		}
-		cuddlk_debug("  success\n");
 		break;
 
 	case CUDDLCI_JANITOR_REGISTER_PID_IOCTL:
@@ -1011,7 +1296,6 @@ static long cuddlk_manager_ioctl(
 		break;
 
 	case CUDDLCI_GET_KERNEL_COMMIT_ID_IOCTL:
-		cuddlk_debug("CUDDLCI_GET_KERNEL_COMMIT_ID_IOCTL called\n");
 		if (copy_from_user(
 			    commit_data, (void*)arg, sizeof(*commit_data))) {
 			cuddlk_print("copy_from_user failed\n");
@@ -1033,12 +1317,9 @@ static long cuddlk_manager_ioctl(
 			ret = -EOVERFLOW;
 			break;
 		}
-		cuddlk_debug("  success\n");
 		break;
 
 	case CUDDLCI_GET_DRIVER_INFO_IOCTL:
-		cuddlk_debug(
-			"CUDDLCI_GET_DRIVER_INFO_IOCTL called\n");
 		if (copy_from_user(
 			    driver_info_data, (void*)arg,
 			    sizeof(*driver_info_data)))
@@ -1057,17 +1338,14 @@ static long cuddlk_manager_ioctl(
 		}
 
 		slot = driver_info_data->device_slot;
-		cuddlk_debug("  device_slot: %d\n", slot);
 
 		if ((slot < 0) || (slot >= CUDDLK_MAX_MANAGED_DEVICES)) {
-			cuddlk_debug("device slot out of range\n");
 			ret = -EBADSLT;
 			break;
 		}
 
-		dev = cuddlk_global_manager_ptr->devices[slot];
+		dev = _get_device(slot);
 		if (!dev) {
-			cuddlk_debug("empty device slot\n");
 			ret = -ENODEV;
 			break;
 		}
@@ -1085,12 +1363,9 @@ static long cuddlk_manager_ioctl(
 			ret = -EOVERFLOW;
 			break;
 		}
-		cuddlk_debug("  success\n");
 		break;
 
 	case CUDDLCI_GET_HW_INFO_IOCTL:
-		cuddlk_debug(
-			"CUDDLCI_GET_HW_INFO_IOCTL called\n");
 		if (copy_from_user(
 			    driver_info_data, (void*)arg,
 			    sizeof(*driver_info_data)))
@@ -1109,17 +1384,14 @@ static long cuddlk_manager_ioctl(
 		}
 
 		slot = driver_info_data->device_slot;
-		cuddlk_debug("  device_slot: %d\n", slot);
 
 		if ((slot < 0) || (slot >= CUDDLK_MAX_MANAGED_DEVICES)) {
-			cuddlk_debug("device slot out of range\n");
 			ret = -EBADSLT;
 			break;
 		}
 
-		dev = cuddlk_global_manager_ptr->devices[slot];
+		dev = _get_device(slot);
 		if (!dev) {
-			cuddlk_debug("empty device slot\n");
 			ret = -ENODEV;
 			break;
 		}
@@ -1137,12 +1409,9 @@ static long cuddlk_manager_ioctl(
 			ret = -EOVERFLOW;
 			break;
 		}
-		cuddlk_debug("  success\n");
 		break;
 
 	case CUDDLCI_GET_KERNEL_VERSION_CODE_IOCTL:
-		cuddlk_debug(
-			"CUDDLCI_GET_KERNEL_VERSION_CODE_IOCTL called\n");
 		if (copy_from_user(
 			    void_data, (void*)arg, sizeof(*void_data))) {
 			cuddlk_print("copy_from_user failed\n");
@@ -1155,12 +1424,10 @@ static long cuddlk_manager_ioctl(
 			ret = -ENOEXEC;
 			break;
 		}
-		cuddlk_debug("  success\n");
 		ret = CUDDLK_VERSION_CODE;
 		break;
 
 	case CUDDLCI_GET_KERNEL_VARIANT_IOCTL:
-		cuddlk_debug("CUDDLCI_GET_KERNEL_VARIANT_IOCTL called\n");
 		if (copy_from_user(
 			    commit_data, (void*)arg, sizeof(*commit_data))) {
 			cuddlk_print("copy_from_user failed\n");
@@ -1182,12 +1449,9 @@ static long cuddlk_manager_ioctl(
 			ret = -EOVERFLOW;
 			break;
 		}
-		cuddlk_debug("  success\n");
 		break;
 
 	case CUDDLCI_EVENTSRC_IS_ENABLED_IOCTL:
-		cuddlk_debug(
-			"CUDDLCI_EVENTSRC_IS_ENABLED_IOCTL called\n");
 		if (copy_from_user(
 			    is_enabled_data, (void*)arg,
 			    sizeof(*is_enabled_data))) {
@@ -1203,22 +1467,19 @@ static long cuddlk_manager_ioctl(
 		}
 		slot = is_enabled_data->token.device_index;
 		eslot = is_enabled_data->token.resource_index;
-		cuddlk_debug("  token: %d %d\n", slot, eslot);
 		if ((slot >= CUDDLK_MAX_MANAGED_DEVICES) || (slot < 0)) {
 			ret = -EBADSLT;
 			break;
 		}
-		dev = cuddlk_global_manager_ptr->devices[slot];
+		dev = _get_device(slot);
 		if (!dev) {
 			ret = -ENODEV;
 			break;
 		}
-		cuddlk_debug("  found slot: %d (dev_ptr: %p)\n", slot, dev);
 		if ((eslot >= CUDDLK_MAX_DEV_EVENTS) || (eslot < 0)) {
 			ret = -EBADSLT;
 			break;
 		}
-		cuddlk_debug("  found eslot: %d\n", eslot);
 		if (!dev->events[eslot].intr.is_enabled) {
 			ret = -EINVAL;
 			break;
@@ -1227,7 +1488,20 @@ static long cuddlk_manager_ioctl(
 			&dev->events[eslot].intr);
 		if (ret < 0)
 			break;
-		cuddlk_debug("  success\n");
+		if (dev->events[eslot].priv.status)
+			cuddlki_eventsrc_set_enabled(
+				&dev->events[eslot].priv, ret);
+		break;
+
+	case CUDDLCI_EVENTSRC_GET_RECORD_IOCTL:
+		ret = _eventsrc_get_record((void __user *) arg);
+		break;
+
+	case CUDDLCI_CLAIM_BATCH_UDD_IOCTL:
+		rt = 1;
+		fallthrough;
+	case CUDDLCI_CLAIM_BATCH_UIO_IOCTL:
+		ret = _claim_batch((void __user *) arg, rt);
 		break;
 
 	default:
@@ -1235,28 +1509,388 @@ static long cuddlk_manager_ioctl(
 		ret = -ENOSYS;
 	}
 
+	if (read_only)
+		srcu_read_unlock(
+			&cuddlk_global_manager_ptr->priv.srcu, srcu_idx);
+	else
+		cuddlk_manager_unlock();
+
+	if (large)
+		kmem_cache_free(cuddlk_ioctl_data_cache, large);
+	return ret;
+}
+
+static int _memregion_claimed_by(int slot, int mslot, pid_t pid)
+{
+	struct cuddlk_resource_ref *pos;
+
+	hash_for_each_possible(cuddlk_mem_refs, pos, node, pid) {
+		if ((pos->token.device_index == slot) &&
+		    (pos->token.resource_index == mslot) &&
+		    (pos->pid == pid))
+			return 1;
+	}
+	return 0;
+}
+
+/*
+ * State shared by the VMAs of a memory region mapping made via the manager
+ * device.  The mapping holds a reference on the module that owns the
+ * device, and on the pages backing ``CUDDLK_MEMT_LOGICAL`` regions and DMA
+ * buffers allocated from system RAM (or on the buffer itself if it came
+ * from ``dma_alloc_coherent()``), so that these outlive the device if it is
+ * unregistered while it is still mapped.  The VMAs of a mapping are
+ * counted in ``users``, and the references are dropped when the last one is
+ * unmapped.
+ */
+struct _memregion_mapping {
+	refcount_t users;
+	struct module *owner;
+	struct cuddlk_device *dev;
+	int slot;
+	unsigned long pfn_delta;
+	void *pinned_addr;
+	unsigned long pinned_len;
+	struct cuddlki_dma_buffer *dma_buf;
+};
+
+static void _memregion_mapping_put(struct _memregion_mapping *map)
+{
+	unsigned long off;
+
+	if (!refcount_dec_and_test(&map->users))
+		return;
+
+	for (off=0; off < map->pinned_len; off+=PAGE_SIZE)
+		put_page(virt_to_page(map->pinned_addr + off));
+	cuddlki_dma_buffer_put(map->dma_buf);
+	module_put(map->owner);
+	kfree(map);
+}
+
+static void _memregion_vm_open(struct vm_area_struct *vma)
+{
+	struct _memregion_mapping *map = vma->vm_private_data;
+
+	refcount_inc(&map->users);
+}
+
+static void _memregion_vm_close(struct vm_area_struct *vma)
+{
+	_memregion_mapping_put(vma->vm_private_data);
+}
+
+static const struct vm_operations_struct _memregion_vm_ops = {
+	.open = _memregion_vm_open,
+	.close = _memregion_vm_close,
+};
+
+#ifdef CONFIG_ARCH_SUPPORTS_HUGE_PFNMAP
+/*
+ * Page fault handler for memory regions mapped with huge pages.  The
+ * ``pfn_delta`` field of the mapping holds the difference between the page
+ * frame number and the virtual page number, which (unlike an offset from
+ * ``vm_start``) remains valid if the VMA is split.  No more pages are
+ * inserted once the device has been removed from the manager.
+ */
+static vm_fault_t _memregion_huge_fault(struct vm_fault *vmf,
+					unsigned int order)
+{
+	struct vm_area_struct *vma = vmf->vma;
+	struct _memregion_mapping *map = vma->vm_private_data;
+	unsigned long size = PAGE_SIZE << order;
+	unsigned long addr = ALIGN_DOWN(vmf->address, size);
+	unsigned long pfn;
+	vm_fault_t ret;
+	int srcu_idx;
+
+	pfn = (addr >> PAGE_SHIFT) + map->pfn_delta;
+	if (order && ((addr < vma->vm_start) ||
+		      (addr + size > vma->vm_end) ||
+		      (pfn & ((1UL << order) - 1))))
+		return VM_FAULT_FALLBACK;
+
+	srcu_idx = srcu_read_lock(&cuddlk_global_manager_ptr->priv.srcu);
+	if (_get_device(map->slot) != map->dev) {
+		ret = VM_FAULT_SIGBUS;
+		goto unlock;
+	}
+
+	switch (order) {
+	case 0:
+		ret = vmf_insert_pfn(vma, addr, pfn);
+		break;
+#ifdef CONFIG_ARCH_SUPPORTS_PMD_PFNMAP
+	case PMD_ORDER:
+		ret = vmf_insert_pfn_pmd(vmf, pfn_dev_compat(pfn),
+					 vmf->flags & FAULT_FLAG_WRITE);
+		break;
+#endif
+#ifdef CONFIG_ARCH_SUPPORTS_PUD_PFNMAP
+	case PUD_ORDER:
+		ret = vmf_insert_pfn_pud(vmf, pfn_dev_compat(pfn),
+					 vmf->flags & FAULT_FLAG_WRITE);
+		break;
+#endif
+	default:
+		ret = VM_FAULT_FALLBACK;
+		break;
+	}
+
+unlock:
+	srcu_read_unlock(&cuddlk_global_manager_ptr->priv.srcu, srcu_idx);
+	return ret;
+}
+
+static vm_fault_t _memregion_fault(struct vm_fault *vmf)
+{
+	return _memregion_huge_fault(vmf, 0);
+}
+
+/* Pages are inserted lazily, so the mapping must not be moved */
+static int _memregion_mremap(struct vm_area_struct *vma)
+{
+	return -EINVAL;
+}
+
+static const struct vm_operations_struct _memregion_huge_vm_ops = {
+	.open = _memregion_vm_open,
+	.close = _memregion_vm_close,
+	.fault = _memregion_fault,
+	.huge_fault = _memregion_huge_fault,
+	.mremap = _memregion_mremap,
+};
+#endif /* CONFIG_ARCH_SUPPORTS_HUGE_PFNMAP */
+
+/*
+ * Map a memory region with an explicit caching mode and/or huge pages, or
+ * map a DMA buffer (with the attributes chosen by the DMA API).  The page
+ * offset selects the memory region and mode, as described for the
+ * ``mode_mmap_offset`` field of the memory region information.  The calling
+ * process must have claimed the memory region, and the driver must permit
+ * the requested caching mode.  Huge pages are only used if the memory
+ * region supports them; otherwise, the memory region is mapped with normal
+ * pages.
+ */
+static int _memregion_mmap(struct vm_area_struct *vma)
+{
+	static const int mode_flags[CUDDLCI_MEM_MAP_HUGE] = {
+		[CUDDLCI_MEM_MAP_UNCACHED] = CUDDL_MEMF_MAP_UNCACHED,
+		[CUDDLCI_MEM_MAP_WRITE_COMBINE] = CUDDL_MEMF_MAP_WRITE_COMBINE,
+		[CUDDLCI_MEM_MAP_CACHED] = CUDDL_MEMF_MAP_CACHED,
+	};
+	const struct vm_operations_struct *vm_ops = &_memregion_vm_ops;
+	unsigned long index = vma->vm_pgoff - CUDDLCI_MEM_MMAP_PGOFF;
+	unsigned long len = vma->vm_end - vma->vm_start;
+	unsigned long off;
+	unsigned long pfn = 0;
+	struct _memregion_mapping *map;
+	struct cuddlk_memregion *mem;
+	struct cuddlk_device *dev;
+	int slot;
+	int mslot;
+	int mode;
+	int huge;
+	int ret;
+
+	mode = index % CUDDLCI_MEM_MAP_MODES;
+	index /= CUDDLCI_MEM_MAP_MODES;
+	huge = mode & CUDDLCI_MEM_MAP_HUGE;
+	mode &= ~CUDDLCI_MEM_MAP_HUGE;
+	if (index >= (unsigned long) CUDDLK_MAX_MANAGED_DEVICES *
+	    CUDDLK_MAX_DEV_MEM_REGIONS)
+		return -EBADSLT;
+	slot = index / CUDDLK_MAX_DEV_MEM_REGIONS;
+	mslot = index % CUDDLK_MAX_DEV_MEM_REGIONS;
+
+	map = kzalloc(sizeof(*map), GFP_KERNEL);
+	if (!map)
+		return -ENOMEM;
+	refcount_set(&map->users, 1);
+	map->slot = slot;
+
+	cuddlk_manager_lock();
+
+	dev = _get_device(slot);
+	if (!dev || (dev->mem[mslot].type == CUDDLK_MEMT_NONE)) {
+		ret = -ENODEV;
+		goto unlock;
+	}
+	mem = &dev->mem[mslot];
+	if (!_memregion_claimed_by(slot, mslot, task_tgid_nr(current))) {
+		ret = -EACCES;
+		goto unlock;
+	}
+	if ((mode != CUDDLCI_MEM_MAP_DEFAULT) &&
+	    !(_memregion_map_flags(mem) & mode_flags[mode])) {
+		ret = -EPERM;
+		goto unlock;
+	}
+	if (len > mem->pa_len) {
+		ret = -EINVAL;
+		goto unlock;
+	}
+	if (!try_module_get(dev->owner_ptr)) {
+		ret = -ENODEV;
+		goto unlock;
+	}
+	map->owner = dev->owner_ptr;
+	map->dev = dev;
+
+	/* Linux UIO maps physical memory regions uncached by default */
+	if ((mode == CUDDLCI_MEM_MAP_UNCACHED) ||
+	    ((mode == CUDDLCI_MEM_MAP_DEFAULT) &&
+	     (mem->type == CUDDLK_MEMT_PHYS)))
+		vma->vm_page_prot = pgprot_noncached(vma->vm_page_prot);
+	else if (mode == CUDDLCI_MEM_MAP_WRITE_COMBINE)
+		vma->vm_page_prot = pgprot_writecombine(vma->vm_page_prot);
+
+	/*
+	 * Buffers from dma_alloc_coherent() are not necessarily in the linear
+	 * map, so they are mapped without computing a pfn.
+	 */
+	if ((mem->type == CUDDLK_MEMT_DMA) && mem->priv.dma_buf) {
+		map->dma_buf = cuddlki_dma_buffer_get(mem->priv.dma_buf);
+		/* The page offset is relative to the DMA buffer */
+		vma->vm_pgoff = 0;
+		ret = dma_mmap_coherent(
+			map->dma_buf->dev, vma, map->dma_buf->cpu_addr,
+			map->dma_buf->dma_addr, len);
+		goto unlock;
+	}
+
+	/* DMA buffers without a DMA device come from the page allocator */
+	if (mem->type == CUDDLK_MEMT_PHYS) {
+		pfn = mem->pa_addr >> PAGE_SHIFT;
+	} else if ((mem->type == CUDDLK_MEMT_LOGICAL) ||
+		   (mem->type == CUDDLK_MEMT_DMA)) {
+		pfn = virt_to_phys((void *) mem->pa_addr) >> PAGE_SHIFT;
+		map->pinned_addr = (void *) mem->pa_addr;
+		map->pinned_len = len;
+		for (off=0; off < len; off+=PAGE_SIZE)
+			get_page(virt_to_page(map->pinned_addr + off));
+	}
+
+#ifdef CONFIG_ARCH_SUPPORTS_HUGE_PFNMAP
+	if (huge && _memregion_huge_page_size(mem)) {
+		vm_flags_set_compat(vma, VM_PFNMAP | VM_DONTEXPAND |
+				    VM_DONTDUMP | VM_HUGEPAGE);
+		if (mem->type == CUDDLK_MEMT_PHYS)
+			vm_flags_set_compat(vma, VM_IO);
+		map->pfn_delta = pfn - (vma->vm_start >> PAGE_SHIFT);
+		vm_ops = &_memregion_huge_vm_ops;
+		ret = 0;
+		goto unlock;
+	}
+#endif
+
+	switch (mem->type) {
+	case CUDDLK_MEMT_PHYS:
+		ret = io_remap_pfn_range(vma, vma->vm_start, pfn, len,
+					 vma->vm_page_prot);
+		break;
+	case CUDDLK_MEMT_DMA:
+	case CUDDLK_MEMT_LOGICAL:
+		ret = remap_pfn_range(vma, vma->vm_start, pfn, len,
+				      vma->vm_page_prot);
+		break;
+	default: /* CUDDLK_MEMT_VIRTUAL */
+		ret = 0;
+		for (off=0; (off < len) && !ret; off+=PAGE_SIZE) {
+			ret = vm_insert_page(
+				vma, vma->vm_start + off,
+				vmalloc_to_page((void *) (mem->pa_addr + off)));
+		}
+		break;
+	}
+
+unlock:
 	cuddlk_manager_unlock();
 
-	kfree(is_enabled_data);
-	kfree(id_data);
-	kfree(void_data);
-	kfree(driver_info_data);
-	kfree(commit_data);
-	kfree(get_id_data);
-	kfree(erdata);
-	kfree(mrdata);
-	kfree(edata);
-	kfree(mdata);
+	if (ret) {
+		_memregion_mapping_put(map);
+		return ret;
+	}
+	vma->vm_private_data = map;
+	vma->vm_ops = vm_ops;
+	return 0;
+}
+
+/*
+ * Map the read-only status page of an event source.  The page offset
+ * selects the event source, as reported in the ``status_mmap_offset`` field
+ * of the event source information.  Page offsets starting at
+ * ``CUDDLCI_MEM_MMAP_PGOFF`` map memory regions instead.
+ */
+static int cuddlk_manager_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	int slot;
+	int eslot;
+	int ret;
+	struct cuddlk_device *dev;
+	struct page *page;
+
+	BUILD_BUG_ON((unsigned long) CUDDLK_MAX_MANAGED_DEVICES *
+		     CUDDLK_MAX_DEV_EVENTS > CUDDLCI_MEM_MMAP_PGOFF);
+
+	if (vma->vm_pgoff >= CUDDLCI_MEM_MMAP_PGOFF)
+		return _memregion_mmap(vma);
+
+	if ((vma->vm_end - vma->vm_start) != CUDDLK_PAGE_SIZE)
+		return -EINVAL;
+	if (vma->vm_flags & VM_WRITE)
+		return -EPERM;
+	if (vma->vm_pgoff >=
+	    (unsigned long) CUDDLK_MAX_MANAGED_DEVICES * CUDDLK_MAX_DEV_EVENTS)
+		return -EBADSLT;
+
+	slot = vma->vm_pgoff / CUDDLK_MAX_DEV_EVENTS;
+	eslot = vma->vm_pgoff % CUDDLK_MAX_DEV_EVENTS;
+
+	cuddlk_manager_lock();
+
+	dev = _get_device(slot);
+	if (!dev) {
+		ret = -ENODEV;
+		goto unlock;
+	}
+	page = dev->events[eslot].priv.status_page;
+	if (!page) {
+		ret = -ENODEV;
+		goto unlock;
+	}
+
+	vm_flags_clear_compat(vma, VM_MAYWRITE);
+	ret = vm_insert_page(vma, vma->vm_start, page);
+
+unlock:
+	cuddlk_manager_unlock();
+	return ret;
+}
+
+static long cuddlk_manager_ioctl(
+	struct file *file, unsigned int cmd, unsigned long arg)
+{
+	long ret;
+
+	trace_cuddl_manager_ioctl_entry(cmd);
+	ret = _manager_ioctl(file, cmd, arg);
+	trace_cuddl_manager_ioctl_exit(cmd, ret);
+
 	return ret;
 }
 
 const struct file_operations cuddlk_manager_fops = {
     .owner = THIS_MODULE,
     .unlocked_ioctl = cuddlk_manager_ioctl,
+    .mmap = cuddlk_manager_mmap,
 };
 
 enum cuddlk_manager_init_failure {
+	CUDDLK_MGR_FAIL_CREATE_REF_CACHE,
+	CUDDLK_MGR_FAIL_CREATE_IOCTL_CACHE,
 	CUDDLK_MGR_FAIL_ALLOC_MANAGER,
+	CUDDLK_MGR_FAIL_INIT_SRCU,
 	CUDDLK_MGR_FAIL_ALLOC_CHRDEV,
 	CUDDLK_MGR_FAIL_CDEV_ADD,
 	CUDDLK_MGR_FAIL_CLASS_CREATE,
@@ -1282,9 +1916,18 @@ static int cuddlk_manager_cleanup(enum cuddlk_manager_init_failure failure)
 		unregister_chrdev_region(cuddlk_manager_dev, 1);
 		fallthrough;
 	case CUDDLK_MGR_FAIL_ALLOC_CHRDEV:
-		kfree(cuddlk_global_manager_ptr);
+		cleanup_srcu_struct(&cuddlk_global_manager_ptr->priv.srcu);
+		fallthrough;
+	case CUDDLK_MGR_FAIL_INIT_SRCU:
+		kvfree(cuddlk_global_manager_ptr);
 		fallthrough;
 	case CUDDLK_MGR_FAIL_ALLOC_MANAGER:
+		kmem_cache_destroy(cuddlk_ioctl_data_cache);
+		fallthrough;
+	case CUDDLK_MGR_FAIL_CREATE_IOCTL_CACHE:
+		kmem_cache_destroy(cuddlk_ref_cache);
+		fallthrough;
+	case CUDDLK_MGR_FAIL_CREATE_REF_CACHE:
 		fallthrough;
 	default:
 		break;
@@ -1292,6 +1935,8 @@ static int cuddlk_manager_cleanup(enum cuddlk_manager_init_failure failure)
 
 	cuddlk_global_manager_ptr = NULL;
 	cuddlk_manager_device = NULL;
+	cuddlk_ioctl_data_cache = NULL;
+	cuddlk_ref_cache = NULL;
 
 	return ret;
 }
@@ -1301,19 +1946,44 @@ static int __init cuddlk_manager_init(void)
 	int ret;
 	enum cuddlk_manager_init_failure failure;
 	
-	INIT_LIST_HEAD(&cuddlk_mem_refs.list);
-	INIT_LIST_HEAD(&cuddlk_event_refs.list);
+	/* Keep claims and releases off the general-purpose allocator */
+	cuddlk_ref_cache = KMEM_CACHE(cuddlk_resource_ref, 0);
+	if (!cuddlk_ref_cache) {
+		ret = -ENOMEM;
+		failure = CUDDLK_MGR_FAIL_CREATE_REF_CACHE;
+		cuddlk_print("%s: kmem_cache_create failed: %d\n",
+			     __func__, ret);
+		goto handle_failure;
+	}
+
+	/* The whole payload is copied to and from user space */
+	cuddlk_ioctl_data_cache = kmem_cache_create_usercopy(
+		"cuddlk_ioctl_data", sizeof(union cuddlk_ioctl_large_data),
+		0, 0, 0, sizeof(union cuddlk_ioctl_large_data), NULL);
+	if (!cuddlk_ioctl_data_cache) {
+		ret = -ENOMEM;
+		failure = CUDDLK_MGR_FAIL_CREATE_IOCTL_CACHE;
+		cuddlk_print("%s: kmem_cache_create failed: %d\n",
+			     __func__, ret);
+		goto handle_failure;
+	}
 
-	cuddlk_global_manager_ptr = kzalloc(
+	/* The manager is too large to rely on physically contiguous memory */
+	cuddlk_global_manager_ptr = kvzalloc(
 		sizeof(struct cuddlk_manager), GFP_KERNEL);
 	if (!cuddlk_global_manager_ptr) {
 		ret = -ENOMEM;
 		failure = CUDDLK_MGR_FAIL_ALLOC_MANAGER;
-		cuddlk_print("%s: kzalloc failed: %d\n", __func__, ret);
+		cuddlk_print("%s: kvzalloc failed: %d\n", __func__, ret);
 		goto handle_failure;
 	}
 
 	mutex_init(&cuddlk_global_manager_ptr->priv.global_mutex);
+	ret = init_srcu_struct(&cuddlk_global_manager_ptr->priv.srcu);
+	if (ret) {
+		failure = CUDDLK_MGR_FAIL_INIT_SRCU;
+		goto handle_failure;
+	}
 
 	ret = alloc_chrdev_region(&cuddlk_manager_dev, 0, 1, "cuddl");
 	if (ret < 0) {
@@ -1356,28 +2026,24 @@ handle_failure:
 
 static void __exit cuddlk_manager_exit(void)
 {
-	struct cuddlk_resource_ref_list *pos;
-	struct cuddlk_resource_ref_list *tmp;
-	struct cuddlk_resource_ref_list *ref_to_free;
+	struct cuddlk_resource_ref *pos;
+	struct hlist_node *tmp;
+	int bkt;
 
-	list_for_each_entry_safe(
-		pos, tmp, &cuddlk_mem_refs.list, list) {
+	hash_for_each_safe(cuddlk_mem_refs, bkt, tmp, pos, node) {
 		cuddlk_print("fallback clean up for mem slot: %d %d\n",
 			     pos->token.device_index,
 			     pos->token.resource_index);
-		ref_to_free = pos;
-		list_del(&pos->list);
-		kfree(ref_to_free);
+		hash_del(&pos->node);
+		kmem_cache_free(cuddlk_ref_cache, pos);
 	}
 
-	list_for_each_entry_safe(
-		pos, tmp, &cuddlk_event_refs.list, list) {
+	hash_for_each_safe(cuddlk_event_refs, bkt, tmp, pos, node) {
 		cuddlk_print("fallback clean up for event slot: %d %d\n",
 			     pos->token.device_index,
 			     pos->token.resource_index);
-		ref_to_free = pos;
-		list_del(&pos->list);
-		kfree(ref_to_free);
+		hash_del(&pos->node);
+		kmem_cache_free(cuddlk_ref_cache, pos);
 	}
 
 	cuddlk_manager_cleanup(CUDDLK_MGR_NO_FAILURE);
@@ -0,0 +1,387 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Cross-platform user-space device driver layer simulated device driver.
+ *
+ * Copyright (C) 2022 Jeff Webb <jeff.webb@codecraftsmen.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * Linux kernel module implementing RAM-backed simulated devices.
+ *
+ * Each simulated device exposes RAM-backed (``CUDDLK_MEMT_LOGICAL``) memory
+ * regions and a single event source that is triggered periodically by a
+ * timer via ``cuddlk_eventsrc_notify()``.  If the ``dma`` parameter is set,
+ * the memory regions are instead ``CUDDLK_MEMT_DMA`` buffers, which are
+ * allocated from system RAM by the Cuddl layer because the simulated
+ * devices have no parent device.  This allows the full
+ * claim/map/wait path to be exercised and benchmarked without hardware.
+ *
+ * This code implements both Linux UIO and Xenomai UDD functionality (based
+ * on the ``CUDDLK_USE_UDD`` *#define*).  Under Linux UIO, events are
+ * generated by an ``hrtimer``.  Under Xenomai UDD, events are generated by
+ * an RTDM timer, so they originate from the real-time domain.
+ */
+
+#include <linux/module.h>
+#include <linux/version.h>
+#include <linux/slab.h>
+#include <linux/hrtimer.h>
+#include <linux/ktime.h>
+#include <linux/atomic.h>
+#include <linux/gfp.h>
+#include <cuddlk.h>
+
+#define CUDDLK_SIM_MAX_DEVICES 1024
+
+/* Interval at which the period is re-checked while events are off (UIO) */
+#define CUDDLK_SIM_IDLE_PERIOD_NS (100 * NSEC_PER_MSEC)
+
+static char *group = "cuddl_sim";
+module_param(group, charp, 0444);
+MODULE_PARM_DESC(group, "Device group name (default: cuddl_sim)");
+
+static int num_devices = 1;
+module_param(num_devices, int, 0444);
+MODULE_PARM_DESC(num_devices, "Number of simulated devices (default: 1)");
+
+static int num_mem_regions = 1;
+module_param(num_mem_regions, int, 0444);
+MODULE_PARM_DESC(num_mem_regions,
+		 "Number of memory regions per device (default: 1)");
+
+static ulong mem_size = 65536;
+module_param(mem_size, ulong, 0444);
+MODULE_PARM_DESC(mem_size,
+		 "Size of each memory region, in bytes (default: 65536)");
+
+static bool shared;
+module_param(shared, bool, 0444);
+MODULE_PARM_DESC(shared,
+		 "Allow resources to be claimed by several applications "
+		 "(default: N)");
+
+/*
+ * Under Linux UIO, changes to this parameter (via sysfs) take effect at the
+ * next timer expiration.  While the period is 0, the timers keep running at
+ * CUDDLK_SIM_IDLE_PERIOD_NS without delivering events, so that a new period
+ * is picked up.  Under Xenomai UDD, the period is fixed at load time.
+ */
+static ulong event_period_ns = 1000000;
+module_param(event_period_ns, ulong, 0644);
+MODULE_PARM_DESC(event_period_ns,
+		 "Event period in nanoseconds, or 0 for no events "
+		 "(default: 1000000)");
+
+static bool dma;
+module_param(dma, bool, 0444);
+MODULE_PARM_DESC(dma,
+		 "Expose memory regions as kernel-allocated DMA buffers "
+		 "(default: N)");
+
+static bool oneshot;
+module_param(oneshot, bool, 0444);
+MODULE_PARM_DESC(oneshot,
+		 "Disable the event source after each event, like a "
+		 "level-triggered interrupt masked by its handler "
+		 "(default: N)");
+
+/*
+ * struct cuddlk_sim_device - Simulated device state.
+ *
+ * @dev: The Cuddl device exposed to user space.
+ * @mem: RAM backing each memory region.
+ * @enabled: Non-zero if events are currently delivered to user space.
+ * @managed: Non-zero if @dev was successfully passed to
+ *           ``cuddlk_devices_manage()``.
+ * @timer_running: Non-zero if @timer was successfully set up.
+ * @timer: Timer that generates events.
+ */
+struct cuddlk_sim_device {
+	struct cuddlk_device dev;
+	void *mem[CUDDLK_MAX_DEV_MEM_REGIONS];
+	atomic_t enabled;
+	int managed;
+	int timer_running;
+#if defined(CUDDLK_USE_UDD)
+	rtdm_timer_t timer;
+#else
+	struct hrtimer timer;
+#endif
+};
+
+static const char *cuddlk_sim_mem_names[CUDDLK_MAX_DEV_MEM_REGIONS] = {
+	"mem0", "mem1", "mem2", "mem3", "mem4",
+};
+
+static struct cuddlk_sim_device *cuddlk_sim_devices;
+static int cuddlk_sim_num_devices;
+
+static struct cuddlk_sim_device *intr_to_sim(struct cuddlk_interrupt *intr)
+{
+	return container_of(intr, struct cuddlk_sim_device,
+			    dev.events[0].intr);
+}
+
+static int cuddlk_sim_enable(struct cuddlk_interrupt *intr)
+{
+	atomic_set(&intr_to_sim(intr)->enabled, 1);
+	return 0;
+}
+
+static int cuddlk_sim_disable(struct cuddlk_interrupt *intr)
+{
+	atomic_set(&intr_to_sim(intr)->enabled, 0);
+	return 0;
+}
+
+static int cuddlk_sim_is_enabled(struct cuddlk_interrupt *intr)
+{
+	return atomic_read(&intr_to_sim(intr)->enabled);
+}
+
+/* Deliver a simulated interrupt (if the event source is enabled) */
+static void cuddlk_sim_fire(struct cuddlk_sim_device *sim)
+{
+	struct cuddlk_eventsrc *eventsrc = &sim->dev.events[0];
+
+	if (oneshot) {
+		if (!atomic_xchg(&sim->enabled, 0))
+			return;
+		cuddlk_eventsrc_report_enabled(eventsrc, 0);
+	} else if (!atomic_read(&sim->enabled)) {
+		return;
+	}
+
+	cuddlk_eventsrc_notify(eventsrc);
+}
+
+#if defined(CUDDLK_USE_UDD)
+static void cuddlk_sim_timer_handler(rtdm_timer_t *timer)
+{
+	cuddlk_sim_fire(container_of(timer, struct cuddlk_sim_device, timer));
+}
+
+static int cuddlk_sim_timer_start(struct cuddlk_sim_device *sim, u64 period)
+{
+	int ret;
+
+	/* With a period of 0 (no events), the timer is never started */
+	ret = rtdm_timer_init(&sim->timer, cuddlk_sim_timer_handler,
+			      sim->dev.name);
+	if (ret || (period == 0))
+		return ret;
+
+	ret = rtdm_timer_start(&sim->timer, period, period,
+			       RTDM_TIMERMODE_RELATIVE);
+	if (ret)
+		rtdm_timer_destroy(&sim->timer);
+	return ret;
+}
+
+static void cuddlk_sim_timer_stop(struct cuddlk_sim_device *sim)
+{
+	rtdm_timer_destroy(&sim->timer);
+}
+
+#else /* UIO */
+static enum hrtimer_restart cuddlk_sim_timer_handler(struct hrtimer *timer)
+{
+	struct cuddlk_sim_device *sim;
+	u64 period;
+
+	sim = container_of(timer, struct cuddlk_sim_device, timer);
+
+	period = READ_ONCE(event_period_ns);
+	if (period == 0)
+		period = CUDDLK_SIM_IDLE_PERIOD_NS;
+	else
+		cuddlk_sim_fire(sim);
+	hrtimer_forward_now(timer, ns_to_ktime(period));
+	return HRTIMER_RESTART;
+}
+
+static int cuddlk_sim_timer_start(struct cuddlk_sim_device *sim, u64 period)
+{
+	if (period == 0)
+		period = CUDDLK_SIM_IDLE_PERIOD_NS;
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6,13,0)
+	hrtimer_setup(&sim->timer, cuddlk_sim_timer_handler,
+		      CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+#else
+	hrtimer_init(&sim->timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	sim->timer.function = cuddlk_sim_timer_handler;
+#endif
+	hrtimer_start(&sim->timer, ns_to_ktime(period), HRTIMER_MODE_REL);
+	return 0;
+}
+
+static void cuddlk_sim_timer_stop(struct cuddlk_sim_device *sim)
+{
+	hrtimer_cancel(&sim->timer);
+}
+#endif
+
+static void cuddlk_sim_free_mem(struct cuddlk_sim_device *sim)
+{
+	int i;
+
+	for (i=0; i<CUDDLK_MAX_DEV_MEM_REGIONS; i++) {
+		if (sim->mem[i])
+			free_pages_exact(sim->mem[i], sim->dev.mem[i].pa_len);
+		sim->mem[i] = NULL;
+	}
+}
+
+static int cuddlk_sim_setup(struct cuddlk_sim_device *sim)
+{
+	struct cuddlk_device *dev = &sim->dev;
+	struct cuddlk_eventsrc *eventsrc = &dev->events[0];
+	cuddlk_size_t pa_len = PAGE_ALIGN(mem_size);
+	int i;
+
+	dev->group = group;
+	dev->name = "sim";
+	dev->driver_info = "cuddl_sim";
+	dev->hw_info = "RAM-backed simulated device";
+	dev->owner_ptr = THIS_MODULE;
+
+	for (i=0; i<num_mem_regions; i++) {
+		dev->mem[i].name = (char *) cuddlk_sim_mem_names[i];
+		dev->mem[i].len = mem_size;
+		if (shared)
+			dev->mem[i].flags |= CUDDLK_MEMF_SHARED;
+		if (dma) {
+			dev->mem[i].type = CUDDLK_MEMT_DMA;
+			continue;
+		}
+		sim->mem[i] = alloc_pages_exact(pa_len,
+						GFP_KERNEL | __GFP_ZERO);
+		if (!sim->mem[i]) {
+			cuddlk_sim_free_mem(sim);
+			return -ENOMEM;
+		}
+		dev->mem[i].pa_addr = (unsigned long) sim->mem[i];
+		dev->mem[i].pa_len = pa_len;
+		dev->mem[i].type = CUDDLK_MEMT_LOGICAL;
+	}
+
+	eventsrc->name = "timer";
+	if (shared)
+		eventsrc->flags |= CUDDLK_EVENTSRCF_SHARED;
+	eventsrc->intr.irq = CUDDLK_IRQ_CUSTOM;
+	eventsrc->intr.enable = cuddlk_sim_enable;
+	eventsrc->intr.disable = cuddlk_sim_disable;
+	eventsrc->intr.is_enabled = cuddlk_sim_is_enabled;
+	atomic_set(&sim->enabled, 0);
+
+	return 0;
+}
+
+static void cuddlk_sim_cleanup(void)
+{
+	struct cuddlk_sim_device *sim;
+	int i;
+
+	for (i=cuddlk_sim_num_devices-1; i>=0; i--) {
+		sim = &cuddlk_sim_devices[i];
+		if (sim->timer_running)
+			cuddlk_sim_timer_stop(sim);
+		if (sim->managed)
+			cuddlk_device_release(&sim->dev);
+		cuddlk_sim_free_mem(sim);
+	}
+
+	kvfree(cuddlk_sim_devices);
+	cuddlk_sim_devices = NULL;
+	cuddlk_sim_num_devices = 0;
+}
+
+static int __init cuddlk_sim_init(void)
+{
+	struct cuddlk_sim_device *sim;
+	struct cuddlk_device **devs;
+	int ret;
+	int i;
+
+	if ((num_devices < 1) || (num_devices > CUDDLK_SIM_MAX_DEVICES) ||
+	    (num_mem_regions < 0) ||
+	    (num_mem_regions > CUDDLK_MAX_DEV_MEM_REGIONS) ||
+	    (mem_size == 0)) {
+		cuddlk_print("cuddl_sim: invalid module parameters\n");
+		return -EINVAL;
+	}
+
+	cuddlk_sim_devices = kvcalloc(
+		num_devices, sizeof(*cuddlk_sim_devices), GFP_KERNEL);
+	if (!cuddlk_sim_devices)
+		return -ENOMEM;
+	cuddlk_sim_num_devices = num_devices;
+
+	devs = kcalloc(num_devices, sizeof(*devs), GFP_KERNEL);
+	if (!devs) {
+		ret = -ENOMEM;
+		goto fail;
+	}
+
+	for (i=0; i<num_devices; i++) {
+		sim = &cuddlk_sim_devices[i];
+		ret = cuddlk_sim_setup(sim);
+		if (ret) {
+			kfree(devs);
+			goto fail;
+		}
+		devs[i] = &sim->dev;
+	}
+
+	/* Register all devices while holding the manager lock only once */
+	ret = cuddlk_devices_manage(devs, num_devices);
+	kfree(devs);
+	if (ret)
+		goto fail;
+
+	/* All devices must be released on failure, so mark them first */
+	for (i=0; i<num_devices; i++)
+		cuddlk_sim_devices[i].managed = 1;
+
+	for (i=0; i<num_devices; i++) {
+		sim = &cuddlk_sim_devices[i];
+
+		ret = cuddlk_sim_timer_start(sim, event_period_ns);
+		if (ret)
+			goto fail;
+		sim->timer_running = 1;
+
+		cuddlk_debug("cuddl_sim: registered %s.%s.%d\n",
+			     sim->dev.group, sim->dev.name, sim->dev.instance);
+	}
+
+	return 0;
+
+fail:
+	cuddlk_print("cuddl_sim: device setup failed (%d)\n", ret);
+	cuddlk_sim_cleanup();
+	return ret;
+}
+
+static void __exit cuddlk_sim_exit(void)
+{
+	cuddlk_sim_cleanup();
+}
+
+module_init(cuddlk_sim_init)
+module_exit(cuddlk_sim_exit)
+MODULE_LICENSE("GPL");
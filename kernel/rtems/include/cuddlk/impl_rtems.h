@@ -29,6 +29,7 @@
 #define CUDDLKI_MEMT_PHYS    1
 #define CUDDLKI_MEMT_LOGICAL 2
 #define CUDDLKI_MEMT_VIRTUAL 3
+#define CUDDLKI_MEMT_DMA     4
 
 #define CUDDLKI_VARIANT "RTEMS"
 
@@ -42,6 +43,8 @@ typedef void cuddlki_iomem_t;
 
 typedef void cuddlki_parent_device_t;
 
+typedef unsigned long cuddlki_dma_addr_t;
+
 typedef void cuddlki_owner_t;
 
 /**
@@ -89,4 +92,9 @@ struct cuddlki_device_priv {
 struct cuddlki_manager_priv {
 };
 
+/* All manager queries hold the manager lock on RTEMS */
+#define cuddlki_manager_read(x) (x)
+#define cuddlki_manager_publish(x, v) ((x) = (v))
+#define cuddlki_manager_sync(manager) do { } while (0)
+
 #endif /* !_CUDDLK_IMPL_RTEMS_H */
@@ -19,95 +19,162 @@
 
 #include <cuddlk.h>
 
+/* Hash a device's (group, name) pair into a manager hash bucket index. */
+static unsigned int _hash_group_name(const char *group, const char *name)
+{
+	/* 32-bit FNV-1a */
+	unsigned int h = 2166136261u;
+	int i;
+
+	for (i=0; (i<CUDDLK_MAX_STR_LEN) && group[i]; i++)
+		h = (h ^ (unsigned char) group[i]) * 16777619u;
+	h = (h ^ '/') * 16777619u;
+	for (i=0; (i<CUDDLK_MAX_STR_LEN) && name[i]; i++)
+		h = (h ^ (unsigned char) name[i]) * 16777619u;
+
+	return h % CUDDLK_MANAGER_HASH_BUCKETS;
+}
+
+static int _is_specified(const char *str)
+{
+	return str && (strnlen(str, CUDDLK_MAX_STR_LEN) > 0);
+}
+
+static int _device_matches(
+	struct cuddlk_device *dev,
+	const char *group, const char *name, const char *resource,
+	int instance, enum cuddlk_resource type)
+{
+	if (instance)
+		if (dev->instance != instance)
+			return 0;
+	if (_is_specified(group))
+		if (strncmp(dev->group, group, CUDDLK_MAX_STR_LEN) != 0)
+			return 0;
+	if (_is_specified(name))
+		if (strncmp(dev->name, name, CUDDLK_MAX_STR_LEN) != 0)
+			return 0;
+	if (_is_specified(resource)) {
+		if (type == CUDDLK_RESOURCE_MEMREGION) {
+			if (cuddlk_device_find_memregion_slot(
+				    dev, resource) < 0)
+				return 0;
+		} else if (type == CUDDLK_RESOURCE_EVENTSRC) {
+			if (cuddlk_device_find_eventsrc_slot(
+				    dev, resource) < 0)
+				return 0;
+		} else {
+			return 0;
+		}
+	}
+	return 1;
+}
+
 int cuddlk_manager_find_device_slot_matching(
 	struct cuddlk_manager *manager,
 	const char *group, const char *name, const char *resource,
 	int instance, enum cuddlk_resource type, int start_index)
 {
 	int i;
-	int found_match = 0;
+	int found = -ENXIO;
+	int *link;
 	struct cuddlk_device *dev = NULL;
 
-	for (i=start_index; i<CUDDLK_MAX_MANAGED_DEVICES; i++) {
-		dev = manager->devices[i];
-		if (!dev)
-			continue;
-		if (instance)
-			if (dev->instance != instance)
+	/*
+	 * When both the group and device names are given, only the devices
+	 * on the corresponding hash chain can match.  The chain is not kept
+	 * in slot order, so the whole chain is scanned for the lowest
+	 * matching slot to preserve the search order of the slow path.  The
+	 * chain may be walked without holding the manager lock (see
+	 * cuddlki_manager_read()), in which case a device that was just
+	 * removed may still be on it with an empty slot.
+	 */
+	if (_is_specified(group) && _is_specified(name)) {
+		link = &manager->hash_heads[_hash_group_name(group, name)];
+		for (; (i = cuddlki_manager_read(*link) - 1) >= 0;
+		     link = &manager->hash_next[i]) {
+			if ((i < start_index) || ((found >= 0) && (i > found)))
 				continue;
-		if (group && (strnlen(group, CUDDLK_MAX_STR_LEN) > 0))
-			if (strncmp(dev->group, group, CUDDLK_MAX_STR_LEN)
-			    != 0) continue;
-		if (name && (strnlen(name, CUDDLK_MAX_STR_LEN) > 0))
-			if (strncmp(dev->name, name, CUDDLK_MAX_STR_LEN)
-			    != 0) continue;
-		if (resource && (strnlen(resource, CUDDLK_MAX_STR_LEN) > 0)) {
-			if (type == CUDDLK_RESOURCE_MEMREGION) {
-				if (cuddlk_device_find_memregion_slot(
-					    dev, resource) < 0)
-					continue;
-			} else if (type == CUDDLK_RESOURCE_EVENTSRC) {
-				if (cuddlk_device_find_eventsrc_slot(
-					    dev, resource) < 0)
-					continue;
-			} else {
+			dev = cuddlki_manager_read(manager->devices[i]);
+			if (!dev)
 				continue;
-			}
+			if (_device_matches(
+				    dev, group, name, resource, instance, type))
+				found = i;
 		}
-		found_match = 1;
-		break;
+		return found;
 	}
 
-	if (!found_match)
-		return -ENXIO;
+	for (i=start_index; i<CUDDLK_MAX_MANAGED_DEVICES; i++) {
+		dev = cuddlki_manager_read(manager->devices[i]);
+		if (!dev)
+			continue;
+		if (_device_matches(dev, group, name, resource, instance, type))
+			return i;
+	}
 
-	return i;
+	return -ENXIO;
 }
 
 int cuddlk_manager_find_device_slot(
 	struct cuddlk_manager *manager, struct cuddlk_device *dev)
 {
 	int i;
-	int found_slot = 0;
 
-	for (i=0; i<CUDDLK_MAX_MANAGED_DEVICES; i++) {
-		if (manager->devices[i] != dev)
-			continue;
-		found_slot = 1;
-		break;
-	}
-	if (!found_slot)
+	if (!dev)
+		return cuddlk_manager_find_empty_slot(manager);
+
+	/* Managed devices always have a group and name */
+	if (!dev->group || !dev->name)
 		return -ENXIO;
 
-	return i;
+	i = manager->hash_heads[_hash_group_name(dev->group, dev->name)] - 1;
+	for (; i>=0; i=manager->hash_next[i] - 1)
+		if (manager->devices[i] == dev)
+			return i;
+
+	return -ENXIO;
 }
 
 int cuddlk_manager_find_empty_slot(struct cuddlk_manager *manager)
 {
-	return cuddlk_manager_find_device_slot(manager, NULL);
+	/* Reuse released slots first, then never-used slots */
+	if (manager->free_slots)
+		return manager->free_slots - 1;
+
+	if (manager->n_slots_used < CUDDLK_MAX_MANAGED_DEVICES)
+		return manager->n_slots_used;
+
+	return -ENXIO;
 }
 
 int  cuddlk_manager_next_available_instance_id(
 	struct cuddlk_manager *manager, struct cuddlk_device *dev)
 {
 	int instance;
-	int slot;
+	int i;
+	struct cuddlk_device *other;
 
+	if (!dev->group || !dev->name)
+		return -EINVAL;
+	if (cuddlk_manager_find_empty_slot(manager) < 0)
+		return -ENOMEM;
+
+	/*
+	 * Hash chains are kept sorted by instance number, so the lowest
+	 * unused instance number is found in a single pass over the chain.
+	 */
 	instance = 1;
-	slot = 0;
-	while (1) {
-		slot = cuddlk_manager_find_device_slot_matching(
-			manager, dev->group, dev->name,  NULL, instance, 0,
-			slot);
-		if (slot < 0)
-			break;
-		if (slot < CUDDLK_MAX_MANAGED_DEVICES - 1) {
-			slot += 1;
+	i = manager->hash_heads[_hash_group_name(dev->group, dev->name)] - 1;
+	for (; i>=0; i=manager->hash_next[i] - 1) {
+		other = manager->devices[i];
+		if (strncmp(other->group, dev->group, CUDDLK_MAX_STR_LEN) ||
+		    strncmp(other->name, dev->name, CUDDLK_MAX_STR_LEN))
+			continue;
+		if (other->instance == instance)
 			instance += 1;
-		} else {
-			instance = -ENOMEM;
+		else if (other->instance > instance)
 			break;
-		}
 	}
 
 	return instance;
@@ -117,73 +184,114 @@ int cuddlk_manager_add_device(
 	struct cuddlk_manager * manager, struct cuddlk_device *dev)
 {
 	int slot;
+	int *link;
+
+	if (!dev->group || !dev->name)
+		return -EINVAL;
 
 	slot = cuddlk_manager_find_empty_slot(manager);
 	if (slot < 0)
 		return -ENOMEM;
 
-	manager->devices[slot] = dev;
+	if (manager->free_slots)
+		manager->free_slots = manager->free_next[slot];
+	else
+		manager->n_slots_used += 1;
+
+	/* Fully link the new entry before making it reachable */
+	cuddlki_manager_publish(manager->devices[slot], dev);
+
+	link = &manager->hash_heads[_hash_group_name(dev->group, dev->name)];
+	while (*link && (manager->devices[*link - 1]->instance < dev->instance))
+		link = &manager->hash_next[*link - 1];
+	cuddlki_manager_publish(manager->hash_next[slot], *link);
+	cuddlki_manager_publish(*link, slot + 1);
 
 	return 0;
 }
 
-int cuddlk_manager_remove_device(
+/*
+ * Unlink a device from the device list and hash index, without waiting for
+ * lockless readers.  The slot is not reused until the caller has called
+ * cuddlki_manager_sync() and released the manager lock, so readers that
+ * are still on the unlinked hash chain entry can finish walking the chain.
+ */
+static int _remove_device(
 	struct cuddlk_manager * manager, struct cuddlk_device *dev)
 {
 	int slot;
+	int *link;
 
 	slot = cuddlk_manager_find_device_slot(manager, dev);
 	if (slot < 0)
 		return slot;
-	
-	manager->devices[slot] = NULL;
+
+	link = &manager->hash_heads[_hash_group_name(dev->group, dev->name)];
+	while (*link && (*link != slot + 1))
+		link = &manager->hash_next[*link - 1];
+	if (*link)
+		cuddlki_manager_publish(*link, manager->hash_next[slot]);
+
+	cuddlki_manager_publish(manager->devices[slot], NULL);
+	manager->free_next[slot] = manager->free_slots;
+	manager->free_slots = slot + 1;
 
 	return 0;
 }
 
-int cuddlk_device_manage(struct cuddlk_device *dev)
+int cuddlk_manager_remove_device(
+	struct cuddlk_manager * manager, struct cuddlk_device *dev)
 {
 	int ret;
-	struct cuddlk_manager *manager;
 
-	manager = cuddlk_manager_lock();
+	ret = _remove_device(manager, dev);
+	if (ret)
+		return ret;
 
-	if (!dev->group) {
-		ret = -EINVAL;
-		goto fail_null_group;
-	}
-	if (!dev->name) {
-		ret = -EINVAL;
-		goto fail_null_name;
-	}
+	cuddlki_manager_sync(manager);
+
+	return 0;
+}
+
+static int _device_manage(
+	struct cuddlk_manager *manager, struct cuddlk_device *dev)
+{
+	int ret;
+
+	if (!dev->group)
+		return -EINVAL;
+	if (!dev->name)
+		return -EINVAL;
 	if (!dev->instance) {
 		ret = cuddlk_manager_next_available_instance_id(
 		      manager, dev);
-		if (ret < 0) {
-			goto fail_auto_instance;
-		}
+		if (ret < 0)
+			return ret;
 		dev->instance = ret;
 	}
 
 	ret = cuddlk_device_register(dev);
 	if (ret)
-		goto fail_register;
+		return ret;
 
 	ret = cuddlk_manager_add_device(manager, dev);
-	if (ret)
-		goto fail_manager_add_device;
-
-	cuddlk_manager_unlock();
+	if (ret) {
+		cuddlk_device_unregister(dev);
+		return ret;
+	}
 
 	return 0;
+}
+
+int cuddlk_device_manage(struct cuddlk_device *dev)
+{
+	int ret;
+	struct cuddlk_manager *manager;
 
-fail_manager_add_device:
-	cuddlk_device_unregister(dev);
-fail_register:
-fail_auto_instance:
-fail_null_name:
-fail_null_group:
+	manager = cuddlk_manager_lock();
+	ret = _device_manage(manager, dev);
 	cuddlk_manager_unlock();
+
 	return ret;
 }
 
@@ -200,3 +308,53 @@ int cuddlk_device_release(struct cuddlk_device *dev)
 		return ret1;
 	return ret2;
 }
+
+int cuddlk_devices_manage(struct cuddlk_device **devs, int n_devs)
+{
+	int i;
+	int ret = 0;
+	struct cuddlk_manager *manager;
+
+	manager = cuddlk_manager_lock();
+	for (i=0; i<n_devs; i++) {
+		ret = _device_manage(manager, devs[i]);
+		if (ret)
+			break;
+	}
+	if (ret) {
+		n_devs = i;
+		for (i=n_devs-1; i>=0; i--)
+			_remove_device(manager, devs[i]);
+		cuddlki_manager_sync(manager);
+		for (i=n_devs-1; i>=0; i--)
+			cuddlk_device_unregister(devs[i]);
+	}
+	cuddlk_manager_unlock();
+
+	return ret;
+}
+
+int cuddlk_devices_release(struct cuddlk_device **devs, int n_devs)
+{
+	int i;
+	int ret;
+	int first_ret = 0;
+	struct cuddlk_manager *manager;
+
+	/* Wait for lockless readers only once for the whole batch */
+	manager = cuddlk_manager_lock();
+	for (i=n_devs-1; i>=0; i--) {
+		ret = _remove_device(manager, devs[i]);
+		if (ret && !first_ret)
+			first_ret = ret;
+	}
+	cuddlki_manager_sync(manager);
+	for (i=n_devs-1; i>=0; i--) {
+		ret = cuddlk_device_unregister(devs[i]);
+		if (ret && !first_ret)
+			first_ret = ret;
+	}
+	cuddlk_manager_unlock();
+
+	return first_ret;
+}
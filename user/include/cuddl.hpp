@@ -23,6 +23,8 @@
  */
 
 #include <cuddl/manager.hpp>
+#include <cuddl/regmap.hpp>
+#include <cuddl/ring.hpp>
 #include <cuddl/version.hpp>
 
 #endif /* !_CUDDL_HPP */
@@ -16,6 +16,7 @@
 #ifndef _CUDDL_EVENTSRC_H
 #define _CUDDL_EVENTSRC_H
 
+#include <stdint.h>
 #include <cuddl/common_eventsrc.h>
 #include <cuddl/impl.h>
 
@@ -118,8 +119,6 @@ struct cuddl_eventsrc {
  *       manager device (Linux).
  *     - Value of ``-errno`` resulting from from ``ioctl()`` call on Cuddl
  *       manager device (Linux).
- *     - Value of ``-errno`` resulting from from ``close()`` call on Cuddl
- *       manager device (Linux).
  */
 int cuddl_eventsrc_claim(
 	struct cuddl_eventsrc_info *eventinfo,
@@ -196,7 +195,10 @@ int cuddl_eventsrc_open(
  *            ``cuddl_eventsrc_open()``.
  *
  * Close the event source ``eventsrc`` to disable reception of events from
- * this source in user space.
+ * this source in user space.  On Linux, the event source shares its file
+ * descriptor with the mapped memory regions of the same device, so it
+ * should be removed from any event source sets or event engines before it
+ * is closed.
  *
  * This routine is automatically called from
  * ``cuddl_eventsrc_close_and_release()``, so user-space applications do not
@@ -270,7 +272,9 @@ int cuddl_eventsrc_close_and_release(struct cuddl_eventsrc *eventsrc);
  *            ``cuddl_eventsrc_open()`` or
  *            ``cuddl_eventsrc_claim_and_open()``.
  *
- * Performs a blocking wait for events from ``eventsrc``.
+ * Performs a blocking wait for events from ``eventsrc``.  If a spin budget
+ * has been set with ``cuddl_eventsrc_set_spin_budget()``, the event source
+ * is polled for up to the spin budget before blocking.
  *
  * Return:
  *   Cumulative event source interrupt count on success (i.e. an event has
@@ -282,6 +286,126 @@ int cuddl_eventsrc_close_and_release(struct cuddl_eventsrc *eventsrc);
  */
 int cuddl_eventsrc_wait(struct cuddl_eventsrc *eventsrc);
 
+/**
+ * struct cuddl_eventsrc_spin_stats - Spin-then-block wait statistics.
+ *
+ * @waits: Number of calls to ``cuddl_eventsrc_wait()`` made with a non-zero
+ *         spin budget.
+ *
+ * @spin_hits: Number of those calls that were satisfied during the spin
+ *             phase, without blocking.
+ *
+ * The ratio of ``spin_hits`` to ``waits`` may be used to tune the spin
+ * budget for a particular event source and CPU core.
+ */
+struct cuddl_eventsrc_spin_stats {
+	unsigned long long waits;
+	unsigned long long spin_hits;
+};
+
+/**
+ * cuddl_eventsrc_set_spin_budget() - Configure spin-then-block waiting.
+ *
+ * @eventsrc: The event source to be configured.  The data structure pointed
+ *            to by this parameter should contain the information returned
+ *            by a successful call to ``cuddl_eventsrc_open()`` or
+ *            ``cuddl_eventsrc_claim_and_open()``.
+ *
+ * @spin_ns: Maximum time (in nanoseconds) that ``cuddl_eventsrc_wait()``
+ *           spins, polling the event source, before falling back to a
+ *           blocking wait.  A value of ``0`` (the default) disables
+ *           spinning.
+ *
+ * Spinning trades CPU time for wakeup latency, so it should only be used on
+ * cores dedicated to servicing the event source.  The spin statistics are
+ * reset by this call.
+ *
+ * Return: ``0`` on success, or a negative error code.
+ *
+ *   Error codes:
+ *     - ``-EINVAL``: ``spin_ns`` is negative.
+ */
+int cuddl_eventsrc_set_spin_budget(
+	struct cuddl_eventsrc *eventsrc, long spin_ns);
+
+/**
+ * cuddl_eventsrc_get_spin_stats() - Retrieve spin-then-block wait statistics.
+ *
+ * @eventsrc: The event source to be queried.
+ *
+ * @stats: Pointer to a data structure that will receive the statistics.
+ */
+void cuddl_eventsrc_get_spin_stats(
+	const struct cuddl_eventsrc *eventsrc,
+	struct cuddl_eventsrc_spin_stats *stats);
+
+/* Number of log2 buckets in the wakeup latency histogram */
+#define CUDDL_EVENTSRC_LATENCY_BUCKETS 32
+
+/**
+ * struct cuddl_eventsrc_latency_stats - Event wakeup latency statistics.
+ *
+ * @samples: Number of wakeups measured.
+ *
+ * @max_ns: Largest wakeup latency measured, in nanoseconds.
+ *
+ * @hist_ns: Histogram of wakeup latencies.  Bucket ``0`` counts latencies of
+ *           ``0`` ns and bucket ``N`` counts latencies in the range
+ *           [2^(N-1), 2^N) ns.  The last bucket also counts all longer
+ *           latencies.
+ *
+ * The wakeup latency is the time from the occurrence of the most recent
+ * event (as time-stamped by the kernel's top-half interrupt handler) to the
+ * return of the wait call that consumed it.  Comparing this histogram with
+ * the kernel's interrupt handler histogram (see *cuddl-top*) shows whether
+ * latency spikes come from the top half or from the wakeup.
+ */
+struct cuddl_eventsrc_latency_stats {
+	uint64_t samples;
+	uint64_t max_ns;
+	uint64_t hist_ns[CUDDL_EVENTSRC_LATENCY_BUCKETS];
+};
+
+/**
+ * cuddl_eventsrc_get_latency_stats() - Retrieve wakeup latency statistics.
+ *
+ * @eventsrc: The event source to be queried.
+ *
+ * @stats: Pointer to a data structure that will receive the statistics.
+ *
+ * Wakeup latencies are only measured once enabled with
+ * ``cuddl_eventsrc_enable_latency_stats()``.  They are then measured by
+ * ``cuddl_eventsrc_wait()`` and ``cuddl_eventsrc_timed_wait()`` (and the
+ * functions built on them) when the kernel's event source status page is
+ * available.  Otherwise no samples are recorded.
+ */
+void cuddl_eventsrc_get_latency_stats(
+	const struct cuddl_eventsrc *eventsrc,
+	struct cuddl_eventsrc_latency_stats *stats);
+
+/**
+ * cuddl_eventsrc_enable_latency_stats() - Enable/disable latency recording.
+ *
+ * @eventsrc: The event source to be configured.
+ *
+ * @enable: Non-zero to record wakeup latencies, or ``0`` to stop.
+ *
+ * Recording is disabled when an event source is opened.  While it is
+ * enabled, every wait that consumes an event reads the clock and updates the
+ * latency histogram, which adds a ``clock_gettime()`` call to each wait, so
+ * it should be left disabled in tight wait loops unless the statistics are
+ * needed.  The statistics are reset when recording is enabled.
+ */
+void cuddl_eventsrc_enable_latency_stats(
+	struct cuddl_eventsrc *eventsrc, int enable);
+
+/**
+ * cuddl_eventsrc_reset_latency_stats() - Reset wakeup latency statistics.
+ *
+ * @eventsrc: The event source to be reset.
+ */
+void cuddl_eventsrc_reset_latency_stats(struct cuddl_eventsrc *eventsrc);
+
 /**
  * cuddl_eventsrc_try_wait() - Check for the occurance of a user-space event.
  *
@@ -290,7 +414,9 @@ int cuddl_eventsrc_wait(struct cuddl_eventsrc *eventsrc);
  *            should contain the information returned by a successful call to
  *            ``cuddl_eventsrc_open()``.
  *
- * Performs a non-blocking check for events from ``eventsrc``.
+ * Performs a non-blocking check for events from ``eventsrc``.  On Linux,
+ * the kernel's read-only status page for the event source is checked first,
+ * so no system calls are made unless an event is pending.
  *
  * Return:
  *   Cumulative event source interrupt count on success (i.e. an event has
@@ -331,6 +457,83 @@ int cuddl_eventsrc_timed_wait(
 	struct cuddl_eventsrc *eventsrc,
 	const struct cuddl_timespec *timeout);
 
+/**
+ * struct cuddl_eventsrc_record - Extended event record.
+ *
+ * @seq: 64-bit sequence number of the most recent event (i.e. the number of
+ *       events that have occurred since the event source was registered).
+ *
+ * @delta: Number of events that have occurred since the previous record was
+ *         retrieved for this event source.  A value greater than ``1``
+ *         indicates that events were coalesced (missed) while the
+ *         application was busy.
+ *
+ * @timestamp: ``CLOCK_MONOTONIC`` time at which the most recent event was
+ *             captured by the kernel's top-half interrupt handler (or by
+ *             ``cuddlk_eventsrc_notify()``).
+ */
+struct cuddl_eventsrc_record {
+	uint64_t seq;
+	uint64_t delta;
+	struct cuddl_timespec timestamp;
+};
+
+/**
+ * cuddl_eventsrc_get_record() - Retrieve the latest extended event record.
+ *
+ * @eventsrc: Input parameter identifying the event source to be queried.
+ *            The data structure pointed to by this parameter should contain
+ *            the information returned by a successful call to
+ *            ``cuddl_eventsrc_open()`` or
+ *            ``cuddl_eventsrc_claim_and_open()``.
+ *
+ * @record: Pointer to a data structure that will receive the event record.
+ *
+ * Retrieve the sequence number and timestamp of the most recent event
+ * without waiting.  The ``delta`` field is computed relative to the
+ * previous call for the same event source (or relative to the time the
+ * event source was opened).  On Linux, the record is read from the
+ * kernel's status page for the event source when it is available, so this
+ * function may be used to poll the event count without system calls.
+ *
+ * Return: ``0`` on success, or a negative error code.
+ *
+ *   Error codes:
+ *     - ``-EBADSLT``: The event source token is out of range.
+ *     - ``-ENODEV``: The associated device is no longer registered.
+ *     - ``-EOVERFLOW``: Error copying data to/from kernel space (Linux).
+ *     - ``-ENOEXEC``: User/kernel major version number mismatch (Linux).
+ *     - Value of ``-errno`` resulting from from ``ioctl()`` call on Cuddl
+ *       manager device (Linux).
+ */
+int cuddl_eventsrc_get_record(
+	struct cuddl_eventsrc *eventsrc, struct cuddl_eventsrc_record *record);
+
+/**
+ * cuddl_eventsrc_wait_record() - Wait for an event and retrieve its record.
+ *
+ * @eventsrc: Input parameter identifying the source of the event to be
+ *            waited on.  The data structure pointed to by this parameter
+ *            should contain the information returned by a successful call to
+ *            ``cuddl_eventsrc_open()`` or
+ *            ``cuddl_eventsrc_claim_and_open()``.
+ *
+ * @record: Pointer to a data structure that will receive the event record.
+ *
+ * Equivalent to ``cuddl_eventsrc_wait()`` followed by
+ * ``cuddl_eventsrc_get_record()``.
+ *
+ * Return:
+ *   Cumulative event source interrupt count on success, or a negative error
+ *   code.
+ *
+ *   Error codes:
+ *     - Error code returned by ``cuddl_eventsrc_wait()``.
+ *     - Error code returned by ``cuddl_eventsrc_get_record()``.
+ */
+int cuddl_eventsrc_wait_record(
+	struct cuddl_eventsrc *eventsrc, struct cuddl_eventsrc_record *record);
+
 /**
  * cuddl_eventsrc_enable() - Enable an event source from user space.
  *
@@ -387,9 +590,12 @@ int cuddl_eventsrc_disable(struct cuddl_eventsrc *eventsrc);
  *   ``1`` indicates that the event source is enabled, and a negative value
  *   indicates an error condition.
  *
- *   On some systems (e.g. Linux and Xenomai, at least), this feature is
- *   implemented via the manager interface (which involves acquiring a global
- *   lock), so real-time use of this function is not recommended.
+ *   On Linux and Xenomai, the state is normally read from the kernel's
+ *   read-only status page for the event source without a system call.  If
+ *   the status page is unavailable or the state has not been established
+ *   yet, the query falls back to the manager interface (which involves
+ *   acquiring a global lock), so real-time use of this function is not
+ *   recommended in that case.
  *
  *   Error codes:
  *     - ``-EINVAL``: This functionality was not implemented by the kernel
@@ -405,8 +611,6 @@ int cuddl_eventsrc_disable(struct cuddl_eventsrc *eventsrc);
  *       manager device (Linux).
  *     - Value of ``-errno`` resulting from from ``ioctl()`` call on Cuddl
  *       manager device (Linux).
- *     - Value of ``-errno`` resulting from from ``close()`` call on Cuddl
- *       manager device (Linux).
  */
 int cuddl_eventsrc_is_enabled(struct cuddl_eventsrc *eventsrc);
 
@@ -442,6 +646,11 @@ int cuddl_eventsrc_get_resource_id(
  * Event source sets allow user-space tasks to be woken up when any one of a
  * specified set of events (such as hardware interrupts from a specific set
  * of peripheral devices) occurs.
+ *
+ * On Linux, event source sets are implemented using ``select()``, so the
+ * file descriptors of the member event sources must be less than
+ * ``FD_SETSIZE``.  Use ``cuddl_eventsrcpoll`` for large sets of event
+ * sources.
  */
 struct cuddl_eventsrcset {
 	struct cuddli_eventsrcset_priv priv;
@@ -520,4 +729,322 @@ int cuddl_eventsrcset_timed_wait(
 	const struct cuddl_timespec *timeout,
 	struct cuddl_eventsrcset *result);
 
+/**
+ * struct cuddl_eventsrcpoll - Represents a persistent set of event sources.
+ *
+ * @priv: Private data reserved for internal use by the Cuddl implementation.
+ *
+ * An event source poll set is an alternative to ``cuddl_eventsrcset`` that
+ * scales to large numbers of event sources.  Event sources are registered
+ * with the set once, rather than on every wait, there is no limit on the
+ * file descriptor values of the member event sources, and the cost of a
+ * wakeup is proportional to the number of event sources that have
+ * triggered, rather than the number of event sources in the set.
+ *
+ * Unlike ``cuddl_eventsrcset``, an event source poll set holds an operating
+ * system resource, so it must be initialized with
+ * ``cuddl_eventsrcpoll_init()`` and cleaned up with
+ * ``cuddl_eventsrcpoll_destroy()``, and it must not be copied.
+ */
+struct cuddl_eventsrcpoll {
+	struct cuddli_eventsrcpoll_priv priv;
+};
+
+/**
+ * cuddl_eventsrcpoll_init() - Initialize an event source poll set.
+ *
+ * @set: The event source poll set to initialize.
+ *
+ * After a successful call, the specified event source poll set will be valid
+ * and empty.
+ *
+ * Return: ``0`` on success, or a negative error code.
+ *
+ *   Error codes:
+ *     - ``-ENOSYS``: Event source poll sets are not supported for real-time
+ *       (Xenomai) event sources.
+ *     - Value of ``-errno`` resulting from from ``epoll_create1()`` call
+ *       (Linux).
+ */
+int cuddl_eventsrcpoll_init(struct cuddl_eventsrcpoll *set);
+
+/**
+ * cuddl_eventsrcpoll_destroy() - Clean up an event source poll set.
+ *
+ * @set: The event source poll set to clean up.
+ *
+ * Release the resources associated with the event source poll set.  The
+ * member event sources are not affected.
+ *
+ * Return: ``0`` on success, or a negative error code.
+ *
+ *   Error codes:
+ *     - Value of ``-errno`` resulting from from ``close()`` call (Linux).
+ */
+int cuddl_eventsrcpoll_destroy(struct cuddl_eventsrcpoll *set);
+
+/**
+ * cuddl_eventsrcpoll_add() - Add an event source to an event src poll set.
+ *
+ * @set: The event source poll set to be modified.
+ *
+ * @eventsrc: The event source to be added.  The data structure pointed to by
+ *            this parameter must remain valid (and open) until it is removed
+ *            from the set, since it is returned by
+ *            ``cuddl_eventsrcpoll_timed_wait()`` when the event source
+ *            triggers.
+ *
+ * Return: ``0`` on success, or a negative error code.
+ *
+ *   Error codes:
+ *     - Value of ``-errno`` resulting from from ``epoll_ctl()`` call
+ *       (Linux).
+ */
+int cuddl_eventsrcpoll_add(
+	struct cuddl_eventsrcpoll *set, struct cuddl_eventsrc *eventsrc);
+
+/**
+ * cuddl_eventsrcpoll_remove() - Remove an event source from a poll set.
+ *
+ * @set: The event source poll set to be modified.
+ *
+ * @eventsrc: The event source to be removed.
+ *
+ * Return: ``0`` on success, or a negative error code.
+ *
+ *   Error codes:
+ *     - Value of ``-errno`` resulting from from ``epoll_ctl()`` call
+ *       (Linux).
+ */
+int cuddl_eventsrcpoll_remove(
+	struct cuddl_eventsrcpoll *set, struct cuddl_eventsrc *eventsrc);
+
+/**
+ * cuddl_eventsrcpoll_size() - Get the number of event sources in a set.
+ *
+ * @set: The event source poll set to be checked.
+ *
+ * Return: Number of event sources currently in the set.
+ */
+int cuddl_eventsrcpoll_size(const struct cuddl_eventsrcpoll *set);
+
+/**
+ * cuddl_eventsrcpoll_timed_wait() - Timed wait for events in a poll set.
+ *
+ * @set: Input parameter identifying the sources of events to be waited on.
+ *
+ * @timeout: Relative time value specifying the maximum time to wait for an
+ *           event, or ``NULL`` to wait indefinitely.  The timeout is rounded
+ *           up to a whole number of milliseconds (Linux).
+ *
+ * @ready: Output array that receives pointers to the event sources that
+ *         have triggered.
+ *
+ * @max_ready: Number of elements in the ``ready`` array.  If more event
+ *             sources have triggered, the remaining ones are reported by the
+ *             next call.
+ *
+ * Performs a blocking wait for events from the event sources in ``set``
+ * with a timeout.  The pending event count of every event source returned in
+ * ``ready`` is consumed, as for ``cuddl_eventsrc_try_wait()``.
+ *
+ * Return:
+ *   The number of triggered event sources stored in ``ready`` on success,
+ *   or a negative error code.
+ *
+ *   Error codes:
+ *     - ``-ETIMEDOUT``: A timeout occurred.
+ *     - ``-EINVAL``: ``max_ready`` is not positive.
+ *     - Value of ``-errno`` resulting from from ``epoll_wait()`` call
+ *       (Linux).
+ *     - Value of ``-errno`` resulting from from ``read()`` call on event
+ *       source file descriptor (Linux).
+ */
+int cuddl_eventsrcpoll_timed_wait(
+	struct cuddl_eventsrcpoll *set,
+	const struct cuddl_timespec *timeout,
+	struct cuddl_eventsrc **ready,
+	int max_ready);
+
+/**
+ * enum cuddl_eventengine_flags - Event engine initialization options.
+ *
+ * @CUDDL_EVENTENGINEF_NO_IO_URING: Do not use ``io_uring``, even if it is
+ *                                  supported by the running kernel (Linux).
+ */
+enum cuddl_eventengine_flags {
+	CUDDL_EVENTENGINEF_NO_IO_URING = (1 << 0),
+};
+
+/**
+ * struct cuddl_eventengine_event - Event reported by an event engine.
+ *
+ * @eventsrc: The event source that triggered.
+ *
+ * @index: Index of the event source, as returned by
+ *         ``cuddl_eventengine_add()``.
+ *
+ * @count: Cumulative event source interrupt count, or a negative error code
+ *         if waiting on (or re-enabling) the event source failed.
+ */
+struct cuddl_eventengine_event {
+	struct cuddl_eventsrc *eventsrc;
+	int index;
+	int count;
+};
+
+/**
+ * struct cuddl_eventengine - Batched wait/re-enable engine for event sources.
+ *
+ * @priv: Private data reserved for internal use by the Cuddl implementation.
+ *
+ * An event engine waits on many event sources at once and minimizes the
+ * number of system calls needed to re-enable and wait on them.  Each event
+ * source added to the engine is *armed*, meaning that a wait for its next
+ * event is pending.  Once an event has been reported by
+ * ``cuddl_eventengine_timed_wait()``, the event source is disarmed until it
+ * is re-armed with ``cuddl_eventengine_rearm()``, which optionally
+ * re-enables the event source at the same time.
+ *
+ * On Linux kernels that support it, the engine is implemented using
+ * ``io_uring``.  Re-enable writes and the subsequent waits are queued as
+ * linked submissions, and all queued submissions are passed to the kernel
+ * (and completions reaped) by a single system call in
+ * ``cuddl_eventengine_timed_wait()``.  On older kernels (or if
+ * ``io_uring`` is disabled), the engine falls back to ``epoll()``, with the
+ * same semantics.
+ *
+ * The event sources added to an engine must remain open until the engine
+ * is destroyed.
+ */
+struct cuddl_eventengine {
+	struct cuddli_eventengine_priv priv;
+};
+
+/**
+ * cuddl_eventengine_init() - Initialize an event engine.
+ *
+ * @engine: The event engine to initialize.
+ *
+ * @max_eventsrcs: Maximum number of event sources that will be added.
+ *
+ * @flags: Initialization options (``cuddl_eventengine_flags``).
+ *
+ * Return: ``0`` on success, or a negative error code.
+ *
+ *   Error codes:
+ *     - ``-EINVAL``: ``max_eventsrcs`` is not positive.
+ *     - ``-ENOMEM``: Error allocating memory.
+ *     - ``-ENOSYS``: Event engines are not supported for real-time
+ *       (Xenomai) event sources.
+ *     - Value of ``-errno`` resulting from from ``epoll_create1()`` call
+ *       (Linux).
+ */
+int cuddl_eventengine_init(
+	struct cuddl_eventengine *engine, int max_eventsrcs, int flags);
+
+/**
+ * cuddl_eventengine_destroy() - Clean up an event engine.
+ *
+ * @engine: The event engine to clean up.
+ *
+ * Any pending waits are cancelled.  The event sources are not closed.
+ *
+ * Return: ``0`` on success, or a negative error code.
+ *
+ *   Error codes:
+ *     - Value of ``-errno`` resulting from from ``close()`` call (Linux).
+ */
+int cuddl_eventengine_destroy(struct cuddl_eventengine *engine);
+
+/**
+ * cuddl_eventengine_uses_io_uring() - Check which implementation is in use.
+ *
+ * @engine: The event engine to check.
+ *
+ * Return: ``1`` if the engine is using ``io_uring``, or ``0`` if it is
+ * using the fallback implementation.
+ */
+int cuddl_eventengine_uses_io_uring(const struct cuddl_eventengine *engine);
+
+/**
+ * cuddl_eventengine_add() - Add an event source to an event engine.
+ *
+ * @engine: The event engine to be modified.
+ *
+ * @eventsrc: The event source to be added and armed.  The data structure
+ *            pointed to by this parameter must remain valid until the engine
+ *            is destroyed.
+ *
+ * The event source is not enabled by this call.
+ *
+ * Return: Non-negative event source index on success, or a negative error
+ * code.
+ *
+ *   Error codes:
+ *     - ``-ENOSPC``: ``max_eventsrcs`` event sources have already been
+ *       added.
+ *     - Value of ``-errno`` resulting from from ``epoll_ctl()`` or
+ *       ``io_uring_enter()`` call (Linux).
+ */
+int cuddl_eventengine_add(
+	struct cuddl_eventengine *engine, struct cuddl_eventsrc *eventsrc);
+
+/**
+ * cuddl_eventengine_rearm() - Re-arm (and optionally re-enable) an event src.
+ *
+ * @engine: The event engine containing the event source.
+ *
+ * @index: Index of the event source, as returned by
+ *         ``cuddl_eventengine_add()``.
+ *
+ * @enable: If non-zero, the event source is also re-enabled, as for
+ *          ``cuddl_eventsrc_enable()``, before it is armed.
+ *
+ * When ``io_uring`` is in use, the request is only queued, and is passed to
+ * the kernel by the next call to ``cuddl_eventengine_timed_wait()``.  If the
+ * event source is already armed, it is only re-enabled, immediately.
+ *
+ * Return: ``0`` on success, or a negative error code.
+ *
+ *   Error codes:
+ *     - ``-EINVAL``: Invalid ``index``.
+ *     - Value of ``-errno`` resulting from from ``write()``, ``epoll_ctl()``,
+ *       or ``io_uring_enter()`` call (Linux).
+ */
+int cuddl_eventengine_rearm(
+	struct cuddl_eventengine *engine, int index, int enable);
+
+/**
+ * cuddl_eventengine_timed_wait() - Timed wait for events in an event engine.
+ *
+ * @engine: The event engine to wait on.
+ *
+ * @timeout: Relative time value specifying the maximum time to wait for an
+ *           event, or ``NULL`` to wait indefinitely.
+ *
+ * @events: Output array that receives the events that have occurred.
+ *
+ * @max_events: Number of elements in the ``events`` array.  Any additional
+ *              events are reported by the next call.
+ *
+ * Submit all queued requests and wait until at least one armed event source
+ * has triggered.  Every event source reported in ``events`` is disarmed.
+ *
+ * Return:
+ *   The number of events stored in ``events`` on success, or a negative
+ *   error code.
+ *
+ *   Error codes:
+ *     - ``-ETIMEDOUT``: A timeout occurred.
+ *     - ``-EINVAL``: ``max_events`` is not positive.
+ *     - Value of ``-errno`` resulting from from ``epoll_wait()``, ``read()``,
+ *       or ``io_uring_enter()`` call (Linux).
+ */
+int cuddl_eventengine_timed_wait(
+	struct cuddl_eventengine *engine,
+	const struct cuddl_timespec *timeout,
+	struct cuddl_eventengine_event *events,
+	int max_events);
+
 #endif /* !_CUDDL_EVENTSRC_H */
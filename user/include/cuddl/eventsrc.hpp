@@ -20,11 +20,16 @@
 
 #include <cuddl/general.hpp>
 #include <chrono>
+#include <unordered_map>
+#include <vector>
 
 namespace cuddl {
 
-// Forward declaration.
+// Forward declarations.
 class EventSrcSet;
+class EventSrcPoll;
+class EventEngine;
+class Ring;
 
 /// \verbatim embed:rst:leading-slashes
 ///
@@ -374,6 +379,29 @@ public:
 		claim_and_open(ResourceID(full_name), claim_flags, open_flags);
 	}
 
+	/// \verbatim embed:rst:leading-slashes
+	///
+	/// C++ wrapper for :c:func:`cuddl_eventsrc_open`.
+	///
+	/// Open an event source that has already been claimed (e.g. via
+	/// :cpp:func:`claim_batch`).  The instance takes ownership of the
+	/// claim, so the event source is released if opening fails and when
+	/// the instance is destroyed.
+	///
+	/// \endverbatim
+	/// @throws std::system_error Operation failed.
+	void open(const EventSrcInfo &info,
+		  const EventSrcOpenFlags &open_flags=0) {
+		cuddl_eventsrc_info eventinfo = info;
+		int ret = cuddl_eventsrc_open(
+			&eventsrc, &eventinfo, open_flags.as_int());
+		if (ret < 0) {
+			cuddl_eventsrc_release(&eventinfo);
+			throw_err(ret, __func__);
+		}
+		opened_ = true;
+	}
+
 	/// \verbatim embed:rst:leading-slashes
 	///
 	/// C++ wrapper for :c:func:`cuddl_eventsrc_close_and_release`.
@@ -427,6 +455,80 @@ public:
 		ts.tv_nsec = ns.count();
 		return cuddl_eventsrc_timed_wait(&eventsrc, &ts);
 	}
+
+	/// \verbatim embed:rst:leading-slashes
+	///
+	/// C++ wrapper for :c:func:`cuddl_eventsrc_set_spin_budget`.
+	///
+	/// \endverbatim
+	/// @throws std::system_error Operation failed.
+	void set_spin_budget(const std::chrono::nanoseconds &budget) {
+		int ret = cuddl_eventsrc_set_spin_budget(
+			&eventsrc, budget.count());
+		if (ret < 0) { throw_err(ret, __func__); }
+	}
+
+	/// \verbatim embed:rst:leading-slashes
+	///
+	/// C++ wrapper for :c:func:`cuddl_eventsrc_get_spin_stats`.
+	///
+	/// \endverbatim
+	cuddl_eventsrc_spin_stats spin_stats() const {
+		cuddl_eventsrc_spin_stats stats;
+		cuddl_eventsrc_get_spin_stats(&eventsrc, &stats);
+		return stats;
+	}
+
+	/// \verbatim embed:rst:leading-slashes
+	///
+	/// C++ wrapper for :c:func:`cuddl_eventsrc_enable_latency_stats`.
+	///
+	/// \endverbatim
+	void enable_latency_stats(bool enable=true) {
+		cuddl_eventsrc_enable_latency_stats(&eventsrc, enable);
+	}
+
+	/// \verbatim embed:rst:leading-slashes
+	///
+	/// C++ wrapper for :c:func:`cuddl_eventsrc_get_latency_stats`.
+	///
+	/// \endverbatim
+	cuddl_eventsrc_latency_stats latency_stats() const {
+		cuddl_eventsrc_latency_stats stats;
+		cuddl_eventsrc_get_latency_stats(&eventsrc, &stats);
+		return stats;
+	}
+
+	/// \verbatim embed:rst:leading-slashes
+	///
+	/// C++ wrapper for :c:func:`cuddl_eventsrc_reset_latency_stats`.
+	///
+	/// \endverbatim
+	void reset_latency_stats() {
+		cuddl_eventsrc_reset_latency_stats(&eventsrc);
+	}
+
+	/// \verbatim embed:rst:leading-slashes
+	///
+	/// C++ wrapper for :c:func:`cuddl_eventsrc_wait_record`.
+	///
+	/// \endverbatim
+	int wait_record(cuddl_eventsrc_record &record) {
+		return cuddl_eventsrc_wait_record(&eventsrc, &record);
+	}
+
+	/// \verbatim embed:rst:leading-slashes
+	///
+	/// C++ wrapper for :c:func:`cuddl_eventsrc_get_record`.
+	///
+	/// \endverbatim
+	/// @throws std::system_error Operation failed.
+	cuddl_eventsrc_record get_record() {
+		cuddl_eventsrc_record record;
+		int ret = cuddl_eventsrc_get_record(&eventsrc, &record);
+		if (ret < 0) { throw_err(ret, __func__); }
+		return record;
+	}
         ///  @}
 
 	/// @name Event Enable/Disable
@@ -478,6 +580,9 @@ private:
 	bool opened_{false};
 
 	friend class EventSrcSet;
+	friend class EventSrcPoll;
+	friend class EventEngine;
+	friend class Ring;
 };
 
 inline std::ostream &operator <<(std::ostream &os, const EventSrc &eventsrc)
@@ -490,6 +595,8 @@ inline std::ostream &operator <<(std::ostream &os, const EventSrc &eventsrc)
 ///
 /// C++ wrapper class for :c:type:`cuddl_eventsrcset`.
 ///
+/// See :cpp:class:`EventSrcPoll` for large sets of event sources.
+///
 /// \endverbatim
 class EventSrcSet
 {
@@ -564,6 +671,262 @@ private:
 	cuddl_eventsrcset eventsrcset;
 };
 
+/// \verbatim embed:rst:leading-slashes
+///
+/// C++ wrapper class for :c:type:`cuddl_eventsrcpoll`.
+///
+/// Event sources are registered once when added, and only the event sources
+/// that have triggered are returned by :cpp:func:`timed_wait`.  The
+/// :cpp:class:`EventSrc` instances added to the set must remain valid until
+/// they are removed or the set is destroyed.
+///
+/// \endverbatim
+class EventSrcPoll
+{
+private:
+	EventSrcPoll(const EventSrcPoll&) = delete;
+	EventSrcPoll& operator=(const EventSrcPoll&) = delete;
+public:
+	/// @name Constructor
+	/// @{
+	/// @throws std::system_error Operation failed.
+	EventSrcPoll() {
+		int ret = cuddl_eventsrcpoll_init(&poll);
+		if (ret < 0) { throw_err(ret, __func__); }
+	}
+        ///  @}
+
+	/// @name Destructor
+	/// @{
+	~EventSrcPoll() {cuddl_eventsrcpoll_destroy(&poll);}
+        ///  @}
+
+	/// \verbatim embed:rst:leading-slashes
+	///
+	/// C++ wrapper for :c:func:`cuddl_eventsrcpoll_add`.
+	///
+	/// \endverbatim
+	/// @throws std::system_error Operation failed.
+	void add(EventSrc &eventsrc) {
+		int ret = cuddl_eventsrcpoll_add(&poll, &eventsrc.eventsrc);
+		if (ret < 0) { throw_err(ret, __func__); }
+		members[&eventsrc.eventsrc] = &eventsrc;
+	}
+
+	/// \verbatim embed:rst:leading-slashes
+	///
+	/// C++ wrapper for :c:func:`cuddl_eventsrcpoll_remove`.
+	///
+	/// \endverbatim
+	/// @throws std::system_error Operation failed.
+	void remove(EventSrc &eventsrc) {
+		int ret = cuddl_eventsrcpoll_remove(&poll, &eventsrc.eventsrc);
+		if (ret < 0) { throw_err(ret, __func__); }
+		members.erase(&eventsrc.eventsrc);
+	}
+
+	/// Test if the set contains the specified event source.
+	bool contains(const EventSrc &eventsrc) const {
+		return members.count(&eventsrc.eventsrc) != 0;
+	}
+
+	/// \verbatim embed:rst:leading-slashes
+	///
+	/// C++ wrapper for :c:func:`cuddl_eventsrcpoll_size`.
+	///
+	/// \endverbatim
+	int size() const {return cuddl_eventsrcpoll_size(&poll);}
+
+	/// \verbatim embed:rst:leading-slashes
+	///
+	/// C++ wrapper for :c:func:`cuddl_eventsrcpoll_timed_wait`.
+	///
+	/// The triggered event sources are stored in ``ready``, which is
+	/// cleared first.  The return value is the number of triggered event
+	/// sources or a negative error code (e.g. ``-ETIMEDOUT``).
+	///
+	/// \endverbatim
+	int timed_wait(const cuddl_timespec &timeout,
+	               std::vector<EventSrc*> &ready) {
+		return wait(&timeout, ready);
+	}
+
+	/// \verbatim embed:rst:leading-slashes
+	///
+	/// C++ wrapper for :c:func:`cuddl_eventsrcpoll_timed_wait`.
+	///
+	/// The triggered event sources are stored in ``ready``, which is
+	/// cleared first.  The return value is the number of triggered event
+	/// sources or a negative error code (e.g. ``-ETIMEDOUT``).
+	///
+	/// \endverbatim
+	int timed_wait(const std::chrono::nanoseconds &timeout,
+	               std::vector<EventSrc*> &ready) {
+		auto s = std::chrono::duration_cast<std::chrono::seconds>(
+			timeout);
+		auto ns = timeout - s;
+		cuddl_timespec ts;
+		ts.tv_sec = s.count();
+		ts.tv_nsec = ns.count();
+		return wait(&ts, ready);
+	}
+
+private:
+	int wait(const cuddl_timespec *timeout,
+	         std::vector<EventSrc*> &ready) {
+		cuddl_eventsrc *c_ready[max_ready];
+
+		ready.clear();
+		int ret = cuddl_eventsrcpoll_timed_wait(
+			&poll, timeout, c_ready, max_ready);
+		for (int i=0; i < ret; i++)
+			ready.push_back(members[c_ready[i]]);
+		return ret;
+	}
+
+	static constexpr int max_ready = 64;
+	cuddl_eventsrcpoll poll;
+	std::unordered_map<const cuddl_eventsrc*, EventSrc*> members;
+};
+
+/// \verbatim embed:rst:leading-slashes
+///
+/// C++ wrapper for :c:enum:`cuddl_eventengine_flags`.
+///
+/// The ``|`` operator is overloaded to return an
+/// :cpp:type:`EventEngineFlags` instance.  The stream output operator is
+/// also overloaded.
+///
+/// \endverbatim
+enum class EventEngineFlag {
+	NO_IO_URING = CUDDL_EVENTENGINEF_NO_IO_URING,
+};
+
+inline std::ostream &operator <<(std::ostream &os, const EventEngineFlag &f)
+{
+	if (f == EventEngineFlag::NO_IO_URING) os << "NO_IO_URING";
+	else                                   os << "INVALID_FLAG";
+	return os;
+}
+
+/// \verbatim embed:rst:leading-slashes
+///
+/// C++ class representing a set of one or more :cpp:enum:`EventEngineFlag`
+/// elements.
+///
+/// See the :cpp:type:`Flags` class template documentation for member
+/// functions.
+///
+/// The ``|`` operator is overloaded for :cpp:enum:`EventEngineFlag` and
+/// :cpp:type:`EventEngineFlags` arguments.  The ``|=`` operator is
+/// overloaded as an alias for ``Flags::set``.  The stream output operator is
+/// also overloaded.
+///
+/// \endverbatim
+using EventEngineFlags = Flags<EventEngineFlag>;
+
+inline std::ostream &operator <<(std::ostream &os, const EventEngineFlags &f)
+{
+	std::string sep = "";
+
+	if (f.is_set(EventEngineFlag::NO_IO_URING)) {
+		os << sep << EventEngineFlag::NO_IO_URING;
+		sep = flag_sep;
+	}
+	return os;
+}
+
+/// \verbatim embed:rst:leading-slashes
+///
+/// C++ wrapper class for :c:type:`cuddl_eventengine`.
+///
+/// The :cpp:class:`EventSrc` instances added to the engine must remain open
+/// until the engine is destroyed.
+///
+/// \endverbatim
+class EventEngine
+{
+private:
+	EventEngine(const EventEngine&) = delete;
+	EventEngine& operator=(const EventEngine&) = delete;
+public:
+	/// @name Constructor
+	/// @{
+	/// @throws std::system_error Operation failed.
+	EventEngine(int max_eventsrcs, const EventEngineFlags &flags=0) {
+		int ret = cuddl_eventengine_init(
+			&engine, max_eventsrcs, flags.as_int());
+		if (ret < 0) { throw_err(ret, __func__); }
+	}
+        ///  @}
+
+	/// @name Destructor
+	/// @{
+	~EventEngine() {cuddl_eventengine_destroy(&engine);}
+        ///  @}
+
+	/// \verbatim embed:rst:leading-slashes
+	///
+	/// C++ wrapper for :c:func:`cuddl_eventengine_uses_io_uring`.
+	///
+	/// \endverbatim
+	bool uses_io_uring() const {
+		return cuddl_eventengine_uses_io_uring(&engine);
+	}
+
+	/// \verbatim embed:rst:leading-slashes
+	///
+	/// C++ wrapper for :c:func:`cuddl_eventengine_add`.
+	///
+	/// \endverbatim
+	/// @throws std::system_error Operation failed.
+	int add(EventSrc &eventsrc) {
+		int ret = cuddl_eventengine_add(&engine, &eventsrc.eventsrc);
+		if (ret < 0) { throw_err(ret, __func__); }
+		return ret;
+	}
+
+	/// \verbatim embed:rst:leading-slashes
+	///
+	/// C++ wrapper for :c:func:`cuddl_eventengine_rearm`.
+	///
+	/// \endverbatim
+	/// @throws std::system_error Operation failed.
+	void rearm(int index, bool enable=true) {
+		int ret = cuddl_eventengine_rearm(&engine, index, enable);
+		if (ret < 0) { throw_err(ret, __func__); }
+	}
+
+	/// \verbatim embed:rst:leading-slashes
+	///
+	/// C++ wrapper for :c:func:`cuddl_eventengine_timed_wait`.
+	///
+	/// The events are stored in ``events``, which is resized to the number
+	/// of events that occurred.  The return value is the number of events
+	/// or a negative error code (e.g. ``-ETIMEDOUT``).
+	///
+	/// \endverbatim
+	int timed_wait(const std::chrono::nanoseconds &timeout,
+	               std::vector<cuddl_eventengine_event> &events,
+	               int max_events=64) {
+		auto s = std::chrono::duration_cast<std::chrono::seconds>(
+			timeout);
+		auto ns = timeout - s;
+		cuddl_timespec ts;
+		ts.tv_sec = s.count();
+		ts.tv_nsec = ns.count();
+
+		events.resize(max_events);
+		int ret = cuddl_eventengine_timed_wait(
+			&engine, &ts, events.data(), max_events);
+		events.resize(ret > 0 ? ret : 0);
+		return ret;
+	}
+
+private:
+	cuddl_eventengine engine;
+};
+
 } // namespace cuddl
 
 #endif /* !_CUDDL_EVENTSRC_HPP */
@@ -50,8 +50,6 @@
  *       manager device (Linux).
  *     - Value of ``-errno`` resulting from from ``ioctl()`` call on Cuddl
  *       manager device (Linux).
- *     - Value of ``-errno`` resulting from from ``close()`` call on Cuddl
- *       manager device (Linux).
  */
 int cuddli_memregion_release_by_token(struct cuddlci_token token);
 
@@ -81,8 +79,6 @@ int cuddli_memregion_release_by_token(struct cuddlci_token token);
  *       manager device (Linux).
  *     - Value of ``-errno`` resulting from from ``ioctl()`` call on Cuddl
  *       manager device (Linux).
- *     - Value of ``-errno`` resulting from from ``close()`` call on Cuddl
- *       manager device (Linux).
  */
 int cuddli_eventsrc_release_by_token(struct cuddlci_token token);
 
@@ -52,12 +52,24 @@ typedef time_t cuddli_time_t;
  *          memory region.
  *
  * @fd: File descriptor used in the ``mmap()`` call to map the memory region.
- *      This file descriptor will be closed via ``close()`` after calling
- *      ``munmap()`` when unmapping the memory region.
+ *      This file descriptor may be shared with the other memory regions and
+ *      the event source of the same device, and will be closed after
+ *      calling ``munmap()`` when it is no longer used by any of them.  This
+ *      is ``-1`` for memory regions mapped through the manager device, which
+ *      are mapped via the session's manager file descriptor.
  *
  * @token: Opaque token used (internally) when releasing ownership of the
  *         associated memory region.
  *
+ * @map_mode: Caching mode requested when the memory region was mapped (see
+ *            ``enum cuddlci_mem_map_mode``).
+ *
+ * @page_size: Page size used to map the memory region, as returned by
+ *             ``cuddl_memregion_get_page_size()``.
+ *
+ * @dma_addr: Bus address of a DMA buffer, as returned by
+ *            ``cuddl_memregion_get_dma_addr()``.
+ *
  * This data structure contains private, platform-specific data members
  * reserved for internal use by the Cuddl implementation.
  */
@@ -66,6 +78,25 @@ struct cuddli_memregion_priv {
 	size_t pa_len;
 	int fd;
 	struct cuddlci_token token;
+	int map_mode;
+	size_t page_size;
+	uint64_t dma_addr;
+};
+
+/* Number of log2 buckets in the wakeup latency histogram */
+#define CUDDLI_EVENTSRC_LATENCY_BUCKETS 32
+
+/**
+ * struct cuddli_eventsrc_latency - Wakeup latency statistics.
+ *
+ * @samples: Number of wakeups measured.
+ * @max_ns: Largest wakeup latency measured, in nanoseconds.
+ * @hist: Log2 histogram of wakeup latencies, in nanoseconds.
+ */
+struct cuddli_eventsrc_latency {
+	uint64_t samples;
+	uint64_t max_ns;
+	uint64_t hist[CUDDLI_EVENTSRC_LATENCY_BUCKETS];
 };
 
 /**
@@ -73,18 +104,53 @@ struct cuddli_memregion_priv {
  *
  * @fd: File descriptor used in the ``open()`` call when opening the event
  *      source.  This file descriptor will be used to wait on events and to
- *      enable/disable interrupt events.  The file descriptor will be closed
- *      via ``close()`` when closing the event source.
+ *      enable/disable interrupt events.  The file descriptor may be shared
+ *      with the memory regions of the same device, and will be closed when
+ *      it is no longer used by the event source or any of them.
  *
  * @token: Opaque token used (internally) when releasing ownership of the
  *         associated event source.
  *
+ * @spin_ns: Spin budget (in nanoseconds) used by ``cuddl_eventsrc_wait()``
+ *           before blocking, or ``0`` if spinning is disabled.
+ *
+ * @spin_waits: Number of waits performed with spinning enabled.
+ *
+ * @spin_hits: Number of those waits satisfied during the spin phase.
+ *
+ * @last_seq: Event sequence number returned by the previous call to
+ *            ``cuddl_eventsrc_get_record()``.
+ *
+ * @status: Read-only mapping of the kernel's event source status page, or
+ *          ``NULL`` if the status page could not be mapped.  When
+ *          available, the status page is used to avoid system calls when
+ *          polling the event source.
+ *
+ * @event_count: Event count most recently returned by ``read()`` on
+ *               ``fd``, by any of the event source, set, poll set, or
+ *               event engine wait routines.  An event is pending if the low 32 bits of the
+ *               status page event sequence number differ from this value.
+ *
+ * @latency_enabled: Non-zero if wakeup latencies are being recorded (see
+ *                   ``cuddl_eventsrc_enable_latency_stats()``).
+ *
+ * @latency: Wakeup latency statistics reported by
+ *           ``cuddl_eventsrc_get_latency_stats()``.
+ *
  * This data structure contains private, platform-specific data members
  * reserved for internal use by the Cuddl implementation.
  */
 struct cuddli_eventsrc_priv {
 	int fd;
 	struct cuddlci_token token;
+	long spin_ns;
+	unsigned long long spin_waits;
+	unsigned long long spin_hits;
+	unsigned long long last_seq;
+	const struct cuddlci_eventsrc_status *status;
+	uint32_t event_count;
+	int latency_enabled;
+	struct cuddli_eventsrc_latency latency;
 };
 
 /**
@@ -104,6 +170,53 @@ struct cuddli_eventsrcset_priv {
 	int max_fd;
 };
 
+/**
+ * struct cuddli_eventsrcpoll_priv - Private event source poll set data.
+ *
+ * @epfd: File descriptor returned by ``epoll_create1()``.  Event sources are
+ *        registered with this file descriptor once, when they are added to
+ *        the set.
+ *
+ * @count: Number of event sources currently registered.
+ *
+ * This data structure contains private, platform-specific data members
+ * reserved for internal use by the Cuddl implementation.
+ */
+struct cuddli_eventsrcpoll_priv {
+	int epfd;
+	int count;
+};
+
+struct cuddli_uring;
+struct cuddli_eventengine_slot;
+
+/**
+ * struct cuddli_eventengine_priv - Private event engine data.
+ *
+ * @uring: Internal io_uring state, or ``NULL`` if the ``epoll()`` fallback
+ *         is in use.
+ *
+ * @slots: Array of per-event-source state, indexed by the value returned by
+ *         ``cuddl_eventengine_add()``.
+ *
+ * @n_slots: Number of event sources that have been added.
+ *
+ * @max_slots: Number of elements in the ``slots`` array.
+ *
+ * @epfd: File descriptor returned by ``epoll_create1()`` when the
+ *        ``epoll()`` fallback is in use, or ``-1``.
+ *
+ * This data structure contains private, platform-specific data members
+ * reserved for internal use by the Cuddl implementation.
+ */
+struct cuddli_eventengine_priv {
+	struct cuddli_uring *uring;
+	struct cuddli_eventengine_slot *slots;
+	int n_slots;
+	int max_slots;
+	int epfd;
+};
+
 /**
  * cuddli_open_janitor() - Register a process to cleanup on application crash.
  *
@@ -134,4 +247,20 @@ int cuddli_open_janitor(void);
  */
 int cuddli_close_janitor(int fd);
 
+/*
+ * Mock backend hooks (see cuddl/mock.h).
+ *
+ * When the user-space library is compiled with ``CUDDLI_ENABLE_MOCK``, these
+ * routines replace the system calls made on the Cuddl manager device and on
+ * memory region and event source device files.  Like the system calls they
+ * replace, they return ``-1`` and set ``errno`` on failure.
+ */
+int cuddli_mock_manager_open(void);
+int cuddli_mock_manager_ioctl(int fd, unsigned long request, void *arg);
+int cuddli_mock_memregion_open(struct cuddlci_token token);
+int cuddli_mock_eventsrc_open(struct cuddlci_token token);
+int cuddli_mock_eventsrc_close(int fd);
+ssize_t cuddli_mock_eventsrc_read(int fd, uint32_t *count);
+ssize_t cuddli_mock_eventsrc_write(int fd, const uint32_t *value);
+
 #endif /* !_CUDDL_IMPL_LINUX_H */
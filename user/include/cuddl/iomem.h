@@ -110,4 +110,308 @@ inline void cuddl_iowrite32(uint32_t value, cuddl_iomem_t *addr)
 	(*(volatile uint32_t *) (addr)) = value;
 }
 
+/**
+ * cuddl_ioread64() - Read a 64-bit value from device I/O memory.
+ *
+ * @addr: I/O memory address for reading.
+ *
+ * On 32-bit platforms, the compiler may split the access into two 32-bit
+ * accesses.  Use ``cuddl_ioread64_split()`` for registers that may change
+ * between the two halves being read.
+ *
+ * Return: Value that results from reading the specified memory address.
+ */
+inline uint64_t cuddl_ioread64(cuddl_iomem_t *addr)
+{
+	return *(volatile uint64_t *) (addr);
+}
+
+/**
+ * cuddl_iowrite64() - Write a 64-bit value to device I/O memory.
+ *
+ * @value: Value to be written.
+ * @addr: I/O memory address for writing.
+ *
+ * On 32-bit platforms, the compiler may split the access into two 32-bit
+ * accesses.
+ */
+inline void cuddl_iowrite64(uint64_t value, cuddl_iomem_t *addr)
+{
+	(*(volatile uint64_t *) (addr)) = value;
+}
+
+/**
+ * cuddl_ioread64_split() - Read a 64-bit counter split over two registers.
+ *
+ * @lo: I/O memory address of the register holding the low 32 bits.
+ * @hi: I/O memory address of the register holding the high 32 bits.
+ *
+ * Read a free-running 64-bit value (such as a timestamp counter) that is
+ * exposed as two 32-bit registers, without tearing.  The high register is
+ * read before and after the low register, and the sequence is retried if
+ * the low register wrapped in between.
+ *
+ * Return: Value that results from reading the specified registers.
+ */
+inline uint64_t cuddl_ioread64_split(cuddl_iomem_t *lo, cuddl_iomem_t *hi)
+{
+	uint32_t h, l, h2;
+
+	h = cuddl_ioread32(hi);
+	for (;;) {
+		l = cuddl_ioread32(lo);
+		h2 = cuddl_ioread32(hi);
+		if (h2 == h)
+			break;
+		h = h2;
+	}
+	return ((uint64_t) h << 32) | l;
+}
+
+/**
+ * cuddl_atomic_cmpxchg32() - Atomic 32-bit compare and exchange.
+ *
+ * @addr: Memory address, which must be 32-bit aligned.
+ * @old: Expected value.
+ * @value: Value to be stored if the current value equals ``old``.
+ *
+ * The atomic routines are intended for memory regions backed by RAM (for
+ * example, memory shared between processes or with a device via DMA), and
+ * act as full memory barriers.  Atomic operations on uncached device
+ * registers are generally not supported by the hardware.
+ *
+ * Return: Value that was stored at ``addr`` before the operation.  The
+ *         exchange succeeded if this is equal to ``old``.
+ */
+inline uint32_t cuddl_atomic_cmpxchg32(
+	cuddl_iomem_t *addr, uint32_t old, uint32_t value)
+{
+	__atomic_compare_exchange_n((uint32_t *) addr, &old, value, 0,
+				    __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+	return old;
+}
+
+/**
+ * cuddl_atomic_fetch_add32() - Atomic 32-bit fetch and add.
+ *
+ * @addr: Memory address, which must be 32-bit aligned.
+ * @value: Value to be added.
+ *
+ * See ``cuddl_atomic_cmpxchg32()`` for restrictions.
+ *
+ * Return: Value that was stored at ``addr`` before the operation.
+ */
+inline uint32_t cuddl_atomic_fetch_add32(cuddl_iomem_t *addr, uint32_t value)
+{
+	return __atomic_fetch_add((uint32_t *) addr, value, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * cuddl_atomic_fetch_or32() - Atomic 32-bit fetch and bitwise OR.
+ *
+ * @addr: Memory address, which must be 32-bit aligned.
+ * @value: Bits to be set.
+ *
+ * See ``cuddl_atomic_cmpxchg32()`` for restrictions.
+ *
+ * Return: Value that was stored at ``addr`` before the operation.
+ */
+inline uint32_t cuddl_atomic_fetch_or32(cuddl_iomem_t *addr, uint32_t value)
+{
+	return __atomic_fetch_or((uint32_t *) addr, value, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * cuddl_atomic_fetch_and32() - Atomic 32-bit fetch and bitwise AND.
+ *
+ * @addr: Memory address, which must be 32-bit aligned.
+ * @value: Mask of the bits to be preserved.
+ *
+ * See ``cuddl_atomic_cmpxchg32()`` for restrictions.
+ *
+ * Return: Value that was stored at ``addr`` before the operation.
+ */
+inline uint32_t cuddl_atomic_fetch_and32(cuddl_iomem_t *addr, uint32_t value)
+{
+	return __atomic_fetch_and((uint32_t *) addr, value, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * cuddl_atomic_cmpxchg64() - Atomic 64-bit compare and exchange.
+ *
+ * @addr: Memory address, which must be 64-bit aligned.
+ * @old: Expected value.
+ * @value: Value to be stored if the current value equals ``old``.
+ *
+ * See ``cuddl_atomic_cmpxchg32()`` for restrictions.
+ *
+ * Return: Value that was stored at ``addr`` before the operation.
+ */
+inline uint64_t cuddl_atomic_cmpxchg64(
+	cuddl_iomem_t *addr, uint64_t old, uint64_t value)
+{
+	__atomic_compare_exchange_n((uint64_t *) addr, &old, value, 0,
+				    __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+	return old;
+}
+
+/**
+ * cuddl_atomic_fetch_add64() - Atomic 64-bit fetch and add.
+ *
+ * @addr: Memory address, which must be 64-bit aligned.
+ * @value: Value to be added.
+ *
+ * See ``cuddl_atomic_cmpxchg32()`` for restrictions.
+ *
+ * Return: Value that was stored at ``addr`` before the operation.
+ */
+inline uint64_t cuddl_atomic_fetch_add64(cuddl_iomem_t *addr, uint64_t value)
+{
+	return __atomic_fetch_add((uint64_t *) addr, value, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * cuddl_atomic_fetch_or64() - Atomic 64-bit fetch and bitwise OR.
+ *
+ * @addr: Memory address, which must be 64-bit aligned.
+ * @value: Bits to be set.
+ *
+ * See ``cuddl_atomic_cmpxchg32()`` for restrictions.
+ *
+ * Return: Value that was stored at ``addr`` before the operation.
+ */
+inline uint64_t cuddl_atomic_fetch_or64(cuddl_iomem_t *addr, uint64_t value)
+{
+	return __atomic_fetch_or((uint64_t *) addr, value, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * cuddl_atomic_fetch_and64() - Atomic 64-bit fetch and bitwise AND.
+ *
+ * @addr: Memory address, which must be 64-bit aligned.
+ * @value: Mask of the bits to be preserved.
+ *
+ * See ``cuddl_atomic_cmpxchg32()`` for restrictions.
+ *
+ * Return: Value that was stored at ``addr`` before the operation.
+ */
+inline uint64_t cuddl_atomic_fetch_and64(cuddl_iomem_t *addr, uint64_t value)
+{
+	return __atomic_fetch_and((uint64_t *) addr, value, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * enum cuddl_io_width - Access widths for block I/O memory transfers.
+ *
+ * @CUDDL_IOW_ANY: Transfer the data as quickly as possible.  Any mixture of
+ *                 access widths (including SIMD vector loads and
+ *                 non-temporal vector stores) may be used, and accesses are
+ *                 not necessarily performed in address order.  The
+ *                 memregion block routines only use non-temporal stores
+ *                 for uncached and write-combining mappings.  This is
+ *                 appropriate for device RAM such as capture buffers, but
+ *                 not for register windows.
+ *
+ * @CUDDL_IOW_8: Perform every access as a single 8-bit access, in ascending
+ *               address order.
+ *
+ * @CUDDL_IOW_16: Perform every access as a single 16-bit access, in
+ *                ascending address order.
+ *
+ * @CUDDL_IOW_32: Perform every access as a single 32-bit access, in
+ *                ascending address order.
+ *
+ * @CUDDL_IOW_64: Perform every access as a single 64-bit access, in
+ *                ascending address order (64-bit platforms only).
+ *
+ * The value of each fixed-width enumerator is the access width in bytes.
+ */
+enum cuddl_io_width {
+	CUDDL_IOW_ANY = 0,
+	CUDDL_IOW_8   = 1,
+	CUDDL_IOW_16  = 2,
+	CUDDL_IOW_32  = 4,
+	CUDDL_IOW_64  = 8,
+};
+
+/**
+ * cuddl_ioread_block() - Copy a block of device I/O memory to host memory.
+ *
+ * @buf: Host memory buffer that will receive the data.  No alignment is
+ *       required.
+ *
+ * @addr: I/O memory address of the start of the block.
+ *
+ * @len: Number of bytes to copy.
+ *
+ * @width: Access width to be used when reading from device I/O memory (see
+ *         ``enum cuddl_io_width``).
+ *
+ * For fixed access widths, ``addr`` and ``len`` must be multiples of the
+ * access width.
+ *
+ * Return: ``0`` on success, or a negative error code.
+ *
+ *   Error codes:
+ *     - ``-EINVAL``: The access width is invalid, or ``addr`` or ``len`` is
+ *       not a multiple of the access width.
+ */
+int cuddl_ioread_block(
+	void *buf, cuddl_iomem_t *addr, cuddl_size_t len, int width);
+
+/**
+ * cuddl_iowrite_block() - Copy a block of host memory to device I/O memory.
+ *
+ * @addr: I/O memory address of the start of the block.
+ *
+ * @buf: Host memory buffer containing the data to be written.  No alignment
+ *       is required.
+ *
+ * @len: Number of bytes to copy.
+ *
+ * @width: Access width to be used when writing to device I/O memory (see
+ *         ``enum cuddl_io_width``).
+ *
+ * For fixed access widths, ``addr`` and ``len`` must be multiples of the
+ * access width.  All writes have been issued (and are globally visible to
+ * the device, with respect to subsequent register writes) when this
+ * routine returns.
+ *
+ * Return: ``0`` on success, or a negative error code.
+ *
+ *   Error codes:
+ *     - ``-EINVAL``: The access width is invalid, or ``addr`` or ``len`` is
+ *       not a multiple of the access width.
+ */
+int cuddl_iowrite_block(
+	cuddl_iomem_t *addr, const void *buf, cuddl_size_t len, int width);
+
+/**
+ * cuddl_iofill() - Fill a block of device I/O memory with a value.
+ *
+ * @addr: I/O memory address of the start of the block.
+ *
+ * @value: Fill pattern.  For 8, 16, and 32-bit access widths, the
+ *         low-order 8, 16, or 32 bits are written to each location.  For
+ *         ``CUDDL_IOW_64`` and ``CUDDL_IOW_ANY``, the 32-bit value is
+ *         repeated throughout the block.
+ *
+ * @len: Number of bytes to fill.
+ *
+ * @width: Access width to be used when writing to device I/O memory (see
+ *         ``enum cuddl_io_width``).
+ *
+ * ``addr`` and ``len`` must be multiples of the access width, or of ``4``
+ * for ``CUDDL_IOW_ANY``.  All writes have been issued when this routine
+ * returns, as for ``cuddl_iowrite_block()``.
+ *
+ * Return: ``0`` on success, or a negative error code.
+ *
+ *   Error codes:
+ *     - ``-EINVAL``: The access width is invalid, or ``addr`` or ``len`` is
+ *       not suitably aligned.
+ */
+int cuddl_iofill(
+	cuddl_iomem_t *addr, uint32_t value, cuddl_size_t len, int width);
+
 #endif /* !_CUDDL_IOMEM_H */
@@ -71,6 +71,138 @@ const auto iowrite16 = cuddl_iowrite16;
 /// \endverbatim
 const auto iowrite32 = cuddl_iowrite32;
 
+/// \verbatim embed:rst:leading-slashes
+///
+/// C++ wrapper for :c:func:`cuddl_ioread64`.
+///
+/// \endverbatim
+const auto ioread64  = cuddl_ioread64;
+
+/// \verbatim embed:rst:leading-slashes
+///
+/// C++ wrapper for :c:func:`cuddl_iowrite64`.
+///
+/// \endverbatim
+const auto iowrite64 = cuddl_iowrite64;
+
+/// \verbatim embed:rst:leading-slashes
+///
+/// C++ wrapper for :c:func:`cuddl_ioread64_split`.
+///
+/// \endverbatim
+const auto ioread64_split = cuddl_ioread64_split;
+
+/// \verbatim embed:rst:leading-slashes
+///
+/// C++ wrapper for :c:func:`cuddl_atomic_cmpxchg32`.
+///
+/// \endverbatim
+const auto atomic_cmpxchg32 = cuddl_atomic_cmpxchg32;
+
+/// \verbatim embed:rst:leading-slashes
+///
+/// C++ wrapper for :c:func:`cuddl_atomic_fetch_add32`.
+///
+/// \endverbatim
+const auto atomic_fetch_add32 = cuddl_atomic_fetch_add32;
+
+/// \verbatim embed:rst:leading-slashes
+///
+/// C++ wrapper for :c:func:`cuddl_atomic_fetch_or32`.
+///
+/// \endverbatim
+const auto atomic_fetch_or32 = cuddl_atomic_fetch_or32;
+
+/// \verbatim embed:rst:leading-slashes
+///
+/// C++ wrapper for :c:func:`cuddl_atomic_fetch_and32`.
+///
+/// \endverbatim
+const auto atomic_fetch_and32 = cuddl_atomic_fetch_and32;
+
+/// \verbatim embed:rst:leading-slashes
+///
+/// C++ wrapper for :c:func:`cuddl_atomic_cmpxchg64`.
+///
+/// \endverbatim
+const auto atomic_cmpxchg64 = cuddl_atomic_cmpxchg64;
+
+/// \verbatim embed:rst:leading-slashes
+///
+/// C++ wrapper for :c:func:`cuddl_atomic_fetch_add64`.
+///
+/// \endverbatim
+const auto atomic_fetch_add64 = cuddl_atomic_fetch_add64;
+
+/// \verbatim embed:rst:leading-slashes
+///
+/// C++ wrapper for :c:func:`cuddl_atomic_fetch_or64`.
+///
+/// \endverbatim
+const auto atomic_fetch_or64 = cuddl_atomic_fetch_or64;
+
+/// \verbatim embed:rst:leading-slashes
+///
+/// C++ wrapper for :c:func:`cuddl_atomic_fetch_and64`.
+///
+/// \endverbatim
+const auto atomic_fetch_and64 = cuddl_atomic_fetch_and64;
+
+/// \verbatim embed:rst:leading-slashes
+///
+/// C++ wrapper for :c:enum:`cuddl_io_width`.
+///
+/// \endverbatim
+enum class IOWidth {
+	ANY = CUDDL_IOW_ANY,
+	W8  = CUDDL_IOW_8,
+	W16 = CUDDL_IOW_16,
+	W32 = CUDDL_IOW_32,
+	W64 = CUDDL_IOW_64,
+};
+
+/// \verbatim embed:rst:leading-slashes
+///
+/// C++ wrapper for :c:func:`cuddl_ioread_block`.
+///
+/// \endverbatim
+/// @throws std::system_error Operation failed.
+inline void ioread_block(
+	void *buf, iomem_t *addr, cuddl_size_t len,
+	IOWidth width=IOWidth::ANY)
+{
+	int ret = cuddl_ioread_block(buf, addr, len, static_cast<int>(width));
+	if (ret < 0) { throw_err(ret, __func__); }
+}
+
+/// \verbatim embed:rst:leading-slashes
+///
+/// C++ wrapper for :c:func:`cuddl_iowrite_block`.
+///
+/// \endverbatim
+/// @throws std::system_error Operation failed.
+inline void iowrite_block(
+	iomem_t *addr, const void *buf, cuddl_size_t len,
+	IOWidth width=IOWidth::ANY)
+{
+	int ret = cuddl_iowrite_block(addr, buf, len, static_cast<int>(width));
+	if (ret < 0) { throw_err(ret, __func__); }
+}
+
+/// \verbatim embed:rst:leading-slashes
+///
+/// C++ wrapper for :c:func:`cuddl_iofill`.
+///
+/// \endverbatim
+/// @throws std::system_error Operation failed.
+inline void iofill(
+	iomem_t *addr, uint32_t value, cuddl_size_t len,
+	IOWidth width=IOWidth::ANY)
+{
+	int ret = cuddl_iofill(addr, value, len, static_cast<int>(width));
+	if (ret < 0) { throw_err(ret, __func__); }
+}
+
 } // namespace cuddl
 
 #endif /* !_CUDDL_IOMEM_HPP */
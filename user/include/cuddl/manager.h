@@ -17,6 +17,8 @@
 #define _CUDDL_DEVICE_H
 
 #include <cuddl/common_general.h>
+#include <cuddl/common_memregion.h>
+#include <cuddl/common_eventsrc.h>
 #include <cuddl/impl.h>
 
 /**
@@ -27,9 +29,143 @@
  * query the device memory regions and event sources that have been made
  * available to user-space applications by Cuddl kernel drivers.
  *
+ * Each process communicates with the device manager through a single,
+ * persistent manager session.  The session is established automatically by
+ * the first routine that requires it, but it may also be opened explicitly
+ * via ``cuddl_manager_open()`` so that connection or version compatibility
+ * problems are reported up front.  The static manager limits (e.g.
+ * ``cuddl_get_max_managed_devices()``) are only retrieved from the kernel
+ * once per session.
+ *
  * This part of the API is only available to user-space code.
  */
 
+/**
+ * cuddl_manager_open() - Open the device manager session.
+ *
+ * Open the process-wide device manager session (if it is not already open)
+ * and verify that the user-space and kernel-space versions are compatible.
+ * Every successful call increments a session reference count that should
+ * be balanced by a call to ``cuddl_manager_close()``.
+ *
+ * Calling this routine is optional, since all routines that communicate
+ * with the device manager will open the session on demand.  The session is
+ * automatically closed when the process exits.
+ *
+ * Return: ``0`` on success, or a negative error code.
+ *
+ *   Error codes:
+ *     - ``-ENOEXEC``: User/kernel major version number mismatch (Linux).
+ *     - Value of ``-errno`` resulting from from ``open()`` call on Cuddl
+ *       manager device (Linux).
+ *     - Value of ``-errno`` resulting from from ``ioctl()`` call on Cuddl
+ *       manager device (Linux).
+ */
+int cuddl_manager_open(void);
+
+/**
+ * cuddl_manager_close() - Close the device manager session.
+ *
+ * Decrement the session reference count acquired by
+ * ``cuddl_manager_open()``.  When the count reaches zero, the manager device
+ * is closed and any cached manager information is discarded.  A subsequent
+ * call to a routine that requires the device manager will re-open the
+ * session on demand.
+ *
+ * Resources that have been claimed remain claimed after the session is
+ * closed.  This routine must not race with calls made by other threads that
+ * communicate with the device manager (including calls that open the
+ * session implicitly).  Such calls keep the manager device open until they
+ * return, so they never use a closed (or reused) file descriptor, but they
+ * may re-open the session.
+ *
+ * Return: ``0`` on success, or a negative error code.
+ *
+ *   Error codes:
+ *     - Value of ``-errno`` resulting from from ``close()`` call on Cuddl
+ *       manager device (Linux).
+ */
+int cuddl_manager_close(void);
+
+/**
+ * struct cuddl_resource_claim - Resource claim request used for batch claims.
+ *
+ * @id: Resource identifier pattern identifying the resource to be claimed.
+ *      Empty ``group`` or ``device`` strings and an ``instance`` of ``0``
+ *      are treated as wildcards.
+ *
+ * @type: Type of resource to be claimed (``CUDDL_RESOURCE_MEMREGION`` or
+ *        ``CUDDL_RESOURCE_EVENTSRC``).
+ *
+ * @options: Claim options (``cuddl_memregion_claim_flags`` or
+ *           ``cuddl_eventsrc_claim_flags``, depending on ``type``).
+ *
+ * @result: Result of the claim for this entry (output).  This is ``0`` if
+ *          the resource was claimed successfully, the error code associated
+ *          with the entry that caused the batch to fail, or ``-ECANCELED``
+ *          if this entry was rolled back or never attempted because another
+ *          entry failed.
+ *
+ * @meminfo: Memory region information for the claimed resource (output,
+ *           valid only if ``type`` is ``CUDDL_RESOURCE_MEMREGION`` and the
+ *           batch claim succeeded).
+ *
+ * @eventinfo: Event source information for the claimed resource (output,
+ *             valid only if ``type`` is ``CUDDL_RESOURCE_EVENTSRC`` and the
+ *             batch claim succeeded).
+ */
+struct cuddl_resource_claim {
+	struct cuddl_resource_id id;
+	int type;
+	int options;
+	int result;
+	struct cuddl_memregion_info meminfo;
+	struct cuddl_eventsrc_info eventinfo;
+};
+
+/**
+ * cuddl_resource_claim_batch() - Claim several resources at once.
+ *
+ * @claims: Array of resource claim requests.  On return, the ``result``
+ *          field of every entry is updated, and the ``meminfo`` or
+ *          ``eventinfo`` field of every entry is filled in if the batch
+ *          claim succeeded.
+ *
+ * @count: Number of entries in the ``claims`` array.
+ *
+ * Claim all of the specified memory regions and event sources in a single
+ * request to the device manager.  The claim is atomic: either every
+ * resource in the batch is claimed, or (if any entry fails) all resources
+ * claimed on behalf of the batch are released again before returning.
+ *
+ * If an entry's resource identifier contains wildcards and the first
+ * matching resource is already claimed (and not shared), the next matching
+ * resource is tried instead.  This allows several identical wildcard
+ * patterns to be used to claim several distinct resources.
+ *
+ * Resources claimed by this routine are released individually using
+ * ``cuddl_memregion_release()`` or ``cuddl_eventsrc_release()``, and may be
+ * mapped or opened with ``cuddl_memregion_map()`` or
+ * ``cuddl_eventsrc_open()``.
+ *
+ * Return: ``0`` on success, or a negative error code.  The index of the entry
+ * that caused a failure may be found by searching for an entry whose
+ * ``result`` field is neither ``0`` nor ``-ECANCELED``.
+ *
+ *   Error codes:
+ *     - ``-EINVAL``: Invalid ``count`` or resource ``type`` specified.
+ *     - ``-ENXIO``: No resource matching one of the entries was found.
+ *     - ``-EBUSY``: A matching resource was already claimed.
+ *     - ``-ENOMEM``: Error allocating memory.
+ *     - ``-EOVERFLOW``: Error copying data to/from kernel space (Linux).
+ *     - ``-ENOEXEC``: User/kernel major version number mismatch (Linux).
+ *     - Value of ``-errno`` resulting from from ``open()`` call on Cuddl
+ *       manager device (Linux).
+ *     - Value of ``-errno`` resulting from from ``ioctl()`` call on Cuddl
+ *       manager device (Linux).
+ */
+int cuddl_resource_claim_batch(struct cuddl_resource_claim *claims, int count);
+
 /**
  * cuddl_get_max_managed_devices() - Get max number of managed devices.
  *
@@ -47,8 +183,6 @@
  *       manager device (Linux).
  *     - Value of ``-errno`` resulting from from ``ioctl()`` call on Cuddl
  *       manager device (Linux).
- *     - Value of ``-errno`` resulting from from ``close()`` call on Cuddl
- *       manager device (Linux).
  */
 int cuddl_get_max_managed_devices(void);
 
@@ -69,8 +203,6 @@ int cuddl_get_max_managed_devices(void);
  *       manager device (Linux).
  *     - Value of ``-errno`` resulting from from ``ioctl()`` call on Cuddl
  *       manager device (Linux).
- *     - Value of ``-errno`` resulting from from ``close()`` call on Cuddl
- *       manager device (Linux).
  */
 int cuddl_get_max_dev_mem_regions(void);
 
@@ -91,8 +223,6 @@ int cuddl_get_max_dev_mem_regions(void);
  *       manager device (Linux).
  *     - Value of ``-errno`` resulting from from ``ioctl()`` call on Cuddl
  *       manager device (Linux).
- *     - Value of ``-errno`` resulting from from ``close()`` call on Cuddl
- *       manager device (Linux).
  */
 int cuddl_get_max_dev_events(void);
 
@@ -125,8 +255,6 @@ int cuddl_get_max_dev_events(void);
  *       manager device (Linux).
  *     - Value of ``-errno`` resulting from from ``ioctl()`` call on Cuddl
  *       manager device (Linux).
- *     - Value of ``-errno`` resulting from from ``close()`` call on Cuddl
- *       manager device (Linux).
  */
 int cuddl_get_memregion_id_for_slot(
 	struct cuddl_resource_id *id, int device_slot, int mem_slot);
@@ -160,8 +288,6 @@ int cuddl_get_memregion_id_for_slot(
  *       manager device (Linux).
  *     - Value of ``-errno`` resulting from from ``ioctl()`` call on Cuddl
  *       manager device (Linux).
- *     - Value of ``-errno`` resulting from from ``close()`` call on Cuddl
- *       manager device (Linux).
  */
 int cuddl_get_eventsrc_id_for_slot(
 	struct cuddl_resource_id *id, int device_slot, int event_slot);
@@ -190,8 +316,6 @@ int cuddl_get_eventsrc_id_for_slot(
  *       manager device (Linux).
  *     - Value of ``-errno`` resulting from from ``ioctl()`` call on Cuddl
  *       manager device (Linux).
- *     - Value of ``-errno`` resulting from from ``close()`` call on Cuddl
- *       manager device (Linux).
  */
 int cuddl_get_memregion_info_for_id(
 	struct cuddl_memregion_info *meminfo,
@@ -221,8 +345,6 @@ int cuddl_get_memregion_info_for_id(
  *       manager device (Linux).
  *     - Value of ``-errno`` resulting from from ``ioctl()`` call on Cuddl
  *       manager device (Linux).
- *     - Value of ``-errno`` resulting from from ``close()`` call on Cuddl
- *       manager device (Linux).
  */
 int cuddl_get_eventsrc_info_for_id(
 	struct cuddl_eventsrc_info *eventinfo,
@@ -247,8 +369,6 @@ int cuddl_get_eventsrc_info_for_id(
  *       manager device (Linux).
  *     - Value of ``-errno`` resulting from from ``ioctl()`` call on Cuddl
  *       manager device (Linux).
- *     - Value of ``-errno`` resulting from from ``close()`` call on Cuddl
- *       manager device (Linux).
  */
 int cuddl_get_memregion_ref_count_for_id(
 	const struct cuddl_resource_id *memregion_id);
@@ -272,8 +392,6 @@ int cuddl_get_memregion_ref_count_for_id(
  *       manager device (Linux).
  *     - Value of ``-errno`` resulting from from ``ioctl()`` call on Cuddl
  *       manager device (Linux).
- *     - Value of ``-errno`` resulting from from ``close()`` call on Cuddl
- *       manager device (Linux).
  */
 int cuddl_get_eventsrc_ref_count_for_id(
 	const struct cuddl_resource_id *eventsrc_id);
@@ -299,8 +417,6 @@ int cuddl_get_eventsrc_ref_count_for_id(
  *       manager device (Linux).
  *     - Value of ``-errno`` resulting from from ``ioctl()`` call on Cuddl
  *       manager device (Linux).
- *     - Value of ``-errno`` resulting from from ``close()`` call on Cuddl
- *       manager device (Linux).
  */
 int cuddl_decrement_memregion_ref_count_for_id(
 	const struct cuddl_resource_id *memregion_id);
@@ -326,8 +442,6 @@ int cuddl_decrement_memregion_ref_count_for_id(
  *       manager device (Linux).
  *     - Value of ``-errno`` resulting from from ``ioctl()`` call on Cuddl
  *       manager device (Linux).
- *     - Value of ``-errno`` resulting from from ``close()`` call on Cuddl
- *       manager device (Linux).
  */
 int cuddl_decrement_eventsrc_ref_count_for_id(
 	const struct cuddl_resource_id *eventsrc_id);
@@ -364,8 +478,6 @@ int cuddl_decrement_eventsrc_ref_count_for_id(
  *       manager device (Linux).
  *     - Value of ``-errno`` resulting from from ``ioctl()`` call on Cuddl
  *       manager device (Linux).
- *     - Value of ``-errno`` resulting from from ``close()`` call on Cuddl
- *       manager device (Linux).
  */
 int cuddl_get_driver_info_for_memregion_id(
 	char *info_str, cuddl_size_t info_len,
@@ -402,8 +514,6 @@ int cuddl_get_driver_info_for_memregion_id(
  *       manager device (Linux).
  *     - Value of ``-errno`` resulting from from ``ioctl()`` call on Cuddl
  *       manager device (Linux).
- *     - Value of ``-errno`` resulting from from ``close()`` call on Cuddl
- *       manager device (Linux).
  */
 int cuddl_get_driver_info_for_eventsrc_id(
 	char *info_str, cuddl_size_t info_len,
@@ -441,8 +551,6 @@ int cuddl_get_driver_info_for_eventsrc_id(
  *       manager device (Linux).
  *     - Value of ``-errno`` resulting from from ``ioctl()`` call on Cuddl
  *       manager device (Linux).
- *     - Value of ``-errno`` resulting from from ``close()`` call on Cuddl
- *       manager device (Linux).
  */
 int cuddl_get_hw_info_for_memregion_id(
 	char *info_str, cuddl_size_t info_len,
@@ -479,8 +587,6 @@ int cuddl_get_hw_info_for_memregion_id(
  *       manager device (Linux).
  *     - Value of ``-errno`` resulting from from ``ioctl()`` call on Cuddl
  *       manager device (Linux).
- *     - Value of ``-errno`` resulting from from ``close()`` call on Cuddl
- *       manager device (Linux).
  */
 int cuddl_get_hw_info_for_eventsrc_id(
 	char *info_str, cuddl_size_t info_len,
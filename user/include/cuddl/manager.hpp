@@ -20,6 +20,8 @@
 
 #include <cuddl/memregion.hpp>
 #include <cuddl/eventsrc.hpp>
+#include <cuddl/version.hpp>
+#include <vector>
 
 namespace cuddl {
 
@@ -253,6 +255,154 @@ inline std::string get_hw_info_for_eventsrc_id(const cuddl_resource_id &id)
 	return s;
 }
 
+/// \verbatim embed:rst:leading-slashes
+///
+/// C++ wrapper class for :c:type:`cuddl_resource_claim`.
+///
+/// Instances are normally created using :cpp:func:`make_memregion_claim` or
+/// :cpp:func:`make_eventsrc_claim` and passed to :cpp:func:`claim_batch`.
+///
+/// \endverbatim
+class ResourceClaim
+{
+public:
+	/// @name Constructors
+	/// @{
+	ResourceClaim() {
+		memset(&claim, 0, sizeof(claim));
+	}
+	ResourceClaim(const cuddl_resource_claim &claim): claim(claim) {}
+	ResourceClaim(const cuddl_resource_id &id, int type, int options=0) {
+		memset(&claim, 0, sizeof(claim));
+		claim.id = id;
+		claim.type = type;
+		claim.options = options;
+	}
+        ///  @}
+
+	/// Cast operator for converting class instances to the equivalent C
+	/// structure.
+	operator cuddl_resource_claim() const {return claim;}
+
+	/// @name Getter Functions
+	/// @{
+	ResourceID id() const {return claim.id;}
+	int type() const {return claim.type;}
+	int result() const {return claim.result;}
+	MemRegionInfo meminfo() const {return claim.meminfo;}
+	EventSrcInfo eventinfo() const {return claim.eventinfo;}
+        ///  @}
+
+private:
+	cuddl_resource_claim claim;
+};
+
+/// Create a batch claim request for a memory region.
+inline ResourceClaim make_memregion_claim(
+	const cuddl_resource_id &id, const MemRegionClaimFlags &flags=0)
+{
+	return ResourceClaim(id, CUDDL_RESOURCE_MEMREGION, flags.as_int());
+}
+
+/// Create a batch claim request for an event source.
+inline ResourceClaim make_eventsrc_claim(
+	const cuddl_resource_id &id, const EventSrcClaimFlags &flags=0)
+{
+	return ResourceClaim(id, CUDDL_RESOURCE_EVENTSRC, flags.as_int());
+}
+
+/// \verbatim embed:rst:leading-slashes
+///
+/// C++ wrapper for :c:func:`cuddl_resource_claim_batch`.
+///
+/// The results are stored back into the ``claims`` vector.  The claimed
+/// resources may then be mapped or opened using :cpp:func:`MemRegion::map`
+/// or :cpp:func:`EventSrc::open`.
+///
+/// \endverbatim
+/// @throws std::system_error Operation failed.
+inline void claim_batch(std::vector<ResourceClaim> &claims)
+{
+	std::vector<cuddl_resource_claim> c(claims.begin(), claims.end());
+
+	int ret = cuddl_resource_claim_batch(c.data(), c.size());
+	claims.assign(c.begin(), c.end());
+	if (ret < 0) {
+		for (auto &claim: c)
+			if (claim.result && (claim.result != -ECANCELED))
+				throw_resource_id_err(ret, __func__, claim.id);
+		throw_err(ret, __func__);
+	}
+}
+
+/// \verbatim embed:rst:leading-slashes
+///
+/// C++ wrapper class for the device manager session.
+///
+/// The constructor calls :c:func:`cuddl_manager_open` and the destructor
+/// calls :c:func:`cuddl_manager_close`, so the process-wide manager session
+/// remains open for at least as long as any ``Manager`` instance exists.
+/// Creating an instance is optional, but doing so reports connection and
+/// version compatibility errors up front.
+///
+/// \endverbatim
+class Manager
+{
+private:
+	Manager(const Manager&) = delete;
+	Manager& operator=(const Manager&) = delete;
+public:
+	/// @name Constructors
+	/// @{
+	/// @throws std::system_error Operation failed.
+	Manager() {
+		int ret = cuddl_manager_open();
+		if (ret < 0) { throw_err(ret, __func__); }
+	}
+        ///  @}
+
+	/// @name Destructor
+	/// @{
+	~Manager() {cuddl_manager_close();}
+        /// @}
+
+	/// @name Getter Functions
+	/// @{
+
+	/// \verbatim embed:rst:leading-slashes
+	///
+	/// C++ wrapper for :c:func:`cuddl_get_kernel_version_code`.
+	///
+	/// \endverbatim
+	/// @throws std::system_error Operation failed.
+	Version kernel_version() const {return get_kernel_version();}
+
+	/// \verbatim embed:rst:leading-slashes
+	///
+	/// C++ wrapper for :c:func:`cuddl_get_max_managed_devices`.
+	///
+	/// \endverbatim
+	/// @throws std::system_error Operation failed.
+	int max_managed_devices() const {return get_max_managed_devices();}
+
+	/// \verbatim embed:rst:leading-slashes
+	///
+	/// C++ wrapper for :c:func:`cuddl_get_max_dev_mem_regions`.
+	///
+	/// \endverbatim
+	/// @throws std::system_error Operation failed.
+	int max_dev_mem_regions() const {return get_max_dev_mem_regions();}
+
+	/// \verbatim embed:rst:leading-slashes
+	///
+	/// C++ wrapper for :c:func:`cuddl_get_max_dev_events`.
+	///
+	/// \endverbatim
+	/// @throws std::system_error Operation failed.
+	int max_dev_events() const {return get_max_dev_events();}
+        ///  @}
+};
+
 } // namespace cuddl
 
 #endif /* !_CUDDL_MANAGER_HPP */
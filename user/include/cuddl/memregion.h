@@ -100,8 +100,6 @@ struct cuddl_memregion {
  *       manager device (Linux).
  *     - Value of ``-errno`` resulting from from ``ioctl()`` call on Cuddl
  *       manager device (Linux).
- *     - Value of ``-errno`` resulting from from ``close()`` call on Cuddl
- *       manager device (Linux).
  */
 int cuddl_memregion_claim(
 	struct cuddl_memregion_info *meminfo,
@@ -148,9 +146,10 @@ int cuddl_memregion_release(struct cuddl_memregion_info *meminfo);
  *           ``cuddl_memregion_claim()``.
  *
  * @options: Input parameter consisting of a set of flags (ORed together)
- *           that are applicable to the memory region map operation.  No map
- *           flags are currently defined for memory regions, so this
- *           parameter should be set to ``0``.
+ *           that are applicable to the memory region map operation.  See
+ *           ``enum cuddl_memregion_map_flags``.  At most one caching mode
+ *           may be specified.  If ``0``, the memory region is mapped with
+ *           the default caching mode of the underlying UIO or UDD device.
  *
  * Map the memory region identified by ``meminfo`` for user-space access.
  *
@@ -161,6 +160,11 @@ int cuddl_memregion_release(struct cuddl_memregion_info *meminfo);
  * Return: ``0`` on success, or a negative error code.
  *
  *   Error codes:
+ *     - ``-EINVAL``: More than one caching mode was specified.
+ *     - ``-EPERM``: The requested caching mode is not permitted for this
+ *       memory region (see the ``CUDDL_MEMF_MAP_*`` memory region flags).
+ *     - ``-EACCES``: The memory region is not claimed by the calling
+ *       process (Linux, when a caching mode is specified).
  *     - Value of ``-errno`` resulting from from ``open()`` call on UIO or
  *       UDD memory region device (Linux).
  *     - Value of ``-errno`` resulting from from ``mmap()`` call on UIO or
@@ -196,6 +200,43 @@ int cuddl_memregion_map(
  */
 int cuddl_memregion_unmap(struct cuddl_memregion *memregion);
 
+/**
+ * cuddl_memregion_get_page_size() - Get the page size of a mapping.
+ *
+ * @memregion: Input parameter identifying a mapped memory region.
+ *
+ * If the memory region was mapped with ``CUDDL_MEM_MAPF_HUGE_PAGES``, this
+ * routine may be used to determine whether huge pages were used.  Under
+ * Linux, huge pages are inserted by the kernel on first access, and
+ * require Linux 6.12 or later with transparent huge pages not disabled
+ * (i.e. ``/sys/kernel/mm/transparent_hugepage/enabled`` is not set to
+ * ``never``).  The memory region must also be aligned to the huge page size
+ * in physical memory.  Any part of the memory region that does not fill a
+ * whole huge page is mapped with normal pages.
+ *
+ * Return: Size of the pages used to map the memory region, in bytes.
+ */
+cuddl_size_t cuddl_memregion_get_page_size(
+	const struct cuddl_memregion *memregion);
+
+/**
+ * cuddl_memregion_get_dma_addr() - Get the bus address of a DMA buffer.
+ *
+ * @memregion: Input parameter identifying a mapped memory region.
+ *
+ * @dma_addr: Output parameter that receives the bus address of the start of
+ *            the memory region (i.e. the address at ``memregion->addr``), to
+ *            be programmed into the device.
+ *
+ * Return: ``0`` on success, or a negative error code.
+ *
+ *   Error codes:
+ *     - ``-ENXIO``: The memory region is not a DMA buffer (i.e. the
+ *       ``CUDDL_MEMF_DMA`` flag is not set).
+ */
+int cuddl_memregion_get_dma_addr(
+	const struct cuddl_memregion *memregion, uint64_t *dma_addr);
+
 /**
  * cuddl_memregion_claim_and_map() - Claim and map a memory region.
  *
@@ -368,6 +409,373 @@ inline void cuddl_memregion_iowrite32(
 	cuddl_iowrite32(value, (uint8_t*)(memregion->addr)+offset);
 }
 
+/**
+ * cuddl_memregion_ioread64() - Read a 64-bit value from a memregion.
+ *
+ * @memregion: Input identifying the memory region to be read from.  The data
+ *             structure pointed to by this parameter should contain the
+ *             information returned by a successful call to
+ *             ``cuddl_memregion_map()`` or
+ *             ``cuddl_memregion_claim_and_map()``.
+ *
+ * @offset: I/O memory address offset for reading.
+ *
+ * See ``cuddl_ioread64()`` for details.
+ *
+ * Return: Value that results from reading the specified memory address.
+ */
+inline uint64_t cuddl_memregion_ioread64(
+	struct cuddl_memregion *memregion, cuddl_size_t offset)
+{
+	return cuddl_ioread64(
+		(uint8_t*)(memregion->addr)+offset);
+}
+
+/**
+ * cuddl_memregion_iowrite64() - Write a 64-bit value to a memregion.
+ *
+ * @memregion: Input identifying the memory region to be written to.  The data
+ *             structure pointed to by this parameter should contain the
+ *             information returned by a successful call to
+ *             ``cuddl_memregion_map()`` or
+ *             ``cuddl_memregion_claim_and_map()``.
+ *
+ * @value: Value to be written.
+ *
+ * @offset: I/O memory address for writing.
+ *
+ * See ``cuddl_iowrite64()`` for details.
+ */
+inline void cuddl_memregion_iowrite64(
+	struct cuddl_memregion *memregion, uint64_t value,
+	cuddl_size_t offset)
+{
+	cuddl_iowrite64(value, (uint8_t*)(memregion->addr)+offset);
+}
+
+/**
+ * cuddl_memregion_ioread64_split() - Read a split 64-bit counter.
+ *
+ * @memregion: Input identifying the memory region to be read from.  The data
+ *             structure pointed to by this parameter should contain the
+ *             information returned by a successful call to
+ *             ``cuddl_memregion_map()`` or
+ *             ``cuddl_memregion_claim_and_map()``.
+ *
+ * @lo_offset: Offset of the register holding the low 32 bits.
+ *
+ * @hi_offset: Offset of the register holding the high 32 bits.
+ *
+ * See ``cuddl_ioread64_split()`` for details.
+ *
+ * Return: Value that results from reading the specified registers.
+ */
+inline uint64_t cuddl_memregion_ioread64_split(
+	struct cuddl_memregion *memregion,
+	cuddl_size_t lo_offset, cuddl_size_t hi_offset)
+{
+	return cuddl_ioread64_split(
+		(uint8_t*)(memregion->addr)+lo_offset,
+		(uint8_t*)(memregion->addr)+hi_offset);
+}
+
+/**
+ * cuddl_memregion_atomic_cmpxchg32() - Atomic 32-bit compare and exchange.
+ *
+ * @memregion: Input identifying the memory region to be accessed.  The data
+ *             structure pointed to by this parameter should contain the
+ *             information returned by a successful call to
+ *             ``cuddl_memregion_map()`` or
+ *             ``cuddl_memregion_claim_and_map()``.
+ *
+ * @offset: Memory address offset.
+ *
+ * @old: Expected value.
+ *
+ * @value: Value to be stored if the current value equals ``old``.
+ *
+ * See ``cuddl_atomic_cmpxchg32()`` for details.
+ *
+ * Return: Value that was stored at ``offset`` before the operation.
+ */
+inline uint32_t cuddl_memregion_atomic_cmpxchg32(
+	struct cuddl_memregion *memregion, cuddl_size_t offset,
+	uint32_t old, uint32_t value)
+{
+	return cuddl_atomic_cmpxchg32(
+		(uint8_t*)(memregion->addr)+offset, old, value);
+}
+
+/**
+ * cuddl_memregion_atomic_fetch_add32() - Atomic 32-bit fetch and add.
+ *
+ * @memregion: Input identifying the memory region to be accessed.  The data
+ *             structure pointed to by this parameter should contain the
+ *             information returned by a successful call to
+ *             ``cuddl_memregion_map()`` or
+ *             ``cuddl_memregion_claim_and_map()``.
+ *
+ * @offset: Memory address offset.
+ *
+ * @value: Operand.
+ *
+ * See ``cuddl_atomic_fetch_add32()`` for details.
+ *
+ * Return: Value that was stored at ``offset`` before the operation.
+ */
+inline uint32_t cuddl_memregion_atomic_fetch_add32(
+	struct cuddl_memregion *memregion, cuddl_size_t offset,
+	uint32_t value)
+{
+	return cuddl_atomic_fetch_add32(
+		(uint8_t*)(memregion->addr)+offset, value);
+}
+
+/**
+ * cuddl_memregion_atomic_fetch_or32() - Atomic 32-bit fetch and bitwise OR.
+ *
+ * @memregion: Input identifying the memory region to be accessed.  The data
+ *             structure pointed to by this parameter should contain the
+ *             information returned by a successful call to
+ *             ``cuddl_memregion_map()`` or
+ *             ``cuddl_memregion_claim_and_map()``.
+ *
+ * @offset: Memory address offset.
+ *
+ * @value: Operand.
+ *
+ * See ``cuddl_atomic_fetch_or32()`` for details.
+ *
+ * Return: Value that was stored at ``offset`` before the operation.
+ */
+inline uint32_t cuddl_memregion_atomic_fetch_or32(
+	struct cuddl_memregion *memregion, cuddl_size_t offset,
+	uint32_t value)
+{
+	return cuddl_atomic_fetch_or32(
+		(uint8_t*)(memregion->addr)+offset, value);
+}
+
+/**
+ * cuddl_memregion_atomic_fetch_and32() - Atomic 32-bit fetch and bitwise AND.
+ *
+ * @memregion: Input identifying the memory region to be accessed.  The data
+ *             structure pointed to by this parameter should contain the
+ *             information returned by a successful call to
+ *             ``cuddl_memregion_map()`` or
+ *             ``cuddl_memregion_claim_and_map()``.
+ *
+ * @offset: Memory address offset.
+ *
+ * @value: Operand.
+ *
+ * See ``cuddl_atomic_fetch_and32()`` for details.
+ *
+ * Return: Value that was stored at ``offset`` before the operation.
+ */
+inline uint32_t cuddl_memregion_atomic_fetch_and32(
+	struct cuddl_memregion *memregion, cuddl_size_t offset,
+	uint32_t value)
+{
+	return cuddl_atomic_fetch_and32(
+		(uint8_t*)(memregion->addr)+offset, value);
+}
+
+/**
+ * cuddl_memregion_atomic_cmpxchg64() - Atomic 64-bit compare and exchange.
+ *
+ * @memregion: Input identifying the memory region to be accessed.  The data
+ *             structure pointed to by this parameter should contain the
+ *             information returned by a successful call to
+ *             ``cuddl_memregion_map()`` or
+ *             ``cuddl_memregion_claim_and_map()``.
+ *
+ * @offset: Memory address offset.
+ *
+ * @old: Expected value.
+ *
+ * @value: Value to be stored if the current value equals ``old``.
+ *
+ * See ``cuddl_atomic_cmpxchg64()`` for details.
+ *
+ * Return: Value that was stored at ``offset`` before the operation.
+ */
+inline uint64_t cuddl_memregion_atomic_cmpxchg64(
+	struct cuddl_memregion *memregion, cuddl_size_t offset,
+	uint64_t old, uint64_t value)
+{
+	return cuddl_atomic_cmpxchg64(
+		(uint8_t*)(memregion->addr)+offset, old, value);
+}
+
+/**
+ * cuddl_memregion_atomic_fetch_add64() - Atomic 64-bit fetch and add.
+ *
+ * @memregion: Input identifying the memory region to be accessed.  The data
+ *             structure pointed to by this parameter should contain the
+ *             information returned by a successful call to
+ *             ``cuddl_memregion_map()`` or
+ *             ``cuddl_memregion_claim_and_map()``.
+ *
+ * @offset: Memory address offset.
+ *
+ * @value: Operand.
+ *
+ * See ``cuddl_atomic_fetch_add64()`` for details.
+ *
+ * Return: Value that was stored at ``offset`` before the operation.
+ */
+inline uint64_t cuddl_memregion_atomic_fetch_add64(
+	struct cuddl_memregion *memregion, cuddl_size_t offset,
+	uint64_t value)
+{
+	return cuddl_atomic_fetch_add64(
+		(uint8_t*)(memregion->addr)+offset, value);
+}
+
+/**
+ * cuddl_memregion_atomic_fetch_or64() - Atomic 64-bit fetch and bitwise OR.
+ *
+ * @memregion: Input identifying the memory region to be accessed.  The data
+ *             structure pointed to by this parameter should contain the
+ *             information returned by a successful call to
+ *             ``cuddl_memregion_map()`` or
+ *             ``cuddl_memregion_claim_and_map()``.
+ *
+ * @offset: Memory address offset.
+ *
+ * @value: Operand.
+ *
+ * See ``cuddl_atomic_fetch_or64()`` for details.
+ *
+ * Return: Value that was stored at ``offset`` before the operation.
+ */
+inline uint64_t cuddl_memregion_atomic_fetch_or64(
+	struct cuddl_memregion *memregion, cuddl_size_t offset,
+	uint64_t value)
+{
+	return cuddl_atomic_fetch_or64(
+		(uint8_t*)(memregion->addr)+offset, value);
+}
+
+/**
+ * cuddl_memregion_atomic_fetch_and64() - Atomic 64-bit fetch and bitwise AND.
+ *
+ * @memregion: Input identifying the memory region to be accessed.  The data
+ *             structure pointed to by this parameter should contain the
+ *             information returned by a successful call to
+ *             ``cuddl_memregion_map()`` or
+ *             ``cuddl_memregion_claim_and_map()``.
+ *
+ * @offset: Memory address offset.
+ *
+ * @value: Operand.
+ *
+ * See ``cuddl_atomic_fetch_and64()`` for details.
+ *
+ * Return: Value that was stored at ``offset`` before the operation.
+ */
+inline uint64_t cuddl_memregion_atomic_fetch_and64(
+	struct cuddl_memregion *memregion, cuddl_size_t offset,
+	uint64_t value)
+{
+	return cuddl_atomic_fetch_and64(
+		(uint8_t*)(memregion->addr)+offset, value);
+}
+
+/**
+ * cuddl_memregion_read_block() - Copy a block of a memregion to host memory.
+ *
+ * @memregion: Input identifying the memory region to be read from.  The data
+ *             structure pointed to by this parameter should contain the
+ *             information returned by a successful call to
+ *             ``cuddl_memregion_map()`` or
+ *             ``cuddl_memregion_claim_and_map()``.
+ *
+ * @buf: Host memory buffer that will receive the data.
+ *
+ * @offset: I/O memory address offset of the start of the block.
+ *
+ * @len: Number of bytes to copy.
+ *
+ * @width: Access width (see ``enum cuddl_io_width``).  Use
+ *         ``CUDDL_IOW_ANY`` for the highest throughput when copying out of
+ *         device RAM, or a fixed access width for register windows.
+ *
+ * See ``cuddl_ioread_block()`` for details.
+ *
+ * Return: ``0`` on success, or a negative error code.
+ *
+ *   Error codes:
+ *     - ``-ERANGE``: The block extends past the end of the memory region.
+ *     - Error code returned by ``cuddl_ioread_block()``.
+ */
+int cuddl_memregion_read_block(
+	struct cuddl_memregion *memregion, void *buf,
+	cuddl_size_t offset, cuddl_size_t len, int width);
+
+/**
+ * cuddl_memregion_write_block() - Copy host memory to a block of a memregion.
+ *
+ * @memregion: Input identifying the memory region to be written to.  The
+ *             data structure pointed to by this parameter should contain the
+ *             information returned by a successful call to
+ *             ``cuddl_memregion_map()`` or
+ *             ``cuddl_memregion_claim_and_map()``.
+ *
+ * @buf: Host memory buffer containing the data to be written.
+ *
+ * @offset: I/O memory address offset of the start of the block.
+ *
+ * @len: Number of bytes to copy.
+ *
+ * @width: Access width (see ``enum cuddl_io_width``).
+ *
+ * See ``cuddl_iowrite_block()`` for details.  For ``CUDDL_IOW_ANY``,
+ * non-temporal stores are only used if the memory region is mapped uncached
+ * or write-combining, so data written to cached mappings stays in the
+ * cache.
+ *
+ * Return: ``0`` on success, or a negative error code.
+ *
+ *   Error codes:
+ *     - ``-ERANGE``: The block extends past the end of the memory region.
+ *     - Error code returned by ``cuddl_iowrite_block()``.
+ */
+int cuddl_memregion_write_block(
+	struct cuddl_memregion *memregion, const void *buf,
+	cuddl_size_t offset, cuddl_size_t len, int width);
+
+/**
+ * cuddl_memregion_fill() - Fill a block of a memregion with a value.
+ *
+ * @memregion: Input identifying the memory region to be written to.  The
+ *             data structure pointed to by this parameter should contain the
+ *             information returned by a successful call to
+ *             ``cuddl_memregion_map()`` or
+ *             ``cuddl_memregion_claim_and_map()``.
+ *
+ * @value: Fill pattern (see ``cuddl_iofill()``).
+ *
+ * @offset: I/O memory address offset of the start of the block.
+ *
+ * @len: Number of bytes to fill.
+ *
+ * @width: Access width (see ``enum cuddl_io_width``).
+ *
+ * See ``cuddl_iofill()`` for details.  Non-temporal stores are used as
+ * described for ``cuddl_memregion_write_block()``.
+ *
+ * Return: ``0`` on success, or a negative error code.
+ *
+ *   Error codes:
+ *     - ``-ERANGE``: The block extends past the end of the memory region.
+ *     - Error code returned by ``cuddl_iofill()``.
+ */
+int cuddl_memregion_fill(
+	struct cuddl_memregion *memregion, uint32_t value,
+	cuddl_size_t offset, cuddl_size_t len, int width);
+
 /**
  * cuddl_memregion_get_resource_id() - Get the associated resource ID.
  *
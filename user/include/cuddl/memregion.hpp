@@ -20,6 +20,10 @@
 
 #include <cuddl/general.hpp>
 #include <cuddl/iomem.hpp>
+#include <type_traits>
+#if __cplusplus >= 202002L
+#  include <span>
+#endif
 
 namespace cuddl {
 
@@ -32,13 +36,24 @@ namespace cuddl {
 ///
 /// \endverbatim
 enum class MemRegionFlag {
-	SHARED = CUDDL_MEMF_SHARED,
+	SHARED            = CUDDL_MEMF_SHARED,
+	MAP_UNCACHED      = CUDDL_MEMF_MAP_UNCACHED,
+	MAP_WRITE_COMBINE = CUDDL_MEMF_MAP_WRITE_COMBINE,
+	MAP_CACHED        = CUDDL_MEMF_MAP_CACHED,
+	MAP_HUGE_PAGES    = CUDDL_MEMF_MAP_HUGE_PAGES,
+	DMA               = CUDDL_MEMF_DMA,
 };
 
 inline std::ostream &operator <<(std::ostream &os, const MemRegionFlag &f)
 {
-	if (f == MemRegionFlag::SHARED) os << "SHARED";
-	else                            os << "INVALID_FLAG";
+	using F = MemRegionFlag;
+	if      (f == F::SHARED)            os << "SHARED";
+	else if (f == F::MAP_UNCACHED)      os << "MAP_UNCACHED";
+	else if (f == F::MAP_WRITE_COMBINE) os << "MAP_WRITE_COMBINE";
+	else if (f == F::MAP_CACHED)        os << "MAP_CACHED";
+	else if (f == F::MAP_HUGE_PAGES)    os << "MAP_HUGE_PAGES";
+	else if (f == F::DMA)               os << "DMA";
+	else                                os << "INVALID_FLAG";
 	return os;
 }
 
@@ -66,6 +81,26 @@ inline std::ostream &operator <<(std::ostream &os, const MemRegionFlags &f)
 		os << sep << MemRegionFlag::SHARED;
 		sep = flag_sep;
 	}
+	if (f.is_set(MemRegionFlag::MAP_UNCACHED)) {
+		os << sep << MemRegionFlag::MAP_UNCACHED;
+		sep = flag_sep;
+	}
+	if (f.is_set(MemRegionFlag::MAP_WRITE_COMBINE)) {
+		os << sep << MemRegionFlag::MAP_WRITE_COMBINE;
+		sep = flag_sep;
+	}
+	if (f.is_set(MemRegionFlag::MAP_CACHED)) {
+		os << sep << MemRegionFlag::MAP_CACHED;
+		sep = flag_sep;
+	}
+	if (f.is_set(MemRegionFlag::MAP_HUGE_PAGES)) {
+		os << sep << MemRegionFlag::MAP_HUGE_PAGES;
+		sep = flag_sep;
+	}
+	if (f.is_set(MemRegionFlag::DMA)) {
+		os << sep << MemRegionFlag::DMA;
+		sep = flag_sep;
+	}
 	return os;
 }
 
@@ -120,8 +155,7 @@ inline std::ostream &operator <<(
 
 /// \verbatim embed:rst:leading-slashes
 ///
-/// Placeholder for memory region mapping flags that may possibly be
-/// implemented in the future.
+/// C++ wrapper for :c:enum:`cuddl_memregion_map_flags`.
 ///
 /// The ``|`` operator is overloaded to return a
 /// :cpp:type:`MemRegionMapFlags` instance.  The stream output operator is
@@ -129,11 +163,20 @@ inline std::ostream &operator <<(
 ///
 /// \endverbatim
 enum class MemRegionMapFlag {
+	UNCACHED      = CUDDL_MEM_MAPF_UNCACHED,
+	WRITE_COMBINE = CUDDL_MEM_MAPF_WRITE_COMBINE,
+	CACHED        = CUDDL_MEM_MAPF_CACHED,
+	HUGE_PAGES    = CUDDL_MEM_MAPF_HUGE_PAGES,
 };
 
 inline std::ostream &operator <<(
 	std::ostream &os, const MemRegionMapFlag &f)
 {
+	if      (f == MemRegionMapFlag::UNCACHED)      os << "UNCACHED";
+	else if (f == MemRegionMapFlag::WRITE_COMBINE) os << "WRITE_COMBINE";
+	else if (f == MemRegionMapFlag::CACHED)        os << "CACHED";
+	else if (f == MemRegionMapFlag::HUGE_PAGES)    os << "HUGE_PAGES";
+	else                                           os << "INVALID_FLAG";
 	return os;
 }
 
@@ -156,6 +199,24 @@ using MemRegionMapFlags = Flags<MemRegionMapFlag>;
 inline std::ostream &operator <<(
 	std::ostream &os, const MemRegionMapFlags &f)
 {
+	std::string sep = "";
+
+	if (f.is_set(MemRegionMapFlag::UNCACHED)) {
+		os << sep << MemRegionMapFlag::UNCACHED;
+		sep = flag_sep;
+	}
+	if (f.is_set(MemRegionMapFlag::WRITE_COMBINE)) {
+		os << sep << MemRegionMapFlag::WRITE_COMBINE;
+		sep = flag_sep;
+	}
+	if (f.is_set(MemRegionMapFlag::CACHED)) {
+		os << sep << MemRegionMapFlag::CACHED;
+		sep = flag_sep;
+	}
+	if (f.is_set(MemRegionMapFlag::HUGE_PAGES)) {
+		os << sep << MemRegionMapFlag::HUGE_PAGES;
+		sep = flag_sep;
+	}
 	return os;
 }
 
@@ -260,6 +321,10 @@ public:
 	cuddl::iomem_t* addr() const {return mem.addr;}
 	cuddl::size_t len() const {return mem.len;}
 	MemRegionFlags flags() const {return mem.flags;}
+	/// C++ wrapper for :c:func:`cuddl_memregion_get_page_size`.
+	cuddl::size_t page_size() const {
+		return cuddl_memregion_get_page_size(&mem);
+	}
         ///  @}
 
 	/// Test if the memory region has been successfully mapped.
@@ -282,7 +347,7 @@ public:
 		           const MemRegionMapFlags &map_flags=0) {
 		int ret = cuddl_memregion_claim_and_map(
 			&mem, id.group, id.device, id.resource,
-			id.instance, claim_flags.as_int(), 0);
+			id.instance, claim_flags.as_int(), map_flags.as_int());
 		if (ret < 0) { throw_resource_id_err(ret, __func__, id); }
 		mapped_ = true;
 	}
@@ -313,6 +378,29 @@ public:
 		claim_and_map(ResourceID(full_name), claim_flags, map_flags);
 	}
 
+	/// \verbatim embed:rst:leading-slashes
+	///
+	/// C++ wrapper for :c:func:`cuddl_memregion_map`.
+	///
+	/// Map a memory region that has already been claimed (e.g. via
+	/// :cpp:func:`claim_batch`).  The instance takes ownership of the
+	/// claim, so the memory region is released if mapping fails and when
+	/// the instance is destroyed.
+	///
+	/// \endverbatim
+	/// @throws std::system_error Operation failed.
+	void map(const MemRegionInfo &info,
+		 const MemRegionMapFlags &map_flags=0) {
+		cuddl_memregion_info meminfo = info;
+		int ret = cuddl_memregion_map(
+			&mem, &meminfo, map_flags.as_int());
+		if (ret < 0) {
+			cuddl_memregion_release(&meminfo);
+			throw_err(ret, __func__);
+		}
+		mapped_ = true;
+	}
+
 	/// \verbatim embed:rst:leading-slashes
 	///
 	/// C++ wrapper for :c:func:`cuddl_memregion_unmap_and_release`.
@@ -383,6 +471,203 @@ public:
 		cuddl_memregion_iowrite32(&mem, value, offset);
 	}
 
+	/// \verbatim embed:rst:leading-slashes
+	///
+	/// C++ wrapper for :c:func:`cuddl_memregion_ioread64`.
+	///
+        /// \endverbatim
+	uint64_t ioread64(cuddl::size_t offset) {
+		return cuddl_memregion_ioread64(&mem, offset);
+	}
+
+	/// \verbatim embed:rst:leading-slashes
+	///
+	/// C++ wrapper for :c:func:`cuddl_memregion_iowrite64`.
+	///
+        /// \endverbatim
+	void iowrite64(uint64_t value, cuddl::size_t offset) {
+		cuddl_memregion_iowrite64(&mem, value, offset);
+	}
+
+	/// \verbatim embed:rst:leading-slashes
+	///
+	/// C++ wrapper for :c:func:`cuddl_memregion_ioread64_split`.
+	///
+        /// \endverbatim
+	uint64_t ioread64_split(cuddl::size_t lo_offset,
+				cuddl::size_t hi_offset) {
+		return cuddl_memregion_ioread64_split(
+			&mem, lo_offset, hi_offset);
+	}
+
+        ///  @}
+
+	/// @name Atomic Memory Access
+	/// @{
+
+	/// \verbatim embed:rst:leading-slashes
+	///
+	/// C++ wrapper for :c:func:`cuddl_memregion_atomic_cmpxchg32`.
+	///
+        /// \endverbatim
+	uint32_t atomic_cmpxchg32(
+		cuddl::size_t offset, uint32_t old, uint32_t value) {
+		return cuddl_memregion_atomic_cmpxchg32(
+			&mem, offset, old, value);
+	}
+
+	/// \verbatim embed:rst:leading-slashes
+	///
+	/// C++ wrapper for :c:func:`cuddl_memregion_atomic_fetch_add32`.
+	///
+        /// \endverbatim
+	uint32_t atomic_fetch_add32(cuddl::size_t offset, uint32_t value) {
+		return cuddl_memregion_atomic_fetch_add32(
+			&mem, offset, value);
+	}
+
+	/// \verbatim embed:rst:leading-slashes
+	///
+	/// C++ wrapper for :c:func:`cuddl_memregion_atomic_fetch_or32`.
+	///
+        /// \endverbatim
+	uint32_t atomic_fetch_or32(cuddl::size_t offset, uint32_t value) {
+		return cuddl_memregion_atomic_fetch_or32(
+			&mem, offset, value);
+	}
+
+	/// \verbatim embed:rst:leading-slashes
+	///
+	/// C++ wrapper for :c:func:`cuddl_memregion_atomic_fetch_and32`.
+	///
+        /// \endverbatim
+	uint32_t atomic_fetch_and32(cuddl::size_t offset, uint32_t value) {
+		return cuddl_memregion_atomic_fetch_and32(
+			&mem, offset, value);
+	}
+
+	/// \verbatim embed:rst:leading-slashes
+	///
+	/// C++ wrapper for :c:func:`cuddl_memregion_atomic_cmpxchg64`.
+	///
+        /// \endverbatim
+	uint64_t atomic_cmpxchg64(
+		cuddl::size_t offset, uint64_t old, uint64_t value) {
+		return cuddl_memregion_atomic_cmpxchg64(
+			&mem, offset, old, value);
+	}
+
+	/// \verbatim embed:rst:leading-slashes
+	///
+	/// C++ wrapper for :c:func:`cuddl_memregion_atomic_fetch_add64`.
+	///
+        /// \endverbatim
+	uint64_t atomic_fetch_add64(cuddl::size_t offset, uint64_t value) {
+		return cuddl_memregion_atomic_fetch_add64(
+			&mem, offset, value);
+	}
+
+	/// \verbatim embed:rst:leading-slashes
+	///
+	/// C++ wrapper for :c:func:`cuddl_memregion_atomic_fetch_or64`.
+	///
+        /// \endverbatim
+	uint64_t atomic_fetch_or64(cuddl::size_t offset, uint64_t value) {
+		return cuddl_memregion_atomic_fetch_or64(
+			&mem, offset, value);
+	}
+
+	/// \verbatim embed:rst:leading-slashes
+	///
+	/// C++ wrapper for :c:func:`cuddl_memregion_atomic_fetch_and64`.
+	///
+        /// \endverbatim
+	uint64_t atomic_fetch_and64(cuddl::size_t offset, uint64_t value) {
+		return cuddl_memregion_atomic_fetch_and64(
+			&mem, offset, value);
+	}
+
+        ///  @}
+
+	/// @name Block I/O Memory Access
+	/// @{
+
+	/// \verbatim embed:rst:leading-slashes
+	///
+	/// C++ wrapper for :c:func:`cuddl_memregion_read_block`.
+	///
+        /// \endverbatim
+	/// @throws std::system_error Operation failed.
+	void read_block(void *buf, cuddl::size_t offset, cuddl::size_t len,
+			IOWidth width=IOWidth::ANY) {
+		int ret = cuddl_memregion_read_block(
+			&mem, buf, offset, len, static_cast<int>(width));
+		if (ret < 0) { throw_err(ret, __func__); }
+	}
+
+	/// \verbatim embed:rst:leading-slashes
+	///
+	/// C++ wrapper for :c:func:`cuddl_memregion_write_block`.
+	///
+        /// \endverbatim
+	/// @throws std::system_error Operation failed.
+	void write_block(const void *buf,
+			 cuddl::size_t offset, cuddl::size_t len,
+			 IOWidth width=IOWidth::ANY) {
+		int ret = cuddl_memregion_write_block(
+			&mem, buf, offset, len, static_cast<int>(width));
+		if (ret < 0) { throw_err(ret, __func__); }
+	}
+
+	/// \verbatim embed:rst:leading-slashes
+	///
+	/// C++ wrapper for :c:func:`cuddl_memregion_fill`.
+	///
+        /// \endverbatim
+	/// @throws std::system_error Operation failed.
+	void fill(uint32_t value, cuddl::size_t offset, cuddl::size_t len,
+		  IOWidth width=IOWidth::ANY) {
+		int ret = cuddl_memregion_fill(
+			&mem, value, offset, len, static_cast<int>(width));
+		if (ret < 0) { throw_err(ret, __func__); }
+	}
+
+#if __cplusplus >= 202002L
+	/// \verbatim embed:rst:leading-slashes
+	///
+	/// Read ``buf.size_bytes()`` bytes starting at ``offset`` into
+	/// ``buf`` (C++20 only).  See :c:func:`cuddl_memregion_read_block`.
+	///
+        /// \endverbatim
+	/// @throws std::system_error Operation failed.
+	template<class T, std::size_t N>
+	void read_block(std::span<T, N> buf, cuddl::size_t offset,
+			IOWidth width=IOWidth::ANY) {
+		static_assert(!std::is_const<T>::value,
+			      "read_block() requires a writable span");
+		static_assert(std::is_trivially_copyable<T>::value,
+			      "read_block() requires trivially copyable data");
+		read_block(static_cast<void *>(buf.data()), offset,
+			   buf.size_bytes(), width);
+	}
+
+	/// \verbatim embed:rst:leading-slashes
+	///
+	/// Write the contents of ``buf`` starting at ``offset`` (C++20
+	/// only).  See :c:func:`cuddl_memregion_write_block`.
+	///
+        /// \endverbatim
+	/// @throws std::system_error Operation failed.
+	template<class T, std::size_t N>
+	void write_block(std::span<T, N> buf, cuddl::size_t offset,
+			 IOWidth width=IOWidth::ANY) {
+		static_assert(std::is_trivially_copyable<T>::value,
+			      "write_block() requires trivially copyable data");
+		write_block(static_cast<const void *>(buf.data()), offset,
+			    buf.size_bytes(), width);
+	}
+#endif
+
         ///  @}
 
 	/// \verbatim embed:rst:leading-slashes
@@ -399,9 +684,25 @@ public:
 		return ResourceID(id);
 }
 
+	/// \verbatim embed:rst:leading-slashes
+	///
+	/// C++ wrapper for :c:func:`cuddl_memregion_get_dma_addr`.
+	///
+        /// \endverbatim
+	/// @throws std::system_error Operation failed.
+	uint64_t dma_addr() const {
+		uint64_t addr;
+
+		int ret = cuddl_memregion_get_dma_addr(&mem, &addr);
+		if (ret < 0) { throw_err(ret, __func__); }
+		return addr;
+	}
+
 private:
 	cuddl_memregion mem;
 	bool mapped_{false};
+
+	friend class Ring;
 };
 
 inline std::ostream &operator <<(std::ostream &os, const MemRegion &mem)
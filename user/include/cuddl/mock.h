@@ -0,0 +1,235 @@
+/* SPDX-License-Identifier: (MIT OR GPL-2.0-or-later) */
+/*
+ * Cross-platform user-space device driver layer mock backend declarations.
+ *
+ * Copyright (C) 2022 Jeff Webb <jeff.webb@codecraftsmen.org>
+ *
+ * This software is dual-licensed and is made available under the terms of
+ * the MIT License or under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.  You may select (at your
+ * option) either of the licenses listed above.  See the LICENSE.MIT and
+ * LICENSE.GPL-2.0 files in the top-level directory of this distribution for
+ * copyright information and license terms.
+ */
+
+#ifndef _CUDDL_MOCK_H
+#define _CUDDL_MOCK_H
+
+#include <cuddl/common_general.h>
+#include <cuddl/common_memregion.h>
+#include <cuddl/common_eventsrc.h>
+
+/**
+ * DOC: User-space mock backend declarations.
+ *
+ * The mock backend allows applications and drivers built on the Cuddl
+ * user-space API to be unit-tested and benchmarked on systems where the
+ * Cuddl kernel modules cannot be loaded.  When the user-space library is
+ * compiled with the ``CUDDLI_ENABLE_MOCK`` c-preprocessor flag (and
+ * *user/src/cuddl_mock_linux.c* is linked into the application), all device
+ * manager requests are answered in-process instead of by the kernel.
+ *
+ * Mock memory regions are backed by shared memory (``memfd_create()``), so
+ * they may be mapped and accessed exactly like device memory.  Mock event
+ * sources are backed by ``eventfd`` file descriptors, so waiting on them
+ * (including via ``select()``, ``epoll()``, event source poll sets, and
+ * event engines) behaves like waiting on a real device.  A test harness
+ * triggers events by calling ``cuddl_mock_eventsrc_trigger()``, typically
+ * from another thread.
+ *
+ * Mock devices may be created programmatically via the routines below, or
+ * by loading a configuration file.  If no mock devices have been created
+ * when the device manager session is first opened, the configuration file
+ * named by the ``CUDDL_MOCK_CONFIG`` environment variable (if set) is
+ * loaded automatically.  Configuration files contain one directive per
+ * line, and ``#`` starts a comment::
+ *
+ *   # device <group> <name> [<instance> [<driver_info> [<hw_info>]]]
+ *   device my_card adc 1
+ *   # memregion <name> <size_in_bytes> [shared] [dma]
+ *   memregion regs 0x1000
+ *   memregion buffer 65536 shared
+ *   memregion ring 0x4000 dma
+ *   # eventsrc <name> [shared]
+ *   eventsrc irq
+ *
+ * Memory region and event source directives apply to the most recent
+ * device directive.  Mock DMA buffers report the address of their backing
+ * memory (see ``cuddl_mock_memregion_addr()``) as their bus address, so a
+ * test harness can emulate device DMA by casting the bus address that was
+ * programmed into the emulated device registers back to a pointer.  An instance number of ``0`` (the default) selects the
+ * next available instance number, as for kernel drivers.
+ *
+ * Mock event sources support enabling, disabling, and querying the enabled
+ * state.  Events triggered while an event source is disabled are latched
+ * and delivered when it is next enabled, like a masked level-triggered
+ * interrupt.
+ *
+ * The routines declared here are only available when the mock backend is
+ * linked into the application.
+ */
+
+/**
+ * cuddl_mock_add_device() - Create a mock device.
+ *
+ * @group: Device group name.
+ *
+ * @name: Device name.
+ *
+ * @instance: Device instance number, or ``0`` to select the next available
+ *            instance number for the specified group and device name.
+ *
+ * @driver_info: Driver information string, or ``NULL``.
+ *
+ * @hw_info: Hardware information string, or ``NULL``.
+ *
+ * Return: Manager device slot number of the new device on success, or a
+ *         negative error code.
+ *
+ *   Error codes:
+ *     - ``-EINVAL``: ``group`` or ``name`` is ``NULL`` or empty, or
+ *       ``instance`` is negative.
+ *     - ``-EEXIST``: A device with the same group, name, and instance
+ *       already exists.
+ *     - ``-ENOMEM``: No device slots are available.
+ */
+int cuddl_mock_add_device(
+	const char *group,
+	const char *name,
+	int instance,
+	const char *driver_info,
+	const char *hw_info);
+
+/**
+ * cuddl_mock_add_memregion() - Add a memory region to a mock device.
+ *
+ * @device_slot: Manager device slot number returned by
+ *               ``cuddl_mock_add_device()``.
+ *
+ * @name: Memory region name.
+ *
+ * @len: Size of the memory region, in bytes.  The backing memory is rounded
+ *       up to a multiple of the page size and is initially zero-filled.
+ *
+ * @flags: Set of ``cuddl_memregion_flags`` ORed together.  Only
+ *         ``CUDDL_MEMF_SHARED`` and ``CUDDL_MEMF_DMA`` are significant.
+ *         Mock memory regions other than DMA buffers may only be mapped
+ *         cached (as reported via ``CUDDL_MEMF_MAP_CACHED``).
+ *
+ * Return: Memory region slot number on success, or a negative error code.
+ *
+ *   Error codes:
+ *     - ``-EINVAL``: Invalid argument.
+ *     - ``-ENODEV``: No mock device exists in the specified slot.
+ *     - ``-EEXIST``: The device already has a memory region with this name.
+ *     - ``-ENOSPC``: All memory region slots of the device are in use.
+ *     - Value of ``-errno`` resulting from ``memfd_create()``,
+ *       ``ftruncate()``, or ``mmap()``.
+ */
+int cuddl_mock_add_memregion(
+	int device_slot, const char *name, cuddl_size_t len, int flags);
+
+/**
+ * cuddl_mock_add_eventsrc() - Add an event source to a mock device.
+ *
+ * @device_slot: Manager device slot number returned by
+ *               ``cuddl_mock_add_device()``.
+ *
+ * @name: Event source name.
+ *
+ * @flags: Set of ``cuddl_eventsrc_flags`` ORed together.  Only
+ *         ``CUDDL_EVENTSRCF_SHARED`` is significant.
+ *
+ * Return: Event source slot number on success, or a negative error code.
+ *
+ *   Error codes:
+ *     - ``-EINVAL``: Invalid argument.
+ *     - ``-ENODEV``: No mock device exists in the specified slot.
+ *     - ``-EEXIST``: The device already has an event source with this name.
+ *     - ``-ENOSPC``: All event source slots of the device are in use.
+ */
+int cuddl_mock_add_eventsrc(int device_slot, const char *name, int flags);
+
+/**
+ * cuddl_mock_load_config() - Create mock devices from a configuration file.
+ *
+ * @path: Path of the configuration file (see above for the format).
+ *
+ * Devices created before an error is detected are not removed.
+ *
+ * Return: ``0`` on success, or a negative error code.
+ *
+ *   Error codes:
+ *     - ``-EINVAL``: Syntax error in the configuration file.
+ *     - Value of ``-errno`` resulting from ``fopen()``.
+ *     - Error codes returned by ``cuddl_mock_add_device()``,
+ *       ``cuddl_mock_add_memregion()``, or ``cuddl_mock_add_eventsrc()``.
+ */
+int cuddl_mock_load_config(const char *path);
+
+/**
+ * cuddl_mock_reset() - Remove all mock devices.
+ *
+ * All mock resources must have been released, unmapped, and closed.
+ *
+ * Return: ``0`` on success, or a negative error code.
+ *
+ *   Error codes:
+ *     - ``-EBUSY``: A mock resource is still claimed or open.
+ */
+int cuddl_mock_reset(void);
+
+/**
+ * cuddl_mock_memregion_addr() - Get the backing memory of a mock region.
+ *
+ * @device_slot: Manager device slot number.
+ *
+ * @mem_slot: Memory region slot number.
+ *
+ * The returned mapping shares its contents with all mappings of the memory
+ * region made via ``cuddl_memregion_map()``, so a test harness may use it to
+ * emulate device registers or inspect what a driver wrote.
+ *
+ * Return: Address of the start of the memory region, or ``NULL`` if the
+ *         memory region does not exist.
+ */
+void *cuddl_mock_memregion_addr(int device_slot, int mem_slot);
+
+/**
+ * cuddl_mock_eventsrc_trigger() - Trigger an event on a mock event source.
+ *
+ * @device_slot: Manager device slot number.
+ *
+ * @event_slot: Event source slot number.
+ *
+ * Increment the event count, update the event sequence number and
+ * timestamp, and wake up all waiters, as the kernel does when a device
+ * interrupt is handled.  If the event source is disabled, the event is
+ * latched and delivered when the event source is next enabled.  This
+ * routine may be called from any thread.
+ *
+ * Return: ``1`` if the event was delivered, ``0`` if it was latched, or a
+ *         negative error code.
+ *
+ *   Error codes:
+ *     - ``-ENODEV``: The event source does not exist.
+ */
+int cuddl_mock_eventsrc_trigger(int device_slot, int event_slot);
+
+/**
+ * cuddl_mock_eventsrc_is_enabled() - Query the state of a mock event source.
+ *
+ * @device_slot: Manager device slot number.
+ *
+ * @event_slot: Event source slot number.
+ *
+ * Return: ``1`` if the event source is enabled, ``0`` if it is disabled, or
+ *         a negative error code.
+ *
+ *   Error codes:
+ *     - ``-ENODEV``: The event source does not exist.
+ */
+int cuddl_mock_eventsrc_is_enabled(int device_slot, int event_slot);
+
+#endif /* !_CUDDL_MOCK_H */
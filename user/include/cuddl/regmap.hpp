@@ -0,0 +1,343 @@
+/* SPDX-License-Identifier: (MIT OR GPL-2.0-or-later) */
+/*
+ * Cross-platform user-space device driver layer user-space C++ declarations.
+ *
+ * Copyright (C) 2022 Jeff Webb <jeff.webb@codecraftsmen.org>
+ *
+ * This software is dual-licensed and is made available under the terms of
+ * the MIT License or under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.  You may select (at your
+ * option) either of the licenses listed above.  See the LICENSE.MIT and
+ * LICENSE.GPL-2.0 files in the top-level directory of this distribution for
+ * copyright information and license terms.
+ */
+
+#ifndef _CUDDL_REGMAP_HPP
+#define _CUDDL_REGMAP_HPP
+
+// C++ compile-time register map declarations.
+
+#include <cuddl/memregion.hpp>
+#include <type_traits>
+
+namespace cuddl {
+
+/// \verbatim embed:rst:leading-slashes
+///
+/// Access mode of a :cpp:class:`Register` or :cpp:class:`Field`.
+///
+/// Reading a write-only register (or field), or writing a read-only
+/// register (or field), is rejected at compile time.
+///
+/// \endverbatim
+enum class RegAccess {
+	RO, ///< Read-only.
+	WO, ///< Write-only.
+	RW, ///< Read-write.
+};
+
+namespace regmap_detail {
+
+template<class T> struct io;
+
+template<> struct io<uint8_t> {
+	static uint8_t read(iomem_t *a) {return cuddl_ioread8(a);}
+	static void write(uint8_t v, iomem_t *a) {cuddl_iowrite8(v, a);}
+};
+
+template<> struct io<uint16_t> {
+	static uint16_t read(iomem_t *a) {return cuddl_ioread16(a);}
+	static void write(uint16_t v, iomem_t *a) {cuddl_iowrite16(v, a);}
+};
+
+template<> struct io<uint32_t> {
+	static uint32_t read(iomem_t *a) {return cuddl_ioread32(a);}
+	static void write(uint32_t v, iomem_t *a) {cuddl_iowrite32(v, a);}
+};
+
+template<> struct io<uint64_t> {
+	static uint64_t read(iomem_t *a) {return cuddl_ioread64(a);}
+	static void write(uint64_t v, iomem_t *a) {cuddl_iowrite64(v, a);}
+};
+
+template<class T> struct is_reg_type : std::false_type {};
+template<> struct is_reg_type<uint8_t>  : std::true_type {};
+template<> struct is_reg_type<uint16_t> : std::true_type {};
+template<> struct is_reg_type<uint32_t> : std::true_type {};
+template<> struct is_reg_type<uint64_t> : std::true_type {};
+
+constexpr bool readable(RegAccess a) {return a != RegAccess::WO;}
+constexpr bool writable(RegAccess a) {return a != RegAccess::RO;}
+
+template<class T>
+constexpr T make_mask(unsigned shift, unsigned width)
+{
+	return static_cast<T>(
+		((width >= 64) ? ~uint64_t(0) : ((uint64_t(1) << width) - 1))
+		<< shift);
+}
+
+// Compile-time properties of a list of fields passed to RegMap::modify()
+// or RegMap::write().
+template<class... Fs> struct fields;
+
+template<class F> struct fields<F> {
+	using reg = typename F::reg;
+	using value_type = typename reg::value_type;
+	static constexpr value_type mask = F::mask;
+	static constexpr bool same_reg = true;
+	static constexpr bool overlap = false;
+	static constexpr bool writable = regmap_detail::writable(F::access);
+};
+
+template<class F, class... Fs> struct fields<F, Fs...> {
+	using reg = typename F::reg;
+	using value_type = typename reg::value_type;
+	using rest = fields<Fs...>;
+	static constexpr value_type mask = F::mask | rest::mask;
+	static constexpr bool same_reg =
+		std::is_same<reg, typename rest::reg>::value && rest::same_reg;
+	static constexpr bool overlap = (F::mask & rest::mask) || rest::overlap;
+	static constexpr bool writable =
+		regmap_detail::writable(F::access) && rest::writable;
+};
+
+template<class T>
+constexpr T or_all() {return 0;}
+
+template<class T, class... Ts>
+constexpr T or_all(T first, Ts... rest) {
+	return static_cast<T>(first | or_all<T>(rest...));
+}
+
+} // namespace regmap_detail
+
+/// \verbatim embed:rst:leading-slashes
+///
+/// Encoded value of a :cpp:class:`Field`, as returned by ``Field::of()``.
+/// Field values are passed to :cpp:func:`RegMap::modify` and
+/// :cpp:func:`RegMap::write`.
+///
+/// \endverbatim
+template<class F>
+struct FieldValue {
+	/// Field value, already shifted and masked into register position.
+	typename F::value_type raw;
+};
+
+/// \verbatim embed:rst:leading-slashes
+///
+/// Compile-time description of a device register.
+///
+/// ``Offset`` is the byte offset of the register from the start of the
+/// memory region, ``T`` is ``uint8_t``, ``uint16_t``, ``uint32_t``, or
+/// ``uint64_t`` (selecting the access width), ``Access`` is the access
+/// mode, and ``Reset`` is the reset value of the register.  The offset must
+/// be a multiple of the access width.
+///
+/// A register may also be used wherever a :cpp:class:`Field` is expected,
+/// in which case it behaves as a field spanning the whole register.
+/// Registers are normally given names via ``using`` declarations::
+///
+///   using CTRL   = cuddl::Register<0x00, uint32_t>;
+///   using STATUS = cuddl::Register<0x04, uint32_t, cuddl::RegAccess::RO>;
+///
+/// \endverbatim
+template<cuddl::size_t Offset, class T,
+	 RegAccess Access=RegAccess::RW, T Reset=0>
+struct Register {
+	static_assert(regmap_detail::is_reg_type<T>::value,
+		      "register width must be 8, 16, 32, or 64 bits");
+	static_assert(Offset % sizeof(T) == 0,
+		      "register offset must be a multiple of its width");
+
+	using value_type = T;
+	using reg = Register;
+
+	static constexpr cuddl::size_t offset = Offset;
+	static constexpr RegAccess access = Access;
+	static constexpr T reset = Reset;
+	static constexpr unsigned shift = 0;
+	static constexpr T mask = static_cast<T>(~T(0));
+	static constexpr bool is_register = true;
+
+	/// Return the encoded value for a write of the whole register.
+	static constexpr FieldValue<Register> of(T value) {
+		return FieldValue<Register>{value};
+	}
+};
+
+/// \verbatim embed:rst:leading-slashes
+///
+/// Compile-time description of a bitfield within a :cpp:class:`Register`.
+///
+/// ``Shift`` is the bit position of the least significant bit of the
+/// field, ``Width`` is the number of bits in the field, and ``Access`` is
+/// the access mode (which defaults to that of the register)::
+///
+///   using CTRL_ENABLE = cuddl::Field<CTRL, 0, 1>;
+///   using CTRL_MODE   = cuddl::Field<CTRL, 4, 3>;
+///   using CTRL_BUSY   = cuddl::Field<CTRL, 31, 1, cuddl::RegAccess::RO>;
+///
+/// Fields that do not fit in the register are rejected at compile time.
+///
+/// \endverbatim
+template<class Reg, unsigned Shift, unsigned Width,
+	 RegAccess Access=Reg::access>
+struct Field {
+	static_assert(Reg::is_register, "field parent must be a Register");
+	static_assert((Width > 0) &&
+		      (Shift + Width <= 8 * sizeof(typename Reg::value_type)),
+		      "field does not fit in its register");
+
+	using value_type = typename Reg::value_type;
+	using reg = Reg;
+
+	static constexpr RegAccess access = Access;
+	static constexpr unsigned shift = Shift;
+	static constexpr value_type mask =
+		regmap_detail::make_mask<value_type>(Shift, Width);
+	static constexpr bool is_register = false;
+
+	/// Return the encoded value of the field, for use with
+	/// :cpp:func:`RegMap::modify` or :cpp:func:`RegMap::write`.
+	static constexpr FieldValue<Field> of(value_type value) {
+		return FieldValue<Field>{
+			static_cast<value_type>((value << Shift) & mask)};
+	}
+};
+
+/// \verbatim embed:rst:leading-slashes
+///
+/// Accessor for the registers of a mapped memory region.
+///
+/// All register and field properties are resolved at compile time, so each
+/// accessor compiles down to a single load and/or store of the register's
+/// width, plus any masking and shifting::
+///
+///   cuddl::RegMap regs{mem};
+///
+///   if (regs.read<CTRL_BUSY>()) { ... }
+///   regs.modify(CTRL_ENABLE::of(1), CTRL_MODE::of(3)); // one RMW
+///   regs.write<CTRL>(0);
+///
+/// A ``RegMap`` does not own the memory region, which must remain mapped
+/// while the ``RegMap`` is in use.
+///
+/// \endverbatim
+class RegMap {
+public:
+	/// @name Constructors
+	/// @{
+	explicit RegMap(iomem_t *base) : base_{static_cast<uint8_t*>(base)} {}
+	explicit RegMap(const MemRegion &mem) :
+		base_{static_cast<uint8_t*>(mem.addr())} {}
+        ///  @}
+
+	/// Return the base address of the register map.
+	iomem_t *base() const {return base_;}
+
+	/// \verbatim embed:rst:leading-slashes
+	///
+	/// Read a register (or the value of a field, shifted down to bit
+	/// ``0``).
+	///
+        /// \endverbatim
+	template<class F>
+	typename F::value_type read() const {
+		static_assert(regmap_detail::readable(F::reg::access) &&
+			      regmap_detail::readable(F::access),
+			      "register or field is write-only");
+		return static_cast<typename F::value_type>(
+			(raw_read<typename F::reg>() & F::mask) >> F::shift);
+	}
+
+	/// \verbatim embed:rst:leading-slashes
+	///
+	/// Write a whole register.
+	///
+        /// \endverbatim
+	template<class R>
+	void write(typename R::value_type value) const {
+		static_assert(R::is_register,
+			      "use modify() or write(F::of(v), ...) for fields");
+		static_assert(regmap_detail::writable(R::access),
+			      "register is read-only");
+		raw_write<R>(value);
+	}
+
+	/// \verbatim embed:rst:leading-slashes
+	///
+	/// Write a whole register, without reading it first.  The specified
+	/// fields take the given values, and all other bits take their reset
+	/// values.  All fields must belong to the same register and must not
+	/// overlap.
+	///
+        /// \endverbatim
+	template<class... Fs>
+	void write(FieldValue<Fs>... values) const {
+		using fs = regmap_detail::fields<Fs...>;
+		using R = typename fs::reg;
+		using T = typename R::value_type;
+		static_assert(fs::same_reg, "fields must share a register");
+		static_assert(!fs::overlap, "fields must not overlap");
+		static_assert(fs::writable && regmap_detail::writable(R::access),
+			      "register or field is read-only");
+		raw_write<R>(static_cast<T>(
+			(R::reset & ~fs::mask) |
+			regmap_detail::or_all<T>(values.raw...)));
+	}
+
+	/// \verbatim embed:rst:leading-slashes
+	///
+	/// Update the specified fields of a register with a single
+	/// read-modify-write sequence.  All fields must belong to the same
+	/// register and must not overlap.
+	///
+        /// \endverbatim
+	template<class... Fs>
+	void modify(FieldValue<Fs>... values) const {
+		using fs = regmap_detail::fields<Fs...>;
+		using R = typename fs::reg;
+		using T = typename R::value_type;
+		static_assert(fs::same_reg, "fields must share a register");
+		static_assert(!fs::overlap, "fields must not overlap");
+		static_assert(regmap_detail::readable(R::access),
+			      "register is write-only");
+		static_assert(fs::writable && regmap_detail::writable(R::access),
+			      "register or field is read-only");
+		raw_write<R>(static_cast<T>(
+			(raw_read<R>() & ~fs::mask) |
+			regmap_detail::or_all<T>(values.raw...)));
+	}
+
+	/// \verbatim embed:rst:leading-slashes
+	///
+	/// Shorthand for ``modify(F::of(value))``.
+	///
+        /// \endverbatim
+	template<class F>
+	void set(typename F::value_type value) const {
+		modify(F::of(value));
+	}
+
+private:
+	template<class R>
+	typename R::value_type raw_read() const {
+		return regmap_detail::io<typename R::value_type>::read(
+			base_ + R::offset);
+	}
+
+	template<class R>
+	void raw_write(typename R::value_type value) const {
+		regmap_detail::io<typename R::value_type>::write(
+			value, base_ + R::offset);
+	}
+
+	uint8_t *base_;
+};
+
+} // namespace cuddl
+
+#endif /* !_CUDDL_REGMAP_HPP */
@@ -0,0 +1,294 @@
+/* SPDX-License-Identifier: (MIT OR GPL-2.0-or-later) */
+/*
+ * Cross-platform user-space device driver layer user-space ring decls.
+ *
+ * Copyright (C) 2022 Jeff Webb <jeff.webb@codecraftsmen.org>
+ *
+ * This software is dual-licensed and is made available under the terms of
+ * the MIT License or under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.  You may select (at your
+ * option) either of the licenses listed above.  See the LICENSE.MIT and
+ * LICENSE.GPL-2.0 files in the top-level directory of this distribution for
+ * copyright information and license terms.
+ */
+
+#ifndef _CUDDL_RING_H
+#define _CUDDL_RING_H
+
+#include <stdint.h>
+#include <cuddl/memregion.h>
+#include <cuddl/eventsrc.h>
+
+/**
+ * DOC: User-space descriptor ring declarations.
+ *
+ * A descriptor ring is an array of fixed-size entries in a memory region
+ * that is shared between software and a device.  One side (the producer)
+ * fills entries and advances a producer index, and the other side (the
+ * consumer) processes entries and advances a consumer index.  Each index
+ * lives in a 32-bit register (or other 32-bit location in I/O memory) and
+ * holds the ring position of the next entry to be filled or processed, in
+ * the range ``0`` to ``n_entries - 1``.  The ring is empty when both
+ * indices are equal, and one entry is always left unused so that a full
+ * ring can be distinguished from an empty one.
+ *
+ * The ``cuddl_ring`` accessor implements the software side of such a ring,
+ * as either the consumer (e.g. for receive rings) or the producer (e.g. for
+ * transmit rings).  Entries are processed in batches:
+ *
+ * - ``cuddl_ring_acquire()`` (or ``cuddl_ring_wait()``) returns every entry
+ *   that is currently available to software, as at most two spans of
+ *   contiguous entries that point directly into the mapped memory region.
+ *   The device's index register is only read when the entries from
+ *   previous reads have all been used, so there is no I/O memory read per
+ *   entry.
+ *
+ * - ``cuddl_ring_release()`` hands the processed (or filled) entries back
+ *   to the device with a single write to the software index register.
+ *
+ * For example, a receive loop looks like this::
+ *
+ *   struct cuddl_ring_batch batch;
+ *
+ *   while (cuddl_ring_wait(&ring, &batch) > 0) {
+ *     for (int s=0; s<2; s++)
+ *       for (uint32_t i=0; i<batch.span[s].count; i++)
+ *         handle(cuddl_ring_span_entry(&ring, &batch.span[s], i));
+ *     cuddl_ring_release(&ring, batch.count);
+ *   }
+ *
+ * A ping-pong (double) buffer is a ring with two entries, each of which is
+ * a whole buffer.  In that case, the device's index register is the
+ * "active buffer" register that selects the buffer the device is currently
+ * using, and the software index register (if any) acknowledges each
+ * buffer as it is handed back.
+ *
+ * This part of the API is only available to user-space code.
+ */
+
+/**
+ * enum cuddl_ring_role - Role of software in a descriptor ring.
+ *
+ * @CUDDL_RING_CONSUMER: The device produces entries (advancing the remote
+ *                       index), and software consumes them (advancing the
+ *                       local index).
+ *
+ * @CUDDL_RING_PRODUCER: Software produces entries (advancing the local
+ *                       index), and the device consumes them (advancing the
+ *                       remote index).
+ */
+enum cuddl_ring_role {
+	CUDDL_RING_CONSUMER = 0,
+	CUDDL_RING_PRODUCER = 1,
+};
+
+/**
+ * struct cuddl_ring - Descriptor ring accessor.
+ *
+ * @entries: Address of the first ring entry in the mapped memory region.
+ *
+ * @entry_size: Size of each ring entry, in bytes.
+ *
+ * @n_entries: Number of entries in the ring.
+ *
+ * @role: Role of software in the ring (see ``enum cuddl_ring_role``).
+ *
+ * @remote_index: Address of the 32-bit index register written by the
+ *                device.
+ *
+ * @local_index: Address of the 32-bit index register written by software,
+ *               or ``NULL`` if the device does not have one.
+ *
+ * @eventsrc: Event source that signals ring activity, or ``NULL``.
+ *
+ * @local: Ring position of the next entry to be used by software.
+ *
+ * @remote: Most recently read value of the remote index register.
+ *
+ * @acquired: Number of entries returned by the last acquire operation that
+ *            have not yet been released.
+ *
+ * The members of this data structure should be treated as read-only, and
+ * should only be modified via the routines declared below.
+ */
+struct cuddl_ring {
+	uint8_t *entries;
+	cuddl_size_t entry_size;
+	uint32_t n_entries;
+	int role;
+	cuddl_iomem_t *remote_index;
+	cuddl_iomem_t *local_index;
+	struct cuddl_eventsrc *eventsrc;
+	uint32_t local;
+	uint32_t remote;
+	uint32_t acquired;
+};
+
+/**
+ * struct cuddl_ring_span - Contiguous run of ring entries.
+ *
+ * @addr: Address of the first entry in the span.
+ *
+ * @index: Ring position of the first entry in the span.
+ *
+ * @count: Number of entries in the span.
+ */
+struct cuddl_ring_span {
+	cuddl_iomem_t *addr;
+	uint32_t index;
+	uint32_t count;
+};
+
+/**
+ * struct cuddl_ring_batch - Batch of ring entries available to software.
+ *
+ * @span: Entries available to software, in ring order.  The second span is
+ *        only non-empty if the batch wraps around the end of the ring.
+ *
+ * @count: Total number of entries in both spans.
+ */
+struct cuddl_ring_batch {
+	struct cuddl_ring_span span[2];
+	uint32_t count;
+};
+
+/**
+ * cuddl_ring_init() - Initialize a descriptor ring accessor.
+ *
+ * @ring: Output parameter identifying the ring accessor to initialize.
+ *
+ * @role: Role of software in the ring (see ``enum cuddl_ring_role``).
+ *
+ * @memregion: Mapped memory region containing the ring entries.
+ *
+ * @offset: Offset of the first ring entry from the start of the memory
+ *          region, in bytes.
+ *
+ * @entry_size: Size of each ring entry, in bytes.
+ *
+ * @n_entries: Number of entries in the ring (at least ``2``).
+ *
+ * @remote_index: Address of the 32-bit index register written by the
+ *                device (e.g. computed via ``memregion->addr + offset``).
+ *
+ * @local_index: Address of the 32-bit index register written by software,
+ *               or ``NULL`` if the device does not have one.
+ *
+ * @eventsrc: Open event source that signals ring activity, or ``NULL`` if
+ *            ``cuddl_ring_wait()`` will not be used.
+ *
+ * The local position is initialized from the local index register (or to
+ * ``0`` if there is none), so the device and software must agree on the
+ * initial ring state.  The memory region must remain mapped (and the event
+ * source must remain open) while the ring accessor is in use.
+ *
+ * Return: ``0`` on success, or a negative error code.
+ *
+ *   Error codes:
+ *     - ``-EINVAL``: Invalid ``role``, ``entry_size``, ``n_entries``, or
+ *       ``remote_index``, or the local index register holds an invalid
+ *       ring position.
+ *     - ``-ERANGE``: The ring entries do not fit in the memory region.
+ */
+int cuddl_ring_init(
+	struct cuddl_ring *ring,
+	int role,
+	const struct cuddl_memregion *memregion,
+	cuddl_size_t offset,
+	cuddl_size_t entry_size,
+	uint32_t n_entries,
+	cuddl_iomem_t *remote_index,
+	cuddl_iomem_t *local_index,
+	struct cuddl_eventsrc *eventsrc);
+
+/**
+ * cuddl_ring_acquire() - Get the ring entries available to software.
+ *
+ * @ring: Input parameter identifying the ring accessor.
+ *
+ * @batch: Output parameter that receives the available entries.  For a
+ *         consumer ring, these are the entries filled by the device that
+ *         have not yet been processed.  For a producer ring, these are the
+ *         free entries that may be filled.
+ *
+ * The remote index register is only read if all of the entries known from
+ * the previous read have been released.  Calling this routine again before
+ * releasing any entries returns the same entries.
+ *
+ * Return: Number of entries in ``batch`` (possibly ``0``) on success, or a
+ *         negative error code.
+ *
+ *   Error codes:
+ *     - ``-EIO``: The remote index register holds an invalid ring position.
+ */
+int cuddl_ring_acquire(
+	struct cuddl_ring *ring, struct cuddl_ring_batch *batch);
+
+/**
+ * cuddl_ring_wait() - Wait for ring entries to become available.
+ *
+ * @ring: Input parameter identifying the ring accessor.
+ *
+ * @batch: Output parameter that receives the available entries (see
+ *         ``cuddl_ring_acquire()``).
+ *
+ * Acquire the available entries, waiting on the event source of the ring
+ * until at least one entry is available.  If the event source must be
+ * re-enabled after each event, the application should do so after
+ * releasing each batch.
+ *
+ * Return: Number of entries in ``batch`` on success, or a negative error
+ *         code.
+ *
+ *   Error codes:
+ *     - ``-EINVAL``: The ring has no event source.
+ *     - Error codes returned by ``cuddl_ring_acquire()``.
+ *     - Error codes returned by ``cuddl_eventsrc_wait()``.
+ */
+int cuddl_ring_wait(
+	struct cuddl_ring *ring, struct cuddl_ring_batch *batch);
+
+/**
+ * cuddl_ring_release() - Hand ring entries back to the device.
+ *
+ * @ring: Input parameter identifying the ring accessor.
+ *
+ * @count: Number of entries to hand back, starting with the first entry of
+ *         the most recently acquired batch.  This may be less than the
+ *         number of acquired entries, in which case the remaining entries
+ *         are returned again by the next acquire operation.
+ *
+ * For a consumer ring, the entries are marked as processed.  For a producer
+ * ring, the entries are published to the device, and all writes to them
+ * are made visible before the index register is updated.  In either case,
+ * the local index register is written once, regardless of ``count``.
+ *
+ * Return: ``0`` on success, or a negative error code.
+ *
+ *   Error codes:
+ *     - ``-EINVAL``: ``count`` exceeds the number of acquired entries.
+ */
+int cuddl_ring_release(struct cuddl_ring *ring, uint32_t count);
+
+/**
+ * cuddl_ring_span_entry() - Get the address of an entry in a span.
+ *
+ * @ring: Input parameter identifying the ring accessor.
+ *
+ * @span: Span returned by ``cuddl_ring_acquire()`` or
+ *        ``cuddl_ring_wait()``.
+ *
+ * @i: Index of the entry within the span.
+ *
+ * Return: Address of the entry in the mapped memory region.
+ */
+inline cuddl_iomem_t *cuddl_ring_span_entry(
+	const struct cuddl_ring *ring,
+	const struct cuddl_ring_span *span,
+	uint32_t i)
+{
+	return (uint8_t *) span->addr + (cuddl_size_t) i * ring->entry_size;
+}
+
+#endif /* !_CUDDL_RING_H */
@@ -0,0 +1,183 @@
+/* SPDX-License-Identifier: (MIT OR GPL-2.0-or-later) */
+/*
+ * Cross-platform user-space device driver layer user-space C++ declarations.
+ *
+ * Copyright (C) 2022 Jeff Webb <jeff.webb@codecraftsmen.org>
+ *
+ * This software is dual-licensed and is made available under the terms of
+ * the MIT License or under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.  You may select (at your
+ * option) either of the licenses listed above.  See the LICENSE.MIT and
+ * LICENSE.GPL-2.0 files in the top-level directory of this distribution for
+ * copyright information and license terms.
+ */
+
+#ifndef _CUDDL_RING_HPP
+#define _CUDDL_RING_HPP
+
+// C++ descriptor ring declarations.
+
+#include <cuddl/memregion.hpp>
+#include <cuddl/eventsrc.hpp>
+#include <cuddl/ring.h>
+
+#if __cplusplus >= 202002L
+#  include <span>
+#endif
+
+namespace cuddl {
+
+/// \verbatim embed:rst:leading-slashes
+///
+/// C++ wrapper for :c:enum:`cuddl_ring_role`.
+///
+/// \endverbatim
+enum class RingRole {
+	CONSUMER = CUDDL_RING_CONSUMER,
+	PRODUCER = CUDDL_RING_PRODUCER,
+};
+
+/// \verbatim embed:rst:leading-slashes
+///
+/// Batch of ring entries returned by :cpp:func:`Ring::acquire` or
+/// :cpp:func:`Ring::wait`.  Entries are addressed by their position within
+/// the batch, and point directly into the mapped memory region::
+///
+///   auto batch = ring.wait();
+///   for (uint32_t i=0; i<batch.count(); i++)
+///     handle(batch.entry<Desc>(i));
+///   ring.release(batch.count());
+///
+/// \endverbatim
+class RingBatch
+{
+public:
+	/// Return the total number of entries in the batch.
+	uint32_t count() const {return batch.count;}
+
+	/// \verbatim embed:rst:leading-slashes
+	///
+	/// Return the address of entry ``i`` of the batch, which must be less
+	/// than :cpp:func:`count`.
+	///
+        /// \endverbatim
+	iomem_t *addr(uint32_t i) const {
+		const cuddl_ring_span &s = (i < batch.span[0].count) ?
+			batch.span[0] : batch.span[1];
+		if (i >= batch.span[0].count)
+			i -= batch.span[0].count;
+		return static_cast<uint8_t*>(s.addr) + i * entry_size;
+	}
+
+	/// Return entry ``i`` of the batch, as a pointer to ``T``.
+	template<class T>
+	T *entry(uint32_t i) const {return static_cast<T*>(addr(i));}
+
+	/// Return the contiguous run ``s`` (``0`` or ``1``) of the batch.
+	const cuddl_ring_span &span(int s) const {return batch.span[s];}
+
+#if __cplusplus >= 202002L
+	/// \verbatim embed:rst:leading-slashes
+	///
+	/// Return the contiguous run ``s`` (``0`` or ``1``) of the batch as a
+	/// span of ``T`` entries (C++20 only).  ``sizeof(T)`` must match the
+	/// ring entry size.
+	///
+        /// \endverbatim
+	template<class T>
+	std::span<T> span(int s) const {
+		return std::span<T>(static_cast<T*>(batch.span[s].addr),
+				    batch.span[s].count);
+	}
+#endif
+
+private:
+	cuddl_ring_batch batch{};
+	cuddl::size_t entry_size{0};
+
+	friend class Ring;
+};
+
+/// \verbatim embed:rst:leading-slashes
+///
+/// C++ wrapper for :c:struct:`cuddl_ring`.
+///
+/// A ``Ring`` does not own the memory region or event source, which must
+/// remain mapped (and open) while the ``Ring`` is in use.
+///
+/// \endverbatim
+class Ring
+{
+public:
+	/// @name Constructors
+	/// @{
+	/// @throws std::system_error Operation failed.
+	Ring(RingRole role, const MemRegion &mem,
+	     cuddl::size_t offset, cuddl::size_t entry_size,
+	     uint32_t n_entries, iomem_t *remote_index,
+	     iomem_t *local_index=nullptr, EventSrc *eventsrc=nullptr) {
+		int ret = cuddl_ring_init(
+			&ring, static_cast<int>(role), &mem.mem,
+			offset, entry_size, n_entries,
+			remote_index, local_index,
+			eventsrc ? &eventsrc->eventsrc : nullptr);
+		if (ret < 0) { throw_err(ret, __func__); }
+	}
+        ///  @}
+
+	/// \verbatim embed:rst:leading-slashes
+	///
+	/// C++ wrapper for :c:func:`cuddl_ring_acquire`.
+	///
+        /// \endverbatim
+	/// @throws std::system_error Operation failed.
+	RingBatch acquire() {
+		RingBatch b;
+		b.entry_size = ring.entry_size;
+		int ret = cuddl_ring_acquire(&ring, &b.batch);
+		if (ret < 0) { throw_err(ret, __func__); }
+		return b;
+	}
+
+	/// \verbatim embed:rst:leading-slashes
+	///
+	/// C++ wrapper for :c:func:`cuddl_ring_wait`.
+	///
+        /// \endverbatim
+	/// @throws std::system_error Operation failed.
+	RingBatch wait() {
+		RingBatch b;
+		b.entry_size = ring.entry_size;
+		int ret = cuddl_ring_wait(&ring, &b.batch);
+		if (ret < 0) { throw_err(ret, __func__); }
+		return b;
+	}
+
+	/// \verbatim embed:rst:leading-slashes
+	///
+	/// C++ wrapper for :c:func:`cuddl_ring_release`.
+	///
+        /// \endverbatim
+	/// @throws std::system_error Operation failed.
+	void release(uint32_t count) {
+		int ret = cuddl_ring_release(&ring, count);
+		if (ret < 0) { throw_err(ret, __func__); }
+	}
+
+	/// Return the size of each ring entry, in bytes.
+	cuddl::size_t entry_size() const {return ring.entry_size;}
+
+	/// Return the number of entries in the ring.
+	uint32_t n_entries() const {return ring.n_entries;}
+
+	/// Return the ring position of the next entry to be used by software.
+	uint32_t local() const {return ring.local;}
+
+private:
+	cuddl_ring ring;
+};
+
+} // namespace cuddl
+
+#endif /* !_CUDDL_RING_HPP */
@@ -109,7 +109,10 @@
 /**
  * cuddl_get_kernel_version_code() - Return the kernel version code.
  *
- * Retrieve the ``CUDDLK_VERSION_CODE`` from the kernel.
+ * Retrieve the ``CUDDLK_VERSION_CODE`` from the kernel.  The value is
+ * obtained when the device manager session is opened (see
+ * ``cuddl_manager_open()``), so this routine does not normally require
+ * communication with the kernel.
  *
  * Return: The kernel version code on success, or a negative error code.
  *
@@ -121,8 +124,6 @@
  *       manager device (Linux).
  *     - Value of ``-errno`` resulting from from ``ioctl()`` call on Cuddl
  *       manager device (Linux).
- *     - Value of ``-errno`` resulting from from ``close()`` call on Cuddl
- *       manager device (Linux).
  */
 int cuddl_get_kernel_version_code();
 
@@ -151,8 +152,6 @@ int cuddl_get_kernel_version_code();
  *       manager device (Linux).
  *     - Value of ``-errno`` resulting from from ``ioctl()`` call on Cuddl
  *       manager device (Linux).
- *     - Value of ``-errno`` resulting from from ``close()`` call on Cuddl
- *       manager device (Linux).
  */
 int cuddl_get_kernel_commit_id(char *id_str, cuddl_size_t id_len);
 
@@ -200,8 +199,6 @@ int cuddl_get_userspace_commit_id(char *id_str, cuddl_size_t id_len);
  *       manager device (Linux).
  *     - Value of ``-errno`` resulting from from ``ioctl()`` call on Cuddl
  *       manager device (Linux).
- *     - Value of ``-errno`` resulting from from ``close()`` call on Cuddl
- *       manager device (Linux).
  */
 int cuddl_get_kernel_variant(char *str, cuddl_size_t len);
 
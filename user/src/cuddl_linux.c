@@ -25,7 +25,11 @@
 #include <sys/ioctl.h>
 #include <unistd.h>
 #include <sys/mman.h>
+#include <sys/epoll.h>
+#include <poll.h>
+#include <time.h>
 #include <stdint.h>
+#include <stdlib.h>
 
 #include <cuddl.h>
 #include <cuddl/common_impl_linux_ioctl.h>
@@ -35,11 +39,13 @@
 #define CUDDLCI_EVENTSRC_CLAIM_IOCTL  CUDDLCI_EVENTSRC_CLAIM_UDD_IOCTL
 #define CUDDLCI_MEMREGION_RELEASE_IOCTL CUDDLCI_MEMREGION_RELEASE_UDD_IOCTL
 #define CUDDLCI_EVENTSRC_RELEASE_IOCTL  CUDDLCI_EVENTSRC_RELEASE_UDD_IOCTL
+#define CUDDLCI_CLAIM_BATCH_IOCTL       CUDDLCI_CLAIM_BATCH_UDD_IOCTL
 #else
 #define CUDDLCI_MEMREGION_CLAIM_IOCTL CUDDLCI_MEMREGION_CLAIM_UIO_IOCTL
 #define CUDDLCI_EVENTSRC_CLAIM_IOCTL  CUDDLCI_EVENTSRC_CLAIM_UIO_IOCTL
 #define CUDDLCI_MEMREGION_RELEASE_IOCTL CUDDLCI_MEMREGION_RELEASE_UIO_IOCTL
 #define CUDDLCI_EVENTSRC_RELEASE_IOCTL  CUDDLCI_EVENTSRC_RELEASE_UIO_IOCTL
+#define CUDDLCI_CLAIM_BATCH_IOCTL       CUDDLCI_CLAIM_BATCH_UIO_IOCTL
 #endif
 
 #ifndef CUDDLI_REPO_IS_DIRTY
@@ -50,52 +56,449 @@
 #endif
 
 #include <stdio.h>
+#include <pthread.h>
+#include <sched.h>
 
-static int cuddli_janitor_fd;
+/*
+ * System calls made on Cuddl device files.  When the mock backend is
+ * enabled, these are answered in-process (see cuddl/mock.h).
+ */
+#ifdef CUDDLI_ENABLE_MOCK
+#define cuddli_sys_manager_open() cuddli_mock_manager_open()
+#define cuddli_sys_manager_ioctl(fd, request, arg) \
+	cuddli_mock_manager_ioctl(fd, request, arg)
+#define cuddli_sys_memregion_open(info) \
+	cuddli_mock_memregion_open((info)->priv.token)
+#define cuddli_sys_memregion_mode_open(info) ({ \
+	int fd_ = cuddli_mock_memregion_open((info)->priv.token); \
+	(fd_ < 0) ? -errno : fd_; })
+#define cuddli_sys_memregion_mode_close(fd) close(fd)
+#define cuddli_sys_memregion_close(fd) close(fd)
+#define cuddli_sys_memregion_mode_offset(info, mode) \
+	((info)->priv.pa_mmap_offset)
+#define cuddli_sys_eventsrc_open(info) \
+	cuddli_mock_eventsrc_open((info)->priv.token)
+#define cuddli_sys_eventsrc_close(fd) cuddli_mock_eventsrc_close(fd)
+#define cuddli_sys_eventsrc_read(fd, count) \
+	cuddli_mock_eventsrc_read(fd, count)
+#define cuddli_sys_eventsrc_write(fd, value) \
+	cuddli_mock_eventsrc_write(fd, value)
+#else
+#define cuddli_sys_manager_open() open("/dev/cuddl", O_RDWR | O_CLOEXEC)
+#define cuddli_sys_manager_ioctl(fd, request, arg) ioctl(fd, request, arg)
+#define cuddli_sys_memregion_open(info) \
+	cuddli_dev_file_open((info)->priv.device_name, O_RDWR, 0)
+#define cuddli_sys_memregion_mode_open(info) cuddli_manager_get()
+#define cuddli_sys_memregion_mode_close(fd) cuddli_manager_put()
+#define cuddli_sys_memregion_close(fd) cuddli_dev_file_close(fd, 0)
+#define cuddli_sys_memregion_mode_offset(info, mode) \
+	((info)->priv.mode_mmap_offset + \
+	 (mode) * (unsigned long) sysconf(_SC_PAGESIZE))
+#define cuddli_sys_eventsrc_open(info) \
+	cuddli_dev_file_open((info)->priv.device_name, O_RDWR, 1)
+#define cuddli_sys_eventsrc_close(fd) cuddli_dev_file_close(fd, 1)
+#define cuddli_sys_eventsrc_read(fd, count) \
+	read(fd, count, sizeof(uint32_t))
+#define cuddli_sys_eventsrc_write(fd, value) \
+	write(fd, value, sizeof(uint32_t))
+#endif
 
-int cuddl_get_kernel_version_code(void)
+/* Mock event sources cannot be read or written via io_uring */
+#if !defined(__XENO__) && !defined(CUDDLI_DISABLE_IO_URING) && \
+	!defined(CUDDLI_ENABLE_MOCK)
+#define CUDDLI_HAVE_IO_URING
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+
+/*
+ * Process-wide Cuddl manager session.
+ *
+ * The manager device is opened on first use (or by ``cuddl_manager_open()``)
+ * and stays open until the session is closed or the process exits, so each
+ * manager query costs a single ``ioctl()``.  The user/kernel version check
+ * is performed once when the manager device is opened, and the static
+ * manager limits are cached after they are first retrieved.  The janitor
+ * device is opened the first time a resource is claimed by the current
+ * process.
+ *
+ * Fast paths use atomic operations only.  The mutex serializes opening and
+ * closing of the device file descriptors.  Calls that use the manager file
+ * descriptor are counted in ``manager_users``, and the descriptor is only
+ * closed once no call is using it, so that its number cannot be reused for
+ * another file while an ``ioctl()`` or ``mmap()`` is about to be issued.
+ */
+struct cuddli_session {
+	int manager_fd;
+	int manager_users;
+	int open_count;
+	int kernel_version_code;
+	int max_managed_devices;
+	int max_dev_mem_regions;
+	int max_dev_events;
+	int janitor_fd;
+	pid_t janitor_pid;
+};
+
+static struct cuddli_session cuddli_session = {
+	.manager_fd = -1,
+	.janitor_fd = -1,
+};
+
+static pthread_mutex_t cuddli_session_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* Must be called with cuddli_session_mutex held */
+static int cuddli_session_open_manager(struct cuddli_session *session)
 {
 	int fd;
-	int ret, ret2;
+	int ret;
 	struct cuddlci_void_ioctl_data s;
 
-	fd = open("/dev/cuddl", O_RDWR);
+	if (session->manager_fd >= 0)
+		return session->manager_fd;
+
+	fd = cuddli_sys_manager_open();
 	if (fd == -1)
 		return -errno;
 
+	/* The kernel rejects incompatible version codes with -ENOEXEC */
 	s.version_code = CUDDL_VERSION_CODE;
 
-	ret = ioctl(fd, CUDDLCI_GET_KERNEL_VERSION_CODE_IOCTL, &s);
-	if ((ret == -1) && errno)
+	ret = cuddli_sys_manager_ioctl(
+		fd, CUDDLCI_GET_KERNEL_VERSION_CODE_IOCTL, &s);
+	if (ret == -1) {
 		ret = -errno;
+		close(fd);
+		return ret;
+	}
+
+	session->kernel_version_code = ret;
+	__atomic_store_n(&session->manager_fd, fd, __ATOMIC_RELEASE);
+
+	return fd;
+}
+
+/* Must be called with cuddli_session_mutex held */
+static int cuddli_session_close_manager(struct cuddli_session *session)
+{
+	int fd;
+
+	fd = __atomic_exchange_n(&session->manager_fd, -1, __ATOMIC_SEQ_CST);
+	while (__atomic_load_n(&session->manager_users, __ATOMIC_SEQ_CST))
+		sched_yield();
+	session->kernel_version_code = 0;
+	__atomic_store_n(&session->max_managed_devices, 0, __ATOMIC_RELAXED);
+	__atomic_store_n(&session->max_dev_mem_regions, 0, __ATOMIC_RELAXED);
+	__atomic_store_n(&session->max_dev_events, 0, __ATOMIC_RELAXED);
 
-	ret2 = close(fd);
-	if ((ret2 == -1) && (ret >= 0))
+	if ((fd >= 0) && (close(fd) == -1))
 		return -errno;
 
+	return 0;
+}
+
+/*
+ * Return the session manager file descriptor (opening it if required), or a
+ * negative error code.  On success, the descriptor remains open until the
+ * matching call to cuddli_manager_put().
+ */
+static int cuddli_manager_get(void)
+{
+	int fd;
+
+	/* Pairs with the exchange and users check in session close */
+	__atomic_add_fetch(&cuddli_session.manager_users, 1, __ATOMIC_SEQ_CST);
+	fd = __atomic_load_n(&cuddli_session.manager_fd, __ATOMIC_SEQ_CST);
+	if (fd >= 0)
+		return fd;
+	__atomic_sub_fetch(&cuddli_session.manager_users, 1, __ATOMIC_SEQ_CST);
+
+	pthread_mutex_lock(&cuddli_session_mutex);
+	fd = cuddli_session_open_manager(&cuddli_session);
+	if (fd >= 0)
+		__atomic_add_fetch(
+			&cuddli_session.manager_users, 1, __ATOMIC_SEQ_CST);
+	pthread_mutex_unlock(&cuddli_session_mutex);
+
+	return fd;
+}
+
+static void cuddli_manager_put(void)
+{
+	__atomic_sub_fetch(&cuddli_session.manager_users, 1, __ATOMIC_RELEASE);
+}
+
+static int cuddli_manager_ioctl(unsigned long request, void *arg)
+{
+	int fd;
+	int ret;
+
+	fd = cuddli_manager_get();
+	if (fd < 0)
+		return fd;
+
+	ret = cuddli_sys_manager_ioctl(fd, request, arg);
+	if ((ret == -1) && errno)
+		ret = -errno;
+	cuddli_manager_put();
+
 	return ret;
 }
 
-int cuddl_get_kernel_commit_id(char *id_str, cuddl_size_t id_len)
+/* Retrieve a static manager limit, querying the kernel only once */
+static int cuddli_manager_cached_limit(int *cache, unsigned long request)
+{
+	int ret;
+	struct cuddlci_void_ioctl_data s;
+
+	ret = __atomic_load_n(cache, __ATOMIC_RELAXED);
+	if (ret > 0)
+		return ret;
+
+	s.version_code = CUDDL_VERSION_CODE;
+
+	ret = cuddli_manager_ioctl(request, &s);
+	if (ret > 0)
+		__atomic_store_n(cache, ret, __ATOMIC_RELAXED);
+
+	return ret;
+}
+
+/*
+ * Register the calling process with the janitor before claiming a resource.
+ * A janitor registration inherited across fork() belongs to the parent, so
+ * a new registration is made when the process id changes.  Failure to open
+ * the janitor device is not considered an error.
+ */
+static void cuddli_session_register_janitor(pid_t pid)
 {
 	int fd;
+
+#ifdef CUDDLI_ENABLE_MOCK
+	/* Mock resources are not known to the kernel */
+	return;
+#endif
+
+	if (__atomic_load_n(&cuddli_session.janitor_pid, __ATOMIC_ACQUIRE) ==
+	    pid)
+		return;
+
+	pthread_mutex_lock(&cuddli_session_mutex);
+	if (cuddli_session.janitor_pid != pid) {
+		cuddli_close_janitor(cuddli_session.janitor_fd);
+		fd = cuddli_open_janitor();
+		cuddli_session.janitor_fd = (fd < 0) ? -1 : fd;
+		__atomic_store_n(
+			&cuddli_session.janitor_pid, pid, __ATOMIC_RELEASE);
+	}
+	pthread_mutex_unlock(&cuddli_session_mutex);
+}
+
+int cuddl_manager_open(void)
+{
 	int ret;
+
+	pthread_mutex_lock(&cuddli_session_mutex);
+	ret = cuddli_session_open_manager(&cuddli_session);
+	if (ret >= 0) {
+		cuddli_session.open_count++;
+		ret = 0;
+	}
+	pthread_mutex_unlock(&cuddli_session_mutex);
+
+	return ret;
+}
+
+int cuddl_manager_close(void)
+{
+	int ret = 0;
+
+	pthread_mutex_lock(&cuddli_session_mutex);
+	if (cuddli_session.open_count > 0)
+		cuddli_session.open_count--;
+	if (cuddli_session.open_count == 0)
+		ret = cuddli_session_close_manager(&cuddli_session);
+	pthread_mutex_unlock(&cuddli_session_mutex);
+
+	return ret;
+}
+
+#ifndef CUDDLI_ENABLE_MOCK
+/*
+ * Process-wide cache of open device files.
+ *
+ * All memory regions of a UIO device are mapped through the same device
+ * file (at different offsets), and its event source is read through that
+ * file as well, so the resources of a device share a single reference
+ * counted file descriptor instead of opening the device file once per
+ * resource.  Memory regions that are mapped through the manager device use
+ * the session's manager file descriptor instead.
+ *
+ * Event counts are tracked per open file, so only one open event source may
+ * use a cached file descriptor.  Opening the same event source again gets a
+ * private file descriptor that is not cached.
+ */
+struct cuddli_dev_file {
+	struct cuddli_dev_file *next;
+	char path[CUDDLCI_MAX_STR_LEN];
+	int fd;
+	int ref_count;
+	int eventsrc_open;
+};
+
+#define CUDDLI_DEV_FILE_HASH_BUCKETS 64
+
+static struct cuddli_dev_file *
+cuddli_dev_files[CUDDLI_DEV_FILE_HASH_BUCKETS];
+
+/* Cached files indexed by file descriptor (NULL if not cached) */
+static struct cuddli_dev_file **cuddli_dev_files_by_fd;
+static int cuddli_dev_files_by_fd_len;
+
+static pthread_mutex_t cuddli_dev_files_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static unsigned int cuddli_dev_file_hash(const char *path)
+{
+	uint32_t h = 2166136261u;
+
+	while (*path)
+		h = (h ^ (uint8_t) *path++) * 16777619u;
+	return h % CUDDLI_DEV_FILE_HASH_BUCKETS;
+}
+
+/* Must be called with cuddli_dev_files_mutex held */
+static struct cuddli_dev_file *cuddli_dev_file_add(const char *path, int fd)
+{
+	struct cuddli_dev_file **by_fd;
+	struct cuddli_dev_file *file;
+	unsigned int bucket;
 	int len;
-	struct cuddlci_get_kernel_commit_id_ioctl_data s;
 
-	fd = open("/dev/cuddl", O_RDWR);
-	if (fd == -1)
-		return -errno;
+	if (fd >= cuddli_dev_files_by_fd_len) {
+		len = (fd < 32) ? 64 : fd * 2;
+		by_fd = realloc(cuddli_dev_files_by_fd, len * sizeof(*by_fd));
+		if (!by_fd)
+			return NULL;
+		memset(by_fd + cuddli_dev_files_by_fd_len, 0,
+		       (len - cuddli_dev_files_by_fd_len) * sizeof(*by_fd));
+		cuddli_dev_files_by_fd = by_fd;
+		cuddli_dev_files_by_fd_len = len;
+	}
+
+	file = calloc(1, sizeof(*file));
+	if (!file)
+		return NULL;
+	strncpy(file->path, path, CUDDLCI_MAX_STR_LEN - 1);
+	file->fd = fd;
+
+	bucket = cuddli_dev_file_hash(path);
+	file->next = cuddli_dev_files[bucket];
+	cuddli_dev_files[bucket] = file;
+	cuddli_dev_files_by_fd[fd] = file;
+
+	return file;
+}
+
+/* Must be called with cuddli_dev_files_mutex held */
+static void cuddli_dev_file_remove(struct cuddli_dev_file *file)
+{
+	struct cuddli_dev_file **link;
+
+	link = &cuddli_dev_files[cuddli_dev_file_hash(file->path)];
+	while (*link != file)
+		link = &(*link)->next;
+	*link = file->next;
+	cuddli_dev_files_by_fd[file->fd] = NULL;
+	free(file);
+}
+
+/*
+ * Open a device file, sharing an already open file descriptor if possible.
+ * Like open(), return the file descriptor, or -1 with errno set.
+ */
+static int cuddli_dev_file_open(const char *path, int flags, int eventsrc)
+{
+	struct cuddli_dev_file *file;
+	int fd;
+
+	pthread_mutex_lock(&cuddli_dev_files_mutex);
+
+	file = cuddli_dev_files[cuddli_dev_file_hash(path)];
+	while (file && strncmp(file->path, path, CUDDLCI_MAX_STR_LEN))
+		file = file->next;
+
+	if (file && !(eventsrc && file->eventsrc_open)) {
+		file->ref_count++;
+		if (eventsrc)
+			file->eventsrc_open = 1;
+		pthread_mutex_unlock(&cuddli_dev_files_mutex);
+		return file->fd;
+	}
+
+	fd = open(path, flags);
+	if ((fd >= 0) && !file) {
+		/* Failure to cache the file only costs extra opens */
+		file = cuddli_dev_file_add(path, fd);
+		if (file) {
+			file->ref_count = 1;
+			file->eventsrc_open = eventsrc;
+		}
+	}
+
+	pthread_mutex_unlock(&cuddli_dev_files_mutex);
+	return fd;
+}
+
+/*
+ * Release a file descriptor returned by cuddli_dev_file_open(), closing it
+ * when it is no longer used.  Like close(), return 0, or -1 with errno set.
+ */
+static int cuddli_dev_file_close(int fd, int eventsrc)
+{
+	struct cuddli_dev_file *file = NULL;
+
+	pthread_mutex_lock(&cuddli_dev_files_mutex);
+
+	if ((fd >= 0) && (fd < cuddli_dev_files_by_fd_len))
+		file = cuddli_dev_files_by_fd[fd];
+	if (file) {
+		if (eventsrc)
+			file->eventsrc_open = 0;
+		if (--file->ref_count > 0) {
+			pthread_mutex_unlock(&cuddli_dev_files_mutex);
+			return 0;
+		}
+		cuddli_dev_file_remove(file);
+	}
+
+	pthread_mutex_unlock(&cuddli_dev_files_mutex);
+	return close(fd);
+}
+#endif
+
+int cuddl_get_kernel_version_code(void)
+{
+	int fd;
+
+	fd = cuddli_manager_get();
+	if (fd < 0)
+		return fd;
+	cuddli_manager_put();
+
+	return cuddli_session.kernel_version_code;
+}
+
+int cuddl_get_kernel_commit_id(char *id_str, cuddl_size_t id_len)
+{
+	int ret;
+	int len;
+	struct cuddlci_get_kernel_commit_id_ioctl_data s;
 
 	s.version_code = CUDDL_VERSION_CODE;
 
-	ret = ioctl(fd, CUDDLCI_GET_KERNEL_COMMIT_ID_IOCTL, &s);
-	if (ret) {
-		if ((ret == -1) && errno)
-			ret = -errno;
-		close(fd);
+	ret = cuddli_manager_ioctl(CUDDLCI_GET_KERNEL_COMMIT_ID_IOCTL, &s);
+	if (ret)
 		return ret;
-	}
 
 	if (id_len > CUDDLCI_MAX_STR_LEN) {
 		id_str[CUDDLCI_MAX_STR_LEN] = '\0';
@@ -105,10 +508,6 @@ int cuddl_get_kernel_commit_id(char *id_str, cuddl_size_t id_len)
 	}
 	strncpy(id_str, s.id_str, len);
 
-	ret = close(fd);
-	if (ret == -1)
-		return -errno;
-
 	return 0;
 }
 
@@ -140,24 +539,15 @@ int cuddl_get_userspace_commit_id(char *id_str, cuddl_size_t id_len)
 
 int cuddl_get_kernel_variant(char *str, cuddl_size_t id_len)
 {
-	int fd;
 	int ret;
 	int len;
 	struct cuddlci_get_kernel_commit_id_ioctl_data s;
 
-	fd = open("/dev/cuddl", O_RDWR);
-	if (fd == -1)
-		return -errno;
-
 	s.version_code = CUDDL_VERSION_CODE;
 
-	ret = ioctl(fd, CUDDLCI_GET_KERNEL_VARIANT_IOCTL, &s);
-	if (ret) {
-		if ((ret == -1) && errno)
-			ret = -errno;
-		close(fd);
+	ret = cuddli_manager_ioctl(CUDDLCI_GET_KERNEL_VARIANT_IOCTL, &s);
+	if (ret)
 		return ret;
-	}
 
 	if (id_len > CUDDLCI_MAX_STR_LEN) {
 		str[CUDDLCI_MAX_STR_LEN] = '\0';
@@ -167,10 +557,6 @@ int cuddl_get_kernel_variant(char *str, cuddl_size_t id_len)
 	}
 	strncpy(str, s.id_str, len);
 
-	ret = close(fd);
-	if (ret == -1)
-		return -errno;
-
 	return 0;
 }
 
@@ -204,33 +590,22 @@ int cuddl_memregion_claim(
 	int instance,
 	int options)
 {
-	int fd;
 	int ret;
 	struct cuddlci_memregion_claim_ioctl_data s;
 
-	fd = open("/dev/cuddl", O_RDWR);
-	if (fd == -1)
-		return -errno;
-
 	s.version_code = CUDDL_VERSION_CODE;
 	populate_id_from_args(&s.id, group, device, memregion, instance);
 	s.pid = getpid();
 	s.options = options;
 
-	ret = ioctl(fd, CUDDLCI_MEMREGION_CLAIM_IOCTL, &s);
-	if (ret) {
-		if ((ret == -1) && errno)
-			ret = -errno;
-		close(fd);
+	cuddli_session_register_janitor(s.pid);
+
+	ret = cuddli_manager_ioctl(CUDDLCI_MEMREGION_CLAIM_IOCTL, &s);
+	if (ret)
 		return ret;
-	}
 
 	memcpy(meminfo, &s.info, sizeof(*meminfo));
 
-	ret = close(fd);
-	if (ret == -1)
-		return -errno;
-
 	return 0;
 }
 
@@ -239,6 +614,68 @@ int cuddl_memregion_release(struct cuddl_memregion_info *meminfo)
 	return cuddli_memregion_release_by_token(meminfo->priv.token);
 }
 
+/*
+ * Translate the caching mode map flags into a ``cuddlci_mem_map_mode``, or a
+ * negative error code if the mode is invalid or not permitted.
+ */
+static int cuddli_memregion_map_mode(
+	const struct cuddl_memregion_info *meminfo, int options)
+{
+	int mode;
+	int allowed;
+
+	switch (options & (CUDDL_MEM_MAPF_UNCACHED |
+			   CUDDL_MEM_MAPF_WRITE_COMBINE |
+			   CUDDL_MEM_MAPF_CACHED)) {
+	case 0:
+		return CUDDLCI_MEM_MAP_DEFAULT;
+	case CUDDL_MEM_MAPF_UNCACHED:
+		mode = CUDDLCI_MEM_MAP_UNCACHED;
+		allowed = meminfo->flags & CUDDL_MEMF_MAP_UNCACHED;
+		break;
+	case CUDDL_MEM_MAPF_WRITE_COMBINE:
+		mode = CUDDLCI_MEM_MAP_WRITE_COMBINE;
+		allowed = meminfo->flags & CUDDL_MEMF_MAP_WRITE_COMBINE;
+		break;
+	case CUDDL_MEM_MAPF_CACHED:
+		mode = CUDDLCI_MEM_MAP_CACHED;
+		allowed = meminfo->flags & CUDDL_MEMF_MAP_CACHED;
+		break;
+	default:
+		return -EINVAL;
+	}
+	if (!allowed)
+		return -EPERM;
+	return mode;
+}
+
+/*
+ * Reserve an address range of len bytes aligned to align bytes, so that a
+ * mapping placed there with MAP_FIXED can use huge pages.  Returns NULL if
+ * no address range could be reserved.
+ */
+static void *cuddli_reserve_aligned(size_t len, size_t align)
+{
+	uint8_t *base;
+	uint8_t *addr;
+	size_t head;
+	size_t tail;
+
+	base = mmap(NULL, len + align, PROT_NONE,
+		    MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (base == (void *) -1)
+		return NULL;
+
+	addr = (uint8_t *) (((uintptr_t) base + align - 1) & ~(align - 1));
+	head = addr - base;
+	tail = align - head;
+	if (head)
+		munmap(base, head);
+	if (tail)
+		munmap(addr + len, tail);
+	return addr;
+}
+
 int cuddl_memregion_map(
 	struct cuddl_memregion *memregion,
 	const struct cuddl_memregion_info *meminfo,
@@ -246,22 +683,69 @@ int cuddl_memregion_map(
 {
 	int fd;
 	void *addr;
+	void *hint = NULL;
 	int ret;
+	int mode;
+	int via_manager;
+	int flags = MAP_SHARED;
+	off_t offset;
+	size_t page_size = sysconf(_SC_PAGESIZE);
+
+	mode = cuddli_memregion_map_mode(meminfo, options);
+	if (mode < 0)
+		return mode;
+
+	/* Fall back to normal pages if huge pages are not supported */
+	if ((options & CUDDL_MEM_MAPF_HUGE_PAGES) &&
+	    (meminfo->flags & CUDDL_MEMF_MAP_HUGE_PAGES)) {
+		hint = cuddli_reserve_aligned(
+			meminfo->priv.pa_len, meminfo->priv.huge_page_size);
+		if (hint) {
+			mode |= CUDDLCI_MEM_MAP_HUGE;
+			flags |= MAP_FIXED;
+			page_size = meminfo->priv.huge_page_size;
+		}
+	}
 
-	fd = open(meminfo->priv.device_name, O_RDWR);
-	if (fd < 0)
-		return -errno;
+	/*
+	 * DMA buffers cannot be mapped via UIO/UDD.  The mapping holds its own
+	 * reference to the manager device file, so the file descriptor used to
+	 * map a region through the manager is not kept.
+	 */
+	via_manager = (mode != CUDDLCI_MEM_MAP_DEFAULT) ||
+		(meminfo->flags & CUDDL_MEMF_DMA);
+	if (!via_manager) {
+		fd = cuddli_sys_memregion_open(meminfo);
+		if (fd < 0)
+			fd = -errno;
+		offset = meminfo->priv.pa_mmap_offset;
+	} else {
+		fd = cuddli_sys_memregion_mode_open(meminfo);
+		offset = cuddli_sys_memregion_mode_offset(meminfo, mode);
+	}
+	if (fd < 0) {
+		if (hint)
+			munmap(hint, meminfo->priv.pa_len);
+		return fd;
+	}
 
 	addr = mmap(
-		NULL,
+		hint,
 		meminfo->priv.pa_len,
 		PROT_READ | PROT_WRITE,
-		MAP_SHARED,
+		flags,
 		fd,
-		meminfo->priv.pa_mmap_offset);
-	if (addr == (void *) -1) {
-		ret = -errno;
-		close(fd);
+		offset);
+	ret = (addr == (void *) -1) ? -errno : 0;
+	if (via_manager) {
+		cuddli_sys_memregion_mode_close(fd);
+		fd = -1;
+	}
+	if (ret) {
+		if (hint)
+			munmap(hint, meminfo->priv.pa_len);
+		if (fd >= 0)
+			cuddli_sys_memregion_close(fd);
 		return ret;
 	}
 
@@ -273,7 +757,27 @@ int cuddl_memregion_map(
 	memregion->len = meminfo->len;
 	memregion->flags = meminfo->flags;
 	memregion->priv.token = meminfo->priv.token;
+	memregion->priv.map_mode = mode & ~CUDDLCI_MEM_MAP_HUGE;
+	memregion->priv.page_size = page_size;
+	memregion->priv.dma_addr =
+		meminfo->priv.dma_addr + meminfo->priv.start_offset;
+
+	return 0;
+}
+
+cuddl_size_t cuddl_memregion_get_page_size(
+	const struct cuddl_memregion *memregion)
+{
+	return memregion->priv.page_size;
+}
+
+int cuddl_memregion_get_dma_addr(
+	const struct cuddl_memregion *memregion, uint64_t *dma_addr)
+{
+	if (!(memregion->flags & CUDDL_MEMF_DMA))
+		return -ENXIO;
 
+	*dma_addr = memregion->priv.dma_addr;
 	return 0;
 }
 
@@ -287,9 +791,11 @@ int cuddl_memregion_unmap(struct cuddl_memregion *memregion)
 	if (err == -1)
 		ret = -errno;
 
-	err = close(memregion->priv.fd);
-	if ((err == -1) && (ret == 0))
-		ret = -errno;
+	if (memregion->priv.fd >= 0) {
+		err = cuddli_sys_memregion_close(memregion->priv.fd);
+		if ((err == -1) && (ret == 0))
+			ret = -errno;
+	}
 
 	return ret;
 }
@@ -330,29 +836,16 @@ int cuddl_memregion_unmap_and_release(struct cuddl_memregion *memregion)
 
 int cuddli_memregion_release_by_token(struct cuddlci_token token)
 {
-	int fd;
 	int ret;
 	struct cuddlci_memregion_release_ioctl_data s;
 
-	fd = open("/dev/cuddl", O_RDWR);
-	if (fd == -1)
-		return -errno;
-
 	s.version_code = CUDDL_VERSION_CODE;
 	s.token = token;
 	s.pid = getpid();
 
-	ret = ioctl(fd, CUDDLCI_MEMREGION_RELEASE_IOCTL, &s);
-	if (ret) {
-		if ((ret == -1) && errno)
-			ret = -errno;
-		close(fd);
+	ret = cuddli_manager_ioctl(CUDDLCI_MEMREGION_RELEASE_IOCTL, &s);
+	if (ret)
 		return ret;
-	}
-
-	ret = close(fd);
-	if (ret == -1)
-		return -errno;
 
 	return 0;
 }
@@ -366,41 +859,475 @@ int cuddl_memregion_get_resource_id(
 		memregion->priv.token.resource_index);
 }
 
-int cuddl_eventsrc_claim(
-	struct cuddl_eventsrc_info *eventinfo,
-	const char *group,
-	const char *device,
-	const char *eventsrc,
-	int instance,
-	int options)
+/*
+ * Block I/O memory transfers.
+ *
+ * Fixed-width transfers use one volatile access of the requested width per
+ * location, in ascending address order.
+ *
+ * ``CUDDL_IOW_ANY`` transfers are split into an unaligned head and tail,
+ * which are copied using the widest naturally-aligned scalar accesses, and
+ * an aligned body.  On x86, the body is read with 16-byte SSE2 loads (or
+ * 32-byte AVX loads, if supported by the running CPU), which cuts the
+ * number of device read round trips by a factor of four (or eight) compared
+ * to 32-bit accesses.  The body is written with 16-byte stores.  On
+ * uncached and write-combining mappings, these are non-temporal stores,
+ * which are combined into full bursts without first reading the
+ * destination into the cache, followed by a store fence.  On cached
+ * mappings, ordinary stores are used instead, so that the written data
+ * stays in the cache for the CPU to read back.  ``cuddl_iowrite_block()``
+ * and ``cuddl_iofill()`` do not know how ``addr`` is mapped and always use
+ * non-temporal stores, while the memregion routines select the store type
+ * from the caching mode of the mapping.  Other architectures use 64-bit
+ * accesses for the body.
+ */
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#define CUDDLI_HAVE_SSE2
+#include <immintrin.h>
+#if defined(__GNUC__)
+#define CUDDLI_HAVE_AVX
+#endif
+#endif
+
+/* Return the widest naturally-aligned access width for address a */
+static inline size_t cuddli_io_step(uintptr_t a, size_t len)
 {
-	int fd;
-	int ret;
-	struct cuddlci_eventsrc_claim_ioctl_data s;
+	if (!(a & 7) && (len >= 8))
+		return 8;
+	if (!(a & 3) && (len >= 4))
+		return 4;
+	if (!(a & 1) && (len >= 2))
+		return 2;
+	return 1;
+}
 
-	fd = open("/dev/cuddl", O_RDWR);
-	if (fd == -1)
-		return -errno;
+static void cuddli_io_read_scalar(uint8_t *dst, const uint8_t *src, size_t len)
+{
+	size_t n;
+
+	for (; len; dst+=n, src+=n, len-=n) {
+		n = cuddli_io_step((uintptr_t) src, len);
+		if (n == 8) {
+			uint64_t v = *(const volatile uint64_t *) src;
+			memcpy(dst, &v, 8);
+		} else if (n == 4) {
+			uint32_t v = *(const volatile uint32_t *) src;
+			memcpy(dst, &v, 4);
+		} else if (n == 2) {
+			uint16_t v = *(const volatile uint16_t *) src;
+			memcpy(dst, &v, 2);
+		} else {
+			*dst = *(const volatile uint8_t *) src;
+		}
+	}
+}
 
-	s.version_code = CUDDL_VERSION_CODE;
-	populate_id_from_args(&s.id, group, device, eventsrc, instance);
+static void cuddli_io_write_scalar(uint8_t *dst, const uint8_t *src, size_t len)
+{
+	size_t n;
+
+	for (; len; dst+=n, src+=n, len-=n) {
+		n = cuddli_io_step((uintptr_t) dst, len);
+		if (n == 8) {
+			uint64_t v;
+			memcpy(&v, src, 8);
+			*(volatile uint64_t *) dst = v;
+		} else if (n == 4) {
+			uint32_t v;
+			memcpy(&v, src, 4);
+			*(volatile uint32_t *) dst = v;
+		} else if (n == 2) {
+			uint16_t v;
+			memcpy(&v, src, 2);
+			*(volatile uint16_t *) dst = v;
+		} else {
+			*(volatile uint8_t *) dst = *src;
+		}
+	}
+}
+
+#ifdef CUDDLI_HAVE_AVX
+/* src is 32-byte aligned, len is a multiple of 32 */
+__attribute__((target("avx")))
+static void cuddli_io_read_avx(uint8_t *dst, const uint8_t *src, size_t len)
+{
+	const volatile __m256i *s = (const volatile __m256i *) src;
+	__m256i a, b;
+
+	for (; len >= 64; len-=64, s+=2, dst+=64) {
+		a = s[0];
+		b = s[1];
+		_mm256_storeu_si256((__m256i *) dst, a);
+		_mm256_storeu_si256((__m256i *) (dst + 32), b);
+	}
+	if (len)
+		_mm256_storeu_si256((__m256i *) dst, s[0]);
+	_mm256_zeroupper();
+}
+#endif
+
+/* Return the body alignment (and granularity) used for bulk reads */
+static inline size_t cuddli_io_read_vector_size(void)
+{
+#if defined(CUDDLI_HAVE_AVX)
+	return __builtin_cpu_supports("avx") ? 32 : 16;
+#elif defined(CUDDLI_HAVE_SSE2)
+	return 16;
+#else
+	return 8;
+#endif
+}
+
+/* src is aligned to vsize, len is a multiple of vsize */
+static void cuddli_io_read_vector(
+	uint8_t *dst, const uint8_t *src, size_t len, size_t vsize)
+{
+#if defined(CUDDLI_HAVE_SSE2)
+	const volatile __m128i *s = (const volatile __m128i *) src;
+	__m128i a, b, c, d;
+
+#ifdef CUDDLI_HAVE_AVX
+	if (vsize == 32) {
+		cuddli_io_read_avx(dst, src, len);
+		return;
+	}
+#endif
+	for (; len >= 64; len-=64, s+=4, dst+=64) {
+		a = s[0];
+		b = s[1];
+		c = s[2];
+		d = s[3];
+		_mm_storeu_si128((__m128i *) dst, a);
+		_mm_storeu_si128((__m128i *) (dst + 16), b);
+		_mm_storeu_si128((__m128i *) (dst + 32), c);
+		_mm_storeu_si128((__m128i *) (dst + 48), d);
+	}
+	for (; len; len-=16, s++, dst+=16)
+		_mm_storeu_si128((__m128i *) dst, *s);
+#else
+	(void) vsize;
+	cuddli_io_read_scalar(dst, src, len);
+#endif
+}
+
+/*
+ * dst is 16-byte aligned, len is a multiple of 16.  Non-temporal stores are
+ * used if stream is set.
+ */
+static void cuddli_io_write_vector(
+	uint8_t *dst, const uint8_t *src, size_t len, int stream)
+{
+#if defined(CUDDLI_HAVE_SSE2)
+	if (stream) {
+		for (; len; len-=16, src+=16, dst+=16)
+			_mm_stream_si128((__m128i *) dst,
+					 _mm_loadu_si128((const __m128i *) src));
+		return;
+	}
+	for (; len; len-=16, src+=16, dst+=16)
+		_mm_store_si128((__m128i *) dst,
+				_mm_loadu_si128((const __m128i *) src));
+#else
+	(void) stream;
+	cuddli_io_write_scalar(dst, src, len);
+#endif
+}
+
+/* Make non-temporal stores visible before any subsequent stores */
+static inline void cuddli_io_store_fence(int stream)
+{
+#if defined(CUDDLI_HAVE_SSE2)
+	if (stream)
+		_mm_sfence();
+#else
+	(void) stream;
+#endif
+}
+
+static int cuddli_io_check_width(
+	const void *addr, cuddl_size_t len, int width, int min_align)
+{
+	int align = (width == CUDDL_IOW_ANY) ? min_align : width;
+
+	if ((width != CUDDL_IOW_ANY) && (width != CUDDL_IOW_8) &&
+	    (width != CUDDL_IOW_16) && (width != CUDDL_IOW_32) &&
+	    ((width != CUDDL_IOW_64) || (sizeof(void *) < 8)))
+		return -EINVAL;
+	if (((uintptr_t) addr | len) & (align - 1))
+		return -EINVAL;
+	return 0;
+}
+
+int cuddl_ioread_block(
+	void *buf, cuddl_iomem_t *addr, cuddl_size_t len, int width)
+{
+	uint8_t *dst = buf;
+	const uint8_t *src = addr;
+	size_t vsize, head, body;
+	cuddl_size_t i;
+	int ret;
+
+	ret = cuddli_io_check_width(addr, len, width, 1);
+	if (ret)
+		return ret;
+
+	switch (width) {
+	case CUDDL_IOW_8:
+		for (i=0; i<len; i++)
+			dst[i] = *(const volatile uint8_t *) (src + i);
+		return 0;
+	case CUDDL_IOW_16:
+		for (i=0; i<len; i+=2) {
+			uint16_t v = *(const volatile uint16_t *) (src + i);
+			memcpy(dst + i, &v, 2);
+		}
+		return 0;
+	case CUDDL_IOW_32:
+		for (i=0; i<len; i+=4) {
+			uint32_t v = *(const volatile uint32_t *) (src + i);
+			memcpy(dst + i, &v, 4);
+		}
+		return 0;
+	case CUDDL_IOW_64:
+		for (i=0; i<len; i+=8) {
+			uint64_t v = *(const volatile uint64_t *) (src + i);
+			memcpy(dst + i, &v, 8);
+		}
+		return 0;
+	}
+
+	vsize = cuddli_io_read_vector_size();
+	head = (-(uintptr_t) src) & (vsize - 1);
+	if (head > len)
+		head = len;
+	body = (len - head) & ~(vsize - 1);
+
+	cuddli_io_read_scalar(dst, src, head);
+	cuddli_io_read_vector(dst + head, src + head, body, vsize);
+	cuddli_io_read_scalar(
+		dst + head + body, src + head + body, len - head - body);
+	return 0;
+}
+
+static int cuddli_iowrite_block(
+	cuddl_iomem_t *addr, const void *buf, cuddl_size_t len, int width,
+	int stream)
+{
+	uint8_t *dst = addr;
+	const uint8_t *src = buf;
+	size_t head, body;
+	cuddl_size_t i;
+	int ret;
+
+	ret = cuddli_io_check_width(addr, len, width, 1);
+	if (ret)
+		return ret;
+
+	switch (width) {
+	case CUDDL_IOW_8:
+		for (i=0; i<len; i++)
+			*(volatile uint8_t *) (dst + i) = src[i];
+		return 0;
+	case CUDDL_IOW_16:
+		for (i=0; i<len; i+=2) {
+			uint16_t v;
+			memcpy(&v, src + i, 2);
+			*(volatile uint16_t *) (dst + i) = v;
+		}
+		return 0;
+	case CUDDL_IOW_32:
+		for (i=0; i<len; i+=4) {
+			uint32_t v;
+			memcpy(&v, src + i, 4);
+			*(volatile uint32_t *) (dst + i) = v;
+		}
+		return 0;
+	case CUDDL_IOW_64:
+		for (i=0; i<len; i+=8) {
+			uint64_t v;
+			memcpy(&v, src + i, 8);
+			*(volatile uint64_t *) (dst + i) = v;
+		}
+		return 0;
+	}
+
+	head = (-(uintptr_t) dst) & 15;
+	if (head > len)
+		head = len;
+	body = (len - head) & ~(size_t) 15;
+
+	cuddli_io_write_scalar(dst, src, head);
+	cuddli_io_write_vector(dst + head, src + head, body, stream);
+	cuddli_io_write_scalar(
+		dst + head + body, src + head + body, len - head - body);
+	cuddli_io_store_fence(stream);
+	return 0;
+}
+
+int cuddl_iowrite_block(
+	cuddl_iomem_t *addr, const void *buf, cuddl_size_t len, int width)
+{
+	return cuddli_iowrite_block(addr, buf, len, width, 1);
+}
+
+static int cuddli_iofill(
+	cuddl_iomem_t *addr, uint32_t value, cuddl_size_t len, int width,
+	int stream)
+{
+	uint8_t *dst = addr;
+	cuddl_size_t i;
+	int ret;
+
+	ret = cuddli_io_check_width(addr, len, width, 4);
+	if (ret)
+		return ret;
+
+	switch (width) {
+	case CUDDL_IOW_8:
+		for (i=0; i<len; i++)
+			*(volatile uint8_t *) (dst + i) = value;
+		return 0;
+	case CUDDL_IOW_16:
+		for (i=0; i<len; i+=2)
+			*(volatile uint16_t *) (dst + i) = value;
+		return 0;
+	case CUDDL_IOW_32:
+		for (i=0; i<len; i+=4)
+			*(volatile uint32_t *) (dst + i) = value;
+		return 0;
+	case CUDDL_IOW_64:
+		for (i=0; i<len; i+=8)
+			*(volatile uint64_t *) (dst + i) =
+				((uint64_t) value << 32) | value;
+		return 0;
+	}
+
+	/* Bring dst to 16-byte alignment with 32-bit stores */
+	for (; len && ((uintptr_t) dst & 15); dst+=4, len-=4)
+		*(volatile uint32_t *) dst = value;
+#if defined(CUDDLI_HAVE_SSE2)
+	{
+		__m128i v = _mm_set1_epi32((int) value);
+
+		for (; len >= 16; dst+=16, len-=16) {
+			if (stream)
+				_mm_stream_si128((__m128i *) dst, v);
+			else
+				_mm_store_si128((__m128i *) dst, v);
+		}
+	}
+#else
+	{
+		uint64_t v = ((uint64_t) value << 32) | value;
+
+		for (; len >= 8; dst+=8, len-=8)
+			*(volatile uint64_t *) dst = v;
+	}
+#endif
+	for (; len; dst+=4, len-=4)
+		*(volatile uint32_t *) dst = value;
+	cuddli_io_store_fence(stream);
+	return 0;
+}
+
+int cuddl_iofill(
+	cuddl_iomem_t *addr, uint32_t value, cuddl_size_t len, int width)
+{
+	return cuddli_iofill(addr, value, len, width, 1);
+}
+
+/*
+ * Return non-zero if non-temporal stores should be used for the mapping of
+ * memregion.  Default mappings are uncached for physical memory regions
+ * (the only ones that permit uncached mappings) and cached otherwise.
+ */
+static int cuddli_memregion_streaming(struct cuddl_memregion *memregion)
+{
+	switch (memregion->priv.map_mode) {
+	case CUDDLCI_MEM_MAP_UNCACHED:
+	case CUDDLCI_MEM_MAP_WRITE_COMBINE:
+		return 1;
+	case CUDDLCI_MEM_MAP_CACHED:
+		return 0;
+	default:
+		return !!(memregion->flags & CUDDL_MEMF_MAP_UNCACHED);
+	}
+}
+
+static int cuddli_memregion_check_range(
+	struct cuddl_memregion *memregion,
+	cuddl_size_t offset, cuddl_size_t len)
+{
+	if ((offset > memregion->len) || (len > memregion->len - offset))
+		return -ERANGE;
+	return 0;
+}
+
+int cuddl_memregion_read_block(
+	struct cuddl_memregion *memregion, void *buf,
+	cuddl_size_t offset, cuddl_size_t len, int width)
+{
+	int ret;
+
+	ret = cuddli_memregion_check_range(memregion, offset, len);
+	if (ret)
+		return ret;
+	return cuddl_ioread_block(
+		buf, (uint8_t *) memregion->addr + offset, len, width);
+}
+
+int cuddl_memregion_write_block(
+	struct cuddl_memregion *memregion, const void *buf,
+	cuddl_size_t offset, cuddl_size_t len, int width)
+{
+	int ret;
+
+	ret = cuddli_memregion_check_range(memregion, offset, len);
+	if (ret)
+		return ret;
+	return cuddli_iowrite_block(
+		(uint8_t *) memregion->addr + offset, buf, len, width,
+		cuddli_memregion_streaming(memregion));
+}
+
+int cuddl_memregion_fill(
+	struct cuddl_memregion *memregion, uint32_t value,
+	cuddl_size_t offset, cuddl_size_t len, int width)
+{
+	int ret;
+
+	ret = cuddli_memregion_check_range(memregion, offset, len);
+	if (ret)
+		return ret;
+	return cuddli_iofill(
+		(uint8_t *) memregion->addr + offset, value, len, width,
+		cuddli_memregion_streaming(memregion));
+}
+
+int cuddl_eventsrc_claim(
+	struct cuddl_eventsrc_info *eventinfo,
+	const char *group,
+	const char *device,
+	const char *eventsrc,
+	int instance,
+	int options)
+{
+	int ret;
+	struct cuddlci_eventsrc_claim_ioctl_data s;
+
+	s.version_code = CUDDL_VERSION_CODE;
+	populate_id_from_args(&s.id, group, device, eventsrc, instance);
 	s.pid = getpid();
 	s.options = options;
 
-	ret = ioctl(fd, CUDDLCI_EVENTSRC_CLAIM_IOCTL, &s);
-	if (ret) {
-		if ((ret == -1) && errno)
-			ret = -errno;
-		close(fd);
+	cuddli_session_register_janitor(s.pid);
+
+	ret = cuddli_manager_ioctl(CUDDLCI_EVENTSRC_CLAIM_IOCTL, &s);
+	if (ret)
 		return ret;
-	}
 
 	memcpy(eventinfo, &s.info, sizeof(*eventinfo));
 
-	ret = close(fd);
-	if (ret == -1)
-		return -errno;
-
 	return 0;
 }
 
@@ -409,24 +1336,166 @@ int cuddl_eventsrc_release(struct cuddl_eventsrc_info *eventinfo)
 	return cuddli_eventsrc_release_by_token(eventinfo->priv.token);
 }
 
+/* Map the read-only event source status page (NULL if unavailable) */
+static const struct cuddlci_eventsrc_status *cuddli_eventsrc_map_status(
+	const struct cuddl_eventsrc_info *eventinfo)
+{
+	int fd;
+	void *addr;
+
+	fd = cuddli_manager_get();
+	if (fd < 0)
+		return NULL;
+
+	addr = mmap(NULL, getpagesize(), PROT_READ, MAP_SHARED, fd,
+		    eventinfo->priv.status_mmap_offset);
+	cuddli_manager_put();
+	if (addr == MAP_FAILED)
+		return NULL;
+
+	return addr;
+}
+
+/*
+ * Take a consistent snapshot of the event source status page.  The kernel
+ * makes the sequence counter odd while an update is in progress and even
+ * again afterward, so retry until the counter is even and unchanged.
+ */
+static void cuddli_eventsrc_read_status(
+	const struct cuddlci_eventsrc_status *status,
+	struct cuddlci_eventsrc_status *snapshot)
+{
+	uint32_t start;
+
+	do {
+		start = __atomic_load_n(&status->sequence, __ATOMIC_ACQUIRE);
+		snapshot->enabled = __atomic_load_n(
+			&status->enabled, __ATOMIC_RELAXED);
+		snapshot->event_seq = __atomic_load_n(
+			&status->event_seq, __ATOMIC_RELAXED);
+		snapshot->timestamp_ns = __atomic_load_n(
+			&status->timestamp_ns, __ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	} while ((start & 1) ||
+		 (__atomic_load_n(&status->sequence, __ATOMIC_RELAXED) !=
+		  start));
+	snapshot->sequence = start;
+}
+
+/*
+ * Return non-zero if the status page shows events that have not been
+ * consumed via read() yet.  This may report a pending event slightly before
+ * the event source file descriptor becomes readable, but never misses one.
+ */
+static inline int cuddli_eventsrc_status_pending(
+	const struct cuddl_eventsrc *eventsrc)
+{
+	uint64_t seq;
+
+	seq = __atomic_load_n(
+		&eventsrc->priv.status->event_seq, __ATOMIC_ACQUIRE);
+	return (uint32_t) seq != eventsrc->priv.event_count;
+}
+
+/*
+ * Open event sources indexed by file descriptor, so that
+ * cuddl_eventsrcset_timed_wait(), which only knows the file descriptors,
+ * can record the event count read from each one.
+ */
+static struct cuddl_eventsrc *cuddli_eventsrcs_by_fd[FD_SETSIZE];
+
+static void cuddli_eventsrc_set_fd_owner(
+	int fd, struct cuddl_eventsrc *eventsrc)
+{
+	if ((fd >= 0) && (fd < FD_SETSIZE))
+		__atomic_store_n(&cuddli_eventsrcs_by_fd[fd], eventsrc,
+				 __ATOMIC_RELEASE);
+}
+
+static struct cuddl_eventsrc *cuddli_eventsrc_fd_owner(int fd)
+{
+	if ((fd < 0) || (fd >= FD_SETSIZE))
+		return NULL;
+	return __atomic_load_n(&cuddli_eventsrcs_by_fd[fd], __ATOMIC_ACQUIRE);
+}
+
+static int cuddli_eventsrc_read_record(
+	struct cuddl_eventsrc *eventsrc,
+	unsigned long long *seq,
+	struct cuddl_timespec *timestamp)
+{
+	int ret;
+	struct cuddlci_eventsrc_get_record_ioctl_data s;
+	struct cuddlci_eventsrc_status snapshot;
+
+	if (eventsrc->priv.status) {
+		cuddli_eventsrc_read_status(eventsrc->priv.status, &snapshot);
+		s.seq = snapshot.event_seq;
+		s.timestamp_ns = snapshot.timestamp_ns;
+	} else {
+		s.version_code = CUDDL_VERSION_CODE;
+		s.token = eventsrc->priv.token;
+
+		ret = cuddli_manager_ioctl(
+			CUDDLCI_EVENTSRC_GET_RECORD_IOCTL, &s);
+		if (ret)
+			return ret;
+	}
+
+	*seq = s.seq;
+	if (timestamp) {
+		timestamp->tv_sec = s.timestamp_ns / 1000000000ULL;
+		timestamp->tv_nsec = s.timestamp_ns % 1000000000ULL;
+	}
+
+	return 0;
+}
+
 int cuddl_eventsrc_open(
 	struct cuddl_eventsrc *eventsrc,
 	const struct cuddl_eventsrc_info *eventinfo,
 	int options)
 {
 	int fd;
-
-	fd = open(eventinfo->priv.device_name, O_RDWR);
-	if (fd < 0)
-		return -errno;
+	const struct cuddlci_eventsrc_status *status;
+	struct cuddlci_eventsrc_status snapshot;
+
+	/*
+	 * Sample the event sequence number before opening the device, so
+	 * that event_count never gets ahead of the events consumed via fd.
+	 */
+	snapshot.event_seq = 0;
+	status = cuddli_eventsrc_map_status(eventinfo);
+	if (status)
+		cuddli_eventsrc_read_status(status, &snapshot);
+
+	fd = cuddli_sys_eventsrc_open(eventinfo);
+	if (fd < 0) {
+		fd = -errno;
+		if (status)
+			munmap((void*)status, getpagesize());
+		return fd;
+	}
 
 	eventsrc->flags = eventinfo->flags;
 	eventsrc->priv.token = eventinfo->priv.token;
 	eventsrc->priv.fd = fd;
+	eventsrc->priv.spin_ns = 0;
+	eventsrc->priv.spin_waits = 0;
+	eventsrc->priv.spin_hits = 0;
+	eventsrc->priv.last_seq = 0;
+	eventsrc->priv.status = NULL; /* Drain stale events via read() */
+	eventsrc->priv.event_count = (uint32_t) snapshot.event_seq;
+	eventsrc->priv.latency_enabled = 0;
+	cuddl_eventsrc_reset_latency_stats(eventsrc);
 
 	cuddl_eventsrc_disable(eventsrc);
 	cuddl_eventsrc_try_wait(eventsrc);
 
+	eventsrc->priv.status = status;
+	cuddli_eventsrc_read_record(eventsrc, &eventsrc->priv.last_seq, NULL);
+	cuddli_eventsrc_set_fd_owner(fd, eventsrc);
+
 	return 0;
 }
 
@@ -434,7 +1503,14 @@ int cuddl_eventsrc_close(struct cuddl_eventsrc *eventsrc)
 {
 	int ret;
 
-	ret = close(eventsrc->priv.fd);
+	if (eventsrc->priv.status) {
+		munmap((void*)eventsrc->priv.status, getpagesize());
+		eventsrc->priv.status = NULL;
+	}
+
+	if (cuddli_eventsrc_fd_owner(eventsrc->priv.fd) == eventsrc)
+		cuddli_eventsrc_set_fd_owner(eventsrc->priv.fd, NULL);
+	ret = cuddli_sys_eventsrc_close(eventsrc->priv.fd);
 	if (ret == -1)
 		return -errno;
 
@@ -477,41 +1553,178 @@ int cuddl_eventsrc_close_and_release(struct cuddl_eventsrc *eventsrc)
 
 int cuddli_eventsrc_release_by_token(struct cuddlci_token token)
 {
-	int fd;
 	int ret;
 	struct cuddlci_eventsrc_release_ioctl_data s;
 
-	fd = open("/dev/cuddl", O_RDWR);
-	if (fd == -1)
-		return -errno;
-
 	s.version_code = CUDDL_VERSION_CODE;
 	s.token = token;
 	s.pid = getpid();
 
-	ret = ioctl(fd, CUDDLCI_EVENTSRC_RELEASE_IOCTL, &s);
-	if (ret) {
-		if ((ret == -1) && errno)
-			ret = -errno;
-		close(fd);
+	ret = cuddli_manager_ioctl(CUDDLCI_EVENTSRC_RELEASE_IOCTL, &s);
+	if (ret)
 		return ret;
-	}
 
-	ret = close(fd);
-	if (ret == -1)
-		return -errno;
+	return 0;
+}
+
+/* Spin-wait hint for the CPU (e.g. to save power / yield to SMT sibling) */
+static inline void cuddli_cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#elif defined(__aarch64__) || (defined(__arm__) && __ARM_ARCH >= 7)
+	__asm__ __volatile__("yield" ::: "memory");
+#else
+	__asm__ __volatile__("" ::: "memory");
+#endif
+}
+
+static inline long long cuddli_monotonic_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (long long) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/*
+ * Record the time from the most recent kernel event (time-stamped in the
+ * top-half interrupt handler) to now, just after it has been consumed.
+ */
+static void cuddli_eventsrc_record_latency(struct cuddl_eventsrc *eventsrc)
+{
+	struct cuddli_eventsrc_latency *latency = &eventsrc->priv.latency;
+	uint64_t event_ns;
+	uint64_t now_ns;
+	uint64_t ns;
+	int bucket;
+
+	if (!eventsrc->priv.latency_enabled || !eventsrc->priv.status)
+		return;
+
+	event_ns = __atomic_load_n(
+		&eventsrc->priv.status->timestamp_ns, __ATOMIC_ACQUIRE);
+	now_ns = cuddli_monotonic_ns();
+	ns = (now_ns > event_ns) ? (now_ns - event_ns) : 0;
+
+	bucket = ns ? (64 - __builtin_clzll(ns)) : 0;
+	if (bucket >= CUDDLI_EVENTSRC_LATENCY_BUCKETS)
+		bucket = CUDDLI_EVENTSRC_LATENCY_BUCKETS - 1;
+
+	latency->samples++;
+	latency->hist[bucket]++;
+	if (ns > latency->max_ns)
+		latency->max_ns = ns;
+}
+
+void cuddl_eventsrc_get_latency_stats(
+	const struct cuddl_eventsrc *eventsrc,
+	struct cuddl_eventsrc_latency_stats *stats)
+{
+	_Static_assert(CUDDL_EVENTSRC_LATENCY_BUCKETS ==
+		       CUDDLI_EVENTSRC_LATENCY_BUCKETS,
+		       "latency histogram size mismatch");
+
+	stats->samples = eventsrc->priv.latency.samples;
+	stats->max_ns = eventsrc->priv.latency.max_ns;
+	memcpy(stats->hist_ns, eventsrc->priv.latency.hist,
+	       sizeof(stats->hist_ns));
+}
+
+void cuddl_eventsrc_enable_latency_stats(
+	struct cuddl_eventsrc *eventsrc, int enable)
+{
+	if (enable && !eventsrc->priv.latency_enabled)
+		cuddl_eventsrc_reset_latency_stats(eventsrc);
+	eventsrc->priv.latency_enabled = enable ? 1 : 0;
+}
+
+void cuddl_eventsrc_reset_latency_stats(struct cuddl_eventsrc *eventsrc)
+{
+	memset(&eventsrc->priv.latency, 0, sizeof(eventsrc->priv.latency));
+}
+
+/* Maximum number of CPU relax hints between polls while spinning */
+#define CUDDLI_SPIN_MAX_BACKOFF 64
+
+/*
+ * Poll the event source until it becomes ready or the spin budget expires.
+ * The number of relax hints between polls doubles after each unsuccessful
+ * poll (up to a limit), so that a long budget does not turn into a
+ * continuous stream of system calls.
+ */
+static int cuddli_eventsrc_spin(struct cuddl_eventsrc *eventsrc)
+{
+	struct pollfd pfd;
+	long long deadline;
+	int backoff = 1;
+	int ret;
+
+	pfd.fd = eventsrc->priv.fd;
+	pfd.events = POLLIN;
+
+	deadline = cuddli_monotonic_ns() + eventsrc->priv.spin_ns;
+	do {
+		if (eventsrc->priv.status) {
+			if (cuddli_eventsrc_status_pending(eventsrc))
+				return 1;
+		} else {
+			ret = poll(&pfd, 1, 0);
+			if (ret > 0)
+				return 1;
+			if (ret == -1)
+				return -errno;
+		}
+		for (int i=0; i < backoff; i++)
+			cuddli_cpu_relax();
+		if (backoff < CUDDLI_SPIN_MAX_BACKOFF)
+			backoff <<= 1;
+	} while (cuddli_monotonic_ns() < deadline);
+
+	return 0;
+}
+
+int cuddl_eventsrc_set_spin_budget(
+	struct cuddl_eventsrc *eventsrc, long spin_ns)
+{
+	if (spin_ns < 0)
+		return -EINVAL;
+
+	eventsrc->priv.spin_ns = spin_ns;
+	eventsrc->priv.spin_waits = 0;
+	eventsrc->priv.spin_hits = 0;
 
 	return 0;
 }
 
+void cuddl_eventsrc_get_spin_stats(
+	const struct cuddl_eventsrc *eventsrc,
+	struct cuddl_eventsrc_spin_stats *stats)
+{
+	stats->waits = eventsrc->priv.spin_waits;
+	stats->spin_hits = eventsrc->priv.spin_hits;
+}
+
 int cuddl_eventsrc_wait(struct cuddl_eventsrc *eventsrc)
 {
 	ssize_t n_bytes_read;
 	uint32_t count = 0;
+	int ret;
+
+	if (eventsrc->priv.spin_ns > 0) {
+		eventsrc->priv.spin_waits++;
+		ret = cuddli_eventsrc_spin(eventsrc);
+		if (ret < 0)
+			return ret;
+		if (ret > 0)
+			eventsrc->priv.spin_hits++;
+	}
 
-	n_bytes_read = read(eventsrc->priv.fd, &count, sizeof(count));
+	n_bytes_read = cuddli_sys_eventsrc_read(eventsrc->priv.fd, &count);
 	if (n_bytes_read == -1)
 		return -errno;
+	eventsrc->priv.event_count = count;
+	cuddli_eventsrc_record_latency(eventsrc);
 
 	return count;
 }
@@ -520,6 +1733,9 @@ int cuddl_eventsrc_try_wait(struct cuddl_eventsrc *eventsrc)
 {
 	struct cuddl_timespec timeout;
 
+	if (eventsrc->priv.status && !cuddli_eventsrc_status_pending(eventsrc))
+		return -ETIMEDOUT;
+
 	timeout.tv_sec = 0;
 	timeout.tv_nsec = 0;
 
@@ -549,9 +1765,45 @@ int cuddl_eventsrc_timed_wait(
 	if (!FD_ISSET(eventsrc->priv.fd, &fds))
 		return -ETIMEDOUT;
 
-	n_bytes_read = read(eventsrc->priv.fd, &count, sizeof(count));
+	n_bytes_read = cuddli_sys_eventsrc_read(eventsrc->priv.fd, &count);
 	if (n_bytes_read == -1)
 		return -errno;
+	eventsrc->priv.event_count = count;
+	cuddli_eventsrc_record_latency(eventsrc);
+
+	return count;
+}
+
+int cuddl_eventsrc_get_record(
+	struct cuddl_eventsrc *eventsrc, struct cuddl_eventsrc_record *record)
+{
+	unsigned long long seq;
+	int ret;
+
+	ret = cuddli_eventsrc_read_record(eventsrc, &seq, &record->timestamp);
+	if (ret)
+		return ret;
+
+	record->seq = seq;
+	record->delta = seq - eventsrc->priv.last_seq;
+	eventsrc->priv.last_seq = seq;
+
+	return 0;
+}
+
+int cuddl_eventsrc_wait_record(
+	struct cuddl_eventsrc *eventsrc, struct cuddl_eventsrc_record *record)
+{
+	int count;
+	int ret;
+
+	count = cuddl_eventsrc_wait(eventsrc);
+	if (count < 0)
+		return count;
+
+	ret = cuddl_eventsrc_get_record(eventsrc, record);
+	if (ret)
+		return ret;
 
 	return count;
 }
@@ -561,7 +1813,7 @@ int cuddl_eventsrc_enable(struct cuddl_eventsrc *eventsrc)
 	int ret;
 	uint32_t value = 1;
 
-	ret = write(eventsrc->priv.fd, &value, 4);
+	ret = cuddli_sys_eventsrc_write(eventsrc->priv.fd, &value);
 	if (ret == -1)
 		return -errno;
 
@@ -573,7 +1825,7 @@ int cuddl_eventsrc_disable(struct cuddl_eventsrc *eventsrc)
 	int ret;
 	uint32_t value = 0;
 
-	ret = write(eventsrc->priv.fd, &value, 4);
+	ret = cuddli_sys_eventsrc_write(eventsrc->priv.fd, &value);
 	if (ret == -1)
 		return -errno;
 
@@ -582,24 +1834,21 @@ int cuddl_eventsrc_disable(struct cuddl_eventsrc *eventsrc)
 
 int cuddl_eventsrc_is_enabled(struct cuddl_eventsrc *eventsrc)
 {
-	int fd;
-	int ret, ret2;
+	int ret;
 	struct cuddlci_eventsrc_is_enabled_ioctl_data s;
+	struct cuddlci_eventsrc_status snapshot;
 
-	fd = open("/dev/cuddl", O_RDWR);
-	if (fd == -1)
-		return -errno;
+	if (eventsrc->priv.status &&
+	    (eventsrc->flags & CUDDL_EVENTSRCF_HAS_IS_ENABLED)) {
+		cuddli_eventsrc_read_status(eventsrc->priv.status, &snapshot);
+		if (snapshot.enabled != CUDDLCI_EVENTSRC_STATUS_ENABLED_UNKNOWN)
+			return snapshot.enabled;
+	}
 
 	s.version_code = CUDDL_VERSION_CODE;
 	s.token = eventsrc->priv.token;
 
-	ret = ioctl(fd, CUDDLCI_EVENTSRC_IS_ENABLED_IOCTL, &s);
-	if ((ret == -1) && errno)
-		ret = -errno;
-
-	ret2 = close(fd);
-	if ((ret2 == -1) && (ret >= 0))
-		return -errno;
+	ret = cuddli_manager_ioctl(CUDDLCI_EVENTSRC_IS_ENABLED_IOCTL, &s);
 
 	return ret;
 }
@@ -618,55 +1867,678 @@ void cuddl_eventsrcset_add(
 		set->priv.max_fd = eventsrc->priv.fd;
 }
 
-void cuddl_eventsrcset_remove(
-	struct cuddl_eventsrcset *set, const struct cuddl_eventsrc *eventsrc)
-{
-	FD_CLR(eventsrc->priv.fd, &set->priv.fds);
+void cuddl_eventsrcset_remove(
+	struct cuddl_eventsrcset *set, const struct cuddl_eventsrc *eventsrc)
+{
+	FD_CLR(eventsrc->priv.fd, &set->priv.fds);
+}
+
+int cuddl_eventsrcset_contains(
+	struct cuddl_eventsrcset *set, const struct cuddl_eventsrc *eventsrc)
+{
+	return FD_ISSET(eventsrc->priv.fd, &set->priv.fds);
+}
+
+int cuddl_eventsrcset_timed_wait(
+	struct cuddl_eventsrcset *eventsrcset,
+	const struct cuddl_timespec *timeout,
+	struct cuddl_eventsrcset *result)
+{
+	uint32_t count = 0;
+
+	struct cuddl_eventsrcset tmp_result;
+	if (!result) {
+		result = &tmp_result;
+	}
+
+	*result = *eventsrcset;
+
+	struct timeval tv;
+	tv.tv_sec = timeout->tv_sec;
+	tv.tv_usec = timeout->tv_nsec/1000;
+
+	int ret = select(result->priv.max_fd + 1, &result->priv.fds,
+	                 NULL, NULL, &tv);
+	if (ret == -1)
+		return -errno;
+
+	int n_ready_fds = 0;
+	struct cuddl_eventsrc *eventsrc;
+	for (int fd=0; fd <= result->priv.max_fd; fd++) {
+		if (FD_ISSET(fd, &result->priv.fds)) {
+			n_ready_fds++;
+			ret = cuddli_sys_eventsrc_read(fd, &count);
+			if (ret == -1)
+				return -errno;
+			eventsrc = cuddli_eventsrc_fd_owner(fd);
+			if (eventsrc)
+				eventsrc->priv.event_count = count;
+		}
+	}
+
+	if (n_ready_fds == 0)
+		return -ETIMEDOUT;
+
+	return n_ready_fds;
+}
+
+/* Maximum number of epoll events retrieved from the kernel per wait */
+#define CUDDLI_EVENTSRCPOLL_MAX_EVENTS 64
+
+int cuddl_eventsrcpoll_init(struct cuddl_eventsrcpoll *set)
+{
+#ifdef __XENO__
+	/* RTDM file descriptors cannot be registered with epoll */
+	set->priv.epfd = -1;
+	set->priv.count = 0;
+	return -ENOSYS;
+#else
+	set->priv.count = 0;
+	set->priv.epfd = epoll_create1(EPOLL_CLOEXEC);
+	if (set->priv.epfd < 0)
+		return -errno;
+
+	return 0;
+#endif
+}
+
+int cuddl_eventsrcpoll_destroy(struct cuddl_eventsrcpoll *set)
+{
+	int ret = 0;
+
+	if (set->priv.epfd >= 0) {
+		ret = close(set->priv.epfd);
+		if (ret == -1)
+			ret = -errno;
+	}
+	set->priv.epfd = -1;
+	set->priv.count = 0;
+
+	return ret;
+}
+
+int cuddl_eventsrcpoll_add(
+	struct cuddl_eventsrcpoll *set, struct cuddl_eventsrc *eventsrc)
+{
+	struct epoll_event ev;
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.ptr = eventsrc;
+
+	if (epoll_ctl(set->priv.epfd, EPOLL_CTL_ADD, eventsrc->priv.fd, &ev))
+		return -errno;
+	set->priv.count++;
+
+	return 0;
+}
+
+int cuddl_eventsrcpoll_remove(
+	struct cuddl_eventsrcpoll *set, struct cuddl_eventsrc *eventsrc)
+{
+	if (epoll_ctl(set->priv.epfd, EPOLL_CTL_DEL, eventsrc->priv.fd, NULL))
+		return -errno;
+	set->priv.count--;
+
+	return 0;
+}
+
+int cuddl_eventsrcpoll_size(const struct cuddl_eventsrcpoll *set)
+{
+	return set->priv.count;
+}
+
+int cuddl_eventsrcpoll_timed_wait(
+	struct cuddl_eventsrcpoll *set,
+	const struct cuddl_timespec *timeout,
+	struct cuddl_eventsrc **ready,
+	int max_ready)
+{
+	struct epoll_event events[CUDDLI_EVENTSRCPOLL_MAX_EVENTS];
+	struct cuddl_eventsrc *eventsrc;
+	uint32_t count = 0;
+	int timeout_ms = -1;
+	int n_events;
+	int ret;
+
+	if (max_ready <= 0)
+		return -EINVAL;
+	if (max_ready > CUDDLI_EVENTSRCPOLL_MAX_EVENTS)
+		max_ready = CUDDLI_EVENTSRCPOLL_MAX_EVENTS;
+
+	if (timeout)
+		timeout_ms = timeout->tv_sec * 1000 +
+			(timeout->tv_nsec + 999999) / 1000000;
+
+	n_events = epoll_wait(set->priv.epfd, events, max_ready, timeout_ms);
+	if (n_events == -1)
+		return -errno;
+	if (n_events == 0)
+		return -ETIMEDOUT;
+
+	for (int i=0; i < n_events; i++) {
+		eventsrc = events[i].data.ptr;
+		ret = cuddli_sys_eventsrc_read(eventsrc->priv.fd, &count);
+		if (ret == -1)
+			return -errno;
+		eventsrc->priv.event_count = count;
+		ready[i] = eventsrc;
+	}
+
+	return n_events;
+}
+
+/*
+ * Event engine.
+ *
+ * Each event source added to an engine has a slot holding the buffer used
+ * for reading its interrupt count.  The io_uring ``user_data`` of a read
+ * submission is the slot address; the low bit is set for re-enable writes.
+ * The epoll fallback uses one-shot registrations so that both
+ * implementations only report an event source again after it is re-armed.
+ */
+struct cuddli_eventengine_slot {
+	struct cuddl_eventsrc *eventsrc;
+	uint32_t count;
+	int write_res;
+	int armed;
+};
+
+#define CUDDLI_URING_WRITE_TAG 1UL
+
+#ifdef CUDDLI_HAVE_IO_URING
+
+static const uint32_t cuddli_eventsrc_enable_value = 1;
+
+struct cuddli_uring {
+	int fd;
+	unsigned sq_entries;
+	unsigned *sq_head;
+	unsigned *sq_tail;
+	unsigned *sq_mask;
+	unsigned *sq_array;
+	unsigned *cq_head;
+	unsigned *cq_tail;
+	unsigned *cq_mask;
+	struct io_uring_sqe *sqes;
+	struct io_uring_cqe *cqes;
+	void *sq_ring;
+	size_t sq_ring_size;
+	void *cq_ring;
+	size_t cq_ring_size;
+	size_t sqes_size;
+	unsigned sq_local_tail;
+	unsigned to_submit;
+};
+
+static void cuddli_uring_teardown(struct cuddli_uring *r)
+{
+	if (r->sqes && (r->sqes != MAP_FAILED))
+		munmap(r->sqes, r->sqes_size);
+	if (r->cq_ring && (r->cq_ring != MAP_FAILED) &&
+	    (r->cq_ring != r->sq_ring))
+		munmap(r->cq_ring, r->cq_ring_size);
+	if (r->sq_ring && (r->sq_ring != MAP_FAILED))
+		munmap(r->sq_ring, r->sq_ring_size);
+	if (r->fd >= 0)
+		close(r->fd);
+	free(r);
+}
+
+/*
+ * Create an io_uring instance.  Kernels that lack io_uring, or that predate
+ * the features used here (single ring mapping and timed waits), yield NULL
+ * so that the caller can use the epoll fallback.
+ */
+static struct cuddli_uring *cuddli_uring_setup(unsigned entries)
+{
+	struct io_uring_params p;
+	struct cuddli_uring *r;
+	char *sq;
+	char *cq;
+
+	r = calloc(1, sizeof(*r));
+	if (!r)
+		return NULL;
+
+	memset(&p, 0, sizeof(p));
+	r->fd = syscall(__NR_io_uring_setup, entries, &p);
+	if (r->fd < 0)
+		goto fail;
+	if (!(p.features & IORING_FEAT_SINGLE_MMAP) ||
+	    !(p.features & IORING_FEAT_EXT_ARG))
+		goto fail;
+
+	r->sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+	r->cq_ring_size = p.cq_off.cqes +
+		p.cq_entries * sizeof(struct io_uring_cqe);
+	if (r->cq_ring_size > r->sq_ring_size)
+		r->sq_ring_size = r->cq_ring_size;
+	r->sq_ring = mmap(NULL, r->sq_ring_size, PROT_READ | PROT_WRITE,
+			  MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQ_RING);
+	if (r->sq_ring == MAP_FAILED)
+		goto fail;
+	r->cq_ring = r->sq_ring;
+
+	r->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+	r->sqes = mmap(NULL, r->sqes_size, PROT_READ | PROT_WRITE,
+		       MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQES);
+	if (r->sqes == MAP_FAILED)
+		goto fail;
+
+	sq = r->sq_ring;
+	cq = r->cq_ring;
+	r->sq_entries = p.sq_entries;
+	r->sq_head = (unsigned *) (sq + p.sq_off.head);
+	r->sq_tail = (unsigned *) (sq + p.sq_off.tail);
+	r->sq_mask = (unsigned *) (sq + p.sq_off.ring_mask);
+	r->sq_array = (unsigned *) (sq + p.sq_off.array);
+	r->cq_head = (unsigned *) (cq + p.cq_off.head);
+	r->cq_tail = (unsigned *) (cq + p.cq_off.tail);
+	r->cq_mask = (unsigned *) (cq + p.cq_off.ring_mask);
+	r->cqes = (struct io_uring_cqe *) (cq + p.cq_off.cqes);
+	r->sq_local_tail = *r->sq_tail;
+
+	return r;
+
+fail:
+	cuddli_uring_teardown(r);
+	return NULL;
+}
+
+static int cuddli_uring_enter(
+	struct cuddli_uring *r, unsigned min_complete,
+	const struct cuddl_timespec *timeout)
+{
+	struct io_uring_getevents_arg arg;
+	struct __kernel_timespec ts;
+	unsigned flags = 0;
+	int ret;
+
+	memset(&arg, 0, sizeof(arg));
+	if (min_complete) {
+		flags |= IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+		arg.sigmask_sz = 8;
+		if (timeout) {
+			ts.tv_sec = timeout->tv_sec;
+			ts.tv_nsec = timeout->tv_nsec;
+			arg.ts = (uintptr_t) &ts;
+		}
+	}
+
+	ret = syscall(__NR_io_uring_enter, r->fd, r->to_submit, min_complete,
+		      flags, min_complete ? &arg : NULL,
+		      min_complete ? sizeof(arg) : 0);
+	if (ret < 0)
+		return -errno;
+
+	r->to_submit -= ret;
+	return 0;
+}
+
+static struct io_uring_sqe *cuddli_uring_get_sqe(struct cuddli_uring *r)
+{
+	struct io_uring_sqe *sqe;
+	unsigned head;
+
+	head = __atomic_load_n(r->sq_head, __ATOMIC_ACQUIRE);
+	if (r->sq_local_tail - head >= r->sq_entries) {
+		if (cuddli_uring_enter(r, 0, NULL) < 0)
+			return NULL;
+		head = __atomic_load_n(r->sq_head, __ATOMIC_ACQUIRE);
+		if (r->sq_local_tail - head >= r->sq_entries)
+			return NULL;
+	}
+
+	sqe = &r->sqes[r->sq_local_tail & *r->sq_mask];
+	memset(sqe, 0, sizeof(*sqe));
+	return sqe;
+}
+
+static void cuddli_uring_commit_sqe(
+	struct cuddli_uring *r, struct io_uring_sqe *sqe)
+{
+	unsigned index = sqe - r->sqes;
+
+	r->sq_array[r->sq_local_tail & *r->sq_mask] = index;
+	r->sq_local_tail++;
+	r->to_submit++;
+	__atomic_store_n(r->sq_tail, r->sq_local_tail, __ATOMIC_RELEASE);
+}
+
+/* Queue an optional (linked) re-enable write followed by a read */
+static int cuddli_uring_queue(
+	struct cuddli_uring *r, struct cuddli_eventengine_slot *slot,
+	int enable)
+{
+	struct io_uring_sqe *sqe;
+
+	/* Make sure a linked pair is not split across submissions */
+	if (enable &&
+	    (r->sq_local_tail + 1 -
+	     __atomic_load_n(r->sq_head, __ATOMIC_ACQUIRE) >= r->sq_entries)) {
+		if (cuddli_uring_enter(r, 0, NULL) < 0)
+			return -EBUSY;
+	}
+
+	if (enable) {
+		sqe = cuddli_uring_get_sqe(r);
+		if (!sqe)
+			return -EBUSY;
+		sqe->opcode = IORING_OP_WRITE;
+		sqe->fd = slot->eventsrc->priv.fd;
+		sqe->addr = (uintptr_t) &cuddli_eventsrc_enable_value;
+		sqe->len = sizeof(cuddli_eventsrc_enable_value);
+		sqe->user_data = (uintptr_t) slot | CUDDLI_URING_WRITE_TAG;
+		sqe->flags = IOSQE_IO_LINK;
+		cuddli_uring_commit_sqe(r, sqe);
+	}
+
+	sqe = cuddli_uring_get_sqe(r);
+	if (!sqe)
+		return -EBUSY;
+	sqe->opcode = IORING_OP_READ;
+	sqe->fd = slot->eventsrc->priv.fd;
+	sqe->addr = (uintptr_t) &slot->count;
+	sqe->len = sizeof(slot->count);
+	sqe->user_data = (uintptr_t) slot;
+	cuddli_uring_commit_sqe(r, sqe);
+	slot->write_res = 0;
+	slot->armed = 1;
+
+	return 0;
+}
+
+static int cuddli_uring_reap(
+	struct cuddli_uring *r, struct cuddl_eventengine *engine,
+	struct cuddl_eventengine_event *events, int max_events)
+{
+	struct cuddli_eventengine_slot *slot;
+	struct io_uring_cqe *cqe;
+	unsigned head;
+	unsigned tail;
+	int n = 0;
+
+	head = *r->cq_head;
+	tail = __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE);
+	while ((head != tail) && (n < max_events)) {
+		cqe = &r->cqes[head & *r->cq_mask];
+		slot = (struct cuddli_eventengine_slot *) (uintptr_t) (
+			cqe->user_data & ~CUDDLI_URING_WRITE_TAG);
+		if (cqe->user_data & CUDDLI_URING_WRITE_TAG) {
+			if (cqe->res < 0)
+				slot->write_res = cqe->res;
+		} else {
+			slot->armed = 0;
+			events[n].eventsrc = slot->eventsrc;
+			events[n].index = slot - engine->priv.slots;
+			if (cqe->res >= 0) {
+				events[n].count = slot->count;
+				slot->eventsrc->priv.event_count =
+					slot->count;
+			}
+			else if ((cqe->res == -ECANCELED) && slot->write_res)
+				events[n].count = slot->write_res;
+			else
+				events[n].count = cqe->res;
+			n++;
+		}
+		head++;
+	}
+	__atomic_store_n(r->cq_head, head, __ATOMIC_RELEASE);
+
+	return n;
+}
+
+static int cuddli_uring_cq_ready(struct cuddli_uring *r)
+{
+	return __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE) != *r->cq_head;
+}
+
+#endif /* CUDDLI_HAVE_IO_URING */
+
+int cuddl_eventengine_init(
+	struct cuddl_eventengine *engine, int max_eventsrcs, int flags)
+{
+	engine->priv.uring = NULL;
+	engine->priv.slots = NULL;
+	engine->priv.n_slots = 0;
+	engine->priv.max_slots = 0;
+	engine->priv.epfd = -1;
+
+#ifdef __XENO__
+	/* RTDM file descriptors support neither io_uring nor epoll */
+	return -ENOSYS;
+#endif
+
+	if (max_eventsrcs <= 0)
+		return -EINVAL;
+
+	engine->priv.slots = calloc(
+		max_eventsrcs, sizeof(struct cuddli_eventengine_slot));
+	if (!engine->priv.slots)
+		return -ENOMEM;
+	engine->priv.max_slots = max_eventsrcs;
+
+#ifdef CUDDLI_HAVE_IO_URING
+	if (!(flags & CUDDL_EVENTENGINEF_NO_IO_URING)) {
+		/* One linked write/read pair per event source */
+		engine->priv.uring = cuddli_uring_setup(2 * max_eventsrcs);
+		if (engine->priv.uring)
+			return 0;
+	}
+#else
+	(void) flags;
+#endif
+
+	engine->priv.epfd = epoll_create1(EPOLL_CLOEXEC);
+	if (engine->priv.epfd < 0) {
+		int ret = -errno;
+		cuddl_eventengine_destroy(engine);
+		return ret;
+	}
+
+	return 0;
+}
+
+int cuddl_eventengine_destroy(struct cuddl_eventengine *engine)
+{
+	int ret = 0;
+
+#ifdef CUDDLI_HAVE_IO_URING
+	if (engine->priv.uring)
+		cuddli_uring_teardown(engine->priv.uring);
+#endif
+	if (engine->priv.epfd >= 0) {
+		ret = close(engine->priv.epfd);
+		if (ret == -1)
+			ret = -errno;
+	}
+	free(engine->priv.slots);
+
+	engine->priv.uring = NULL;
+	engine->priv.slots = NULL;
+	engine->priv.n_slots = 0;
+	engine->priv.max_slots = 0;
+	engine->priv.epfd = -1;
+
+	return ret;
+}
+
+int cuddl_eventengine_uses_io_uring(const struct cuddl_eventengine *engine)
+{
+	return engine->priv.uring != NULL;
+}
+
+static int cuddli_eventengine_epoll_arm(
+	struct cuddl_eventengine *engine, int index, int op)
+{
+	struct cuddli_eventengine_slot *slot = &engine->priv.slots[index];
+	struct epoll_event ev;
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN | EPOLLONESHOT;
+	ev.data.u32 = index;
+
+	if (epoll_ctl(engine->priv.epfd, op, slot->eventsrc->priv.fd, &ev))
+		return -errno;
+	slot->armed = 1;
+
+	return 0;
+}
+
+int cuddl_eventengine_add(
+	struct cuddl_eventengine *engine, struct cuddl_eventsrc *eventsrc)
+{
+	struct cuddli_eventengine_slot *slot;
+	int index;
+	int ret;
+
+	if (engine->priv.n_slots >= engine->priv.max_slots)
+		return -ENOSPC;
+
+	index = engine->priv.n_slots;
+	slot = &engine->priv.slots[index];
+	slot->eventsrc = eventsrc;
+
+#ifdef CUDDLI_HAVE_IO_URING
+	if (engine->priv.uring)
+		ret = cuddli_uring_queue(engine->priv.uring, slot, 0);
+	else
+#endif
+		ret = cuddli_eventengine_epoll_arm(engine, index, EPOLL_CTL_ADD);
+	if (ret)
+		return ret;
+
+	engine->priv.n_slots++;
+	return index;
 }
 
-int cuddl_eventsrcset_contains(
-	struct cuddl_eventsrcset *set, const struct cuddl_eventsrc *eventsrc)
+int cuddl_eventengine_rearm(
+	struct cuddl_eventengine *engine, int index, int enable)
 {
-	return FD_ISSET(eventsrc->priv.fd, &set->priv.fds);
+	struct cuddli_eventengine_slot *slot;
+	int ret;
+
+	if ((index < 0) || (index >= engine->priv.n_slots))
+		return -EINVAL;
+	slot = &engine->priv.slots[index];
+
+#ifdef CUDDLI_HAVE_IO_URING
+	/*
+	 * A re-enable write is only linked to (and reported via) the read
+	 * that re-arms the event source, so an armed event source is
+	 * re-enabled immediately.
+	 */
+	if (engine->priv.uring && !slot->armed)
+		return cuddli_uring_queue(engine->priv.uring, slot, enable);
+	if (engine->priv.uring)
+		return enable ? cuddl_eventsrc_enable(slot->eventsrc) : 0;
+#endif
+
+	if (enable) {
+		ret = cuddl_eventsrc_enable(slot->eventsrc);
+		if (ret)
+			return ret;
+	}
+	if (slot->armed)
+		return 0;
+
+	return cuddli_eventengine_epoll_arm(engine, index, EPOLL_CTL_MOD);
 }
 
-int cuddl_eventsrcset_timed_wait(
-	struct cuddl_eventsrcset *eventsrcset,
+int cuddl_eventengine_timed_wait(
+	struct cuddl_eventengine *engine,
 	const struct cuddl_timespec *timeout,
-	struct cuddl_eventsrcset *result)
+	struct cuddl_eventengine_event *events,
+	int max_events)
 {
-	uint32_t count = 0;
+	struct epoll_event ep_events[CUDDLI_EVENTSRCPOLL_MAX_EVENTS];
+	struct cuddli_eventengine_slot *slot;
+	int timeout_ms = -1;
+	int n_events;
+	int ret;
 
-	struct cuddl_eventsrcset tmp_result;
-	if (!result) {
-		result = &tmp_result;
+	if (max_events <= 0)
+		return -EINVAL;
+
+#ifdef CUDDLI_HAVE_IO_URING
+	if (engine->priv.uring) {
+		struct cuddli_uring *r = engine->priv.uring;
+		struct cuddl_timespec remaining;
+		long long deadline = 0;
+		long long left;
+
+		if (timeout) {
+			remaining = *timeout;
+			deadline = cuddli_monotonic_ns() +
+				timeout->tv_sec * 1000000000LL +
+				timeout->tv_nsec;
+		}
+
+		/*
+		 * Submit queued requests, blocking only if nothing is ready.
+		 * The completion of a re-enable write also ends the wait
+		 * without yielding an event, so wait again until an event
+		 * source triggers or the timeout expires.
+		 */
+		for (;;) {
+			if (!cuddli_uring_cq_ready(r)) {
+				ret = cuddli_uring_enter(
+					r, 1, timeout ? &remaining : NULL);
+				if (ret == -ETIME)
+					return -ETIMEDOUT;
+				if (ret)
+					return ret;
+			} else if (r->to_submit) {
+				ret = cuddli_uring_enter(r, 0, NULL);
+				if (ret)
+					return ret;
+			}
+
+			n_events = cuddli_uring_reap(
+				r, engine, events, max_events);
+			if (n_events)
+				return n_events;
+
+			if (timeout) {
+				left = deadline - cuddli_monotonic_ns();
+				if (left <= 0)
+					return -ETIMEDOUT;
+				remaining.tv_sec = left / 1000000000LL;
+				remaining.tv_nsec = left % 1000000000LL;
+			}
+		}
 	}
+#endif
 
-	*result = *eventsrcset;
+	if (max_events > CUDDLI_EVENTSRCPOLL_MAX_EVENTS)
+		max_events = CUDDLI_EVENTSRCPOLL_MAX_EVENTS;
 
-	struct timeval tv;
-	tv.tv_sec = timeout->tv_sec;
-	tv.tv_usec = timeout->tv_nsec/1000;
+	if (timeout)
+		timeout_ms = timeout->tv_sec * 1000 +
+			(timeout->tv_nsec + 999999) / 1000000;
 
-	int ret = select(result->priv.max_fd + 1, &result->priv.fds,
-	                 NULL, NULL, &tv);
-	if (ret == -1)
+	n_events = epoll_wait(
+		engine->priv.epfd, ep_events, max_events, timeout_ms);
+	if (n_events == -1)
 		return -errno;
+	if (n_events == 0)
+		return -ETIMEDOUT;
 
-	int n_ready_fds = 0;
-	for (int fd=0; fd <= result->priv.max_fd; fd++) {
-		if (FD_ISSET(fd, &result->priv.fds)) {
-			n_ready_fds++;
-			ret = read(fd, &count, sizeof(count));
-			if (ret == -1)
-				return -errno;
-		}
+	for (int i=0; i < n_events; i++) {
+		slot = &engine->priv.slots[ep_events[i].data.u32];
+		slot->armed = 0;
+		events[i].eventsrc = slot->eventsrc;
+		events[i].index = ep_events[i].data.u32;
+		ret = cuddli_sys_eventsrc_read(
+			slot->eventsrc->priv.fd, &slot->count);
+		events[i].count = (ret == -1) ? -errno : (int) slot->count;
+		if (ret != -1)
+			slot->eventsrc->priv.event_count = slot->count;
 	}
 
-	if (n_ready_fds == 0)
-		return -ETIMEDOUT;
-
-	return n_ready_fds;
+	return n_events;
 }
 
 int cuddl_eventsrc_get_resource_id(
@@ -678,98 +2550,89 @@ int cuddl_eventsrc_get_resource_id(
 		eventsrc->priv.token.resource_index);
 }
 
-int cuddl_get_max_managed_devices(void)
+int cuddl_resource_claim_batch(struct cuddl_resource_claim *claims, int count)
 {
-	int fd;
-	int ret, ret2;
-	struct cuddlci_void_ioctl_data s;
+	int i;
+	int ret;
+	struct cuddlci_claim_batch_ioctl_data s;
+	struct cuddlci_claim_batch_entry *entries;
 
-	fd = open("/dev/cuddl", O_RDWR);
-	if (fd == -1)
-		return -errno;
+	if ((count <= 0) || (count > CUDDLCI_MAX_CLAIM_BATCH))
+		return -EINVAL;
 
-	s.version_code = CUDDL_VERSION_CODE;
+	entries = calloc(count, sizeof(*entries));
+	if (!entries)
+		return -ENOMEM;
 
-	ret = ioctl(fd, CUDDLCI_GET_MAX_MANAGED_DEVICES_IOCTL, &s);
-	if ((ret == -1) && errno)
-		ret = -errno;
+	for (i=0; i<count; i++) {
+		memcpy(&entries[i].id, &claims[i].id, sizeof(entries[i].id));
+		entries[i].type = claims[i].type;
+		entries[i].options = claims[i].options;
+		entries[i].result = -ECANCELED;
+	}
 
-	ret2 = close(fd);
-	if ((ret2 == -1) && (ret >= 0))
-		return -errno;
+	s.version_code = CUDDL_VERSION_CODE;
+	s.pid = getpid();
+	s.count = count;
+	s.failed_index = -1;
+	s.entries = (uintptr_t) entries;
+
+	cuddli_session_register_janitor(s.pid);
+
+	ret = cuddli_manager_ioctl(CUDDLCI_CLAIM_BATCH_IOCTL, &s);
+
+	for (i=0; i<count; i++) {
+		claims[i].result = ret ? entries[i].result : 0;
+		if (ret)
+			continue;
+		if (claims[i].type == CUDDL_RESOURCE_MEMREGION)
+			memcpy(&claims[i].meminfo, &entries[i].info.mem,
+			       sizeof(claims[i].meminfo));
+		else
+			memcpy(&claims[i].eventinfo, &entries[i].info.event,
+			       sizeof(claims[i].eventinfo));
+	}
+
+	free(entries);
 
 	return ret;
 }
 
-int cuddl_get_max_dev_mem_regions(void)
+int cuddl_get_max_managed_devices(void)
 {
-	int fd;
-	int ret, ret2;
-	struct cuddlci_void_ioctl_data s;
-
-	fd = open("/dev/cuddl", O_RDWR);
-	if (fd == -1)
-		return -errno;
-
-	s.version_code = CUDDL_VERSION_CODE;
-
-	ret = ioctl(fd, CUDDLCI_GET_MAX_DEV_MEM_REGIONS_IOCTL, &s);
-	if ((ret == -1) && errno)
-		ret = -errno;
-
-	ret2 = close(fd);
-	if ((ret2 == -1) && (ret >= 0))
-		return -errno;
+	return cuddli_manager_cached_limit(
+		&cuddli_session.max_managed_devices,
+		CUDDLCI_GET_MAX_MANAGED_DEVICES_IOCTL);
+}
 
-	return ret;
+int cuddl_get_max_dev_mem_regions(void)
+{
+	return cuddli_manager_cached_limit(
+		&cuddli_session.max_dev_mem_regions,
+		CUDDLCI_GET_MAX_DEV_MEM_REGIONS_IOCTL);
 }
 
 int cuddl_get_max_dev_events(void)
 {
-	int fd;
-	int ret, ret2;
-	struct cuddlci_void_ioctl_data s;
-
-	fd = open("/dev/cuddl", O_RDWR);
-	if (fd == -1)
-		return -errno;
-
-	s.version_code = CUDDL_VERSION_CODE;
-
-	ret = ioctl(fd, CUDDLCI_GET_MAX_DEV_EVENTS_IOCTL, &s);
-	if ((ret == -1) && errno)
-		ret = -errno;
-
-	ret2 = close(fd);
-	if ((ret2 == -1) && (ret >= 0))
-		return -errno;
-
-	return ret;
+	return cuddli_manager_cached_limit(
+		&cuddli_session.max_dev_events,
+		CUDDLCI_GET_MAX_DEV_EVENTS_IOCTL);
 }
 
 /* Internal */
 static int _cuddl_get_driver_info_for_slot(
 	char *info_str, cuddl_size_t info_len, int device_slot)
 {
-	int fd;
 	int ret;
 	int len;
 	struct cuddlci_get_driver_info_ioctl_data s;
 
-	fd = open("/dev/cuddl", O_RDWR);
-	if (fd == -1)
-		return -errno;
-
 	s.version_code = CUDDL_VERSION_CODE;
 	s.device_slot = device_slot;
 
-	ret = ioctl(fd, CUDDLCI_GET_DRIVER_INFO_IOCTL, &s);
-	if (ret) {
-		if ((ret == -1) && errno)
-			ret = -errno;
-		close(fd);
+	ret = cuddli_manager_ioctl(CUDDLCI_GET_DRIVER_INFO_IOCTL, &s);
+	if (ret)
 		return ret;
-	}
 
 	if (info_len > CUDDLCI_MAX_STR_LEN) {
 		info_str[CUDDLCI_MAX_STR_LEN] = '\0';
@@ -779,10 +2642,6 @@ static int _cuddl_get_driver_info_for_slot(
 	}
 	strncpy(info_str, s.info_str, len);
 
-	ret = close(fd);
-	if (ret == -1)
-		return -errno;
-
 	return 0;
 }
 
@@ -790,25 +2649,16 @@ static int _cuddl_get_driver_info_for_slot(
 static int _cuddl_get_hw_info_for_slot(
 	char *info_str, cuddl_size_t info_len, int device_slot)
 {
-	int fd;
 	int ret;
 	int len;
 	struct cuddlci_get_driver_info_ioctl_data s;
 
-	fd = open("/dev/cuddl", O_RDWR);
-	if (fd == -1)
-		return -errno;
-
 	s.version_code = CUDDL_VERSION_CODE;
 	s.device_slot = device_slot;
 
-	ret = ioctl(fd, CUDDLCI_GET_HW_INFO_IOCTL, &s);
-	if (ret) {
-		if ((ret == -1) && errno)
-			ret = -errno;
-		close(fd);
+	ret = cuddli_manager_ioctl(CUDDLCI_GET_HW_INFO_IOCTL, &s);
+	if (ret)
 		return ret;
-	}
 
 	if (info_len > CUDDLCI_MAX_STR_LEN) {
 		info_str[CUDDLCI_MAX_STR_LEN] = '\0';
@@ -818,74 +2668,44 @@ static int _cuddl_get_hw_info_for_slot(
 	}
 	strncpy(info_str, s.info_str, len);
 
-	ret = close(fd);
-	if (ret == -1)
-		return -errno;
-
 	return 0;
 }
 
 int cuddl_get_memregion_id_for_slot(
 	struct cuddl_resource_id *id, int device_slot, int mem_slot)
 {
-	int fd;
 	int ret;
 	struct cuddlci_get_resource_id_ioctl_data s;
 
-	fd = open("/dev/cuddl", O_RDWR);
-	if (fd == -1)
-		return -errno;
-
 	s.version_code = CUDDL_VERSION_CODE;
 	s.device_slot = device_slot;
 	s.resource_slot = mem_slot;
 
-	ret = ioctl(fd, CUDDLCI_GET_MEMREGION_ID_IOCTL, &s);
-	if (ret) {
-		if ((ret == -1) && errno)
-			ret = -errno;
-		close(fd);
+	ret = cuddli_manager_ioctl(CUDDLCI_GET_MEMREGION_ID_IOCTL, &s);
+	if (ret)
 		return ret;
-	}
 
 	memcpy(id, &s.id, sizeof(*id));
 
-	ret = close(fd);
-	if (ret == -1)
-		return -errno;
-
 	return 0;
 }
 
 int cuddl_get_eventsrc_id_for_slot(
 	struct cuddl_resource_id *id, int device_slot, int event_slot)
 {
-	int fd;
 	int ret;
 	struct cuddlci_get_resource_id_ioctl_data s;
 
-	fd = open("/dev/cuddl", O_RDWR);
-	if (fd == -1)
-		return -errno;
-
 	s.version_code = CUDDL_VERSION_CODE;
 	s.device_slot = device_slot;
 	s.resource_slot = event_slot;
 
-	ret = ioctl(fd, CUDDLCI_GET_EVENTSRC_ID_IOCTL, &s);
-	if (ret) {
-		if ((ret == -1) && errno)
-			ret = -errno;
-		close(fd);
+	ret = cuddli_manager_ioctl(CUDDLCI_GET_EVENTSRC_ID_IOCTL, &s);
+	if (ret)
 		return ret;
-	}
 
 	memcpy(id, &s.id, sizeof(*id));
 
-	ret = close(fd);
-	if (ret == -1)
-		return -errno;
-
 	return 0;
 }
 
@@ -893,32 +2713,19 @@ int cuddl_get_memregion_info_for_id(
 	struct cuddl_memregion_info *meminfo,
 	const struct cuddl_resource_id *memregion_id)
 {
-	int fd;
 	int ret;
 	struct cuddlci_memregion_claim_ioctl_data s;
 
-	fd = open("/dev/cuddl", O_RDWR);
-	if (fd == -1)
-		return -errno;
-
 	s.version_code = CUDDL_VERSION_CODE;
 	memcpy(&s.id, memregion_id, sizeof(s.id));
 	s.pid = getpid();
 
-	ret = ioctl(fd, CUDDLCI_GET_MEMREGION_INFO_IOCTL, &s);
-	if (ret) {
-		if ((ret == -1) && errno)
-			ret = -errno;
-		close(fd);
+	ret = cuddli_manager_ioctl(CUDDLCI_GET_MEMREGION_INFO_IOCTL, &s);
+	if (ret)
 		return ret;
-	}
 
 	memcpy(meminfo, &s.info, sizeof(*meminfo));
 
-	ret = close(fd);
-	if (ret == -1)
-		return -errno;
-
 	return 0;
 }
 
@@ -926,56 +2733,32 @@ int cuddl_get_eventsrc_info_for_id(
 	struct cuddl_eventsrc_info *eventinfo,
 	const struct cuddl_resource_id *eventsrc_id)
 {
-	int fd;
 	int ret;
 	struct cuddlci_eventsrc_claim_ioctl_data s;
 
-	fd = open("/dev/cuddl", O_RDWR);
-	if (fd == -1)
-		return -errno;
-
 	s.version_code = CUDDL_VERSION_CODE;
 	memcpy(&s.id, eventsrc_id, sizeof(s.id));
 	s.pid = getpid();
 
-	ret = ioctl(fd, CUDDLCI_GET_EVENTSRC_INFO_IOCTL, &s);
-	if (ret) {
-		if ((ret == -1) && errno)
-			ret = -errno;
-		close(fd);
+	ret = cuddli_manager_ioctl(CUDDLCI_GET_EVENTSRC_INFO_IOCTL, &s);
+	if (ret)
 		return ret;
-	}
 
 	memcpy(eventinfo, &s.info, sizeof(*eventinfo));
 
-	ret = close(fd);
-	if (ret == -1)
-		return -errno;
-
 	return 0;
 }
 
 int cuddl_get_memregion_ref_count_for_id(
 	const struct cuddl_resource_id *memregion_id)
 {
-	int fd;
-	int ret, ret2;
+	int ret;
 	struct cuddlci_ref_count_ioctl_data s;
 
-	fd = open("/dev/cuddl", O_RDWR);
-	if (fd == -1)
-		return -errno;
-
 	s.version_code = CUDDL_VERSION_CODE;
 	memcpy(&s.id, memregion_id, sizeof(s.id));
 
-	ret = ioctl(fd, CUDDLCI_GET_MEMREGION_REF_COUNT_IOCTL, &s);
-	if ((ret == -1) && errno)
-		ret = -errno;
-
-	ret2 = close(fd);
-	if ((ret2 == -1) && (ret >= 0))
-		return -errno;
+	ret = cuddli_manager_ioctl(CUDDLCI_GET_MEMREGION_REF_COUNT_IOCTL, &s);
 
 	return ret;
 }
@@ -983,24 +2766,13 @@ int cuddl_get_memregion_ref_count_for_id(
 int cuddl_get_eventsrc_ref_count_for_id(
 	const struct cuddl_resource_id *eventsrc_id)
 {
-	int fd;
-	int ret, ret2;
+	int ret;
 	struct cuddlci_ref_count_ioctl_data s;
 
-	fd = open("/dev/cuddl", O_RDWR);
-	if (fd == -1)
-		return -errno;
-
 	s.version_code = CUDDL_VERSION_CODE;
 	memcpy(&s.id, eventsrc_id, sizeof(s.id));
 
-	ret = ioctl(fd, CUDDLCI_GET_EVENTSRC_REF_COUNT_IOCTL, &s);
-	if ((ret == -1) && errno)
-		ret = -errno;
-
-	ret2 = close(fd);
-	if ((ret2 == -1) && (ret >= 0))
-		return -errno;
+	ret = cuddli_manager_ioctl(CUDDLCI_GET_EVENTSRC_REF_COUNT_IOCTL, &s);
 
 	return ret;
 }
@@ -1008,25 +2780,13 @@ int cuddl_get_eventsrc_ref_count_for_id(
 int cuddl_decrement_memregion_ref_count_for_id(
 	const struct cuddl_resource_id *memregion_id)
 {
-	int fd;
-	int ret, ret2;
+	int ret;
 	struct cuddlci_ref_count_ioctl_data s;
 
-	fd = open("/dev/cuddl", O_RDWR);
-	if (fd == -1)
-		return -errno;
-
 	s.version_code = CUDDL_VERSION_CODE;
 	memcpy(&s.id, memregion_id, sizeof(s.id));
 
-	ret = ioctl(
-		fd, CUDDLCI_DECREMENT_MEMREGION_REF_COUNT_IOCTL, &s);
-	if ((ret == -1) && errno)
-		ret = -errno;
-
-	ret2 = close(fd);
-	if ((ret2 == -1) && (ret >= 0))
-		return -errno;
+	ret = cuddli_manager_ioctl(CUDDLCI_DECREMENT_MEMREGION_REF_COUNT_IOCTL, &s);
 
 	return ret;
 }
@@ -1034,24 +2794,13 @@ int cuddl_decrement_memregion_ref_count_for_id(
 int cuddl_decrement_eventsrc_ref_count_for_id(
 	const struct cuddl_resource_id *eventsrc_id)
 {
-	int fd;
-	int ret, ret2;
+	int ret;
 	struct cuddlci_ref_count_ioctl_data s;
 
-	fd = open("/dev/cuddl", O_RDWR);
-	if (fd == -1)
-		return -errno;
-
 	s.version_code = CUDDL_VERSION_CODE;
 	memcpy(&s.id, eventsrc_id, sizeof(s.id));
 
-	ret = ioctl(fd, CUDDLCI_DECREMENT_EVENTSRC_REF_COUNT_IOCTL, &s);
-	if ((ret == -1) && errno)
-		ret = -errno;
-
-	ret2 = close(fd);
-	if ((ret2 == -1) && (ret >= 0))
-		return -errno;
+	ret = cuddli_manager_ioctl(CUDDLCI_DECREMENT_EVENTSRC_REF_COUNT_IOCTL, &s);
 
 	return ret;
 }
@@ -1148,6 +2897,143 @@ int cuddl_get_eventsrc_id_for_match(
 		info.priv.token.resource_index);
 }
 
+/* Number of entries available to software for a given remote index. */
+static uint32_t cuddli_ring_avail(
+	const struct cuddl_ring *ring, uint32_t remote)
+{
+	uint32_t n = ring->n_entries;
+
+	if (ring->role == CUDDL_RING_CONSUMER)
+		return (remote + n - ring->local) % n;
+	else
+		return (remote + n - ring->local - 1) % n;
+}
+
+int cuddl_ring_init(
+	struct cuddl_ring *ring,
+	int role,
+	const struct cuddl_memregion *memregion,
+	cuddl_size_t offset,
+	cuddl_size_t entry_size,
+	uint32_t n_entries,
+	cuddl_iomem_t *remote_index,
+	cuddl_iomem_t *local_index,
+	struct cuddl_eventsrc *eventsrc)
+{
+	uint32_t local = 0;
+
+	if ((role != CUDDL_RING_CONSUMER) && (role != CUDDL_RING_PRODUCER))
+		return -EINVAL;
+
+	if ((entry_size == 0) || (n_entries < 2) || !remote_index)
+		return -EINVAL;
+
+	if ((offset > memregion->len) ||
+	    ((memregion->len - offset) / entry_size < n_entries))
+		return -ERANGE;
+
+	if (local_index) {
+		local = cuddl_ioread32(local_index);
+		if (local >= n_entries)
+			return -EINVAL;
+	}
+
+	ring->entries = (uint8_t *) memregion->addr + offset;
+	ring->entry_size = entry_size;
+	ring->n_entries = n_entries;
+	ring->role = role;
+	ring->remote_index = remote_index;
+	ring->local_index = local_index;
+	ring->eventsrc = eventsrc;
+	ring->local = local;
+	ring->acquired = 0;
+
+	/*
+	 * Start with a cached remote index that makes no entries available,
+	 * so that the first acquire operation reads the index register.
+	 */
+	if (role == CUDDL_RING_CONSUMER)
+		ring->remote = local;
+	else
+		ring->remote = (local + 1) % n_entries;
+
+	return 0;
+}
+
+int cuddl_ring_acquire(
+	struct cuddl_ring *ring, struct cuddl_ring_batch *batch)
+{
+	uint32_t avail;
+	uint32_t remote;
+	uint32_t first;
+
+	avail = cuddli_ring_avail(ring, ring->remote);
+	if (avail == 0) {
+		remote = cuddl_ioread32(ring->remote_index);
+		if (remote >= ring->n_entries)
+			return -EIO;
+		/* Don't let entry accesses get ahead of the index read */
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		ring->remote = remote;
+		avail = cuddli_ring_avail(ring, remote);
+	}
+
+	first = ring->n_entries - ring->local;
+	if (first > avail)
+		first = avail;
+
+	batch->span[0].addr = ring->entries + ring->local * ring->entry_size;
+	batch->span[0].index = ring->local;
+	batch->span[0].count = first;
+	batch->span[1].addr = ring->entries;
+	batch->span[1].index = 0;
+	batch->span[1].count = avail - first;
+	batch->count = avail;
+
+	ring->acquired = avail;
+
+	return avail;
+}
+
+int cuddl_ring_wait(
+	struct cuddl_ring *ring, struct cuddl_ring_batch *batch)
+{
+	int ret;
+
+	if (!ring->eventsrc)
+		return -EINVAL;
+
+	for (;;) {
+		ret = cuddl_ring_acquire(ring, batch);
+		if (ret != 0)
+			return ret;
+
+		ret = cuddl_eventsrc_wait(ring->eventsrc);
+		if (ret < 0)
+			return ret;
+	}
+}
+
+int cuddl_ring_release(struct cuddl_ring *ring, uint32_t count)
+{
+	if (count > ring->acquired)
+		return -EINVAL;
+
+	if (count == 0)
+		return 0;
+
+	ring->local = (ring->local + count) % ring->n_entries;
+	ring->acquired -= count;
+
+	if (ring->local_index) {
+		/* Finish all entry accesses before handing entries back */
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+		cuddl_iowrite32(ring->local, ring->local_index);
+	}
+
+	return 0;
+}
+
 int cuddli_open_janitor(void)
 {
 	const char *janitor_dev_name = "/dev/cuddl_janitor";
@@ -1200,18 +3086,12 @@ int cuddli_close_janitor(int fd)
 	return ret;
 }
 
-__attribute__((constructor)) void cuddl_startup(void)
-{
-	cuddli_janitor_fd = cuddli_open_janitor();
-	if (cuddli_janitor_fd == -1) {
-		/*
-		printf("warning: could not open janitor device\n");
-		*/
-		return;
-	}
-}
-
 __attribute__((destructor)) void cuddl_cleanup(void)
 {
-	cuddli_close_janitor(cuddli_janitor_fd);
+	pthread_mutex_lock(&cuddli_session_mutex);
+	cuddli_session_close_manager(&cuddli_session);
+	cuddli_close_janitor(cuddli_session.janitor_fd);
+	cuddli_session.janitor_fd = -1;
+	cuddli_session.janitor_pid = 0;
+	pthread_mutex_unlock(&cuddli_session_mutex);
 }
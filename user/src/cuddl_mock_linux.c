@@ -0,0 +1,1279 @@
+/* SPDX-License-Identifier: (MIT OR GPL-2.0-or-later) */
+/*
+ * Cross-platform user-space device driver layer mock backend (Linux).
+ *
+ * Copyright (C) 2022 Jeff Webb <jeff.webb@codecraftsmen.org>
+ *
+ * This software is dual-licensed and is made available under the terms of
+ * the MIT License or under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.  You may select (at your
+ * option) either of the licenses listed above.  See the LICENSE.MIT and
+ * LICENSE.GPL-2.0 files in the top-level directory of this distribution for
+ * copyright information and license terms.
+ */
+
+/*
+ * In-process implementation of the Cuddl device manager, used in place of
+ * the kernel modules when the user-space library is compiled with
+ * CUDDLI_ENABLE_MOCK.  See cuddl/mock.h for the user-visible behavior.
+ *
+ * The "manager device" handed to cuddl_linux.c is a memfd holding one
+ * status page per event source slot, laid out exactly like the kernel's, so
+ * the status page fast paths work unchanged.  Memory regions are separate
+ * memfds.  Each open of an event source gets its own eventfd, and an
+ * fd-indexed table maps eventfds back to their event sources so that the
+ * read()/write() hooks cost a single array lookup.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* memfd_create() */
+#endif
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <time.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include <cuddl.h>
+#include <cuddl/mock.h>
+#include <cuddl/common_impl_linux_ioctl.h>
+
+/* These match the kernel defaults so that slot numbers are realistic */
+#define CUDDLI_MOCK_MAX_DEVICES 256
+#define CUDDLI_MOCK_MAX_DEV_MEM_REGIONS 5
+#define CUDDLI_MOCK_MAX_DEV_EVENTS 4
+
+/* Event source file descriptors must be below this value */
+#define CUDDLI_MOCK_MAX_FDS 4096
+
+/* Maximum number of simultaneous opens of a single event source */
+#define CUDDLI_MOCK_MAX_LISTENERS 16
+
+struct cuddli_mock_memregion {
+	char name[CUDDL_MAX_STR_LEN];
+	cuddl_size_t len;
+	size_t pa_len;
+	int flags;
+	int fd;
+	void *addr;
+	int ref_count;
+};
+
+struct cuddli_mock_eventsrc {
+	char name[CUDDL_MAX_STR_LEN];
+	int flags;
+	int ref_count;
+	int enabled;
+	int pending;
+	struct cuddlci_eventsrc_status *status;
+	int n_listeners;
+	int listeners[CUDDLI_MOCK_MAX_LISTENERS];
+};
+
+struct cuddli_mock_device {
+	char group[CUDDL_MAX_STR_LEN];
+	char name[CUDDL_MAX_STR_LEN];
+	int instance;
+	char driver_info[CUDDL_MAX_STR_LEN];
+	char hw_info[CUDDL_MAX_STR_LEN];
+	struct cuddli_mock_memregion mem[CUDDLI_MOCK_MAX_DEV_MEM_REGIONS];
+	struct cuddli_mock_eventsrc events[CUDDLI_MOCK_MAX_DEV_EVENTS];
+};
+
+/*
+ * Mock manager state.  The mutex protects everything except fd_table,
+ * which is read without locking on the event source read()/write() paths.
+ */
+struct cuddli_mock {
+	int status_fd;
+	char *status_pages;
+	size_t page_size;
+	int config_checked;
+	struct cuddli_mock_device *devices[CUDDLI_MOCK_MAX_DEVICES];
+	struct cuddli_mock_eventsrc *fd_table[CUDDLI_MOCK_MAX_FDS];
+};
+
+static struct cuddli_mock cuddli_mock = {
+	.status_fd = -1,
+};
+
+static pthread_mutex_t cuddli_mock_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void cuddli_mock_copy_str(char *dst, const char *src)
+{
+	if (src)
+		strncpy(dst, src, CUDDL_MAX_STR_LEN-1);
+	else
+		strncpy(dst, "UNKNOWN", CUDDL_MAX_STR_LEN-1);
+	dst[CUDDL_MAX_STR_LEN-1] = '\0';
+}
+
+static inline int cuddli_mock_str_matches(const char *pattern, const char *s)
+{
+	return (pattern[0] == '\0') ||
+		(strncmp(pattern, s, CUDDL_MAX_STR_LEN) == 0);
+}
+
+/* Must be called with cuddli_mock_mutex held */
+static int cuddli_mock_init_status(void)
+{
+	int fd;
+	size_t len;
+	void *addr;
+
+	if (cuddli_mock.status_pages)
+		return 0;
+
+	cuddli_mock.page_size = sysconf(_SC_PAGESIZE);
+	len = cuddli_mock.page_size *
+		CUDDLI_MOCK_MAX_DEVICES * CUDDLI_MOCK_MAX_DEV_EVENTS;
+
+	fd = memfd_create("cuddl-mock-status", MFD_CLOEXEC);
+	if (fd < 0)
+		return -errno;
+
+	if (ftruncate(fd, len) == -1) {
+		int ret = -errno;
+		close(fd);
+		return ret;
+	}
+
+	addr = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (addr == MAP_FAILED) {
+		int ret = -errno;
+		close(fd);
+		return ret;
+	}
+
+	cuddli_mock.status_fd = fd;
+	cuddli_mock.status_pages = addr;
+
+	return 0;
+}
+
+/*
+ * Update an event source status page.  Readers retry while the sequence
+ * counter is odd or changes, as for the kernel's status page.  Must be
+ * called with cuddli_mock_mutex held.
+ */
+static void cuddli_mock_write_status(
+	struct cuddlci_eventsrc_status *status,
+	int32_t enabled, uint64_t event_seq, uint64_t timestamp_ns)
+{
+	uint32_t seq = status->sequence;
+
+	__atomic_store_n(&status->sequence, seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	__atomic_store_n(&status->enabled, enabled, __ATOMIC_RELAXED);
+	__atomic_store_n(&status->event_seq, event_seq, __ATOMIC_RELAXED);
+	__atomic_store_n(
+		&status->timestamp_ns, timestamp_ns, __ATOMIC_RELAXED);
+	__atomic_store_n(&status->sequence, seq + 2, __ATOMIC_RELEASE);
+}
+
+/* Must be called with cuddli_mock_mutex held */
+static void cuddli_mock_deliver(struct cuddli_mock_eventsrc *src)
+{
+	struct timespec ts;
+	uint64_t one = 1;
+	ssize_t ret;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	cuddli_mock_write_status(
+		src->status, src->enabled, src->status->event_seq + 1,
+		ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+
+	for (int i=0; i<src->n_listeners; i++) {
+		ret = write(src->listeners[i], &one, sizeof(one));
+		(void) ret; /* The counter cannot overflow in practice */
+	}
+}
+
+/* Must be called with cuddli_mock_mutex held */
+static void cuddli_mock_set_enabled(
+	struct cuddli_mock_eventsrc *src, int enabled)
+{
+	src->enabled = enabled;
+	cuddli_mock_write_status(
+		src->status, enabled, src->status->event_seq,
+		src->status->timestamp_ns);
+
+	if (enabled && src->pending) {
+		src->pending = 0;
+		cuddli_mock_deliver(src);
+	}
+}
+
+/* Must be called with cuddli_mock_mutex held */
+static struct cuddli_mock_device *cuddli_mock_get_device(int slot)
+{
+	if ((slot < 0) || (slot >= CUDDLI_MOCK_MAX_DEVICES))
+		return NULL;
+	return cuddli_mock.devices[slot];
+}
+
+/* Must be called with cuddli_mock_mutex held */
+static struct cuddli_mock_memregion *cuddli_mock_get_memregion(
+	int slot, int mslot)
+{
+	struct cuddli_mock_device *dev = cuddli_mock_get_device(slot);
+
+	if (!dev || (mslot < 0) || (mslot >= CUDDLI_MOCK_MAX_DEV_MEM_REGIONS))
+		return NULL;
+	if (dev->mem[mslot].fd < 0)
+		return NULL;
+	return &dev->mem[mslot];
+}
+
+/* Must be called with cuddli_mock_mutex held */
+static struct cuddli_mock_eventsrc *cuddli_mock_get_eventsrc(
+	int slot, int eslot)
+{
+	struct cuddli_mock_device *dev = cuddli_mock_get_device(slot);
+
+	if (!dev || (eslot < 0) || (eslot >= CUDDLI_MOCK_MAX_DEV_EVENTS))
+		return NULL;
+	if (!dev->events[eslot].status)
+		return NULL;
+	return &dev->events[eslot];
+}
+
+static int cuddli_mock_find_memregion_slot(
+	struct cuddli_mock_device *dev, const char *name)
+{
+	for (int i=0; i<CUDDLI_MOCK_MAX_DEV_MEM_REGIONS; i++) {
+		if ((dev->mem[i].fd >= 0) &&
+		    cuddli_mock_str_matches(name, dev->mem[i].name))
+			return i;
+	}
+	return -ENXIO;
+}
+
+static int cuddli_mock_find_eventsrc_slot(
+	struct cuddli_mock_device *dev, const char *name)
+{
+	for (int i=0; i<CUDDLI_MOCK_MAX_DEV_EVENTS; i++) {
+		if (dev->events[i].status &&
+		    cuddli_mock_str_matches(name, dev->events[i].name))
+			return i;
+	}
+	return -ENXIO;
+}
+
+/*
+ * Find the first device at or after start_index matching the given resource
+ * identifier, using the same wildcard rules as the kernel device manager.
+ * Must be called with cuddli_mock_mutex held.
+ */
+static int cuddli_mock_find_device_slot_matching(
+	const struct cuddl_resource_id *id, int type, int start_index)
+{
+	struct cuddli_mock_device *dev;
+
+	for (int i=start_index; i<CUDDLI_MOCK_MAX_DEVICES; i++) {
+		dev = cuddli_mock.devices[i];
+		if (!dev)
+			continue;
+		if (id->instance && (dev->instance != id->instance))
+			continue;
+		if (!cuddli_mock_str_matches(id->group, dev->group))
+			continue;
+		if (!cuddli_mock_str_matches(id->device, dev->name))
+			continue;
+		if ((type == CUDDL_RESOURCE_MEMREGION) &&
+		    (cuddli_mock_find_memregion_slot(dev, id->resource) < 0))
+			continue;
+		if ((type == CUDDL_RESOURCE_EVENTSRC) &&
+		    (cuddli_mock_find_eventsrc_slot(dev, id->resource) < 0))
+			continue;
+		return i;
+	}
+
+	return -ENXIO;
+}
+
+static void cuddli_mock_fill_memregion_info(
+	struct cuddl_memregion_info *info, int slot, int mslot)
+{
+	struct cuddli_mock_device *dev = cuddli_mock.devices[slot];
+	struct cuddli_mock_memregion *mem = &dev->mem[mslot];
+
+	memset(info, 0, sizeof(*info));
+	info->len = mem->len;
+	/*
+	 * Mock memory regions are backed by RAM, so they are always cached.
+	 * DMA buffers report their backing address as the bus address.
+	 */
+	info->flags = mem->flags & (CUDDL_MEMF_SHARED | CUDDL_MEMF_DMA);
+	if (mem->flags & CUDDL_MEMF_DMA)
+		info->priv.dma_addr = (uintptr_t) mem->addr;
+	else
+		info->flags |= CUDDL_MEMF_MAP_CACHED;
+	info->priv.token.device_index = slot;
+	info->priv.token.resource_index = mslot;
+	info->priv.pa_mmap_offset = 0;
+	info->priv.pa_len = mem->pa_len;
+	info->priv.start_offset = 0;
+	snprintf(info->priv.device_name, CUDDLCI_MAX_STR_LEN,
+		 "mock:%.64s.%.64s.%d:%.64s", dev->group, dev->name, dev->instance,
+		 mem->name);
+}
+
+static void cuddli_mock_fill_eventsrc_info(
+	struct cuddl_eventsrc_info *info, int slot, int eslot)
+{
+	struct cuddli_mock_device *dev = cuddli_mock.devices[slot];
+	struct cuddli_mock_eventsrc *src = &dev->events[eslot];
+
+	memset(info, 0, sizeof(*info));
+	info->flags = (src->flags & CUDDL_EVENTSRCF_SHARED) |
+		CUDDL_EVENTSRCF_WAITABLE |
+		CUDDL_EVENTSRCF_HAS_ENABLE |
+		CUDDL_EVENTSRCF_HAS_DISABLE |
+		CUDDL_EVENTSRCF_HAS_IS_ENABLED;
+	info->priv.token.device_index = slot;
+	info->priv.token.resource_index = eslot;
+	info->priv.status_mmap_offset =
+		(slot * CUDDLI_MOCK_MAX_DEV_EVENTS + eslot) *
+		cuddli_mock.page_size;
+	snprintf(info->priv.device_name, CUDDLCI_MAX_STR_LEN,
+		 "mock:%.64s.%.64s.%d:%.64s", dev->group, dev->name, dev->instance,
+		 src->name);
+}
+
+static int cuddli_mock_claim_ref(int *ref_count, int shared, int hostile)
+{
+	if ((*ref_count > 0) && !shared && !hostile)
+		return -EBUSY;
+	*ref_count += 1;
+	return 0;
+}
+
+static int cuddli_mock_decr_ref(int *ref_count)
+{
+	if (*ref_count == 0)
+		return -ENOSPC;
+	*ref_count -= 1;
+	return 0;
+}
+
+/*
+ * Claim the resource matching a resource identifier.  If skip_busy is set,
+ * a busy match moves on to the next matching device (as for batch claims).
+ * Must be called with cuddli_mock_mutex held.
+ */
+static int cuddli_mock_claim(
+	const struct cuddl_resource_id *id, int type, int options,
+	int skip_busy, int *slot_out, int *rslot_out)
+{
+	struct cuddli_mock_device *dev;
+	int slot;
+	int rslot;
+	int start = 0;
+	int ret = -ENXIO;
+
+	while (start < CUDDLI_MOCK_MAX_DEVICES) {
+		slot = cuddli_mock_find_device_slot_matching(id, type, start);
+		if (slot < 0)
+			return (ret == -EBUSY) ? ret : slot;
+		dev = cuddli_mock.devices[slot];
+		start = slot + 1;
+
+		if (type == CUDDL_RESOURCE_MEMREGION) {
+			rslot = cuddli_mock_find_memregion_slot(
+				dev, id->resource);
+			ret = cuddli_mock_claim_ref(
+				&dev->mem[rslot].ref_count,
+				dev->mem[rslot].flags & CUDDL_MEMF_SHARED,
+				options & CUDDL_MEM_CLAIMF_HOSTILE);
+		} else {
+			rslot = cuddli_mock_find_eventsrc_slot(
+				dev, id->resource);
+			ret = cuddli_mock_claim_ref(
+				&dev->events[rslot].ref_count,
+				dev->events[rslot].flags &
+				CUDDL_EVENTSRCF_SHARED,
+				options & CUDDL_EVENTSRC_CLAIMF_HOSTILE);
+		}
+		if ((ret == -EBUSY) && skip_busy)
+			continue;
+		if (ret)
+			return ret;
+
+		*slot_out = slot;
+		*rslot_out = rslot;
+		return 0;
+	}
+
+	return ret;
+}
+
+/* Must be called with cuddli_mock_mutex held */
+static int cuddli_mock_release(struct cuddlci_token token, int type)
+{
+	struct cuddli_mock_memregion *mem;
+	struct cuddli_mock_eventsrc *src;
+
+	if (type == CUDDL_RESOURCE_MEMREGION) {
+		mem = cuddli_mock_get_memregion(
+			token.device_index, token.resource_index);
+		if (!mem)
+			return -ENODEV;
+		return cuddli_mock_decr_ref(&mem->ref_count);
+	}
+
+	src = cuddli_mock_get_eventsrc(
+		token.device_index, token.resource_index);
+	if (!src)
+		return -ENODEV;
+	return cuddli_mock_decr_ref(&src->ref_count);
+}
+
+/* Must be called with cuddli_mock_mutex held */
+static int cuddli_mock_claim_batch(struct cuddlci_claim_batch_ioctl_data *b)
+{
+	struct cuddlci_claim_batch_entry *entries;
+	struct cuddlci_claim_batch_entry *e;
+	int n_claimed;
+	int slot;
+	int rslot;
+	int ret = 0;
+
+	if ((b->count <= 0) || (b->count > CUDDLCI_MAX_CLAIM_BATCH))
+		return -EINVAL;
+	entries = (struct cuddlci_claim_batch_entry *) (uintptr_t) b->entries;
+
+	b->failed_index = -1;
+	for (n_claimed = 0; n_claimed < b->count; n_claimed++) {
+		e = &entries[n_claimed];
+		if ((e->type != CUDDL_RESOURCE_MEMREGION) &&
+		    (e->type != CUDDL_RESOURCE_EVENTSRC))
+			ret = -EINVAL;
+		else
+			ret = cuddli_mock_claim(
+				&e->id, e->type, e->options, 1, &slot, &rslot);
+		e->result = ret;
+		if (ret) {
+			b->failed_index = n_claimed;
+			break;
+		}
+		if (e->type == CUDDL_RESOURCE_MEMREGION)
+			cuddli_mock_fill_memregion_info(
+				&e->info.mem, slot, rslot);
+		else
+			cuddli_mock_fill_eventsrc_info(
+				&e->info.event, slot, rslot);
+	}
+
+	if (!ret)
+		return 0;
+
+	for (int i = n_claimed - 1; i >= 0; i--) {
+		e = &entries[i];
+		cuddli_mock_release(
+			(e->type == CUDDL_RESOURCE_MEMREGION) ?
+			e->info.mem.priv.token : e->info.event.priv.token,
+			e->type);
+	}
+	for (int i = 0; i < b->count; i++)
+		if (i != b->failed_index)
+			entries[i].result = -ECANCELED;
+
+	return ret;
+}
+
+/* Must be called with cuddli_mock_mutex held */
+static int cuddli_mock_get_ref_count(
+	const struct cuddl_resource_id *id, int type, int decrement)
+{
+	struct cuddli_mock_device *dev;
+	int slot;
+	int rslot;
+	int *ref_count;
+
+	slot = cuddli_mock_find_device_slot_matching(id, type, 0);
+	if (slot < 0)
+		return slot;
+	dev = cuddli_mock.devices[slot];
+
+	if (type == CUDDL_RESOURCE_MEMREGION) {
+		rslot = cuddli_mock_find_memregion_slot(dev, id->resource);
+		ref_count = &dev->mem[rslot].ref_count;
+	} else {
+		rslot = cuddli_mock_find_eventsrc_slot(dev, id->resource);
+		ref_count = &dev->events[rslot].ref_count;
+	}
+
+	if (decrement)
+		return cuddli_mock_decr_ref(ref_count);
+	return *ref_count;
+}
+
+/* Must be called with cuddli_mock_mutex held */
+static int cuddli_mock_get_resource_id(
+	struct cuddlci_get_resource_id_ioctl_data *s, int type)
+{
+	struct cuddli_mock_device *dev;
+	const char *name;
+
+	if ((s->device_slot < 0) ||
+	    (s->device_slot >= CUDDLI_MOCK_MAX_DEVICES))
+		return -EBADSLT;
+	dev = cuddli_mock.devices[s->device_slot];
+
+	if (type == CUDDL_RESOURCE_MEMREGION) {
+		if ((s->resource_slot < 0) ||
+		    (s->resource_slot >= CUDDLI_MOCK_MAX_DEV_MEM_REGIONS))
+			return -EBADSLT;
+		if (!dev)
+			return -ENODEV;
+		if (dev->mem[s->resource_slot].fd < 0)
+			return -EINVAL;
+		name = dev->mem[s->resource_slot].name;
+	} else {
+		if ((s->resource_slot < 0) ||
+		    (s->resource_slot >= CUDDLI_MOCK_MAX_DEV_EVENTS))
+			return -EBADSLT;
+		if (!dev)
+			return -ENODEV;
+		if (!dev->events[s->resource_slot].status)
+			return -EINVAL;
+		name = dev->events[s->resource_slot].name;
+	}
+
+	memcpy(s->id.group, dev->group, CUDDL_MAX_STR_LEN);
+	memcpy(s->id.device, dev->name, CUDDL_MAX_STR_LEN);
+	memcpy(s->id.resource, name, CUDDL_MAX_STR_LEN);
+	s->id.instance = dev->instance;
+
+	return 0;
+}
+
+/* Must be called with cuddli_mock_mutex held */
+static int cuddli_mock_get_info_str(
+	struct cuddlci_get_driver_info_ioctl_data *s, int hw)
+{
+	struct cuddli_mock_device *dev;
+
+	if ((s->device_slot < 0) ||
+	    (s->device_slot >= CUDDLI_MOCK_MAX_DEVICES))
+		return -EBADSLT;
+	dev = cuddli_mock.devices[s->device_slot];
+	if (!dev)
+		return -ENODEV;
+
+	memcpy(s->info_str, hw ? dev->hw_info : dev->driver_info,
+	       CUDDLCI_MAX_STR_LEN);
+
+	return 0;
+}
+
+/* Must be called with cuddli_mock_mutex held */
+static int cuddli_mock_dispatch(unsigned long request, void *arg)
+{
+	struct cuddlci_memregion_claim_ioctl_data *mdata = arg;
+	struct cuddlci_eventsrc_claim_ioctl_data *edata = arg;
+	struct cuddlci_memregion_release_ioctl_data *mrdata = arg;
+	struct cuddlci_eventsrc_release_ioctl_data *erdata = arg;
+	struct cuddlci_ref_count_ioctl_data *id_data = arg;
+	struct cuddlci_get_kernel_commit_id_ioctl_data *commit_data = arg;
+	struct cuddlci_eventsrc_is_enabled_ioctl_data *is_enabled_data = arg;
+	struct cuddlci_eventsrc_get_record_ioctl_data *rdata = arg;
+	struct cuddli_mock_eventsrc *src;
+	int slot;
+	int rslot;
+	int ret;
+
+	switch (request) {
+	case CUDDLCI_MEMREGION_CLAIM_UIO_IOCTL:
+	case CUDDLCI_MEMREGION_CLAIM_UDD_IOCTL:
+		ret = cuddli_mock_claim(
+			&mdata->id, CUDDL_RESOURCE_MEMREGION, mdata->options, 0,
+			&slot, &rslot);
+		if (ret)
+			return ret;
+		cuddli_mock_fill_memregion_info(&mdata->info, slot, rslot);
+		return 0;
+
+	case CUDDLCI_GET_MEMREGION_INFO_IOCTL:
+		slot = cuddli_mock_find_device_slot_matching(
+			&mdata->id, CUDDL_RESOURCE_MEMREGION, 0);
+		if (slot < 0)
+			return slot;
+		rslot = cuddli_mock_find_memregion_slot(
+			cuddli_mock.devices[slot], mdata->id.resource);
+		cuddli_mock_fill_memregion_info(&mdata->info, slot, rslot);
+		return 0;
+
+	case CUDDLCI_EVENTSRC_CLAIM_UIO_IOCTL:
+	case CUDDLCI_EVENTSRC_CLAIM_UDD_IOCTL:
+		ret = cuddli_mock_claim(
+			&edata->id, CUDDL_RESOURCE_EVENTSRC, edata->options, 0,
+			&slot, &rslot);
+		if (ret)
+			return ret;
+		cuddli_mock_fill_eventsrc_info(&edata->info, slot, rslot);
+		return 0;
+
+	case CUDDLCI_GET_EVENTSRC_INFO_IOCTL:
+		slot = cuddli_mock_find_device_slot_matching(
+			&edata->id, CUDDL_RESOURCE_EVENTSRC, 0);
+		if (slot < 0)
+			return slot;
+		rslot = cuddli_mock_find_eventsrc_slot(
+			cuddli_mock.devices[slot], edata->id.resource);
+		cuddli_mock_fill_eventsrc_info(&edata->info, slot, rslot);
+		return 0;
+
+	case CUDDLCI_MEMREGION_RELEASE_UIO_IOCTL:
+	case CUDDLCI_MEMREGION_RELEASE_UDD_IOCTL:
+		return cuddli_mock_release(
+			mrdata->token, CUDDL_RESOURCE_MEMREGION);
+
+	case CUDDLCI_EVENTSRC_RELEASE_UIO_IOCTL:
+	case CUDDLCI_EVENTSRC_RELEASE_UDD_IOCTL:
+		return cuddli_mock_release(
+			erdata->token, CUDDL_RESOURCE_EVENTSRC);
+
+	case CUDDLCI_CLAIM_BATCH_UIO_IOCTL:
+	case CUDDLCI_CLAIM_BATCH_UDD_IOCTL:
+		return cuddli_mock_claim_batch(arg);
+
+	case CUDDLCI_GET_MAX_MANAGED_DEVICES_IOCTL:
+		return CUDDLI_MOCK_MAX_DEVICES;
+
+	case CUDDLCI_GET_MAX_DEV_MEM_REGIONS_IOCTL:
+		return CUDDLI_MOCK_MAX_DEV_MEM_REGIONS;
+
+	case CUDDLCI_GET_MAX_DEV_EVENTS_IOCTL:
+		return CUDDLI_MOCK_MAX_DEV_EVENTS;
+
+	case CUDDLCI_GET_MEMREGION_ID_IOCTL:
+		return cuddli_mock_get_resource_id(
+			arg, CUDDL_RESOURCE_MEMREGION);
+
+	case CUDDLCI_GET_EVENTSRC_ID_IOCTL:
+		return cuddli_mock_get_resource_id(
+			arg, CUDDL_RESOURCE_EVENTSRC);
+
+	case CUDDLCI_GET_MEMREGION_REF_COUNT_IOCTL:
+		return cuddli_mock_get_ref_count(
+			&id_data->id, CUDDL_RESOURCE_MEMREGION, 0);
+
+	case CUDDLCI_GET_EVENTSRC_REF_COUNT_IOCTL:
+		return cuddli_mock_get_ref_count(
+			&id_data->id, CUDDL_RESOURCE_EVENTSRC, 0);
+
+	case CUDDLCI_DECREMENT_MEMREGION_REF_COUNT_IOCTL:
+		return cuddli_mock_get_ref_count(
+			&id_data->id, CUDDL_RESOURCE_MEMREGION, 1);
+
+	case CUDDLCI_DECREMENT_EVENTSRC_REF_COUNT_IOCTL:
+		return cuddli_mock_get_ref_count(
+			&id_data->id, CUDDL_RESOURCE_EVENTSRC, 1);
+
+	case CUDDLCI_GET_KERNEL_COMMIT_ID_IOCTL:
+		return cuddl_get_userspace_commit_id(
+			commit_data->id_str, CUDDLCI_MAX_STR_LEN);
+
+	case CUDDLCI_GET_KERNEL_VARIANT_IOCTL:
+		strncpy(commit_data->id_str, "MOCK", CUDDLCI_MAX_STR_LEN);
+		return 0;
+
+	case CUDDLCI_GET_DRIVER_INFO_IOCTL:
+		return cuddli_mock_get_info_str(arg, 0);
+
+	case CUDDLCI_GET_HW_INFO_IOCTL:
+		return cuddli_mock_get_info_str(arg, 1);
+
+	case CUDDLCI_GET_KERNEL_VERSION_CODE_IOCTL:
+		return CUDDL_VERSION_CODE;
+
+	case CUDDLCI_EVENTSRC_IS_ENABLED_IOCTL:
+		src = cuddli_mock_get_eventsrc(
+			is_enabled_data->token.device_index,
+			is_enabled_data->token.resource_index);
+		if (!src)
+			return -ENODEV;
+		return src->enabled;
+
+	case CUDDLCI_EVENTSRC_GET_RECORD_IOCTL:
+		src = cuddli_mock_get_eventsrc(
+			rdata->token.device_index, rdata->token.resource_index);
+		if (!src)
+			return -ENODEV;
+		rdata->seq = src->status->event_seq;
+		rdata->timestamp_ns = src->status->timestamp_ns;
+		return 0;
+
+	default:
+		return -ENOSYS;
+	}
+}
+
+int cuddli_mock_manager_open(void)
+{
+	const char *config;
+	int fd;
+	int ret;
+	int load = 0;
+
+	pthread_mutex_lock(&cuddli_mock_mutex);
+	if (!cuddli_mock.config_checked) {
+		cuddli_mock.config_checked = 1;
+		load = 1;
+		for (int i=0; i<CUDDLI_MOCK_MAX_DEVICES; i++)
+			if (cuddli_mock.devices[i])
+				load = 0;
+	}
+	pthread_mutex_unlock(&cuddli_mock_mutex);
+
+	config = getenv("CUDDL_MOCK_CONFIG");
+	if (load && config) {
+		ret = cuddl_mock_load_config(config);
+		if (ret) {
+			fprintf(stderr, "cuddl: cannot load mock config %s: "
+				"%s\n", config, strerror(-ret));
+			errno = -ret;
+			return -1;
+		}
+	}
+
+	pthread_mutex_lock(&cuddli_mock_mutex);
+	ret = cuddli_mock_init_status();
+	if (ret == 0)
+		ret = fcntl(cuddli_mock.status_fd, F_DUPFD_CLOEXEC, 0);
+	else
+		errno = -ret;
+	fd = ret;
+	pthread_mutex_unlock(&cuddli_mock_mutex);
+
+	return (fd < 0) ? -1 : fd;
+}
+
+int cuddli_mock_manager_ioctl(int fd, unsigned long request, void *arg)
+{
+	int ret;
+
+	(void) fd;
+
+	pthread_mutex_lock(&cuddli_mock_mutex);
+	ret = cuddli_mock_dispatch(request, arg);
+	pthread_mutex_unlock(&cuddli_mock_mutex);
+
+	if (ret < 0) {
+		errno = -ret;
+		return -1;
+	}
+	return ret;
+}
+
+int cuddli_mock_memregion_open(struct cuddlci_token token)
+{
+	struct cuddli_mock_memregion *mem;
+	int fd = -1;
+
+	pthread_mutex_lock(&cuddli_mock_mutex);
+	mem = cuddli_mock_get_memregion(
+		token.device_index, token.resource_index);
+	if (mem)
+		fd = fcntl(mem->fd, F_DUPFD_CLOEXEC, 0);
+	else
+		errno = ENODEV;
+	pthread_mutex_unlock(&cuddli_mock_mutex);
+
+	return fd;
+}
+
+int cuddli_mock_eventsrc_open(struct cuddlci_token token)
+{
+	struct cuddli_mock_eventsrc *src;
+	int fd;
+	int err = 0;
+
+	fd = eventfd(0, EFD_CLOEXEC);
+	if (fd < 0)
+		return -1;
+
+	pthread_mutex_lock(&cuddli_mock_mutex);
+	src = cuddli_mock_get_eventsrc(
+		token.device_index, token.resource_index);
+	if (!src)
+		err = ENODEV;
+	else if ((fd >= CUDDLI_MOCK_MAX_FDS) ||
+		 (src->n_listeners >= CUDDLI_MOCK_MAX_LISTENERS))
+		err = EMFILE;
+	if (!err) {
+		src->listeners[src->n_listeners++] = fd;
+		__atomic_store_n(
+			&cuddli_mock.fd_table[fd], src, __ATOMIC_RELEASE);
+	}
+	pthread_mutex_unlock(&cuddli_mock_mutex);
+
+	if (err) {
+		close(fd);
+		errno = err;
+		return -1;
+	}
+	return fd;
+}
+
+int cuddli_mock_eventsrc_close(int fd)
+{
+	struct cuddli_mock_eventsrc *src;
+
+	if ((fd >= 0) && (fd < CUDDLI_MOCK_MAX_FDS)) {
+		pthread_mutex_lock(&cuddli_mock_mutex);
+		src = cuddli_mock.fd_table[fd];
+		if (src) {
+			for (int i=0; i<src->n_listeners; i++) {
+				if (src->listeners[i] == fd) {
+					src->listeners[i] = src->listeners[
+						--src->n_listeners];
+					break;
+				}
+			}
+			__atomic_store_n(
+				&cuddli_mock.fd_table[fd], NULL,
+				__ATOMIC_RELEASE);
+		}
+		pthread_mutex_unlock(&cuddli_mock_mutex);
+	}
+
+	return close(fd);
+}
+
+static inline struct cuddli_mock_eventsrc *cuddli_mock_lookup_fd(int fd)
+{
+	if ((fd < 0) || (fd >= CUDDLI_MOCK_MAX_FDS))
+		return NULL;
+	return __atomic_load_n(&cuddli_mock.fd_table[fd], __ATOMIC_ACQUIRE);
+}
+
+ssize_t cuddli_mock_eventsrc_read(int fd, uint32_t *count)
+{
+	struct cuddli_mock_eventsrc *src;
+	uint64_t value;
+
+	src = cuddli_mock_lookup_fd(fd);
+	if (!src)
+		return read(fd, count, sizeof(*count));
+
+	/* The event sequence number is updated before waking the reader */
+	if (read(fd, &value, sizeof(value)) == -1)
+		return -1;
+	*count = (uint32_t) __atomic_load_n(
+		&src->status->event_seq, __ATOMIC_ACQUIRE);
+
+	return sizeof(*count);
+}
+
+ssize_t cuddli_mock_eventsrc_write(int fd, const uint32_t *value)
+{
+	struct cuddli_mock_eventsrc *src;
+
+	src = cuddli_mock_lookup_fd(fd);
+	if (!src)
+		return write(fd, value, sizeof(*value));
+
+	pthread_mutex_lock(&cuddli_mock_mutex);
+	cuddli_mock_set_enabled(src, *value != 0);
+	pthread_mutex_unlock(&cuddli_mock_mutex);
+
+	return sizeof(*value);
+}
+
+/* Must be called with cuddli_mock_mutex held */
+static int cuddli_mock_add_device_locked(
+	const char *group,
+	const char *name,
+	int instance,
+	const char *driver_info,
+	const char *hw_info)
+{
+	struct cuddli_mock_device *dev;
+	struct cuddl_resource_id id;
+	int slot = -1;
+
+	if (!group || !name || !group[0] || !name[0] || (instance < 0))
+		return -EINVAL;
+
+	memset(&id, 0, sizeof(id));
+	cuddli_mock_copy_str(id.group, group);
+	cuddli_mock_copy_str(id.device, name);
+	if (instance) {
+		id.instance = instance;
+		if (cuddli_mock_find_device_slot_matching(&id, 0, 0) >= 0)
+			return -EEXIST;
+	} else {
+		/* Select the lowest unused instance number */
+		for (id.instance = 1;
+		     cuddli_mock_find_device_slot_matching(&id, 0, 0) >= 0;
+		     id.instance++)
+			;
+	}
+
+	for (int i=0; i<CUDDLI_MOCK_MAX_DEVICES; i++) {
+		if (!cuddli_mock.devices[i]) {
+			slot = i;
+			break;
+		}
+	}
+	if (slot < 0)
+		return -ENOMEM;
+
+	dev = calloc(1, sizeof(*dev));
+	if (!dev)
+		return -ENOMEM;
+	memcpy(dev->group, id.group, CUDDL_MAX_STR_LEN);
+	memcpy(dev->name, id.device, CUDDL_MAX_STR_LEN);
+	dev->instance = id.instance;
+	cuddli_mock_copy_str(dev->driver_info, driver_info);
+	cuddli_mock_copy_str(dev->hw_info, hw_info);
+	for (int i=0; i<CUDDLI_MOCK_MAX_DEV_MEM_REGIONS; i++)
+		dev->mem[i].fd = -1;
+
+	cuddli_mock.devices[slot] = dev;
+
+	return slot;
+}
+
+/* Must be called with cuddli_mock_mutex held */
+static int cuddli_mock_add_memregion_locked(
+	int device_slot, const char *name, cuddl_size_t len, int flags)
+{
+	struct cuddli_mock_device *dev;
+	struct cuddli_mock_memregion *mem = NULL;
+	size_t page_size = sysconf(_SC_PAGESIZE);
+	int mslot = -1;
+	int fd;
+	void *addr;
+
+	if (!name || !name[0] || (len == 0))
+		return -EINVAL;
+	dev = cuddli_mock_get_device(device_slot);
+	if (!dev)
+		return -ENODEV;
+
+	for (int i=0; i<CUDDLI_MOCK_MAX_DEV_MEM_REGIONS; i++) {
+		if (dev->mem[i].fd < 0) {
+			if (mslot < 0)
+				mslot = i;
+		} else if (strncmp(dev->mem[i].name, name,
+				   CUDDL_MAX_STR_LEN) == 0) {
+			return -EEXIST;
+		}
+	}
+	if (mslot < 0)
+		return -ENOSPC;
+	mem = &dev->mem[mslot];
+
+	fd = memfd_create(name, MFD_CLOEXEC);
+	if (fd < 0)
+		return -errno;
+
+	mem->pa_len = (len + page_size - 1) & ~(page_size - 1);
+	if (ftruncate(fd, mem->pa_len) == -1) {
+		int ret = -errno;
+		close(fd);
+		return ret;
+	}
+
+	addr = mmap(NULL, mem->pa_len, PROT_READ | PROT_WRITE, MAP_SHARED,
+		    fd, 0);
+	if (addr == MAP_FAILED) {
+		int ret = -errno;
+		close(fd);
+		return ret;
+	}
+
+	cuddli_mock_copy_str(mem->name, name);
+	mem->len = len;
+	mem->flags = flags;
+	mem->fd = fd;
+	mem->addr = addr;
+	mem->ref_count = 0;
+
+	return mslot;
+}
+
+/* Must be called with cuddli_mock_mutex held */
+static int cuddli_mock_add_eventsrc_locked(
+	int device_slot, const char *name, int flags)
+{
+	struct cuddli_mock_device *dev;
+	struct cuddli_mock_eventsrc *src;
+	int eslot = -1;
+	int ret;
+
+	if (!name || !name[0])
+		return -EINVAL;
+	dev = cuddli_mock_get_device(device_slot);
+	if (!dev)
+		return -ENODEV;
+
+	for (int i=0; i<CUDDLI_MOCK_MAX_DEV_EVENTS; i++) {
+		if (!dev->events[i].status) {
+			if (eslot < 0)
+				eslot = i;
+		} else if (strncmp(dev->events[i].name, name,
+				   CUDDL_MAX_STR_LEN) == 0) {
+			return -EEXIST;
+		}
+	}
+	if (eslot < 0)
+		return -ENOSPC;
+
+	ret = cuddli_mock_init_status();
+	if (ret)
+		return ret;
+
+	src = &dev->events[eslot];
+	memset(src, 0, sizeof(*src));
+	cuddli_mock_copy_str(src->name, name);
+	src->flags = flags;
+	src->status = (struct cuddlci_eventsrc_status *) (
+		cuddli_mock.status_pages +
+		(device_slot * CUDDLI_MOCK_MAX_DEV_EVENTS + eslot) *
+		cuddli_mock.page_size);
+	cuddli_mock_write_status(src->status, 0, 0, 0);
+
+	return eslot;
+}
+
+int cuddl_mock_add_device(
+	const char *group,
+	const char *name,
+	int instance,
+	const char *driver_info,
+	const char *hw_info)
+{
+	int ret;
+
+	pthread_mutex_lock(&cuddli_mock_mutex);
+	ret = cuddli_mock_add_device_locked(
+		group, name, instance, driver_info, hw_info);
+	pthread_mutex_unlock(&cuddli_mock_mutex);
+
+	return ret;
+}
+
+int cuddl_mock_add_memregion(
+	int device_slot, const char *name, cuddl_size_t len, int flags)
+{
+	int ret;
+
+	pthread_mutex_lock(&cuddli_mock_mutex);
+	ret = cuddli_mock_add_memregion_locked(device_slot, name, len, flags);
+	pthread_mutex_unlock(&cuddli_mock_mutex);
+
+	return ret;
+}
+
+int cuddl_mock_add_eventsrc(int device_slot, const char *name, int flags)
+{
+	int ret;
+
+	pthread_mutex_lock(&cuddli_mock_mutex);
+	ret = cuddli_mock_add_eventsrc_locked(device_slot, name, flags);
+	pthread_mutex_unlock(&cuddli_mock_mutex);
+
+	return ret;
+}
+
+/* Parse one configuration file line.  Must be called with the mutex held. */
+static int cuddli_mock_parse_line(char *line, int *device_slot)
+{
+	char *save;
+	char *tok[6];
+	int n = 0;
+	char *end;
+	unsigned long long len;
+	int instance = 0;
+	int flags = 0;
+	int ret;
+
+	end = strchr(line, '#');
+	if (end)
+		*end = '\0';
+
+	for (char *t = strtok_r(line, " \t\r\n", &save); t && (n < 6);
+	     t = strtok_r(NULL, " \t\r\n", &save))
+		tok[n++] = t;
+	if (n == 0)
+		return 0;
+
+	if (strcmp(tok[0], "device") == 0) {
+		if ((n < 3) || (n > 6))
+			return -EINVAL;
+		if (n > 3) {
+			instance = strtol(tok[3], &end, 0);
+			if (*end)
+				return -EINVAL;
+		}
+		ret = cuddli_mock_add_device_locked(
+			tok[1], tok[2], instance,
+			(n > 4) ? tok[4] : NULL, (n > 5) ? tok[5] : NULL);
+		if (ret < 0)
+			return ret;
+		*device_slot = ret;
+		return 0;
+	}
+
+	if (strcmp(tok[0], "memregion") == 0) {
+		if ((n < 3) || (*device_slot < 0))
+			return -EINVAL;
+		for (int i=3; i<n; i++) {
+			if (strcmp(tok[i], "shared") == 0)
+				flags |= CUDDL_MEMF_SHARED;
+			else if (strcmp(tok[i], "dma") == 0)
+				flags |= CUDDL_MEMF_DMA;
+			else
+				return -EINVAL;
+		}
+		len = strtoull(tok[2], &end, 0);
+		if (*end)
+			return -EINVAL;
+		ret = cuddli_mock_add_memregion_locked(
+			*device_slot, tok[1], len, flags);
+		return (ret < 0) ? ret : 0;
+	}
+
+	if (strcmp(tok[0], "eventsrc") == 0) {
+		if ((n < 2) || (n > 3) || (*device_slot < 0))
+			return -EINVAL;
+		if ((n == 3) && (strcmp(tok[2], "shared") != 0))
+			return -EINVAL;
+		ret = cuddli_mock_add_eventsrc_locked(
+			*device_slot, tok[1],
+			(n == 3) ? CUDDL_EVENTSRCF_SHARED : 0);
+		return (ret < 0) ? ret : 0;
+	}
+
+	return -EINVAL;
+}
+
+int cuddl_mock_load_config(const char *path)
+{
+	FILE *f;
+	char line[1024];
+	int device_slot = -1;
+	int line_num = 0;
+	int ret = 0;
+
+	f = fopen(path, "r");
+	if (!f)
+		return -errno;
+
+	pthread_mutex_lock(&cuddli_mock_mutex);
+	cuddli_mock.config_checked = 1;
+	while (fgets(line, sizeof(line), f)) {
+		line_num++;
+		ret = cuddli_mock_parse_line(line, &device_slot);
+		if (ret) {
+			fprintf(stderr, "cuddl: %s:%d: %s\n",
+				path, line_num, strerror(-ret));
+			break;
+		}
+	}
+	pthread_mutex_unlock(&cuddli_mock_mutex);
+
+	fclose(f);
+	return ret;
+}
+
+int cuddl_mock_reset(void)
+{
+	struct cuddli_mock_device *dev;
+	int ret = 0;
+
+	pthread_mutex_lock(&cuddli_mock_mutex);
+
+	for (int i=0; (i<CUDDLI_MOCK_MAX_DEVICES) && !ret; i++) {
+		dev = cuddli_mock.devices[i];
+		if (!dev)
+			continue;
+		for (int j=0; j<CUDDLI_MOCK_MAX_DEV_MEM_REGIONS; j++)
+			if (dev->mem[j].ref_count)
+				ret = -EBUSY;
+		for (int j=0; j<CUDDLI_MOCK_MAX_DEV_EVENTS; j++)
+			if (dev->events[j].ref_count ||
+			    dev->events[j].n_listeners)
+				ret = -EBUSY;
+	}
+
+	for (int i=0; (i<CUDDLI_MOCK_MAX_DEVICES) && !ret; i++) {
+		dev = cuddli_mock.devices[i];
+		if (!dev)
+			continue;
+		for (int j=0; j<CUDDLI_MOCK_MAX_DEV_MEM_REGIONS; j++) {
+			if (dev->mem[j].fd < 0)
+				continue;
+			munmap(dev->mem[j].addr, dev->mem[j].pa_len);
+			close(dev->mem[j].fd);
+		}
+		free(dev);
+		cuddli_mock.devices[i] = NULL;
+	}
+
+	pthread_mutex_unlock(&cuddli_mock_mutex);
+
+	return ret;
+}
+
+void *cuddl_mock_memregion_addr(int device_slot, int mem_slot)
+{
+	struct cuddli_mock_memregion *mem;
+	void *addr = NULL;
+
+	pthread_mutex_lock(&cuddli_mock_mutex);
+	mem = cuddli_mock_get_memregion(device_slot, mem_slot);
+	if (mem)
+		addr = mem->addr;
+	pthread_mutex_unlock(&cuddli_mock_mutex);
+
+	return addr;
+}
+
+int cuddl_mock_eventsrc_trigger(int device_slot, int event_slot)
+{
+	struct cuddli_mock_eventsrc *src;
+	int ret;
+
+	pthread_mutex_lock(&cuddli_mock_mutex);
+	src = cuddli_mock_get_eventsrc(device_slot, event_slot);
+	if (!src) {
+		ret = -ENODEV;
+	} else if (!src->enabled) {
+		src->pending = 1;
+		ret = 0;
+	} else {
+		cuddli_mock_deliver(src);
+		ret = 1;
+	}
+	pthread_mutex_unlock(&cuddli_mock_mutex);
+
+	return ret;
+}
+
+int cuddl_mock_eventsrc_is_enabled(int device_slot, int event_slot)
+{
+	struct cuddli_mock_eventsrc *src;
+	int ret;
+
+	pthread_mutex_lock(&cuddli_mock_mutex);
+	src = cuddli_mock_get_eventsrc(device_slot, event_slot);
+	ret = src ? src->enabled : -ENODEV;
+	pthread_mutex_unlock(&cuddli_mock_mutex);
+
+	return ret;
+}
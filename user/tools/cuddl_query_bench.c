@@ -0,0 +1,236 @@
+/* SPDX-License-Identifier: (MIT OR GPL-2.0-or-later) */
+/*
+ * Cross-platform user-space device driver layer query benchmark.
+ *
+ * Copyright (C) 2022 Jeff Webb <jeff.webb@codecraftsmen.org>
+ *
+ * This software is dual-licensed and is made available under the terms of
+ * the MIT License or under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.  You may select (at your
+ * option) either of the licenses listed above.  See the LICENSE.MIT and
+ * LICENSE.GPL-2.0 files in the top-level directory of this distribution for
+ * copyright information and license terms.
+ */
+
+/*
+ * cuddl-query-bench: Measure the throughput of read-only device manager
+ * queries (reference count and memory region information lookups) issued
+ * concurrently from 1, 2, 4, ... threads, to show how the manager scales
+ * when several monitoring processes poll it at once.
+ *
+ * This program uses the Cuddl user-space library, so it may be built with
+ * something like::
+ *
+ *   cc -O2 -pthread -Iuser/include -Icommon/include \
+ *     -o cuddl-query-bench user/tools/cuddl_query_bench.c \
+ *     user/src/cuddl_linux.c
+ */
+
+#include <cuddl.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define CUDDL_QUERY_BENCH_MAX_THREADS 256
+
+struct cuddl_query_bench_thread {
+	pthread_t thread;
+	const struct cuddl_resource_id *id;
+	int info;
+	unsigned long ops;
+	int err;
+};
+
+static volatile int stop;
+
+static void usage(const char *prog)
+{
+	fprintf(stderr,
+		"Usage: %s [-t max_threads] [-s seconds] [-I] "
+		"[group device resource instance]\n"
+		"  -t  Maximum number of query threads (default: number "
+		"of CPUs)\n"
+		"  -s  Duration of each measurement in seconds "
+		"(default: 1)\n"
+		"  -I  Query memory region information instead of the "
+		"reference count\n"
+		"If no memory region is specified, the first one found "
+		"is used.\n",
+		prog);
+}
+
+static void *query_thread(void *arg)
+{
+	struct cuddl_query_bench_thread *t = arg;
+	struct cuddl_memregion_info info;
+	int ret;
+
+	while (!stop) {
+		if (t->info)
+			ret = cuddl_get_memregion_info_for_id(&info, t->id);
+		else
+			ret = cuddl_get_memregion_ref_count_for_id(t->id);
+		if (ret < 0) {
+			t->err = ret;
+			break;
+		}
+		t->ops++;
+	}
+	return NULL;
+}
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int find_first_memregion(struct cuddl_resource_id *id)
+{
+	int max_devs = cuddl_get_max_managed_devices();
+	int max_mem = cuddl_get_max_dev_mem_regions();
+	int slot;
+	int mslot;
+
+	if (max_devs < 0)
+		return max_devs;
+	if (max_mem < 0)
+		return max_mem;
+
+	for (slot = 0; slot < max_devs; slot++)
+		for (mslot = 0; mslot < max_mem; mslot++)
+			if (cuddl_get_memregion_id_for_slot(
+				    id, slot, mslot) == 0)
+				return 0;
+	return -ENODEV;
+}
+
+static int run(const struct cuddl_resource_id *id, int info,
+	       int n_threads, double seconds)
+{
+	struct cuddl_query_bench_thread *threads;
+	unsigned long total = 0;
+	double start;
+	double elapsed;
+	int err = 0;
+	int i;
+
+	threads = calloc(n_threads, sizeof(*threads));
+	if (!threads)
+		return -ENOMEM;
+
+	stop = 0;
+	start = now();
+	for (i = 0; i < n_threads; i++) {
+		threads[i].id = id;
+		threads[i].info = info;
+		err = -pthread_create(
+			&threads[i].thread, NULL, query_thread, &threads[i]);
+		if (err) {
+			n_threads = i;
+			break;
+		}
+	}
+	if (!err)
+		usleep((useconds_t) (seconds * 1e6));
+	stop = 1;
+	for (i = 0; i < n_threads; i++) {
+		pthread_join(threads[i].thread, NULL);
+		total += threads[i].ops;
+		if (threads[i].err && !err)
+			err = threads[i].err;
+	}
+	elapsed = now() - start;
+
+	if (!err)
+		printf("%7d %14.0f %14.0f\n", n_threads,
+		       total / elapsed, total / elapsed / n_threads);
+	free(threads);
+	return err;
+}
+
+int main(int argc, char *argv[])
+{
+	struct cuddl_resource_id id;
+	int max_threads = sysconf(_SC_NPROCESSORS_ONLN);
+	double seconds = 1.0;
+	int info = 0;
+	int n;
+	int opt;
+	int ret;
+
+	while ((opt = getopt(argc, argv, "t:s:Ih")) != -1) {
+		switch (opt) {
+		case 't':
+			max_threads = atoi(optarg);
+			break;
+		case 's':
+			seconds = atof(optarg);
+			break;
+		case 'I':
+			info = 1;
+			break;
+		default:
+			usage(argv[0]);
+			return (opt == 'h') ? 0 : 1;
+		}
+	}
+	if ((max_threads < 1) ||
+	    (max_threads > CUDDL_QUERY_BENCH_MAX_THREADS) ||
+	    (seconds <= 0.0) ||
+	    ((argc - optind != 0) && (argc - optind != 4))) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	ret = cuddl_manager_open();
+	if (ret < 0) {
+		fprintf(stderr, "cuddl-query-bench: cannot open manager: "
+			"%s\n", strerror(-ret));
+		return 1;
+	}
+
+	memset(&id, 0, sizeof(id));
+	if (argc - optind == 4) {
+		strncpy(id.group, argv[optind], CUDDL_MAX_STR_LEN - 1);
+		strncpy(id.device, argv[optind + 1], CUDDL_MAX_STR_LEN - 1);
+		strncpy(id.resource, argv[optind + 2],
+			CUDDL_MAX_STR_LEN - 1);
+		id.instance = atoi(argv[optind + 3]);
+	} else {
+		ret = find_first_memregion(&id);
+		if (ret < 0) {
+			fprintf(stderr, "cuddl-query-bench: no memory region "
+				"found: %s\n", strerror(-ret));
+			cuddl_manager_close();
+			return 1;
+		}
+	}
+
+	printf("Querying %s %s of %s %s %d\n",
+	       info ? "info" : "ref count", id.resource,
+	       id.group, id.device, id.instance);
+	printf("%7s %14s %14s\n", "threads", "ops/s", "ops/s/thread");
+	/* 1, 2, 4, ... threads, ending with max_threads */
+	for (n = 1; ; n = (n * 2 < max_threads) ? n * 2 : max_threads) {
+		ret = run(&id, info, n, seconds);
+		if (ret < 0) {
+			fprintf(stderr, "cuddl-query-bench: query failed: "
+				"%s\n", strerror(-ret));
+			cuddl_manager_close();
+			return 1;
+		}
+		if (n == max_threads)
+			break;
+	}
+
+	cuddl_manager_close();
+	return 0;
+}
@@ -0,0 +1,353 @@
+/* SPDX-License-Identifier: (MIT OR GPL-2.0-or-later) */
+/*
+ * Cross-platform user-space device driver layer statistics monitor.
+ *
+ * Copyright (C) 2022 Jeff Webb <jeff.webb@codecraftsmen.org>
+ *
+ * This software is dual-licensed and is made available under the terms of
+ * the MIT License or under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.  You may select (at your
+ * option) either of the licenses listed above.  See the LICENSE.MIT and
+ * LICENSE.GPL-2.0 files in the top-level directory of this distribution for
+ * copyright information and license terms.
+ */
+
+/*
+ * cuddl-top: Display live per-device interrupt rates and top-half interrupt
+ * handler latencies from the statistics that the Cuddl kernel modules
+ * publish in debugfs (``/sys/kernel/debug/cuddl/<device>/stats``).
+ *
+ * This program only depends on the C library, so it may be built with
+ * something like::
+ *
+ *   cc -O2 -o cuddl-top user/tools/cuddl_top.c
+ */
+
+#include <dirent.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define CUDDL_TOP_DEFAULT_DIR "/sys/kernel/debug/cuddl"
+#define CUDDL_TOP_MAX_NAME 256
+#define CUDDL_TOP_HIST_BUCKETS 32
+
+struct cuddl_top_dev {
+	char name[CUDDL_TOP_MAX_NAME];
+	uint64_t irqs_seen;
+	uint64_t irqs_handled;
+	uint64_t irqs_not_handled;
+	uint64_t notifications;
+	uint64_t eventsrc_claims;
+	uint64_t eventsrc_releases;
+	uint64_t memregion_claims;
+	uint64_t memregion_releases;
+	uint64_t claims_busy;
+	uint64_t hist[CUDDL_TOP_HIST_BUCKETS];
+};
+
+struct cuddl_top_snapshot {
+	int n_devs;
+	int max_devs;
+	struct cuddl_top_dev *devs;
+};
+
+static void usage(const char *prog)
+{
+	fprintf(stderr,
+		"Usage: %s [-d dir] [-i seconds] [-n count] [-b]\n"
+		"  -d dir      debugfs statistics directory (default: %s)\n"
+		"  -i seconds  update interval (default: 1)\n"
+		"  -n count    exit after count updates (default: run forever)\n"
+		"  -b          batch mode (do not clear the screen)\n",
+		prog, CUDDL_TOP_DEFAULT_DIR);
+}
+
+static int read_stats_file(const char *path, struct cuddl_top_dev *dev)
+{
+	FILE *f;
+	char line[1024];
+	char resource[32];
+	char counter[64];
+	int slot;
+	int pos;
+	uint64_t value;
+	int is_eventsrc;
+
+	f = fopen(path, "r");
+	if (!f)
+		return -errno;
+
+	while (fgets(line, sizeof(line), f)) {
+		if (sscanf(line, "%31s %d %63s %n",
+			   resource, &slot, counter, &pos) != 3)
+			continue;
+
+		if (strcmp(counter, "handler_ns_log2") == 0) {
+			char *p = line + pos;
+			char *end;
+			for (int i=0; i<CUDDL_TOP_HIST_BUCKETS; i++) {
+				value = strtoull(p, &end, 10);
+				if (end == p)
+					break;
+				dev->hist[i] += value;
+				p = end;
+			}
+			continue;
+		}
+
+		if (sscanf(line + pos, "%" SCNu64, &value) != 1)
+			continue;
+
+		is_eventsrc = (strcmp(resource, "eventsrc") == 0);
+		if (strcmp(counter, "irqs_seen") == 0)
+			dev->irqs_seen += value;
+		else if (strcmp(counter, "irqs_handled") == 0)
+			dev->irqs_handled += value;
+		else if (strcmp(counter, "irqs_not_handled") == 0)
+			dev->irqs_not_handled += value;
+		else if (strcmp(counter, "notifications") == 0)
+			dev->notifications += value;
+		else if ((strcmp(counter, "claims") == 0) && is_eventsrc)
+			dev->eventsrc_claims += value;
+		else if (strcmp(counter, "claims") == 0)
+			dev->memregion_claims += value;
+		else if ((strcmp(counter, "releases") == 0) && is_eventsrc)
+			dev->eventsrc_releases += value;
+		else if (strcmp(counter, "releases") == 0)
+			dev->memregion_releases += value;
+		else if (strcmp(counter, "claims_busy") == 0)
+			dev->claims_busy += value;
+	}
+
+	fclose(f);
+	return 0;
+}
+
+static int take_snapshot(const char *dir, struct cuddl_top_snapshot *snap)
+{
+	DIR *d;
+	struct dirent *entry;
+	char path[CUDDL_TOP_MAX_NAME * 2 + 16];
+	struct cuddl_top_dev *dev;
+	struct cuddl_top_dev *devs;
+	int max_devs;
+
+	d = opendir(dir);
+	if (!d)
+		return -errno;
+
+	snap->n_devs = 0;
+	while ((entry = readdir(d))) {
+		if (entry->d_name[0] == '.')
+			continue;
+		if (snap->n_devs == snap->max_devs) {
+			max_devs = snap->max_devs ? snap->max_devs * 2 : 64;
+			devs = realloc(snap->devs, max_devs * sizeof(*devs));
+			if (!devs) {
+				closedir(d);
+				return -ENOMEM;
+			}
+			snap->devs = devs;
+			snap->max_devs = max_devs;
+		}
+		dev = &snap->devs[snap->n_devs];
+		memset(dev, 0, sizeof(*dev));
+		snprintf(dev->name, sizeof(dev->name), "%s", entry->d_name);
+		snprintf(path, sizeof(path), "%s/%s/stats", dir, entry->d_name);
+		if (read_stats_file(path, dev) == 0)
+			snap->n_devs++;
+	}
+
+	closedir(d);
+	return 0;
+}
+
+static const struct cuddl_top_dev *find_dev(
+	const struct cuddl_top_snapshot *snap, const char *name)
+{
+	for (int i=0; i<snap->n_devs; i++) {
+		if (strcmp(snap->devs[i].name, name) == 0)
+			return &snap->devs[i];
+	}
+	return NULL;
+}
+
+/* Format the upper bound of a log2 histogram bucket */
+static void format_bucket(char *buf, size_t len, int bucket)
+{
+	double ns = (double) (1ULL << bucket);
+
+	if (bucket == 0)
+		snprintf(buf, len, "0");
+	else if (bucket == CUDDL_TOP_HIST_BUCKETS - 1)
+		snprintf(buf, len, ">1s");
+	else if (ns < 1e3)
+		snprintf(buf, len, "<%.0fns", ns);
+	else if (ns < 1e6)
+		snprintf(buf, len, "<%.0fus", ns / 1e3);
+	else
+		snprintf(buf, len, "<%.0fms", ns / 1e6);
+}
+
+/* Return the bucket containing the given fraction of the samples (or -1) */
+static int hist_percentile(const uint64_t *hist, double fraction)
+{
+	uint64_t total = 0;
+	uint64_t sum = 0;
+
+	for (int i=0; i<CUDDL_TOP_HIST_BUCKETS; i++)
+		total += hist[i];
+	if (total == 0)
+		return -1;
+
+	for (int i=0; i<CUDDL_TOP_HIST_BUCKETS; i++) {
+		sum += hist[i];
+		if ((double) sum >= fraction * (double) total)
+			return i;
+	}
+	return CUDDL_TOP_HIST_BUCKETS - 1;
+}
+
+static void print_snapshot(
+	const struct cuddl_top_snapshot *cur,
+	const struct cuddl_top_snapshot *prev,
+	double interval)
+{
+	const struct cuddl_top_dev *dev;
+	const struct cuddl_top_dev *old;
+	struct cuddl_top_dev zero;
+	uint64_t hist[CUDDL_TOP_HIST_BUCKETS];
+	char p50[16], p99[16], pmax[16];
+	int b;
+
+	memset(&zero, 0, sizeof(zero));
+
+	printf("%-32s %10s %10s %10s %10s %8s %8s %8s %8s %8s %8s\n",
+	       "DEVICE", "IRQ/s", "HANDLED/s", "UNHANDL/s", "NOTIFY/s",
+	       "EV HELD", "MEM HELD", "BUSY", "TOP p50", "TOP p99", "TOP max");
+
+	for (int i=0; i<cur->n_devs; i++) {
+		dev = &cur->devs[i];
+		old = prev ? find_dev(prev, dev->name) : NULL;
+		if (!old)
+			old = &zero;
+
+		for (int j=0; j<CUDDL_TOP_HIST_BUCKETS; j++)
+			hist[j] = dev->hist[j] - old->hist[j];
+
+		b = hist_percentile(hist, 0.50);
+		if (b < 0)
+			snprintf(p50, sizeof(p50), "-");
+		else
+			format_bucket(p50, sizeof(p50), b);
+		b = hist_percentile(hist, 0.99);
+		if (b < 0)
+			snprintf(p99, sizeof(p99), "-");
+		else
+			format_bucket(p99, sizeof(p99), b);
+		b = hist_percentile(hist, 1.0);
+		if (b < 0)
+			snprintf(pmax, sizeof(pmax), "-");
+		else
+			format_bucket(pmax, sizeof(pmax), b);
+
+		printf("%-32.32s %10.1f %10.1f %10.1f %10.1f %8" PRIu64
+		       " %8" PRIu64 " %8" PRIu64 " %8s %8s %8s\n",
+		       dev->name,
+		       (dev->irqs_seen - old->irqs_seen) / interval,
+		       (dev->irqs_handled - old->irqs_handled) / interval,
+		       (dev->irqs_not_handled - old->irqs_not_handled) /
+		       interval,
+		       (dev->notifications - old->notifications) / interval,
+		       dev->eventsrc_claims - dev->eventsrc_releases,
+		       dev->memregion_claims - dev->memregion_releases,
+		       dev->claims_busy,
+		       p50, p99, pmax);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	const char *dir = CUDDL_TOP_DEFAULT_DIR;
+	double interval = 1.0;
+	long count = -1;
+	int batch = !isatty(STDOUT_FILENO);
+	struct cuddl_top_snapshot *cur;
+	struct cuddl_top_snapshot *prev;
+	struct cuddl_top_snapshot *tmp;
+	int have_prev = 0;
+	int opt;
+	int ret;
+
+	while ((opt = getopt(argc, argv, "d:i:n:bh")) != -1) {
+		switch (opt) {
+		case 'd':
+			dir = optarg;
+			break;
+		case 'i':
+			interval = atof(optarg);
+			break;
+		case 'n':
+			count = atol(optarg);
+			break;
+		case 'b':
+			batch = 1;
+			break;
+		default:
+			usage(argv[0]);
+			return (opt == 'h') ? 0 : 1;
+		}
+	}
+	if (interval <= 0.0) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	cur = calloc(1, sizeof(*cur));
+	prev = calloc(1, sizeof(*prev));
+	if (!cur || !prev) {
+		fprintf(stderr, "cuddl-top: out of memory\n");
+		return 1;
+	}
+
+	while (count != 0) {
+		ret = take_snapshot(dir, cur);
+		if (ret) {
+			fprintf(stderr, "cuddl-top: cannot read %s: %s\n",
+				dir, strerror(-ret));
+			return 1;
+		}
+
+		if (!batch)
+			printf("\033[H\033[2J");
+		if (have_prev) {
+			print_snapshot(cur, prev, interval);
+		} else {
+			/* Totals since registration for the first update */
+			printf("Totals since registration:\n");
+			print_snapshot(cur, NULL, 1.0);
+		}
+		fflush(stdout);
+
+		tmp = prev;
+		prev = cur;
+		cur = tmp;
+		have_prev = 1;
+
+		if (count > 0)
+			count--;
+		if (count != 0)
+			usleep((useconds_t) (interval * 1e6));
+	}
+
+	free(cur->devs);
+	free(prev->devs);
+	free(cur);
+	free(prev);
+	return 0;
+}